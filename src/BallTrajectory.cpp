@@ -0,0 +1,206 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "BallTrajectory.h"
+
+/* includes */
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+
+#include "PhysicWorld.h"
+#include "GameConstants.h"
+#include "DeterministicMath.h"
+
+/* implementation */
+
+namespace
+{
+	// the closed form solution differs from the float computation by rounding errors, so the free flight
+	// segments are planned to end this many pixels before any contact.
+	const double MARGIN = 1;
+
+	const double GROUND_LIMIT = GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS - MARGIN;
+	const double LEFT_LIMIT = LEFT_PLANE + BALL_RADIUS + MARGIN;
+	const double RIGHT_LIMIT = RIGHT_PLANE - BALL_RADIUS - MARGIN;
+	// horizontal distance from the net at which the ball can touch it
+	const double NET_LIMIT = NET_RADIUS + BALL_RADIUS + MARGIN;
+	// above this height, the ball flies over the net
+	const double NET_TOP_LIMIT = NET_SPHERE_POSITION - NET_RADIUS - BALL_RADIUS - MARGIN;
+
+	const double INFINITE_STEPS = std::numeric_limits<double>::infinity();
+
+	/// number of frames until the ball, starting at height \p y with vertical speed \p vy, drops
+	/// below \p limit. Remember that y grows downwards.
+	double stepsAbove(double y, double vy, double limit)
+	{
+		if(y > limit)
+			return 0;
+
+		// solve y + k * vy + g/2 * k^2 = limit for the positive k, in a form without cancellation
+		const double g = BALL_GRAVITATION;
+		const double root = std::sqrt(vy * vy + 2 * g * (limit - y));
+		if(vy >= 0)
+			return 2 * (limit - y) / (vy + root);
+		return (root - vy) / g;
+	}
+
+	/// whether the ball can have touched the walls, the ground or the net in a free flight segment
+	/// that started at \p first and ended at \p last. In free flight, x changes monotonically and y
+	/// first decreases and then increases, so the ball is furthest out at one of the end points. The
+	/// tests use the float expressions of PhysicWorld::handleBallWorldCollisions, so they are exact.
+	bool segmentClear(const Vector2& first, const Vector2& last)
+	{
+		for(const Vector2& position : {first, last})
+		{
+			if(position.y + BALL_RADIUS > GROUND_PLANE_HEIGHT_MAX)
+				return false;
+			if(position.x - BALL_RADIUS <= LEFT_PLANE || position.x + BALL_RADIUS >= RIGHT_PLANE)
+				return false;
+		}
+
+		// the net and its top can only be hit when the ball is horizontally closer than
+		// BALL_RADIUS + NET_RADIUS and below the top of the net sphere.
+		const float distance = BALL_RADIUS + NET_RADIUS;
+		bool left = first.x - NET_POSITION_X <= -distance && last.x - NET_POSITION_X <= -distance;
+		bool right = first.x - NET_POSITION_X >= distance && last.x - NET_POSITION_X >= distance;
+		bool above = first.y - NET_SPHERE_POSITION <= -distance && last.y - NET_SPHERE_POSITION <= -distance;
+		return left || right || above;
+	}
+}
+
+BallTrajectory::BallTrajectory(PhysicWorld& world, Vector2 position, Vector2 velocity) :
+	mWorld(world), mPosition(position), mVelocity(velocity)
+{
+}
+
+void BallTrajectory::advance(int steps)
+{
+	mHasStop = false;
+	while(steps > 0)
+		steps -= advanceSegment(steps);
+}
+
+int BallTrajectory::advanceUntil(Axis axis, float coordinate, bool below, int maxSteps)
+{
+	mHasStop = true;
+	mStopAxis = axis;
+	mStopCoordinate = coordinate;
+	mStopBelow = below;
+
+	int steps = 0;
+	while(steps < maxSteps)
+	{
+		steps += advanceSegment(maxSteps - steps);
+		if(reachedStop(mPosition))
+			break;
+	}
+	return steps;
+}
+
+int BallTrajectory::advanceSegment(int limit)
+{
+	int steps = freeFlightSteps(limit);
+	if(steps > 0)
+	{
+		steps = freeFlight(steps);
+		if(steps > 0)
+			return steps;
+	}
+
+	contactStep();
+	return 1;
+}
+
+int BallTrajectory::freeFlightSteps(int limit) const
+{
+	const double x = mPosition.x;
+	const double y = mPosition.y;
+	const double vx = mVelocity.x;
+	const double vy = mVelocity.y;
+	if(!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(vx) || !std::isfinite(vy))
+		return 0;
+
+	double steps = std::min((double)limit, stepsAbove(y, vy, GROUND_LIMIT));
+
+	// walls
+	if(vx > 0)
+		steps = std::min(steps, (RIGHT_LIMIT - x) / vx);
+	else if(vx < 0)
+		steps = std::min(steps, (x - LEFT_LIMIT) / -vx);
+
+	// net: the ball is safe until it comes close to the net horizontally, or as long as it is above it
+	double net_distance = std::abs(x - NET_POSITION_X) - NET_LIMIT;
+	double approach = x < NET_POSITION_X ? vx : -vx;
+	double net_steps = net_distance <= 0 ? 0 : (approach > 0 ? net_distance / approach : INFINITE_STEPS);
+	steps = std::min(steps, std::max(net_steps, stepsAbove(y, vy, NET_TOP_LIMIT)));
+
+	return steps > 0 ? (int)steps : 0;
+}
+
+int BallTrajectory::freeFlight(int steps)
+{
+	short fpf = set_fpu_single_precision();
+
+	Vector2 position = mPosition;
+	Vector2 velocity = mVelocity;
+	Vector2 first;
+	int done = 0;
+	while(done < steps)
+	{
+		// same computation as in PhysicWorld::step
+		position += Vector2(0, 0.5f * BALL_GRAVITATION) + velocity;
+		velocity.y += BALL_GRAVITATION;
+
+		if(done == 0)
+			first = position;
+		++done;
+
+		if(mHasStop && reachedStop(position))
+			break;
+	}
+
+	reset_fpu_flags(fpf);
+
+	if(!segmentClear(first, position))
+		return 0;
+
+	mPosition = position;
+	mVelocity = velocity;
+	return done;
+}
+
+void BallTrajectory::contactStep()
+{
+	mWorld.setBallPosition(mPosition);
+	mWorld.setBallVelocity(mVelocity);
+	// the ball is not valid, so the blobs do not matter
+	mWorld.step(PlayerInput(), PlayerInput(), false, true);
+	mPosition = mWorld.getBallPosition();
+	mVelocity = mWorld.getBallVelocity();
+}
+
+bool BallTrajectory::reachedStop(const Vector2& position) const
+{
+	float value = mStopAxis == Axis::X ? position.x : 600 - position.y;
+	return (value < mStopCoordinate) != mStopBelow;
+}
@@ -0,0 +1,87 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include "Vector.h"
+
+class PhysicWorld;
+
+/*! \class BallTrajectory
+	\brief predicts the flight of the ball
+	\details Advances a ball the way PhysicWorld::step does for a running game in which the ball
+			cannot hit the blobs, i.e. with isBallValid = false. The results are bit-identical to
+			stepping a PhysicWorld frame by frame.
+			Parabola intersection tells how many frames the ball surely flies without touching
+			the walls, the ground or the net. These frames only need the float recurrence of the
+			free flight, without any collision tests. Since float rounding makes the closed form
+			results inexact, they are only used to plan these segments; each segment is checked
+			afterwards and redone frame by frame if the ball came too close to a contact. Frames
+			in which the ball may touch something are stepped with the full PhysicWorld.
+*/
+class BallTrajectory
+{
+	public:
+		enum class Axis
+		{
+			X,
+			Y
+		};
+
+		/// creates a trajectory starting at \p position with \p velocity. \p world is used for
+		/// the frames near contacts; its ball state is overwritten.
+		BallTrajectory(PhysicWorld& world, Vector2 position, Vector2 velocity);
+
+		/// advances the ball by \p steps frames
+		void advance(int steps);
+
+		/// advances the ball until its \p axis coordinate is no longer below \p coordinate (for
+		/// \p below = true) or below it (for \p below = false), but at most \p maxSteps frames.
+		/// The y coordinate counts upwards from the bottom of the screen.
+		/// \return the number of frames the ball was advanced.
+		int advanceUntil(Axis axis, float coordinate, bool below, int maxSteps);
+
+		Vector2 getPosition() const { return mPosition; }
+		Vector2 getVelocity() const { return mVelocity; }
+
+	private:
+		/// advances the ball by at least one and at most \p limit frames and returns the number of frames
+		int advanceSegment(int limit);
+		/// number of frames, at most \p limit, for which the ball surely touches nothing
+		int freeFlightSteps(int limit) const;
+		/// advances the ball by up to \p steps frames of free flight. Returns the number of frames
+		/// done, or 0 if the ball came near a contact on the way and the state was left unchanged.
+		int freeFlight(int steps);
+		/// advances the ball by one frame with the full physics
+		void contactStep();
+
+		/// whether the stop condition of advanceUntil is met at \p position
+		bool reachedStop(const Vector2& position) const;
+
+		PhysicWorld& mWorld;
+		Vector2 mPosition;
+		Vector2 mVelocity;
+
+		// stop condition of advanceUntil
+		bool mHasStop = false;
+		Axis mStopAxis = Axis::X;
+		float mStopCoordinate = 0;
+		bool mStopBelow = false;
+};
@@ -20,9 +20,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "BlobbyDebug.h"
 #include <string>
 #include <map>
+#include <mutex>
 #include <iostream>
 #include <fstream>
 
+// objects are created from several threads (server game threads, background loading)
+std::recursive_mutex& GetCounterMutex()
+{
+	static std::recursive_mutex mutex;
+	return mutex;
+}
+
 std::map<std::string, CountingReport>& GetCounterMap()
 {
 	static std::map<std::string, CountingReport> CounterMap;
@@ -43,6 +51,7 @@ std::map<std::string, int>& GetProfMap()
 
 int count(const std::type_info& type)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetCounterMutex());
 	std::string test = type.name();
 	if(GetCounterMap().find(type.name()) == GetCounterMap().end() )
 	{
@@ -55,16 +64,19 @@ int count(const std::type_info& type)
 
 int uncount(const std::type_info& type)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetCounterMutex());
 	return --GetCounterMap()[type.name()].alive;
 }
 
 int getObjectCount(const std::type_info& type)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetCounterMutex());
 	return 	GetCounterMap()[type.name()].alive;
 }
 
 int count(const std::type_info& type, std::string tag, int n)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetCounterMutex());
 	std::string name = std::string(type.name()) + " - " + std::move(tag);
 	if(GetCounterMap().find(name) == GetCounterMap().end() )
 	{
@@ -76,11 +88,13 @@ int count(const std::type_info& type, std::string tag, int n)
 
 int uncount(const std::type_info& type, std::string tag, int n)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetCounterMutex());
 	return GetCounterMap()[std::string(type.name()) + " - " + std::move(tag)].alive -= n;
 }
 
 int count(const std::type_info& type, std::string tag, void* address, int num)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetCounterMutex());
 	std::cout << "MALLOC " << num << "\n";
 	count(type, std::move(tag), num);
 	GetAddressMap()[address] = num;
@@ -89,6 +103,7 @@ int count(const std::type_info& type, std::string tag, void* address, int num)
 
 int uncount(const std::type_info& type, std::string tag, void* address)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetCounterMutex());
 	int num = GetAddressMap()[address];
 	std::cout << "FREE " << num << "\n";
 	uncount(type, std::move(tag), num);
@@ -109,6 +124,7 @@ std::fstream total_plot("logs/total.txt", std::fstream::out);
 
 void report(std::ostream& stream)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetCounterMutex());
 	stream << "MEMORY REPORT\n";
 	int sum = 0;
 	for(auto& i : GetCounterMap())
@@ -22,7 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Clock.h"
 
 /* includes */
-#include <sstream>
+#include <cstdio>
 
 /* implementation */
 
@@ -74,29 +74,15 @@ std::string Clock::makeTimeString(seconds time)
 	int minutes = ((time_sec - seconds) / 60) % 60;
 	int hours = ((time_sec - 60 * minutes - seconds) / 3600) % 60;
 
-	// now convert to string via stringstream
-	std::stringstream stream;
-
-	// only write hours if already player more than 1h
+	// the result is short enough for the small string buffer, so this does not allocate.
+	// leading 0 for minutes and seconds, hours only if already played more than 1h
+	char buffer[32];
 	if(hours > 0)
-		stream << hours << ":";
-
-	// write minutes
-	// leading 0 if minutes < 10
-	if(minutes < 10)
-		stream << "0";
-
-	stream << minutes << ":";
-
-	// write seconds
-	// leading 0 if seconds < 10
-	if(seconds < 10)
-		stream << "0";
-
-	stream << seconds;
+		snprintf(buffer, sizeof(buffer), "%d:%02d:%02d", hours, minutes, seconds);
+	else
+		snprintf(buffer, sizeof(buffer), "%02d:%02d", minutes, seconds);
 
-	// convert stringstream to string and return
-	return stream.str();
+	return buffer;
 }
 
 const std::string& Clock::getTimeString() const
@@ -0,0 +1,89 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <cfloat>
+
+/**
+ * @file DeterministicMath.h
+ * @brief Floating point settings for a deterministic physics simulation
+ *
+ * The physics has to compute bit-identical results on all machines, because replays and network games
+ * only work if every participant simulates the same match. This requires that each float operation is
+ * rounded to single precision exactly as IEEE 754 specifies, and that multiplications and additions are
+ * not fused (build with -ffp-contract=off, see the DETERMINISTIC_MATH option).
+ *
+ * With SSE2 math on x86 and with VFP / NEON on ARM, floats are computed in single precision by the
+ * hardware, so nothing has to be done at run time. The x87 FPU of old x86 builds computes in extended
+ * precision, so there, set_fpu_single_precision has to switch the rounding precision for each step.
+ */
+
+// FLT_EVAL_METHOD == 0 means that float operations are evaluated in float precision
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+	#define SINGLE_PRECISION_FLOAT_MATH 1
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM) || defined(_M_ARM64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define SINGLE_PRECISION_FLOAT_MATH 1
+#else
+	#define SINGLE_PRECISION_FLOAT_MATH 0
+#endif
+
+#if !SINGLE_PRECISION_FLOAT_MATH && !(defined(i386) || defined(__i386__) || defined(_M_IX86))
+	#if defined(_MSC_VER)
+		#pragma message ( "FPU precision may not conform to IEEE 754" )
+	#else
+		#warning FPU precision may not conform to IEEE 754
+	#endif
+#endif
+
+/// switches the x87 FPU to single precision and returns the previous control word,
+/// which has to be restored with reset_fpu_flags. Does nothing with single precision float math.
+inline short set_fpu_single_precision()
+{
+	short fl = 0;
+	#if !SINGLE_PRECISION_FLOAT_MATH
+	#if defined(__GNUC__) && (defined(i386) || defined(__i386__))
+		volatile short cw;
+		asm volatile ("fstcw %0" : "=m"(cw));
+		fl = cw;
+		cw = cw & 0xfcff;
+		asm volatile ("fldcw %0" :: "m"(cw));
+	#elif defined(_MSC_VER) && defined(_M_IX86)
+		short cw;
+		__asm fstcw cw;
+		fl = cw;
+		cw = cw & 0xfcff;
+		__asm fldcw cw;
+	#endif
+	#endif
+	return fl;
+}
+
+inline void reset_fpu_flags(short flags)
+{
+	#if !SINGLE_PRECISION_FLOAT_MATH
+	#if defined(__GNUC__) && (defined(i386) || defined(__i386__))
+		asm volatile ("fldcw %0" :: "m"(flags));
+	#elif defined(_MSC_VER) && defined(_M_IX86)
+		__asm fldcw flags;
+	#endif
+	#endif
+	(void)flags;
+}
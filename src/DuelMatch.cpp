@@ -22,9 +22,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "DuelMatch.h"
 
 /* includes */
+#include <cassert>
+#include <utility>
+
 #include "DuelMatchState.h"
+#include "MatchSnapshot.h"
 #include "MatchEvents.h"
 #include "PhysicWorld.h"
+#include "PhysicWorldBatch.h"
+#include "FixedPhysicWorld.h"
+#include "TrajectoryCache.h"
 #include "GenericIO.h"
 #include "GameConstants.h"
 #include "InputSource.h"
@@ -33,8 +40,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* implementation */
 
-DuelMatch::DuelMatch(bool remote, const std::string& rules, int score_to_win) :
+DuelMatch::DuelMatch(bool remote, const std::string& rules, int score_to_win, PhysicBackend backend) :
+		mBackend(backend),
 		mPaused(false),
+		mEvents(&mEventBuffers[0]),
+		mLastEvents(&mEventBuffers[1]),
 		mRemote(remote)
 {
 	if(score_to_win == 0) {
@@ -42,12 +52,15 @@ DuelMatch::DuelMatch(bool remote, const std::string& rules, int score_to_win) :
 	}
 
 	mLogic = createGameLogic(rules, score_to_win);
-	mPhysicWorld.reset( new PhysicWorld() );
+	createWorld();
+	mTrajectoryCache = std::make_shared<TrajectoryCache>();
 
 	setInputSources(std::make_shared<InputSource>(), std::make_shared<InputSource>());
 
-	if(!mRemote)
-		mPhysicWorld->setEventCallback( [this]( const MatchEvent& event ) { mEvents.push_back(event); } );
+	mInitialSnapshot.reset( new MatchSnapshot() );
+	saveSnapshot( *mInitialSnapshot );
+
+	connectEventSink();
 }
 
 void DuelMatch::setPlayers(PlayerIdentity left_player, PlayerIdentity right_player)
@@ -67,8 +80,40 @@ void DuelMatch::setInputSources(std::shared_ptr<InputSource> left_input, std::sh
 
 void DuelMatch::reset()
 {
-	mPhysicWorld.reset(new PhysicWorld());
-	mLogic = mLogic->clone();
+	// this is much faster than loading the rules script again
+	restoreSnapshot( *mInitialSnapshot );
+	mLogic->getClock().reset();
+	mLogic->getClock().start();
+}
+
+void DuelMatch::createWorld()
+{
+	mPhysicWorld.reset( new PhysicWorld() );
+	if(mBackend == PhysicBackend::FIXED_POINT)
+	{
+		mFixedWorld.reset( new FixedPhysicWorld() );
+		mPhysicWorld->setState( mFixedWorld->getState() );
+	}
+}
+
+void DuelMatch::syncFixedWorld()
+{
+	if(!mFixedWorld)
+		return;
+
+	mFixedWorld->setState( mPhysicWorld->getState() );
+	mPhysicWorld->setState( mFixedWorld->getState() );
+}
+
+void DuelMatch::connectEventSink()
+{
+	if(mRemote)
+		return;
+
+	if(mFixedWorld)
+		mFixedWorld->setEventSink( mEvents );
+	else
+		mPhysicWorld->setEventSink( mEvents );
 }
 
 DuelMatch::~DuelMatch() = default;
@@ -78,6 +123,7 @@ void DuelMatch::setRules(const std::string& rulesFile, int score_to_win)
 	if( score_to_win == 0)
 		score_to_win = getScoreToWin();
 	mLogic = createGameLogic(rulesFile, score_to_win);
+	mLogic->saveState( mInitialSnapshot->state.logicState, mInitialSnapshot->script );
 }
 
 
@@ -87,6 +133,78 @@ void DuelMatch::step()
 	if(mPaused)
 		return;
 
+	updateInput();
+
+	// do steps in physic and logic
+	stepPhysics();
+
+	processStep();
+}
+
+void DuelMatch::stepPhysics()
+{
+	if(mFixedWorld)
+	{
+		mFixedWorld->step( mTransformedInput[LEFT_PLAYER], mTransformedInput[RIGHT_PLAYER],
+						   mLogic->isBallValid(), mLogic->isGameRunning() );
+		mPhysicWorld->setState( mFixedWorld->getState() );
+	}
+	else
+	{
+		mPhysicWorld->step( mTransformedInput[LEFT_PLAYER], mTransformedInput[RIGHT_PLAYER],
+							mLogic->isBallValid(), mLogic->isGameRunning() );
+	}
+}
+
+void DuelMatch::stepBatch(const std::vector<DuelMatch*>& matches, PhysicWorldBatch& batch)
+{
+	// the batch computes float physics, so fixed point matches take the scalar path. Paused matches
+	// are not stepped at all.
+	std::vector<DuelMatch*> batched;
+	batched.reserve(matches.size());
+	for(DuelMatch* match : matches)
+	{
+		if(match->mFixedWorld || match->mPaused)
+		{
+			match->step();
+			continue;
+		}
+
+		assert((int)batched.size() < batch.size());
+		const int index = batched.size();
+		batched.push_back(match);
+
+		match->updateInput();
+		batch.load(index, *match->mPhysicWorld);
+		batch.setInput(index, match->mTransformedInput[LEFT_PLAYER], match->mTransformedInput[RIGHT_PLAYER],
+						match->mLogic->isBallValid(), match->mLogic->isGameRunning());
+	}
+
+	if(batched.empty())
+		return;
+
+	// worlds of the batch that are not needed in this step are not simulated
+	batch.step(batched.size());
+
+	for( const auto& event : batch.getEvents() )
+	{
+		DuelMatch* match = batched[event.world];
+		if(!match->mRemote)
+			match->mEvents->push( event.event );
+	}
+
+	for(std::size_t i = 0; i < batched.size(); ++i)
+	{
+		batch.store(i, *batched[i]->mPhysicWorld);
+		batched[i]->processStep();
+	}
+}
+
+void DuelMatch::updateInput()
+{
+	// the bots of both sides share the cached simulations of this frame
+	mTrajectoryCache->invalidate();
+
 	mTransformedInput[LEFT_PLAYER] = mInputSources[LEFT_PLAYER]->updateInput().toPlayerInput(this);
 	mTransformedInput[RIGHT_PLAYER] = mInputSources[RIGHT_PLAYER]->updateInput().toPlayerInput(this);
 
@@ -95,17 +213,17 @@ void DuelMatch::step()
 		mTransformedInput[LEFT_PLAYER] = mLogic->transformInput( mTransformedInput[LEFT_PLAYER], LEFT_PLAYER );
 		mTransformedInput[RIGHT_PLAYER] = mLogic->transformInput( mTransformedInput[RIGHT_PLAYER], RIGHT_PLAYER );
 	}
+}
 
-	// do steps in physic and logic
-	mPhysicWorld->step( mTransformedInput[LEFT_PLAYER], mTransformedInput[RIGHT_PLAYER],
-						mLogic->isBallValid(), mLogic->isGameRunning() );
+void DuelMatch::processStep()
+{
 	mLogic->step( getState() );
 
 	// check for all hit events
 
 	// process events
 	// process all physics events and relay them to logic
-	for( const auto& event : mEvents )
+	for( const auto& event : *mEvents )
 	{
 		switch( event.event )
 		{
@@ -116,7 +234,10 @@ void DuelMatch::step()
 				mLogic->onBallHitsGround( event.side );
 				// if not valid, reduce velocity
 				if(!mLogic->isBallValid())
+				{
 					mPhysicWorld->setBallVelocity( mPhysicWorld->getBallVelocity().scale(0.6) );
+					syncFixedWorld();
+				}
 				break;
 			case MatchEvent::BALL_HIT_NET:
 				mLogic->onBallHitsNet( event.side );
@@ -135,8 +256,9 @@ void DuelMatch::step()
 	auto errorside = mLogic->getLastErrorSide();
 	if(errorside != NO_PLAYER)
 	{
-		mEvents.emplace_back( MatchEvent::PLAYER_ERROR, errorside, 0 );
+		mEvents->push( MatchEvent(MatchEvent::PLAYER_ERROR, errorside, 0) );
 		mPhysicWorld->setBallVelocity( mPhysicWorld->getBallVelocity().scale(0.6) );
+		syncFixedWorld();
 	}
 
 	// if the round is finished, we
@@ -147,12 +269,11 @@ void DuelMatch::step()
 	{
 		resetBall( mLogic->getServingPlayer() );
 		mLogic->onServe();
-		mEvents.emplace_back( MatchEvent::RESET_BALL, NO_PLAYER, 0 );
+		mEvents->push( MatchEvent(MatchEvent::RESET_BALL, NO_PLAYER, 0) );
 	}
 
 	// reset events
-	mLastEvents = mEvents;
-	mEvents.clear();
+	swapEvents();
 }
 
 void DuelMatch::setScore(int left, int right)
@@ -266,6 +387,7 @@ PlayerSide DuelMatch::getServingPlayer() const
 void DuelMatch::setState(const DuelMatchState& state)
 {
 	mPhysicWorld->setState(state.worldState);
+	syncFixedWorld();
 	mLogic->setState(state.logicState);
 
 	mTransformedInput[LEFT_PLAYER] = state.playerInput[LEFT_PLAYER];
@@ -275,9 +397,38 @@ void DuelMatch::setState(const DuelMatchState& state)
 	mInputSources[RIGHT_PLAYER]->setInput( mTransformedInput[RIGHT_PLAYER] );
 }
 
-void DuelMatch::trigger( const MatchEvent& event )
+void DuelMatch::saveSnapshot(MatchSnapshot& snapshot) const
 {
-	mEvents.push_back( event );
+	snapshot.state.worldState = mPhysicWorld->getState();
+	mLogic->saveState( snapshot.state.logicState, snapshot.script );
+	snapshot.state.playerInput[LEFT_PLAYER] = mTransformedInput[LEFT_PLAYER];
+	snapshot.state.playerInput[RIGHT_PLAYER] = mTransformedInput[RIGHT_PLAYER];
+
+	snapshot.blobAnimationSpeed[LEFT_PLAYER] = mPhysicWorld->getBlobAnimationSpeed(LEFT_PLAYER);
+	snapshot.blobAnimationSpeed[RIGHT_PLAYER] = mPhysicWorld->getBlobAnimationSpeed(RIGHT_PLAYER);
+
+	if(mFixedWorld)
+	{
+		snapshot.fixedState = mFixedWorld->getFixedState();
+		snapshot.fixedAnimationSpeed[LEFT_PLAYER] = mFixedWorld->getBlobAnimationSpeed(LEFT_PLAYER);
+		snapshot.fixedAnimationSpeed[RIGHT_PLAYER] = mFixedWorld->getBlobAnimationSpeed(RIGHT_PLAYER);
+	}
+}
+
+void DuelMatch::restoreSnapshot(const MatchSnapshot& snapshot)
+{
+	setState( snapshot.state );
+	mLogic->restoreState( snapshot.state.logicState, snapshot.script );
+
+	mPhysicWorld->setBlobAnimationSpeed(LEFT_PLAYER, snapshot.blobAnimationSpeed[LEFT_PLAYER]);
+	mPhysicWorld->setBlobAnimationSpeed(RIGHT_PLAYER, snapshot.blobAnimationSpeed[RIGHT_PLAYER]);
+
+	if(mFixedWorld)
+	{
+		mFixedWorld->setFixedState( snapshot.fixedState );
+		mFixedWorld->setBlobAnimationSpeed(LEFT_PLAYER, snapshot.fixedAnimationSpeed[LEFT_PLAYER]);
+		mFixedWorld->setBlobAnimationSpeed(RIGHT_PLAYER, snapshot.fixedAnimationSpeed[RIGHT_PLAYER]);
+	}
 }
 
 DuelMatchState DuelMatch::getState() const
@@ -325,6 +476,7 @@ void DuelMatch::resetBall( PlayerSide side )
 
 	mPhysicWorld->setBallVelocity( Vector2(0, 0) );
 	mPhysicWorld->setBallAngularVelocity( (side == RIGHT_PLAYER ? -1 : 1) * STANDARD_BALL_ANGULAR_VELOCITY );
+	syncFixedWorld();
 }
 
 bool DuelMatch::canStartRound(PlayerSide servingPlayer) const
@@ -344,9 +496,9 @@ PlayerIdentity& DuelMatch::getPlayer(PlayerSide player)
 	return mPlayers[player];
 }
 
-void DuelMatch::updateEvents()
+void DuelMatch::swapEvents()
 {
-	/// \todo more economical with a swap?
-	mLastEvents = mEvents;
-	mEvents.clear();
+	std::swap(mEvents, mLastEvents);
+	mEvents->clear();
+	connectEventSink();
 }
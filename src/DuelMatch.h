@@ -33,7 +33,11 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 class InputSource;
 struct DuelMatchState;
+struct MatchSnapshot;
 class PhysicWorld;
+class PhysicWorldBatch;
+class FixedPhysicWorld;
+class TrajectoryCache;
 
 /*! \class DuelMatch
 	\brief class representing a blobby game.
@@ -49,8 +53,11 @@ class DuelMatch : public ObjectCounter<DuelMatch>
 	public:
 		// If remote is true, only physical responses will be calculated
 		// but hit events and score events are received from network
+		// With PhysicBackend::FIXED_POINT, the physics is computed by a FixedPhysicWorld, which gives the
+		// same results on all architectures. All participants of a match have to use the same backend.
 
-		DuelMatch(bool remote, const std::string& rules, int score_to_win = 0);
+		DuelMatch(bool remote, const std::string& rules, int score_to_win = 0,
+				PhysicBackend backend = PhysicBackend::FLOAT);
 
 		void setPlayers(PlayerIdentity left_player, PlayerIdentity right_player);
 		void setInputSources(std::shared_ptr<InputSource> left_input, std::shared_ptr<InputSource> right_input );
@@ -64,6 +71,12 @@ class DuelMatch : public ObjectCounter<DuelMatch>
 		// This steps through one frame
 		void step();
 
+		/// steps all \p matches through one frame, like calling step on each of them, but with the
+		/// physics of all matches computed together by \p batch. \p batch needs at least as many
+		/// worlds as there are running float matches. Matches with fixed point physics are stepped
+		/// on their own and do not use the batch.
+		static void stepBatch(const std::vector<DuelMatch*>& matches, PhysicWorldBatch& batch);
+
 		// these methods allow external input
 		// events triggered by the network
 		void setScore(int left, int right);
@@ -92,7 +105,13 @@ class DuelMatch : public ObjectCounter<DuelMatch>
 		Vector2 getBlobVelocity(PlayerSide player) const;
 		float getBlobState(PlayerSide player) const;
 
+		/// the physic world. With fixed point physics, this holds the state of the FixedPhysicWorld as
+		/// floats, but is not stepped itself.
 		const PhysicWorld& getWorld() const{ return *mPhysicWorld; };
+		PhysicBackend getPhysicBackend() const { return mBackend; }
+		/// cache for the ball simulations of scripted input sources. It is emptied before the
+		/// input sources are asked for their input.
+		std::shared_ptr<TrajectoryCache> getTrajectoryCache() const { return mTrajectoryCache; }
 
 		// Timing
 		const std::string& getTimeString() const;
@@ -113,12 +132,18 @@ class DuelMatch : public ObjectCounter<DuelMatch>
 
 		/// Set a new state using a saved DuelMatchState
 		void setState(const DuelMatchState& state);
-		/// trigger an external event
-		void trigger( const MatchEvent& event );
 
 		/// gets the current state
 		DuelMatchState getState() const;
 
+		/// \brief saves everything needed to continue the match exactly from this step into \p snapshot.
+		/// \details Unlike getState, this includes the variables of a lua rules script. Reusing the
+		///			same snapshot avoids memory allocations, which makes this cheap enough for rollback
+		///			and searching through possible moves.
+		void saveSnapshot(MatchSnapshot& snapshot) const;
+		/// restores a snapshot saved by a match with the same rules and physic backend.
+		void restoreSnapshot(const MatchSnapshot& snapshot);
+
 		//Input stuff for recording and playing replays
 		std::shared_ptr<InputSource> getInputSource(PlayerSide player) const;
 
@@ -127,14 +152,26 @@ class DuelMatch : public ObjectCounter<DuelMatch>
 
 		void setServingPlayer(PlayerSide side);
 
-		const std::vector<MatchEvent>& getEvents() const { return mLastEvents; }
-		// this function will move all events into mLastEvents, so they will be returned by get events.
-		// use this if no match step is performed, but external events have to be processed.
-		void updateEvents();
+		const MatchEventBuffer& getEvents() const { return *mLastEvents; }
 
 	private:
-
+		// the parts of step before and after the physics step
+		void updateInput();
+		void stepPhysics();
+		void processStep();
+		// creates new physic worlds for mBackend
+		void createWorld();
+		// copies changes made through mPhysicWorld into the fixed point world, and the rounded values back
+		void syncFixedWorld();
+		// lets the world that is stepped add its events to mEvents
+		void connectEventSink();
+		// makes the accumulated events the last events and starts a new accumulation
+		void swapEvents();
+
+		PhysicBackend mBackend;
 		std::unique_ptr<PhysicWorld> mPhysicWorld;
+		std::unique_ptr<FixedPhysicWorld> mFixedWorld;
+		std::shared_ptr<TrajectoryCache> mTrajectoryCache;
 
 		std::shared_ptr<InputSource> mInputSources[MAX_PLAYERS];
 		PlayerInput mTransformedInput[MAX_PLAYERS];
@@ -142,12 +179,16 @@ class DuelMatch : public ObjectCounter<DuelMatch>
 		PlayerIdentity mPlayers[MAX_PLAYERS];
 
 		GameLogicPtr mLogic;
+		// state directly after loading the rules, used by reset
+		std::unique_ptr<MatchSnapshot> mInitialSnapshot;
 
 		bool mPaused;
 
+		// the two event buffers are swapped instead of copied after each frame
+		MatchEventBuffer mEventBuffers[2];
 		// accumulation of physic events since last event processing
-		std::vector<MatchEvent> mEvents;
-		std::vector<MatchEvent> mLastEvents;	// events that were generated in the last processed frame
+		MatchEventBuffer* mEvents;
+		MatchEventBuffer* mLastEvents;	// events that were generated in the last processed frame
 
 		bool mRemote;
 };
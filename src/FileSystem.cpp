@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* includes */
 #include <cassert>
+#include <cstdio>
 #include <iostream> /// \todo remove this? currently needed for that probeDir error messages
 #include <utility>
 
@@ -96,11 +97,35 @@ bool FileSystem::deleteFile(const std::string& filename)
 	return PHYSFS_delete(filename.c_str());
 }
 
+bool FileSystem::rename(const std::string& from, const std::string& to)
+{
+	const char* write_dir = PHYSFS_getWriteDir();
+	if(!write_dir)
+		return false;
+
+	std::string target = join(write_dir, to);
+#ifdef _WIN32
+	std::remove(target.c_str());
+#endif
+	return std::rename(join(write_dir, from).c_str(), target.c_str()) == 0;
+}
+
 bool FileSystem::exists(const std::string& filename) const
 {
 	return PHYSFS_exists(filename.c_str());
 }
 
+bool FileSystem::getFileInfo(const std::string& filename, std::uint64_t& size, std::int64_t& modified) const
+{
+	PHYSFS_Stat stat;
+	if ( !PHYSFS_stat(filename.c_str(), &stat) )
+		return false;
+
+	size = stat.filesize;
+	modified = stat.modtime;
+	return true;
+}
+
 bool FileSystem::isDirectory(const std::string& dirname) const
 {
 	if(!exists(dirname)) { return false; }
@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -54,9 +55,19 @@ class FileSystem : public ObjectCounter<FileSystem>
 		/// \brief deletes a file
 		bool deleteFile(const std::string& filename);
 
+		/// \brief renames a file in the write directory, replacing a file of the new name.
+		/// \details physfs cannot rename files, so this works on the real paths. On POSIX systems, the file
+		///			is replaced atomically, so readers either see the old or the new file. Windows does not
+		///			replace existing files, so there the old file is deleted first.
+		bool rename(const std::string& from, const std::string& to);
+
 		/// \brief tests whether a file exists
 		bool exists(const std::string& filename) const;
 
+		/// \brief gets size and last modification time of a file
+		/// \return false, if the file does not exist
+		bool getFileInfo(const std::string& filename, std::uint64_t& size, std::int64_t& modified) const;
+
 		/// \brief tests whether given path is a directory
 		bool isDirectory(const std::string& dirname) const;
 
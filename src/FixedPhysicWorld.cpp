@@ -0,0 +1,350 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "FixedPhysicWorld.h"
+
+/* includes */
+#include <algorithm>
+
+#include "MatchEvents.h"
+
+/* implementation */
+
+namespace
+{
+	// The constants of GameConstants.h, derived from integers so they do not depend on any float rounding.
+	const Fixed LEFT_PLANE = Fixed::fromInt(0);
+	const Fixed RIGHT_PLANE = Fixed::fromInt(800);
+
+	const Fixed BLOBBY_UPPER_SPHERE = Fixed::fromInt(19);
+	const Fixed BLOBBY_UPPER_RADIUS = Fixed::fromInt(25);
+	const Fixed BLOBBY_LOWER_SPHERE = Fixed::fromInt(13);
+	const Fixed BLOBBY_LOWER_RADIUS = Fixed::fromInt(33);
+
+	const Fixed GROUND_PLANE_HEIGHT_MAX = Fixed::fromInt(500);
+	const Fixed GROUND_PLANE_HEIGHT = Fixed::fromRatio(911, 2);	// 500 - 89 / 2
+
+	// 15.1^2 / (455.5 - 206.375)
+	const Fixed BLOBBY_JUMP_ACCELERATION = Fixed::fromRatio(-151, 10);
+	const Fixed GRAVITATION = Fixed::fromRatio(2280100, 2491250);
+	const Fixed BLOBBY_JUMP_BUFFER = Fixed::fromRatio(2280100, 2 * 2491250);
+
+	const Fixed BALL_RADIUS = Fixed::fromRatio(63, 2);
+	const Fixed BALL_GRAVITATION = Fixed::fromRatio(287, 1000);
+	const Fixed BALL_COLLISION_VELOCITY = sqrt(Fixed::fromRatio(1722, 10));	// sqrt(0.75 * 800 * 0.287)
+
+	const Fixed NET_POSITION_X = Fixed::fromInt(400);
+	const Fixed NET_RADIUS = Fixed::fromInt(7);
+	const Fixed NET_SPHERE_POSITION = Fixed::fromInt(284);
+
+	const Fixed STANDARD_BALL_HEIGHT = Fixed::fromRatio(601, 2);	// 269 + BALL_RADIUS
+
+	const Fixed BLOBBY_SPEED = Fixed::fromRatio(9, 2);
+	const Fixed STANDARD_BALL_ANGULAR_VELOCITY = Fixed::fromRatio(1, 10);
+	const Fixed BLOBBY_ANIMATION_SPEED = Fixed::fromRatio(1, 2);
+
+	const Fixed HALF = Fixed::fromRatio(1, 2);
+
+	bool circleCircleCollision(const FixedVector2& pos1, Fixed rad1, const FixedVector2& pos2, Fixed rad2)
+	{
+		std::int64_t sum_radii = (rad1 + rad2).raw();
+		return (pos1 - pos2).lengthSQ() < sum_radii * sum_radii;
+	}
+}
+
+FixedPhysicWorld::FixedPhysicWorld()
+{
+	mState.ballPosition = FixedVector2(Fixed::fromInt(200), STANDARD_BALL_HEIGHT);
+	mState.ballAngularVelocity = STANDARD_BALL_ANGULAR_VELOCITY;
+
+	mState.blobPosition[LEFT_PLAYER] = FixedVector2(Fixed::fromInt(200), GROUND_PLANE_HEIGHT);
+	mState.blobPosition[RIGHT_PLAYER] = FixedVector2(Fixed::fromInt(600), GROUND_PLANE_HEIGHT);
+}
+
+inline void FixedPhysicWorld::emitEvent( const MatchEvent& event )
+{
+	if(mEventSink)
+		mEventSink->push(event);
+}
+
+void FixedPhysicWorld::setEventSink( MatchEventBuffer* sink )
+{
+	mEventSink = sink;
+}
+
+PhysicState FixedPhysicWorld::getState() const
+{
+	return mState.toPhysicState();
+}
+
+void FixedPhysicWorld::setState(const PhysicState& state)
+{
+	mState = FixedPhysicState::fromPhysicState(state);
+}
+
+void FixedPhysicWorld::setFixedState(const FixedPhysicState& state)
+{
+	mState = state;
+}
+
+Fixed FixedPhysicWorld::getBlobAnimationSpeed(PlayerSide player) const
+{
+	return mCurrentBlobbyAnimationSpeed[player];
+}
+
+void FixedPhysicWorld::setBlobAnimationSpeed(PlayerSide player, Fixed speed)
+{
+	mCurrentBlobbyAnimationSpeed[player] = speed;
+}
+
+bool FixedPhysicWorld::blobHitGround(PlayerSide player) const
+{
+	return mState.blobPosition[player].y >= GROUND_PLANE_HEIGHT;
+}
+
+void FixedPhysicWorld::blobbyAnimationStep(PlayerSide player)
+{
+	Fixed& blob_state = mState.blobState[player];
+	if (blob_state < Fixed())
+	{
+		mCurrentBlobbyAnimationSpeed[player] = Fixed();
+		blob_state = Fixed();
+	}
+
+	if (blob_state >= Fixed::fromRatio(9, 2))
+	{
+		mCurrentBlobbyAnimationSpeed[player] = -BLOBBY_ANIMATION_SPEED;
+	}
+
+	blob_state += mCurrentBlobbyAnimationSpeed[player];
+
+	if (blob_state >= Fixed::fromInt(5))
+	{
+		blob_state = Fixed::fromRatio(499, 100);
+	}
+}
+
+void FixedPhysicWorld::blobbyStartAnimation(PlayerSide player)
+{
+	if (mCurrentBlobbyAnimationSpeed[player] == Fixed())
+		mCurrentBlobbyAnimationSpeed[player] = BLOBBY_ANIMATION_SPEED;
+}
+
+void FixedPhysicWorld::handleBlob(PlayerSide player, PlayerInput input)
+{
+	FixedVector2& position = mState.blobPosition[player];
+	FixedVector2& velocity = mState.blobVelocity[player];
+	Fixed currentBlobbyGravity = GRAVITATION;
+
+	if (input.up)
+	{
+		if (blobHitGround(player))
+		{
+			velocity.y = BLOBBY_JUMP_ACCELERATION;
+			blobbyStartAnimation( player );
+		}
+
+		currentBlobbyGravity -= BLOBBY_JUMP_BUFFER;
+	}
+
+	if ((input.left || input.right) && blobHitGround(player))
+	{
+		blobbyStartAnimation(player);
+	}
+
+	velocity.x = (input.right ? BLOBBY_SPEED : Fixed()) - (input.left ? BLOBBY_SPEED : Fixed());
+
+	// ds = a/2 * dt^2 + v * dt
+	position += FixedVector2(Fixed(), HALF * currentBlobbyGravity) + velocity;
+	// dv = a * dt
+	velocity.y += currentBlobbyGravity;
+
+	// Hitting the ground
+	if (position.y > GROUND_PLANE_HEIGHT)
+	{
+		if(velocity.y > Fixed::fromRatio(7, 2))
+		{
+			blobbyStartAnimation(player);
+		}
+
+		position.y = GROUND_PLANE_HEIGHT;
+		velocity.y = Fixed();
+	}
+
+	blobbyAnimationStep(player);
+}
+
+bool FixedPhysicWorld::handleBlobbyBallCollision(PlayerSide player)
+{
+	const FixedVector2& blob_position = mState.blobPosition[player];
+	FixedVector2 collision_center = blob_position;
+	// check for impact
+	if(circleCircleCollision(mState.ballPosition, BALL_RADIUS,
+							 FixedVector2(blob_position.x, blob_position.y + BLOBBY_LOWER_SPHERE), BLOBBY_LOWER_RADIUS))
+	{
+		collision_center.y += BLOBBY_LOWER_SPHERE;
+	}
+	else if(circleCircleCollision(mState.ballPosition, BALL_RADIUS,
+								  FixedVector2(blob_position.x, blob_position.y - BLOBBY_UPPER_SPHERE), BLOBBY_UPPER_RADIUS))
+	{
+		collision_center.y -= BLOBBY_UPPER_SPHERE;
+	} else
+	{	// no impact!
+		return false;
+	}
+
+	// calculate hit intensity
+	Fixed intensity = std::min(Fixed::fromInt(1),
+			(mState.blobVelocity[player] - mState.ballVelocity).length() / Fixed::fromInt(25));
+
+	// set ball velocity
+	mState.ballVelocity = (mState.ballPosition - collision_center).normalise().scale(BALL_COLLISION_VELOCITY);
+	mState.ballPosition += mState.ballVelocity;
+
+	emitEvent( MatchEvent{MatchEvent::BALL_HIT_BLOB, player, intensity.toFloat()} );
+
+	return true;
+}
+
+void FixedPhysicWorld::step(const PlayerInput& leftInput, const PlayerInput& rightInput,
+					bool isBallValid, bool isGameRunning)
+{
+	// Compute independent actions
+	handleBlob(LEFT_PLAYER, leftInput);
+	handleBlob(RIGHT_PLAYER, rightInput);
+
+	FixedVector2& ball_position = mState.ballPosition;
+	FixedVector2& ball_velocity = mState.ballVelocity;
+
+	// Move ball when game is running
+	if (isGameRunning)
+	{
+		ball_position += FixedVector2(Fixed(), HALF * BALL_GRAVITATION) + ball_velocity;
+		ball_velocity.y += BALL_GRAVITATION;
+	}
+
+	// Collision detection
+	if(isBallValid)
+	{
+		handleBlobbyBallCollision(LEFT_PLAYER);
+		handleBlobbyBallCollision(RIGHT_PLAYER);
+	}
+
+	handleBallWorldCollisions();
+
+	// Collision between blobby and the net
+	FixedVector2* blob_position = mState.blobPosition;
+	if (blob_position[LEFT_PLAYER].x + BLOBBY_LOWER_RADIUS > NET_POSITION_X - NET_RADIUS)
+		blob_position[LEFT_PLAYER].x = NET_POSITION_X - NET_RADIUS - BLOBBY_LOWER_RADIUS;
+
+	if (blob_position[RIGHT_PLAYER].x - BLOBBY_LOWER_RADIUS < NET_POSITION_X + NET_RADIUS)
+		blob_position[RIGHT_PLAYER].x = NET_POSITION_X + NET_RADIUS + BLOBBY_LOWER_RADIUS;
+
+	// Collision between blobby and the border
+	if (blob_position[LEFT_PLAYER].x < LEFT_PLANE)
+		blob_position[LEFT_PLAYER].x = LEFT_PLANE;
+
+	if (blob_position[RIGHT_PLAYER].x > RIGHT_PLANE)
+		blob_position[RIGHT_PLAYER].x = RIGHT_PLANE;
+
+	// Velocity Integration
+	Fixed& rotation = mState.ballRotation;
+	if( !isGameRunning )
+		rotation -= mState.ballAngularVelocity;
+	else if (ball_velocity.x > Fixed())
+		rotation += mState.ballAngularVelocity * (ball_velocity.length() / Fixed::fromInt(6));
+	else
+		rotation -= mState.ballAngularVelocity * (ball_velocity.length() / Fixed::fromInt(6));
+
+	// Overflow-Protection
+	const Fixed full_rotation = Fixed::fromRatio(25, 4);
+	if (rotation <= Fixed())
+		rotation = full_rotation + rotation;
+	else if (rotation >= full_rotation)
+		rotation = rotation - full_rotation;
+}
+
+void FixedPhysicWorld::handleBallWorldCollisions()
+{
+	FixedVector2& ball_position = mState.ballPosition;
+	FixedVector2& ball_velocity = mState.ballVelocity;
+
+	// Ball to ground Collision
+	if (ball_position.y + BALL_RADIUS > GROUND_PLANE_HEIGHT_MAX)
+	{
+		ball_velocity = FixedVector2(ball_velocity.x, -ball_velocity.y).scale(Fixed::fromRatio(95, 100));
+		ball_position.y = GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS;
+		emitEvent( MatchEvent{MatchEvent::BALL_HIT_GROUND, ball_position.x > NET_POSITION_X ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
+	}
+
+	// Border Collision
+	if (ball_position.x - BALL_RADIUS <= LEFT_PLANE && ball_velocity.x < Fixed())
+	{
+		ball_velocity.x = -ball_velocity.x;
+		ball_position.x = LEFT_PLANE + BALL_RADIUS;
+		emitEvent( MatchEvent{MatchEvent::BALL_HIT_WALL, LEFT_PLAYER, 0} );
+	}
+	else if (ball_position.x + BALL_RADIUS >= RIGHT_PLANE && ball_velocity.x > Fixed())
+	{
+		ball_velocity.x = -ball_velocity.x;
+		ball_position.x = RIGHT_PLANE - BALL_RADIUS;
+		emitEvent( MatchEvent{MatchEvent::BALL_HIT_WALL, RIGHT_PLAYER, 0} );
+	}
+	else if (ball_position.y > NET_SPHERE_POSITION &&
+			abs(ball_position.x - NET_POSITION_X) < BALL_RADIUS + NET_RADIUS)
+	{
+		bool right = ball_position.x > NET_POSITION_X;
+		ball_velocity.x = -ball_velocity.x;
+		// set the ball's position so that it touches the net
+		ball_position.x = right ? NET_POSITION_X + BALL_RADIUS + NET_RADIUS : NET_POSITION_X - BALL_RADIUS - NET_RADIUS;
+
+		emitEvent( MatchEvent{MatchEvent::BALL_HIT_NET, right ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
+	}
+	else
+	{
+		// Net Collisions
+		const FixedVector2 net_sphere{NET_POSITION_X, NET_SPHERE_POSITION};
+
+		if (circleCircleCollision(ball_position, BALL_RADIUS, net_sphere, NET_RADIUS))
+		{
+			FixedVector2 normal = (net_sphere - ball_position).normalise();
+
+			// normal component of kinetic energy
+			Fixed perp_ekin = normal.dotProduct(ball_velocity);
+			perp_ekin *= perp_ekin;
+			// parallel component of kinetic energy
+			Fixed para_ekin = ball_velocity.dotProduct(ball_velocity) - perp_ekin;
+
+			// the normal component is damped stronger than the parallel component
+			perp_ekin *= Fixed::fromRatio(7, 10);
+			para_ekin *= Fixed::fromRatio(9, 10);
+
+			Fixed new_speed = sqrt( perp_ekin + para_ekin );
+
+			ball_velocity = ball_velocity.reflect(normal).normalise().scale(new_speed);
+
+			// pushes the ball out of the net
+			ball_position = net_sphere - normal.scale(NET_RADIUS + BALL_RADIUS);
+
+			emitEvent( MatchEvent{MatchEvent::BALL_HIT_NET_TOP, NO_PLAYER, 0} );
+		}
+	}
+}
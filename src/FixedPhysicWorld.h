@@ -0,0 +1,76 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include "Global.h"
+#include "FixedPoint.h"
+#include "PlayerInput.h"
+#include "BlobbyDebug.h"
+#include "PhysicState.h"
+#include "MatchEvents.h"
+
+/*! \brief blobby world in fixed point numbers
+	\details Computes the same physics as PhysicWorld, but with fixed point numbers instead of floats.
+			Floats give different results on different architectures and compilers, whereas the integer
+			operations used here are exact everywhere, so a fixed point match can be simulated in
+			lockstep by an ARM client and an x86 server that only exchange inputs.
+			The results differ slightly from PhysicWorld, so all participants of a match have to use
+			the same physics.
+*/
+class FixedPhysicWorld : public ObjectCounter<FixedPhysicWorld>
+{
+	public:
+		FixedPhysicWorld();
+
+		/// the events of each step are added to \p sink. With nullptr, events are discarded.
+		void setEventSink( MatchEventBuffer* sink );
+
+		void step(const PlayerInput& leftInput, const PlayerInput& rightInput,
+					bool isBallValid, bool isGameRunning);
+
+		/// the state as floats. As all values of a match are below 1024, this is exact.
+		PhysicState getState() const;
+		/// sets the state, with each value rounded to the nearest fixed point number
+		void setState(const PhysicState& state);
+
+		const FixedPhysicState& getFixedState() const { return mState; }
+		void setFixedState(const FixedPhysicState& state);
+
+		/// the animation speed is not part of the FixedPhysicState, but needed to continue a match exactly
+		Fixed getBlobAnimationSpeed(PlayerSide player) const;
+		void setBlobAnimationSpeed(PlayerSide player, Fixed speed);
+
+	private:
+		bool blobHitGround(PlayerSide player) const;
+		void blobbyStartAnimation(PlayerSide player);
+		void blobbyAnimationStep(PlayerSide player);
+
+		void handleBlob(PlayerSide player, PlayerInput input);
+		bool handleBlobbyBallCollision(PlayerSide player);
+		void handleBallWorldCollisions();
+
+		void emitEvent( const MatchEvent& event );
+
+		FixedPhysicState mState;
+		Fixed mCurrentBlobbyAnimationSpeed[MAX_PLAYERS];
+
+		MatchEventBuffer* mEventSink = nullptr;
+};
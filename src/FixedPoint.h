@@ -0,0 +1,235 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/**
+ * @file FixedPoint.h
+ * @brief Contains fixed point numbers and vectors for the fixed point physics
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+/*! \brief fixed point number
+	\details A number with FRACTION_BITS binary digits after the point, stored in a 32 bit integer. All
+			operations are integer operations, so the results are the same on every machine and with
+			every compiler.
+			With 14 fraction bits, every number below 1024 has at most 24 significant bits, so toFloat
+			is exact for all positions and velocities of a match. Products and quotients are truncated
+			towards zero, so negating the operands negates the result and mirrored situations stay
+			mirrored.
+*/
+class Fixed
+{
+	public:
+		static const int FRACTION_BITS = 14;
+		static const std::int32_t ONE = 1 << FRACTION_BITS;
+
+		Fixed() : mRaw(0) { }
+
+		static Fixed fromRaw(std::int32_t raw);
+		static Fixed fromInt(int value);
+		/// \p numerator / \p denominator, rounded to the nearest fixed point number
+		static Fixed fromRatio(std::int64_t numerator, std::int64_t denominator);
+		/// rounds \p value to the nearest fixed point number
+		static Fixed fromFloat(float value);
+
+		std::int32_t raw() const { return mRaw; }
+		float toFloat() const;
+
+		Fixed operator-() const { return fromRaw(-mRaw); }
+		Fixed& operator+=(Fixed other) { mRaw += other.mRaw; return *this; }
+		Fixed& operator-=(Fixed other) { mRaw -= other.mRaw; return *this; }
+		Fixed& operator*=(Fixed other);
+
+	private:
+		std::int32_t mRaw;
+};
+
+/// \brief two dimensional vector of fixed point numbers
+/// \details the fixed point counterpart to Vector2.
+struct FixedVector2
+{
+	Fixed x;
+	Fixed y;
+
+	FixedVector2() = default;
+	FixedVector2(Fixed x_, Fixed y_) : x(x_), y(y_) { }
+
+	/// the squared length, with 2 * Fixed::FRACTION_BITS fraction bits, so it cannot overflow
+	std::int64_t lengthSQ() const;
+	Fixed length() const;
+	/// the vector with length one in the same direction. A zero vector is returned unchanged.
+	FixedVector2 normalise() const;
+	FixedVector2 scale(Fixed factor) const;
+	Fixed dotProduct(const FixedVector2& other) const;
+	/// reflection at the plane with the normal vector \p normal, which has to have length one
+	FixedVector2 reflect(const FixedVector2& normal) const;
+};
+
+// -------------------------------------------------------------------------------------------------
+//    							INLINE IMPLEMENTATION
+// -------------------------------------------------------------------------------------------------
+
+inline Fixed Fixed::fromRaw(std::int32_t raw)
+{
+	Fixed result;
+	result.mRaw = raw;
+	return result;
+}
+
+inline Fixed Fixed::fromInt(int value)
+{
+	return fromRaw(value * ONE);
+}
+
+inline Fixed Fixed::fromRatio(std::int64_t numerator, std::int64_t denominator)
+{
+	// twice the result, so the last bit decides the rounding (half away from zero)
+	std::int64_t twice = numerator * ONE * 2 / denominator;
+	return fromRaw( static_cast<std::int32_t>((twice + (twice < 0 ? -1 : 1)) / 2) );
+}
+
+inline Fixed Fixed::fromFloat(float value)
+{
+	// scaling a float by a power of two is exact in double
+	return fromRaw( static_cast<std::int32_t>(std::round(static_cast<double>(value) * ONE)) );
+}
+
+inline float Fixed::toFloat() const
+{
+	return static_cast<float>(mRaw) * (1.f / ONE);
+}
+
+inline Fixed operator+(Fixed a, Fixed b)
+{
+	return Fixed::fromRaw(a.raw() + b.raw());
+}
+
+inline Fixed operator-(Fixed a, Fixed b)
+{
+	return Fixed::fromRaw(a.raw() - b.raw());
+}
+
+inline Fixed operator*(Fixed a, Fixed b)
+{
+	return Fixed::fromRaw( static_cast<std::int32_t>(static_cast<std::int64_t>(a.raw()) * b.raw() / Fixed::ONE) );
+}
+
+inline Fixed operator/(Fixed a, Fixed b)
+{
+	return Fixed::fromRaw( static_cast<std::int32_t>(static_cast<std::int64_t>(a.raw()) * Fixed::ONE / b.raw()) );
+}
+
+inline Fixed& Fixed::operator*=(Fixed other)
+{
+	return *this = *this * other;
+}
+
+inline bool operator==(Fixed a, Fixed b) { return a.raw() == b.raw(); }
+inline bool operator!=(Fixed a, Fixed b) { return a.raw() != b.raw(); }
+inline bool operator<(Fixed a, Fixed b) { return a.raw() < b.raw(); }
+inline bool operator>(Fixed a, Fixed b) { return a.raw() > b.raw(); }
+inline bool operator<=(Fixed a, Fixed b) { return a.raw() <= b.raw(); }
+inline bool operator>=(Fixed a, Fixed b) { return a.raw() >= b.raw(); }
+
+inline Fixed abs(Fixed value)
+{
+	return value < Fixed() ? -value : value;
+}
+
+/// integer square root, rounded down. \p value has to be below 2^62.
+inline std::uint64_t isqrt(std::uint64_t value)
+{
+	// the double square root is correctly rounded everywhere, but can still be off by one after the
+	// conversion for large values. The correction makes the result exact, so it does not depend on
+	// the floating point unit.
+	std::uint64_t result = static_cast<std::uint64_t>(std::sqrt(static_cast<double>(value)));
+	while(result * result > value)
+		--result;
+	while((result + 1) * (result + 1) <= value)
+		++result;
+	return result;
+}
+
+inline Fixed sqrt(Fixed value)
+{
+	if(value.raw() <= 0)
+		return Fixed();
+	return Fixed::fromRaw( static_cast<std::int32_t>(isqrt(static_cast<std::uint64_t>(value.raw()) << Fixed::FRACTION_BITS)) );
+}
+
+inline FixedVector2 operator+(const FixedVector2& a, const FixedVector2& b)
+{
+	return {a.x + b.x, a.y + b.y};
+}
+
+inline FixedVector2 operator-(const FixedVector2& a, const FixedVector2& b)
+{
+	return {a.x - b.x, a.y - b.y};
+}
+
+inline FixedVector2& operator+=(FixedVector2& a, const FixedVector2& b)
+{
+	a.x += b.x;
+	a.y += b.y;
+	return a;
+}
+
+inline bool operator==(const FixedVector2& a, const FixedVector2& b)
+{
+	return a.x == b.x && a.y == b.y;
+}
+
+inline std::int64_t FixedVector2::lengthSQ() const
+{
+	return static_cast<std::int64_t>(x.raw()) * x.raw() + static_cast<std::int64_t>(y.raw()) * y.raw();
+}
+
+inline Fixed FixedVector2::length() const
+{
+	return Fixed::fromRaw( static_cast<std::int32_t>(isqrt(static_cast<std::uint64_t>(lengthSQ()))) );
+}
+
+inline FixedVector2 FixedVector2::normalise() const
+{
+	Fixed len = length();
+	if(len == Fixed())
+		return *this;
+	return {x / len, y / len};
+}
+
+inline FixedVector2 FixedVector2::scale(Fixed factor) const
+{
+	return {x * factor, y * factor};
+}
+
+inline Fixed FixedVector2::dotProduct(const FixedVector2& other) const
+{
+	return Fixed::fromRaw( static_cast<std::int32_t>(
+			(static_cast<std::int64_t>(x.raw()) * other.x.raw() + static_cast<std::int64_t>(y.raw()) * other.y.raw()) / Fixed::ONE) );
+}
+
+inline FixedVector2 FixedVector2::reflect(const FixedVector2& normal) const
+{
+	Fixed twice_dot = dotProduct(normal) * Fixed::fromInt(2);
+	return *this - normal.scale(twice_dot);
+}
@@ -159,6 +159,28 @@ void IGameLogic::setState(GameLogicState gls)
 	mSquishGround = gls.squishGround;
 	mIsGameRunning = gls.isGameRunning;
 	mIsBallValid = gls.isBallValid;
+	mWinningPlayer = gls.winningPlayer;
+}
+
+void IGameLogic::saveState(GameLogicState& state, ScriptSnapshot& script) const
+{
+	state = getState();
+	saveScriptState(script);
+}
+
+void IGameLogic::restoreState(const GameLogicState& state, const ScriptSnapshot& script)
+{
+	setState(state);
+	mLastError = NO_PLAYER;
+	restoreScriptState(script);
+}
+
+void IGameLogic::saveScriptState(ScriptSnapshot& script) const
+{
+}
+
+void IGameLogic::restoreScriptState(const ScriptSnapshot& script)
+{
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -431,6 +453,9 @@ class LuaGameLogic : public FallbackGameLogic, public IScriptableComponent
 		void OnBallHitsGroundHandler(PlayerSide side) override;
 		void OnGameHandler( const DuelMatchState& state ) override;
 
+		void saveScriptState(ScriptSnapshot& script) const override;
+		void restoreScriptState(const ScriptSnapshot& script) override;
+
 		static LuaGameLogic* getGameLogic(lua_State* state);
 
 	private:
@@ -477,6 +502,8 @@ LuaGameLogic::LuaGameLogic( std::string filename, int score_to_win ) :
 	// now load script file
 	openScript("api");
 	openScript("rules_api");
+	// everything the rules script defines is part of its state
+	markBaseGlobals();
 	openScript("rules/"+mSourceFile);
 
 	lua_getglobal(mState, "SCORE_TO_WIN");
@@ -643,6 +670,16 @@ void LuaGameLogic::OnGameHandler( const DuelMatchState& state )
 	}
 }
 
+void LuaGameLogic::saveScriptState(ScriptSnapshot& script) const
+{
+	saveScriptSnapshot(script);
+}
+
+void LuaGameLogic::restoreScriptState(const ScriptSnapshot& script)
+{
+	restoreScriptSnapshot(script);
+}
+
 LuaGameLogic* LuaGameLogic::getGameLogic(lua_State* state)
 {
 	lua_getglobal(state, "__GAME_LOGIC_POINTER");
@@ -34,6 +34,7 @@ typedef std::unique_ptr<IGameLogic> GameLogicPtr;
 
 struct GameLogicState;
 struct DuelMatchState;
+struct ScriptSnapshot;
 class DuelMatch;
 class Clock;
 struct PlayerInput;
@@ -101,6 +102,13 @@ class IGameLogic: public ObjectCounter<IGameLogic>
 		GameLogicState getState() const;
 		void setState(GameLogicState gls);
 
+		/// \brief saves the complete state of the rules.
+		/// \details In addition to getState, this saves everything a rules script remembers to \p script.
+		void saveState(GameLogicState& state, ScriptSnapshot& script) const;
+		/// restores a state saved by saveState of a game logic with the same rules. Unlike setState,
+		/// this restores the winning player as well.
+		void restoreState(const GameLogicState& state, const ScriptSnapshot& script);
+
 
 		// -----------------------------------------------------------------------------------------
 		// 								Event - Handlers
@@ -201,6 +209,11 @@ class IGameLogic: public ObjectCounter<IGameLogic>
 		/// this function checks whether a player has won the game
 		virtual PlayerSide checkWin() const = 0;
 
+		/// saves the state of the rules script. Rules without script have nothing to save.
+		virtual void saveScriptState(ScriptSnapshot& script) const;
+		/// restores the script state written by saveScriptState
+		virtual void restoreScriptState(const ScriptSnapshot& script);
+
 		/// config parameter: score to win
 		/// lua rules can change it by changing SCORE_TO_WIN variable in the global scope
 		int mScoreToWin;
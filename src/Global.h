@@ -51,7 +51,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 const int BLOBBY_PORT = 1234;
 
 const int BLOBBY_VERSION_MAJOR = 0;
-const int BLOBBY_VERSION_MINOR = 107;
+const int BLOBBY_VERSION_MINOR = 109;
 
 const char AppTitle[] = "Blobby Volley 2 Version 1.1.1";
 const int BASE_RESOLUTION_X = 800;
@@ -77,6 +77,13 @@ enum PlayerSide
 	// and can be used to declare arrays
 };
 
+/// the number format in which the physics of a match is computed
+enum class PhysicBackend
+{
+	FLOAT,			///< PhysicWorld, only deterministic between builds for the same architecture
+	FIXED_POINT		///< FixedPhysicWorld, deterministic on all architectures
+};
+
 /// we need to define this constant to make it compile with strict c++98 mode
 #undef M_PI
 const double M_PI = 3.141592653589793238462643383279;
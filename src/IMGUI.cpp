@@ -1107,6 +1107,11 @@ bool IMGUI::usingCursor() const
 	return mUsingCursor;
 }
 
+bool IMGUI::hasFocus() const
+{
+	return mActiveButton != -1;
+}
+
 const TextManager& IMGUI::textMgr() const {
 	return *mTextManager;
 }
@@ -95,6 +95,8 @@ class IMGUI : public ObjectCounter<IMGUI>
 		bool doBlob(int id, const Vector2& position, const Color& col);
 
 		bool usingCursor() const;
+		/// whether a widget is highlighted for keyboard navigation, i.e. the arrow keys are used by the gui
+		bool hasFocus() const;
 		void doInactiveMode(bool inactive) { mInactive = inactive; }
 
 		int getNextId() { return mIdCounter++; };
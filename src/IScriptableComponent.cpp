@@ -7,11 +7,17 @@
 #include "DuelMatchState.h"
 #include "FileRead.h"
 #include "PhysicWorld.h"
+#include "BallTrajectory.h"
+#include "TrajectoryCache.h"
 
+#include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 IScriptableComponent::IScriptableComponent() :
-		mState(luaL_newstate()), mDummyWorld(new PhysicWorld())
+		mState(luaL_newstate()), mDummyWorld(new PhysicWorld()), mScriptGlobals(LUA_NOREF)
 {
 	// register this in the lua registry
 	lua_pushliteral(mState, "__C++_ScriptComponent__");
@@ -148,6 +154,12 @@ struct IScriptableComponent::Access
 		auto sc = getScriptComponent( state );
 		return sc->mDummyWorld.get();
 	}
+
+	static TrajectoryCache* getCache( lua_State* state )
+	{
+		auto sc = getScriptComponent( state );
+		return sc->mTrajectoryCache.get();
+	}
 };
 
 inline const DuelMatchState getMatchState( lua_State* state )  {
@@ -155,6 +167,14 @@ inline const DuelMatchState getMatchState( lua_State* state )  {
 	return sc->getMatchState();
 }
 inline PhysicWorld* getWorld( lua_State* s )  { return IScriptableComponent::Access::getWorld(s); }
+inline TrajectoryCache* getCache( lua_State* s )  { return IScriptableComponent::Access::getCache(s); }
+
+int lua_pushresult(lua_State* state, const TrajectoryCache::Result& result)
+{
+	int ret = lua_pushvector(state, result.position, VectorType::POSITION);
+	ret += lua_pushvector(state, result.velocity, VectorType::VELOCITY);
+	return ret;
+}
 
 // standard lua functions
 int get_ball_pos(lua_State* state)
@@ -239,17 +259,24 @@ int simulate_steps( lua_State* state )
 	float vy = lua_tonumber( state, 5);
 	lua_pop( state, 5);
 
-	world->setBallPosition( Vector2{x, 600 - y} );
-	world->setBallVelocity( Vector2{vx, -vy});
-	for(int i = 0; i < steps; ++i)
+	const Vector2 position{x, 600 - y};
+	const Vector2 velocity{vx, -vy};
+	TrajectoryCache* cache = getCache( state );
+	const TrajectoryCache::Key key{TrajectoryCache::Query::SIMULATE, steps, Vector2{x, y}, Vector2{vx, vy}};
+	if( cache )
 	{
-		// set ball valid to false to ignore blobby bounces
-		world->step(PlayerInput(), PlayerInput(), false, true);
+		if( const auto* result = cache->find(key) )
+			return lua_pushresult(state, *result);
 	}
 
-	int ret = lua_pushvector(state, world->getBallPosition(), VectorType::POSITION);
-	ret += lua_pushvector(state, world->getBallVelocity(), VectorType::VELOCITY);
-	return ret;
+	// the ball is not valid, so blobby bounces are ignored
+	BallTrajectory trajectory{*world, position, velocity};
+	trajectory.advance(steps);
+
+	const TrajectoryCache::Result result{steps, trajectory.getPosition(), trajectory.getVelocity()};
+	if( cache )
+		cache->insert(key, result);
+	return lua_pushresult(state, result);
 }
 
 int simulate_until(lua_State* state)
@@ -274,31 +301,37 @@ int simulate_until(lua_State* state)
 	}
 	const bool init = ival < coordinate;
 
-	// set up the world
-	world->setBallPosition( Vector2{x, 600 - y} );
-	world->setBallVelocity( Vector2{vx, -vy});
+	const Vector2 position{x, 600 - y};
+	const Vector2 velocity{vx, -vy};
+	TrajectoryCache* cache = getCache( state );
+	const auto query = axis == "x" ? TrajectoryCache::Query::UNTIL_X : TrajectoryCache::Query::UNTIL_Y;
+	const TrajectoryCache::Key key{query, coordinate, Vector2{x, y}, Vector2{vx, vy}};
+	const TrajectoryCache::Result* cached = cache ? cache->find(key) : nullptr;
+	if( cached )
+	{
+		lua_pushinteger(state, cached->steps);
+		return 1 + lua_pushresult(state, *cached);
+	}
+
+	// the ball is not valid, so blobby bounces are ignored
+	BallTrajectory trajectory{*world, position, velocity};
 
 	int steps = 0;
-	while(coordinate != ival && steps < 75 * 5)
+	if(coordinate != ival)
 	{
-		steps++;
-		// set ball valid to false to ignore blobby bounces
-		world->step(PlayerInput(), PlayerInput(), false, true);
-		// check for the condition
-		auto pos = world->getBallPosition();
-		float v = axis == "x" ? pos.x : 600 - pos.y;
-		if( (v < coordinate) != init )
-			break;
+		auto axis_id = axis == "x" ? BallTrajectory::Axis::X : BallTrajectory::Axis::Y;
+		steps = trajectory.advanceUntil(axis_id, coordinate, init, 75 * 5);
 	}
 	// indicate failure
 	if(steps == 75 * 5)
 		steps = -1;
 
+	const TrajectoryCache::Result result{steps, trajectory.getPosition(), trajectory.getVelocity()};
+	if( cache )
+		cache->insert(key, result);
+
 	lua_pushinteger(state, steps);
-	int ret = 1;
-	ret += lua_pushvector(state, world->getBallPosition(), VectorType::POSITION);
-	ret += lua_pushvector(state, world->getBallVelocity(), VectorType::VELOCITY);
-	return ret;
+	return 1 + lua_pushresult(state, result);
 }
 
 void IScriptableComponent::setGameFunctions()
@@ -321,6 +354,306 @@ const DuelMatchState& IScriptableComponent::getMatchState() const
 	return mCachedState;
 }
 
+void IScriptableComponent::setTrajectoryCache(std::shared_ptr<TrajectoryCache> cache)
+{
+	mTrajectoryCache = std::move(cache);
+}
+
 void IScriptableComponent::setMatchState(const DuelMatchState& state) {
 	mCachedState = state;
-}
\ No newline at end of file
+}
+
+// saving and restoring of global variables
+
+namespace
+{
+	// each saved value starts with one of these tags. Tables are followed by their key/value pairs
+	// and TAG_END.
+	enum ValueTag : unsigned char
+	{
+		TAG_END,
+		TAG_FALSE,
+		TAG_TRUE,
+		TAG_INTEGER,
+		TAG_NUMBER,
+		TAG_STRING,
+		TAG_TABLE
+	};
+
+	// deeper nested tables are most likely cyclic
+	const int MAX_TABLE_DEPTH = 16;
+
+	const char* const INVALID_DATA = "invalid saved lua variables";
+
+	bool isSavable(int type)
+	{
+		return type == LUA_TBOOLEAN || type == LUA_TNUMBER || type == LUA_TSTRING || type == LUA_TTABLE;
+	}
+
+	template<class T>
+	void appendRaw(std::vector<unsigned char>& buffer, T value)
+	{
+		const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	void saveValue(lua_State* state, int index, std::vector<unsigned char>& buffer, int depth)
+	{
+		switch(lua_type(state, index))
+		{
+			case LUA_TBOOLEAN:
+				buffer.push_back( lua_toboolean(state, index) ? TAG_TRUE : TAG_FALSE );
+				break;
+			case LUA_TNUMBER:
+				// integers and floats are different in lua 5.3, e.g. when converted to strings
+				if(lua_isinteger(state, index))
+				{
+					buffer.push_back( TAG_INTEGER );
+					appendRaw( buffer, lua_tointeger(state, index) );
+				}
+				else
+				{
+					buffer.push_back( TAG_NUMBER );
+					appendRaw( buffer, lua_tonumber(state, index) );
+				}
+				break;
+			case LUA_TSTRING:
+			{
+				std::size_t length;
+				const char* string = lua_tolstring(state, index, &length);
+				buffer.push_back( TAG_STRING );
+				appendRaw( buffer, std::uint32_t(length) );
+				buffer.insert( buffer.end(), string, string + length );
+				break;
+			}
+			case LUA_TTABLE:
+			{
+				if(depth >= MAX_TABLE_DEPTH)
+					BOOST_THROW_EXCEPTION( std::runtime_error("lua table nested too deeply to be saved") );
+
+				luaL_checkstack(state, 2, "saving lua table");
+				int table = lua_absindex(state, index);
+				buffer.push_back( TAG_TABLE );
+				lua_pushnil(state);
+				while(lua_next(state, table))
+				{
+					int key_type = lua_type(state, -2);
+					if(key_type != LUA_TTABLE && isSavable(key_type) && isSavable(lua_type(state, -1)))
+					{
+						saveValue(state, -2, buffer, depth + 1);
+						saveValue(state, -1, buffer, depth + 1);
+					}
+					lua_pop(state, 1);
+				}
+				buffer.push_back( TAG_END );
+				break;
+			}
+			default:
+				assert(0);
+		}
+	}
+
+	class ValueReader
+	{
+		public:
+			ValueReader(const unsigned char* data, std::size_t size) : mPosition(data), mEnd(data + size)
+			{
+			}
+
+			bool atEnd() const
+			{
+				return mPosition == mEnd;
+			}
+
+			/// pushes the next value onto the stack. Returns false, without pushing anything, at the end of a table.
+			bool pushValue(lua_State* state, int depth)
+			{
+				switch( read<unsigned char>() )
+				{
+					case TAG_END:
+						return false;
+					case TAG_FALSE:
+						lua_pushboolean(state, 0);
+						return true;
+					case TAG_TRUE:
+						lua_pushboolean(state, 1);
+						return true;
+					case TAG_INTEGER:
+						lua_pushinteger(state, read<lua_Integer>());
+						return true;
+					case TAG_NUMBER:
+						lua_pushnumber(state, read<lua_Number>());
+						return true;
+					case TAG_STRING:
+					{
+						std::size_t length = read<std::uint32_t>();
+						require(length);
+						lua_pushlstring(state, reinterpret_cast<const char*>(mPosition), length);
+						mPosition += length;
+						return true;
+					}
+					case TAG_TABLE:
+						if(depth >= MAX_TABLE_DEPTH)
+							break;
+						luaL_checkstack(state, 3, "restoring lua table");
+						lua_newtable(state);
+						while( pushValue(state, depth + 1) )
+						{
+							if( !pushValue(state, depth + 1) )
+								BOOST_THROW_EXCEPTION( std::runtime_error(INVALID_DATA) );
+							lua_rawset(state, -3);
+						}
+						return true;
+				}
+				BOOST_THROW_EXCEPTION( std::runtime_error(INVALID_DATA) );
+			}
+
+		private:
+			void require(std::size_t bytes) const
+			{
+				if(std::size_t(mEnd - mPosition) < bytes)
+					BOOST_THROW_EXCEPTION( std::runtime_error(INVALID_DATA) );
+			}
+
+			template<class T>
+			T read()
+			{
+				require(sizeof(T));
+				T value;
+				std::memcpy(&value, mPosition, sizeof(T));
+				mPosition += sizeof(T);
+				return value;
+			}
+
+			const unsigned char* mPosition;
+			const unsigned char* mEnd;
+	};
+
+	// adds the string at index \p name to the list of global names at index \p names. The list contains
+	// the names at 1 ... n, and the position of each name under the name itself.
+	void addGlobalName(lua_State* state, int names, int name)
+	{
+		lua_pushvalue(state, name);
+		if(lua_rawget(state, names) == LUA_TNIL)
+		{
+			lua_Integer index = lua_rawlen(state, names) + 1;
+			lua_pushvalue(state, name);
+			lua_rawseti(state, names, index);
+			lua_pushvalue(state, name);
+			lua_pushinteger(state, index);
+			lua_rawset(state, names);
+		}
+		lua_pop(state, 1);
+	}
+
+	// __newindex of the global table. It is only called for new globals, and adds their names to the
+	// list in its upvalue.
+	int recordNewGlobal(lua_State* state)
+	{
+		if(lua_type(state, 2) == LUA_TSTRING)
+			addGlobalName(state, lua_upvalueindex(1), 2);
+		lua_rawset(state, 1);
+		return 0;
+	}
+}
+
+void IScriptableComponent::markBaseGlobals()
+{
+	assert(mScriptGlobals == LUA_NOREF);
+
+	// names of the globals that are created from now on
+	lua_newtable(mState);
+	lua_pushvalue(mState, -1);
+	mScriptGlobals = luaL_ref(mState, LUA_REGISTRYINDEX);
+
+	// so snapshots do not have to go through all the api functions, new globals are recorded
+	// when they are created
+	lua_newtable(mState);
+	lua_insert(mState, -2);
+	lua_pushcclosure(mState, recordNewGlobal, 1);
+	lua_setfield(mState, -2, "__newindex");
+	lua_pushglobaltable(mState);
+	lua_insert(mState, -2);
+	lua_setmetatable(mState, -2);
+	lua_pop(mState, 1);
+}
+
+void IScriptableComponent::saveScriptSnapshot(ScriptSnapshot& snapshot) const
+{
+	assert(mScriptGlobals != LUA_NOREF);
+
+	snapshot.matchState = mCachedState;
+	std::vector<unsigned char>& buffer = snapshot.globals;
+	buffer.clear();
+
+	int top = lua_gettop(mState);
+	lua_pushglobaltable(mState);
+	lua_rawgeti(mState, LUA_REGISTRYINDEX, mScriptGlobals);
+	try
+	{
+		lua_Integer count = lua_rawlen(mState, top + 2);
+		for(lua_Integer i = 1; i <= count; ++i)
+		{
+			lua_rawgeti(mState, top + 2, i);
+			lua_pushvalue(mState, -1);
+			if( isSavable(lua_rawget(mState, top + 1)) )
+			{
+				saveValue(mState, -2, buffer, 0);
+				saveValue(mState, -1, buffer, 0);
+			}
+			lua_pop(mState, 2);
+		}
+	}
+	catch(...)
+	{
+		lua_settop(mState, top);
+		throw;
+	}
+	lua_settop(mState, top);
+}
+
+void IScriptableComponent::restoreScriptSnapshot(const ScriptSnapshot& snapshot)
+{
+	assert(mScriptGlobals != LUA_NOREF);
+
+	mCachedState = snapshot.matchState;
+
+	int top = lua_gettop(mState);
+	lua_pushglobaltable(mState);
+	lua_rawgeti(mState, LUA_REGISTRYINDEX, mScriptGlobals);
+
+	// remove the current variables, so variables that have been created after saving disappear.
+	lua_Integer count = lua_rawlen(mState, top + 2);
+	for(lua_Integer i = 1; i <= count; ++i)
+	{
+		lua_rawgeti(mState, top + 2, i);
+		lua_pushvalue(mState, -1);
+		if( isSavable(lua_rawget(mState, top + 1)) )
+		{
+			lua_pushvalue(mState, -2);
+			lua_pushnil(mState);
+			lua_rawset(mState, top + 1);
+		}
+		lua_pop(mState, 2);
+	}
+
+	ValueReader reader(snapshot.globals.data(), snapshot.globals.size());
+	try
+	{
+		while(!reader.atEnd())
+		{
+			if( !reader.pushValue(mState, 0) || lua_type(mState, -1) != LUA_TSTRING || !reader.pushValue(mState, 0) )
+				BOOST_THROW_EXCEPTION( std::runtime_error(INVALID_DATA) );
+
+			// the snapshot may come from another component, which created variables this one does not know yet
+			addGlobalName(mState, top + 2, top + 3);
+			lua_rawset(mState, top + 1);
+		}
+	}
+	catch(...)
+	{
+		lua_settop(mState, top);
+		throw;
+	}
+	lua_settop(mState, top);
+}
@@ -22,11 +22,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <string>
 #include <memory>
+#include <vector>
 #include "DuelMatchState.h"
 
 struct lua_State;
 class DuelMatch;
 class PhysicWorld;
+class TrajectoryCache;
 
 struct ScriptException : public std::exception
 {
@@ -35,6 +37,17 @@ struct ScriptException : public std::exception
 };
 
 
+/*! \struct ScriptSnapshot
+	\brief state of a lua script, as saved by IScriptableComponent::saveScriptSnapshot.
+*/
+struct ScriptSnapshot
+{
+	/// the match state the script currently sees
+	DuelMatchState matchState;
+	/// serialised global variables of the script
+	std::vector<unsigned char> globals;
+};
+
 /*! \class IScriptableComponent
 	\brief Base class for lua scripted objects.
 	\details Use this class as base class for objects that support lua scripting. It defines some commonly used functions to make
@@ -63,13 +76,29 @@ class IScriptableComponent
 		void setGameFunctions();
 
 		void setMatchState(const DuelMatchState& state);
+		/// the results of the simulate functions are stored in \p cache, if it is not null
+		void setTrajectoryCache(std::shared_ptr<TrajectoryCache> cache);
+
+		/// remembers the global variables that exist now, e.g. the api functions and constants.
+		/// Snapshots only contain the variables that are created later on.
+		void markBaseGlobals();
+		/// saves the match state seen by the script and all global variables that did not exist when
+		/// markBaseGlobals was called. Of those, only booleans, numbers, strings and tables are saved,
+		/// functions and userdata are skipped.
+		void saveScriptSnapshot(ScriptSnapshot& snapshot) const;
+		/// restores a snapshot saved by a component that loaded the same scripts
+		void restoreScriptSnapshot(const ScriptSnapshot& snapshot);
 
 		lua_State* mState;
 
 	private:
 		// we save a dummy physic world here to do simulations
 		std::unique_ptr<PhysicWorld> mDummyWorld;
+		std::shared_ptr<TrajectoryCache> mTrajectoryCache;
 
 		DuelMatchState mCachedState;
+
+		// registry reference to the set of names of the globals created after markBaseGlobals
+		int mScriptGlobals;
 };
 
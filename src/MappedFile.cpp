@@ -0,0 +1,107 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "MappedFile.h"
+
+/* includes */
+#include <algorithm>
+
+#include <physfs.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "FileRead.h"
+
+/* implementation */
+
+MappedFile::MappedFile(const std::string& filename) : mData(nullptr), mSize(0), mMapped(false)
+{
+	const char* dir = PHYSFS_getRealDir(filename.c_str());
+	if(dir && map(std::string(dir) + PHYSFS_getDirSeparator() + filename))
+		return;
+
+	// fallback: file is inside an archive, or could not be mapped
+	FileRead file(filename);
+	mBuffer = file.readRawBytes(file.length());
+	mData = reinterpret_cast<const unsigned char*>(mBuffer.data());
+	mSize = mBuffer.size();
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+	if(mMapped)
+		munmap(const_cast<unsigned char*>(mData), mSize);
+#endif
+}
+
+void MappedFile::prefetch(std::size_t offset, std::size_t length) const
+{
+	if(!mMapped || offset >= mSize)
+		return;
+	length = std::min(length, mSize - offset);
+
+#ifndef _WIN32
+	// madvise needs a page aligned start
+	std::size_t page = sysconf(_SC_PAGESIZE);
+	std::size_t start = offset - offset % page;
+	madvise(const_cast<unsigned char*>(mData) + start, length + offset - start, MADV_WILLNEED);
+
+	// the advice is asynchronous, touching the pages makes sure they are actually read
+	volatile unsigned char sink = 0;
+	for(std::size_t position = start; position < offset + length; position += page)
+		sink = sink ^ mData[position];
+#endif
+}
+
+bool MappedFile::map(const std::string& path)
+{
+#ifndef _WIN32
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat info;
+	if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+	if(address == MAP_FAILED)
+		return false;
+
+	mData = static_cast<const unsigned char*>(address);
+	mSize = info.st_size;
+	mMapped = true;
+	return true;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,64 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "BlobbyDebug.h"
+
+/**
+	\class MappedFile
+	\brief read-only view of the whole content of a file.
+	\details If the file lies in a native directory of the search path, it is mapped into memory,
+			so only the parts that are actually accessed are read from disk. Otherwise (files inside
+			archives, platforms without mmap) the file is read into a buffer as a fallback.
+			The file name is a physfs path, like for FileRead.
+*/
+class MappedFile : public ObjectCounter<MappedFile>
+{
+	public:
+		/// \brief opens and maps the file
+		/// \throw FileLoadException if the file could not be opened
+		explicit MappedFile(const std::string& filename);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const unsigned char* data() const { return mData; }
+		std::size_t size() const { return mSize; }
+		/// true if the content is memory mapped, false if the read fallback was used
+		bool isMapped() const { return mMapped; }
+
+		/// \brief reads a range of the file into memory ahead of use.
+		/// \details Only has an effect for mapped files. Can be called from another thread.
+		void prefetch(std::size_t offset, std::size_t length) const;
+
+	private:
+		bool map(const std::string& path);
+
+		const unsigned char* mData;
+		std::size_t mSize;
+		bool mMapped;
+		std::vector<char> mBuffer;
+};
@@ -50,5 +50,49 @@ struct MatchEvent
 	{
 
 	}
+
+	// uninitialized, for the storage of MatchEventBuffer
+	MatchEvent() = default;
+};
+
+/*! \class MatchEventBuffer
+	\brief the events of a single frame
+	\details Stores the events in a fixed array, so collecting them never allocates. One frame has at
+			most a handful of events; if there are more than CAPACITY, the additional ones are dropped
+			and counted, see getDropped.
+*/
+class MatchEventBuffer
+{
+	public:
+		static const int CAPACITY = 32;
+
+		/// adds \p event, returns false if the buffer is full
+		bool push(const MatchEvent& event)
+		{
+			if(mSize == CAPACITY)
+			{
+				++mDropped;
+				return false;
+			}
+			mEvents[mSize++] = event;
+			return true;
+		}
+
+		void clear() { mSize = 0; }
+
+		/// number of events that did not fit into the buffer, over its whole lifetime
+		int getDropped() const { return mDropped; }
+
+		int size() const { return mSize; }
+		bool empty() const { return mSize == 0; }
+
+		const MatchEvent& operator[](int index) const { return mEvents[index]; }
+		const MatchEvent* begin() const { return mEvents; }
+		const MatchEvent* end() const { return mEvents + mSize; }
+
+	private:
+		MatchEvent mEvents[CAPACITY];
+		int mSize = 0;
+		int mDropped = 0;
 };
 
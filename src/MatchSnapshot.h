@@ -0,0 +1,56 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include "Global.h"
+#include "FixedPoint.h"
+#include "PhysicState.h"
+#include "DuelMatchState.h"
+#include "IScriptableComponent.h"
+
+/*! \struct MatchSnapshot
+	\brief everything needed to continue a DuelMatch exactly from a certain step.
+	\details DuelMatchState only contains what is sent over the network and saved in replays. A snapshot
+			additionally holds the blob animation speeds, the exact fixed point state and everything a
+			lua rules script remembers in global variables. The script variables are serialised into
+			a buffer which keeps its capacity, so saving into the same snapshot again does not
+			allocate memory. A snapshot can only be restored into a match with the same rules and
+			physic backend. The game clock, which follows the real time, is not part of it.
+			Snapshots are created and restored by DuelMatch::saveSnapshot and DuelMatch::restoreSnapshot.
+*/
+struct MatchSnapshot
+{
+	/// \param script_capacity bytes reserved for the script variables
+	explicit MatchSnapshot(std::size_t script_capacity = 256)
+	{
+		script.globals.reserve(script_capacity);
+	}
+
+	DuelMatchState state;
+	float blobAnimationSpeed[MAX_PLAYERS] = {0, 0};
+
+	// these are only used with PhysicBackend::FIXED_POINT
+	FixedPhysicState fixedState;
+	Fixed fixedAnimationSpeed[MAX_PLAYERS];
+
+	/// state of the rules script, empty for rules without script
+	ScriptSnapshot script;
+};
@@ -67,3 +67,107 @@ void PhysicState::swapSides()
 	ballAngularVelocity = -ballAngularVelocity;
 	ballRotation = 2*M_PI - ballRotation;
 }
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//  				fixed point physic state
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+namespace
+{
+	// calls func for every number of state, in serialisation order
+	template<class State, class Func>
+	void forEachNumber(State& state, Func func)
+	{
+		for(PlayerSide side : {LEFT_PLAYER, RIGHT_PLAYER})
+		{
+			func(state.blobPosition[side].x);
+			func(state.blobPosition[side].y);
+			func(state.blobVelocity[side].x);
+			func(state.blobVelocity[side].y);
+		}
+		func(state.blobState[LEFT_PLAYER]);
+		func(state.blobState[RIGHT_PLAYER]);
+
+		func(state.ballPosition.x);
+		func(state.ballPosition.y);
+		func(state.ballVelocity.x);
+		func(state.ballVelocity.y);
+		func(state.ballRotation);
+		func(state.ballAngularVelocity);
+	}
+}
+
+// the fixed point numbers are written as unsigned integers, so we cannot use
+// USER_SERIALIZER_IMPLEMENTATION_HELPER here, which needs the same code for reading and writing.
+template<>
+void UserSerializer<FixedPhysicState>::serialize( GenericOut& out, const FixedPhysicState& value)
+{
+	forEachNumber(value, [&out](const Fixed& number)
+	{
+		out.uint32( static_cast<unsigned int>(number.raw()) );
+	});
+}
+
+template<>
+void UserSerializer<FixedPhysicState>::serialize( GenericIn& in, FixedPhysicState& value)
+{
+	forEachNumber(value, [&in](Fixed& number)
+	{
+		unsigned int raw;
+		in.uint32( raw );
+		number = Fixed::fromRaw( static_cast<std::int32_t>(raw) );
+	});
+}
+
+PhysicState FixedPhysicState::toPhysicState() const
+{
+	PhysicState state;
+	for(PlayerSide side : {LEFT_PLAYER, RIGHT_PLAYER})
+	{
+		state.blobPosition[side] = Vector2(blobPosition[side].x.toFloat(), blobPosition[side].y.toFloat());
+		state.blobVelocity[side] = Vector2(blobVelocity[side].x.toFloat(), blobVelocity[side].y.toFloat());
+		state.blobState[side] = blobState[side].toFloat();
+	}
+
+	state.ballPosition = Vector2(ballPosition.x.toFloat(), ballPosition.y.toFloat());
+	state.ballVelocity = Vector2(ballVelocity.x.toFloat(), ballVelocity.y.toFloat());
+	state.ballRotation = ballRotation.toFloat();
+	state.ballAngularVelocity = ballAngularVelocity.toFloat();
+	return state;
+}
+
+FixedPhysicState FixedPhysicState::fromPhysicState(const PhysicState& state)
+{
+	FixedPhysicState fixed;
+	for(PlayerSide side : {LEFT_PLAYER, RIGHT_PLAYER})
+	{
+		fixed.blobPosition[side] = FixedVector2(Fixed::fromFloat(state.blobPosition[side].x), Fixed::fromFloat(state.blobPosition[side].y));
+		fixed.blobVelocity[side] = FixedVector2(Fixed::fromFloat(state.blobVelocity[side].x), Fixed::fromFloat(state.blobVelocity[side].y));
+		fixed.blobState[side] = Fixed::fromFloat(state.blobState[side]);
+	}
+
+	fixed.ballPosition = FixedVector2(Fixed::fromFloat(state.ballPosition.x), Fixed::fromFloat(state.ballPosition.y));
+	fixed.ballVelocity = FixedVector2(Fixed::fromFloat(state.ballVelocity.x), Fixed::fromFloat(state.ballVelocity.y));
+	fixed.ballRotation = Fixed::fromFloat(state.ballRotation);
+	fixed.ballAngularVelocity = Fixed::fromFloat(state.ballAngularVelocity);
+	return fixed;
+}
+
+void FixedPhysicState::swapSides()
+{
+	const Fixed right_plane = Fixed::fromFloat(RIGHT_PLANE);
+	const Fixed two_pi = Fixed::fromFloat(2 * M_PI);
+
+	blobPosition[LEFT_PLAYER].x = right_plane - blobPosition[LEFT_PLAYER].x;
+	blobPosition[RIGHT_PLAYER].x = right_plane - blobPosition[RIGHT_PLAYER].x;
+	blobVelocity[LEFT_PLAYER].x = -blobVelocity[LEFT_PLAYER].x;
+	blobVelocity[RIGHT_PLAYER].x = -blobVelocity[RIGHT_PLAYER].x;
+	std::swap(blobPosition[LEFT_PLAYER], blobPosition[RIGHT_PLAYER]);
+	std::swap(blobVelocity[LEFT_PLAYER], blobVelocity[RIGHT_PLAYER]);
+	std::swap(blobState[LEFT_PLAYER], blobState[RIGHT_PLAYER]);
+
+	ballPosition.x = right_plane - ballPosition.x;
+	ballVelocity.x = -ballVelocity.x;
+	ballAngularVelocity = -ballAngularVelocity;
+	ballRotation = two_pi - ballRotation;
+}
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "Global.h"
 #include "Vector.h"
+#include "FixedPoint.h"
 #include "GenericIOFwd.h"
 
 namespace RakNet
@@ -42,3 +43,26 @@ struct PhysicState
 
 	void swapSides();
 };
+
+/*! \brief physic state of the fixed point physics
+	\details Contains the same values as PhysicState. The serialisation writes the raw integers, so the
+			state can be compared and transferred between machines without any rounding.
+*/
+struct FixedPhysicState
+{
+	FixedVector2 blobPosition[MAX_PLAYERS];
+	FixedVector2 blobVelocity[MAX_PLAYERS];
+	Fixed   blobState[MAX_PLAYERS];
+
+	FixedVector2 ballPosition;
+	FixedVector2 ballVelocity;
+	Fixed   ballRotation;
+	Fixed   ballAngularVelocity;
+
+	/// the state as floats. This is exact for all values below 1024.
+	PhysicState toPhysicState() const;
+	/// rounds all values of \p state to the nearest fixed point numbers
+	static FixedPhysicState fromPhysicState(const PhysicState& state);
+
+	void swapSides();
+};
@@ -22,24 +22,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "PhysicWorld.h"
 
 /* includes */
-#include <utility>
-
 #include "GameConstants.h"
 #include "MatchEvents.h"
+#include "DeterministicMath.h"
 
 /* implementation */
-// Gamefeeling relevant constants:
-const float BLOBBY_ANIMATION_SPEED = 0.5;
-
-// helper function for setting FPU precision
-inline short set_fpu_single_precision();
-void reset_fpu_flags(short flags);
 
 PhysicWorld::PhysicWorld()
 : mBallPosition(Vector2(200, STANDARD_BALL_HEIGHT))
 , mBallRotation(0)
 , mBallAngularVelocity(STANDARD_BALL_ANGULAR_VELOCITY)
-, mCallback( [](const MatchEvent& me) {} )
 {
 	mCurrentBlobbyAnimationSpeed[LEFT_PLAYER] = 0.0;
 	mCurrentBlobbyAnimationSpeed[RIGHT_PLAYER] = 0.0;
@@ -53,6 +45,12 @@ PhysicWorld::PhysicWorld()
 
 PhysicWorld::~PhysicWorld() = default;
 
+inline void PhysicWorld::emitEvent( const MatchEvent& event )
+{
+	if(mEventSink)
+		mEventSink->push(event);
+}
+
 bool PhysicWorld::blobHitGround(PlayerSide player) const
 {
 	if (player == LEFT_PLAYER || player == RIGHT_PLAYER)
@@ -104,6 +102,16 @@ float PhysicWorld::getBlobState(PlayerSide player) const
 	return mBlobState[player];
 }
 
+float PhysicWorld::getBlobAnimationSpeed(PlayerSide player) const
+{
+	return mCurrentBlobbyAnimationSpeed[player];
+}
+
+void PhysicWorld::setBlobAnimationSpeed(PlayerSide player, float speed)
+{
+	mCurrentBlobbyAnimationSpeed[player] = speed;
+}
+
 // Blobby animation methods
 void PhysicWorld::blobbyAnimationStep(PlayerSide player)
 {
@@ -203,7 +211,7 @@ bool PhysicWorld::handleBlobbyBallCollision(PlayerSide player)
 	mBallVelocity = mBallVelocity.scale(BALL_COLLISION_VELOCITY);
 	mBallPosition += mBallVelocity;
 
-	mCallback( MatchEvent{MatchEvent::BALL_HIT_BLOB, player, intensity} );
+	emitEvent( MatchEvent{MatchEvent::BALL_HIT_BLOB, player, intensity} );
 
 	return true;
 }
@@ -277,7 +285,7 @@ void PhysicWorld::handleBallWorldCollisions()
 		mBallVelocity = mBallVelocity.reflectY();
 		mBallVelocity = mBallVelocity.scale(0.95);
 		mBallPosition.y = GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS;
-		mCallback( MatchEvent{MatchEvent::BALL_HIT_GROUND, mBallPosition.x > NET_POSITION_X ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
+		emitEvent( MatchEvent{MatchEvent::BALL_HIT_GROUND, mBallPosition.x > NET_POSITION_X ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
 	}
 
 	// Border Collision
@@ -286,14 +294,14 @@ void PhysicWorld::handleBallWorldCollisions()
 		mBallVelocity = mBallVelocity.reflectX();
 		// set the ball's position
 		mBallPosition.x = LEFT_PLANE + BALL_RADIUS;
-		mCallback( MatchEvent{MatchEvent::BALL_HIT_WALL, LEFT_PLAYER, 0} );
+		emitEvent( MatchEvent{MatchEvent::BALL_HIT_WALL, LEFT_PLAYER, 0} );
 	}
 	else if (mBallPosition.x + BALL_RADIUS >= RIGHT_PLANE && mBallVelocity.x > 0.0)
 	{
 		mBallVelocity = mBallVelocity.reflectX();
 		// set the ball's position
 		mBallPosition.x = RIGHT_PLANE - BALL_RADIUS;
-		mCallback( MatchEvent{MatchEvent::BALL_HIT_WALL, RIGHT_PLAYER, 0} );
+		emitEvent( MatchEvent{MatchEvent::BALL_HIT_WALL, RIGHT_PLAYER, 0} );
 	}
 	else if (mBallPosition.y > NET_SPHERE_POSITION &&
 			fabs(mBallPosition.x - NET_POSITION_X) < BALL_RADIUS + NET_RADIUS)
@@ -303,7 +311,7 @@ void PhysicWorld::handleBallWorldCollisions()
 		// set the ball's position so that it touches the net
 		mBallPosition.x = NET_POSITION_X + (right ? (BALL_RADIUS + NET_RADIUS) : (-BALL_RADIUS - NET_RADIUS));
 
-		mCallback( MatchEvent{MatchEvent::BALL_HIT_NET, right ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
+		emitEvent( MatchEvent{MatchEvent::BALL_HIT_NET, right ? RIGHT_PLAYER : LEFT_PLAYER, 0} );
 	}
 	else
 	{
@@ -334,7 +342,7 @@ void PhysicWorld::handleBallWorldCollisions()
 			// pushes the ball out of the net
 			mBallPosition = (Vector2(NET_POSITION_X, NET_SPHERE_POSITION) - normal * (NET_RADIUS + BALL_RADIUS));
 
-			mCallback( MatchEvent{MatchEvent::BALL_HIT_NET_TOP, NO_PLAYER, 0} );
+			emitEvent( MatchEvent{MatchEvent::BALL_HIT_NET_TOP, NO_PLAYER, 0} );
 		}
 		// mBallVelocity = mBallVelocity.reflect( Vector2( mBallPosition, Vector2 (NET_POSITION_X, temp) ).normalise()).scale(0.75);
 	}
@@ -398,47 +406,7 @@ void PhysicWorld::setState(const PhysicState& ps)
 	mBallAngularVelocity = ps.ballAngularVelocity;
 }
 
-void PhysicWorld::setEventCallback( event_callback_fn cb )
-{
-	mCallback = std::move(cb);
-}
-
-inline short set_fpu_single_precision()
-{
-	short fl = 0;
-	#if defined(i386) || defined(__x86_64) // We need to set a precision for diverse x86 hardware
-	#if defined(__GNUC__)
-		volatile short cw;
-		asm volatile ("fstcw %0" : "=m"(cw));
-		fl = cw;
-		cw = cw & 0xfcff;
-		asm volatile ("fldcw %0" :: "m"(cw));
-	#elif defined(_MSC_VER)
-		short cw;
-		asm fstcw cw;
-		fl = cw;
-		cw = cw & 0xfcff;
-		asm fldcw cw;
-	#endif
-	#elif (defined _MSC_VER)
-	#pragma message ( "FPU precision may not conform to IEEE 754" )
-	#else
-	#warning FPU precision may not conform to IEEE 754
-	#endif
-	return fl;
-}
-
-void reset_fpu_flags(short flags)
+void PhysicWorld::setEventSink( MatchEventBuffer* sink )
 {
-	#if defined(i386) || defined(__x86_64) // We need to set a precision for diverse x86 hardware
-	#if defined(__GNUC__)
-		asm volatile ("fldcw %0" :: "m"(flags));
-	#elif defined(_MSC_VER)
-		asm fldcw flags;
-	#endif
-	#elif (defined _MSC_VER)
-	#pragma message ( "FPU precision may not conform to IEEE 754" )
-	#else
-	#warning FPU precision may not conform to IEEE 754
-	#endif
+	mEventSink = sink;
 }
@@ -26,7 +26,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "BlobbyDebug.h"
 #include "PhysicState.h"
 #include "MatchEvents.h"
-#include <functional>	// for std::function used for the callback
 
 /*! \brief blobby world
 	\details This class encapsulates the physical world where blobby happens. It manages the two blobs,
@@ -34,15 +33,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 class PhysicWorld : public ObjectCounter<PhysicWorld>
 {
-	// callback function type
-	typedef std::function<void(MatchEvent)> event_callback_fn;
-
 	public:
 		PhysicWorld();
 		~PhysicWorld();
 
-		// set the callback
-		void setEventCallback( event_callback_fn );
+		/// the events of each step are added to \p sink. With nullptr, events are discarded.
+		void setEventSink( MatchEventBuffer* sink );
 
 		// ball information queries
 		Vector2 getBallPosition() const;
@@ -56,6 +52,9 @@ class PhysicWorld : public ObjectCounter<PhysicWorld>
 		Vector2 getBlobPosition(PlayerSide player) const;
 		Vector2 getBlobVelocity(PlayerSide player) const;
 		float getBlobState(PlayerSide player) const;
+		/// the animation speed is not part of the PhysicState, but needed to continue a match exactly
+		float getBlobAnimationSpeed(PlayerSide player) const;
+		void setBlobAnimationSpeed(PlayerSide player, float speed);
 		// this function calculates whether the player is on the ground
 		bool blobHitGround(PlayerSide player) const;
 
@@ -100,7 +99,13 @@ class PhysicWorld : public ObjectCounter<PhysicWorld>
 		float mBlobState[MAX_PLAYERS];
 		float mCurrentBlobbyAnimationSpeed[MAX_PLAYERS];
 
-		event_callback_fn mCallback;
+		// adds an event to the sink
+		void emitEvent( const MatchEvent& event );
+
+		MatchEventBuffer* mEventSink = nullptr;
+
+		// the batch copies the animation speed, which is not part of the PhysicState
+		friend class PhysicWorldBatch;
 };
 
 
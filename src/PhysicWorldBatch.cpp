@@ -0,0 +1,502 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "PhysicWorldBatch.h"
+
+/* includes */
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "PhysicWorld.h"
+#include "GameConstants.h"
+#include "DeterministicMath.h"
+
+/* implementation */
+
+PhysicWorldBatch::PhysicWorldBatch(int size) : mSize(size), mActive(size),
+	mBallPositionX(size, 200), mBallPositionY(size, STANDARD_BALL_HEIGHT),
+	mBallVelocityX(size, 0), mBallVelocityY(size, 0),
+	mBallRotation(size, 0), mBallAngularVelocity(size, STANDARD_BALL_ANGULAR_VELOCITY),
+	mBallValid(size, 0), mGameRunning(size, 0), mCollision(size, 0)
+{
+	assert(size >= 0);
+	for(int player = LEFT_PLAYER; player <= RIGHT_PLAYER; ++player)
+	{
+		BlobArrays& blobs = mBlobs[player];
+		blobs.positionX.assign(size, player == LEFT_PLAYER ? 200 : 600);
+		blobs.positionY.assign(size, GROUND_PLANE_HEIGHT);
+		blobs.velocityX.assign(size, 0);
+		blobs.velocityY.assign(size, 0);
+		blobs.state.assign(size, 0);
+		blobs.animationSpeed.assign(size, 0);
+		mInput[player].assign(size, 0);
+	}
+}
+
+PhysicWorldBatch::~PhysicWorldBatch() = default;
+
+void PhysicWorldBatch::load(int index, const PhysicWorld& source)
+{
+	setState(index, source.getState());
+	mBlobs[LEFT_PLAYER].animationSpeed[index] = source.mCurrentBlobbyAnimationSpeed[LEFT_PLAYER];
+	mBlobs[RIGHT_PLAYER].animationSpeed[index] = source.mCurrentBlobbyAnimationSpeed[RIGHT_PLAYER];
+}
+
+void PhysicWorldBatch::store(int index, PhysicWorld& target) const
+{
+	target.setState(getState(index));
+	target.mCurrentBlobbyAnimationSpeed[LEFT_PLAYER] = mBlobs[LEFT_PLAYER].animationSpeed[index];
+	target.mCurrentBlobbyAnimationSpeed[RIGHT_PLAYER] = mBlobs[RIGHT_PLAYER].animationSpeed[index];
+}
+
+PhysicState PhysicWorldBatch::getState(int index) const
+{
+	PhysicState state;
+	for(int player = LEFT_PLAYER; player <= RIGHT_PLAYER; ++player)
+	{
+		const BlobArrays& blobs = mBlobs[player];
+		state.blobPosition[player] = Vector2(blobs.positionX[index], blobs.positionY[index]);
+		state.blobVelocity[player] = Vector2(blobs.velocityX[index], blobs.velocityY[index]);
+		state.blobState[player] = blobs.state[index];
+	}
+
+	state.ballPosition = Vector2(mBallPositionX[index], mBallPositionY[index]);
+	state.ballVelocity = Vector2(mBallVelocityX[index], mBallVelocityY[index]);
+	state.ballRotation = mBallRotation[index];
+	state.ballAngularVelocity = mBallAngularVelocity[index];
+	return state;
+}
+
+void PhysicWorldBatch::setState(int index, const PhysicState& state)
+{
+	for(int player = LEFT_PLAYER; player <= RIGHT_PLAYER; ++player)
+	{
+		BlobArrays& blobs = mBlobs[player];
+		blobs.positionX[index] = state.blobPosition[player].x;
+		blobs.positionY[index] = state.blobPosition[player].y;
+		blobs.velocityX[index] = state.blobVelocity[player].x;
+		blobs.velocityY[index] = state.blobVelocity[player].y;
+		blobs.state[index] = state.blobState[player];
+	}
+
+	mBallPositionX[index] = state.ballPosition.x;
+	mBallPositionY[index] = state.ballPosition.y;
+	mBallVelocityX[index] = state.ballVelocity.x;
+	mBallVelocityY[index] = state.ballVelocity.y;
+	mBallRotation[index] = state.ballRotation;
+	mBallAngularVelocity[index] = state.ballAngularVelocity;
+}
+
+void PhysicWorldBatch::setInput(int index, const PlayerInput& leftInput, const PlayerInput& rightInput,
+								bool isBallValid, bool isGameRunning)
+{
+	mInput[LEFT_PLAYER][index] = leftInput.getAll();
+	mInput[RIGHT_PLAYER][index] = rightInput.getAll();
+	mBallValid[index] = isBallValid;
+	mGameRunning[index] = isGameRunning;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+//  kernels
+// ---------------------------------------------------------------------------------------------------------------------
+
+// The kernels compute the same expressions as PhysicWorld, in the same order, but replace the branches
+// by selects so the loops can be vectorized. Select only picks one of two exactly computed values, so
+// this does not change any result. They are free functions with __restrict parameters, otherwise the
+// compiler would need too many runtime alias checks to vectorize the loops.
+namespace
+{
+	// input bits, see PlayerInput::getAll
+	const int INPUT_LEFT = 4;
+	const int INPUT_RIGHT = 2;
+	const int INPUT_UP = 1;
+
+	// results of the collision tests
+	enum Collision
+	{
+		NO_COLLISION = 0,
+		// ball world collisions. The lowest bit is set when the ball hit the ground.
+		HIT_GROUND = 1,
+		HIT_LEFT_WALL = 2,
+		HIT_RIGHT_WALL = 4,
+		HIT_NET_LEFT = 6,
+		HIT_NET_RIGHT = 8,
+		NEAR_NET_TOP = 10,
+		// blob ball collisions
+		HIT_BLOB_BOTTOM = 1,
+		HIT_BLOB_TOP = 2
+	};
+
+	// see PhysicWorld::handleBlob and PhysicWorld::blobbyAnimationStep
+	void stepBlobKernel(int size, const int* __restrict input,
+						float* __restrict position_x, float* __restrict position_y,
+						float* __restrict velocity_x, float* __restrict velocity_y,
+						float* __restrict state, float* __restrict animation_speed)
+	{
+		for(int i = 0; i < size; ++i)
+		{
+			int in = input[i];
+			float y = position_y[i];
+
+			float gravity = (in & INPUT_UP) ? GRAVITATION - BLOBBY_JUMP_BUFFER : GRAVITATION;
+			float vy = velocity_y[i];
+			float jump = (in & INPUT_UP) ? BLOBBY_JUMP_ACCELERATION : vy;
+			vy = y >= GROUND_PLANE_HEIGHT ? jump : vy;
+
+			float speed = animation_speed[i];
+			float started = speed == 0 ? BLOBBY_ANIMATION_SPEED : speed;
+			started = (in & (INPUT_UP | INPUT_LEFT | INPUT_RIGHT)) ? started : speed;
+			speed = y >= GROUND_PLANE_HEIGHT ? started : speed;
+
+			float vx = ((in & INPUT_RIGHT) ? BLOBBY_SPEED : 0) - ((in & INPUT_LEFT) ? BLOBBY_SPEED : 0);
+
+			float x = position_x[i] + (0.f + vx);
+			y = y + (0.5f * gravity + vy);
+			vy = vy + gravity;
+
+			// Hitting the ground
+			started = speed == 0 ? BLOBBY_ANIMATION_SPEED : speed;
+			started = vy > 3.5f ? started : speed;
+			speed = y > GROUND_PLANE_HEIGHT ? started : speed;
+			vy = y > GROUND_PLANE_HEIGHT ? 0.f : vy;
+			y = y > GROUND_PLANE_HEIGHT ? GROUND_PLANE_HEIGHT : y;
+
+			// animation step
+			float blob_state = state[i];
+			speed = blob_state < 0.f ? 0.f : speed;
+			blob_state = blob_state < 0.f ? 0.f : blob_state;
+			speed = blob_state >= 4.5f ? -BLOBBY_ANIMATION_SPEED : speed;
+			blob_state = blob_state + speed;
+			blob_state = blob_state >= 5.f ? 4.99f : blob_state;
+
+			position_x[i] = x;
+			position_y[i] = y;
+			velocity_x[i] = vx;
+			velocity_y[i] = vy;
+			state[i] = blob_state;
+			animation_speed[i] = speed;
+		}
+	}
+
+	void moveBallKernel(int size, const int* __restrict running,
+						float* __restrict position_x, float* __restrict position_y,
+						const float* __restrict velocity_x, float* __restrict velocity_y)
+	{
+		for(int i = 0; i < size; ++i)
+		{
+			float x = position_x[i];
+			float y = position_y[i];
+			float vy = velocity_y[i];
+
+			// the moved values are computed for every world, as the compiler does not vectorize
+			// computations inside the selects
+			float moved_x = x + (0.f + velocity_x[i]);
+			float moved_y = y + (0.5f * BALL_GRAVITATION + vy);
+			float moved_vy = vy + BALL_GRAVITATION;
+			position_x[i] = running[i] ? moved_x : x;
+			position_y[i] = running[i] ? moved_y : y;
+			velocity_y[i] = running[i] ? moved_vy : vy;
+		}
+	}
+
+	// see PhysicWorld::circleCircleCollision. \return whether there was any collision.
+	bool blobBallTestKernel(int size, const int* __restrict valid,
+							const float* __restrict blob_x, const float* __restrict blob_y,
+							const float* __restrict ball_x, const float* __restrict ball_y,
+							int* __restrict collision)
+	{
+		const float bottom_radii = BALL_RADIUS + BLOBBY_LOWER_RADIUS;
+		const float top_radii = BALL_RADIUS + BLOBBY_UPPER_RADIUS;
+
+		int any = 0;
+		for(int i = 0; i < size; ++i)
+		{
+			float dx = ball_x[i] - blob_x[i];
+			float bottom_dy = ball_y[i] - (blob_y[i] + BLOBBY_LOWER_SPHERE);
+			float top_dy = ball_y[i] - (blob_y[i] - BLOBBY_UPPER_SPHERE);
+			bool bottom = dx * dx + bottom_dy * bottom_dy < bottom_radii * bottom_radii;
+			bool top = dx * dx + top_dy * top_dy < top_radii * top_radii;
+			int result = bottom ? HIT_BLOB_BOTTOM : (top ? HIT_BLOB_TOP : NO_COLLISION);
+			result = valid[i] ? result : NO_COLLISION;
+			collision[i] = result;
+			any |= result;
+		}
+		return any != 0;
+	}
+
+	// see PhysicWorld::handleBallWorldCollisions. This is split into two loops, the compiler does not
+	// vectorize a single loop. The first one handles ground collisions.
+	void ballGroundKernel(int size, float* __restrict position_y, float* __restrict velocity_x,
+						float* __restrict velocity_y, int* __restrict collision)
+	{
+		for(int i = 0; i < size; ++i)
+		{
+			float y = position_y[i];
+			int ground = y + BALL_RADIUS > GROUND_PLANE_HEIGHT_MAX;
+
+			// multiplications with 1 and -1 are exact, so this is the same as reflecting and scaling
+			// the velocity only on a collision.
+			float factor = ground ? 0.95f : 1.f;
+			float sign = ground ? -1.f : 1.f;
+			velocity_x[i] = velocity_x[i] * factor;
+			velocity_y[i] = (sign * velocity_y[i]) * factor;
+			// y + BALL_RADIUS is computed exactly near the ground, so this is the same as setting
+			// the position on a collision.
+			position_y[i] = std::min(y, GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS);
+			collision[i] = ground ? HIT_GROUND : NO_COLLISION;
+		}
+	}
+
+	// The second one handles wall and net collisions. Collisions with the net top are only detected,
+	// the response is computed world by world. \return whether there was any collision, including
+	// the ground.
+	bool ballWallKernel(int size, float* __restrict position_x, const float* __restrict position_y,
+						float* __restrict velocity_x, int* __restrict collision)
+	{
+		int any = 0;
+		for(int i = 0; i < size; ++i)
+		{
+			float x = position_x[i];
+			float y = position_y[i];
+			float vx = velocity_x[i];
+
+			// Only the first collision that applies is handled. The conditions are combined as ints,
+			// chains of selects are not vectorized.
+			float net_dx = NET_POSITION_X - x;
+			float net_dy = NET_SPHERE_POSITION - y;
+			int left_wall = (x - BALL_RADIUS <= LEFT_PLANE) & (vx < 0.f);
+			int right_wall = (x + BALL_RADIUS >= RIGHT_PLANE) & (vx > 0.f) & !left_wall;
+			int net = (y > NET_SPHERE_POSITION) & (std::fabs(x - NET_POSITION_X) < BALL_RADIUS + NET_RADIUS) &
+						!(left_wall | right_wall);
+			int net_right = x - NET_POSITION_X > 0;
+			int net_top = (std::sqrt(net_dx * net_dx + net_dy * net_dy) < NET_RADIUS + BALL_RADIUS) &
+						!(left_wall | right_wall | net);
+
+			float reflected_vx = -vx;
+			float net_x = NET_POSITION_X + (net_right ? (BALL_RADIUS + NET_RADIUS) : (-BALL_RADIUS - NET_RADIUS));
+			vx = (left_wall | right_wall | net) ? reflected_vx : vx;
+			x = left_wall ? LEFT_PLANE + BALL_RADIUS : x;
+			x = right_wall ? RIGHT_PLANE - BALL_RADIUS : x;
+			x = net ? net_x : x;
+
+			position_x[i] = x;
+			velocity_x[i] = vx;
+
+			int result = collision[i] + left_wall * HIT_LEFT_WALL + right_wall * HIT_RIGHT_WALL +
+						net_top * NEAR_NET_TOP + net * (net_right ? HIT_NET_RIGHT : HIT_NET_LEFT);
+			collision[i] = result;
+			any |= result;
+		}
+		return any != 0;
+	}
+
+	void blobWorldKernel(int size, float* __restrict left_x, float* __restrict right_x)
+	{
+		for(int i = 0; i < size; ++i)
+		{
+			// Collision between blobby and the net
+			float left = left_x[i] + BLOBBY_LOWER_RADIUS > NET_POSITION_X - NET_RADIUS ?
+							NET_POSITION_X - NET_RADIUS - BLOBBY_LOWER_RADIUS : left_x[i];
+			float right = right_x[i] - BLOBBY_LOWER_RADIUS < NET_POSITION_X + NET_RADIUS ?
+							NET_POSITION_X + NET_RADIUS + BLOBBY_LOWER_RADIUS : right_x[i];
+
+			// Collision between blobby and the border
+			left_x[i] = left < LEFT_PLANE ? LEFT_PLANE : left;
+			right_x[i] = right > RIGHT_PLANE ? RIGHT_PLANE : right;
+		}
+	}
+
+	void rotateBallKernel(int size, const int* __restrict running,
+						const float* __restrict velocity_x, const float* __restrict velocity_y,
+						const float* __restrict angular_velocity, float* __restrict rotation)
+	{
+		for(int i = 0; i < size; ++i)
+		{
+			float vx = velocity_x[i];
+			float vy = velocity_y[i];
+			float turn = angular_velocity[i] * (std::sqrt(vx * vx + vy * vy) / 6);
+
+			float r = rotation[i];
+			float rolling = vx > 0.f ? r + turn : r - turn;
+			r = running[i] ? rolling : r - angular_velocity[i];
+
+			// Overflow-Protection
+			r = r <= 0 ? 6.25f + r : (r >= 6.25f ? r - 6.25f : r);
+			rotation[i] = r;
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+void PhysicWorldBatch::step(int count)
+{
+	assert(count >= 0 && count <= mSize);
+	mActive = count;
+
+	// Deterministic IEEE 754 floating point computations
+	short fpf = set_fpu_single_precision();
+
+	mEvents.clear();
+
+	// the same order of operations as in PhysicWorld::step
+	stepBlobs(LEFT_PLAYER);
+	stepBlobs(RIGHT_PLAYER);
+	moveBalls();
+	handleBlobbyBallCollisions(LEFT_PLAYER);
+	handleBlobbyBallCollisions(RIGHT_PLAYER);
+	handleBallWorldCollisions();
+	handleBlobWorldCollisions();
+	rotateBalls();
+
+	reset_fpu_flags(fpf);
+}
+
+void PhysicWorldBatch::stepBlobs(PlayerSide player)
+{
+	BlobArrays& blobs = mBlobs[player];
+	stepBlobKernel(mActive, mInput[player].data(), blobs.positionX.data(), blobs.positionY.data(),
+					blobs.velocityX.data(), blobs.velocityY.data(), blobs.state.data(), blobs.animationSpeed.data());
+}
+
+void PhysicWorldBatch::moveBalls()
+{
+	moveBallKernel(mActive, mGameRunning.data(), mBallPositionX.data(), mBallPositionY.data(),
+					mBallVelocityX.data(), mBallVelocityY.data());
+}
+
+void PhysicWorldBatch::handleBlobbyBallCollisions(PlayerSide player)
+{
+	const BlobArrays& blobs = mBlobs[player];
+	if(!blobBallTestKernel(mActive, mBallValid.data(), blobs.positionX.data(), blobs.positionY.data(),
+							mBallPositionX.data(), mBallPositionY.data(), mCollision.data()))
+		return;
+
+	// collision response, see PhysicWorld::handleBlobbyBallCollision
+	for(int i = 0; i < mActive; ++i)
+	{
+		if(mCollision[i] == NO_COLLISION)
+			continue;
+
+		Vector2 collision_center{blobs.positionX[i], blobs.positionY[i]};
+		if(mCollision[i] == HIT_BLOB_BOTTOM)
+			collision_center.y += BLOBBY_LOWER_SPHERE;
+		else
+			collision_center.y -= BLOBBY_UPPER_SPHERE;
+
+		Vector2 ball_position{mBallPositionX[i], mBallPositionY[i]};
+		Vector2 ball_velocity{mBallVelocityX[i], mBallVelocityY[i]};
+		Vector2 blob_velocity{blobs.velocityX[i], blobs.velocityY[i]};
+
+		float intensity = std::min(1.f, Vector2(ball_velocity, blob_velocity).length() / 25.f);
+
+		ball_velocity = -Vector2( ball_position, collision_center);
+		ball_velocity = ball_velocity.normalise();
+		ball_velocity = ball_velocity.scale(BALL_COLLISION_VELOCITY);
+		ball_position += ball_velocity;
+
+		mBallPositionX[i] = ball_position.x;
+		mBallPositionY[i] = ball_position.y;
+		mBallVelocityX[i] = ball_velocity.x;
+		mBallVelocityY[i] = ball_velocity.y;
+
+		mEvents.push_back( Event{i, MatchEvent{MatchEvent::BALL_HIT_BLOB, player, intensity}} );
+	}
+}
+
+void PhysicWorldBatch::handleBallWorldCollisions()
+{
+	ballGroundKernel(mActive, mBallPositionY.data(), mBallVelocityX.data(), mBallVelocityY.data(), mCollision.data());
+	if(!ballWallKernel(mActive, mBallPositionX.data(), mBallPositionY.data(), mBallVelocityX.data(), mCollision.data()))
+		return;
+
+	for(int i = 0; i < mActive; ++i)
+	{
+		if(mCollision[i] == NO_COLLISION)
+			continue;
+
+		if(mCollision[i] & HIT_GROUND)
+		{
+			// the position is already corrected for wall and net hits here, but these corrections never
+			// move the ball to the other side of the net.
+			PlayerSide side = mBallPositionX[i] > NET_POSITION_X ? RIGHT_PLAYER : LEFT_PLAYER;
+			mEvents.push_back( Event{i, MatchEvent{MatchEvent::BALL_HIT_GROUND, side, 0}} );
+		}
+
+		switch(mCollision[i] & ~HIT_GROUND)
+		{
+			case HIT_LEFT_WALL:
+				mEvents.push_back( Event{i, MatchEvent{MatchEvent::BALL_HIT_WALL, LEFT_PLAYER, 0}} );
+				break;
+			case HIT_RIGHT_WALL:
+				mEvents.push_back( Event{i, MatchEvent{MatchEvent::BALL_HIT_WALL, RIGHT_PLAYER, 0}} );
+				break;
+			case HIT_NET_LEFT:
+				mEvents.push_back( Event{i, MatchEvent{MatchEvent::BALL_HIT_NET, LEFT_PLAYER, 0}} );
+				break;
+			case HIT_NET_RIGHT:
+				mEvents.push_back( Event{i, MatchEvent{MatchEvent::BALL_HIT_NET, RIGHT_PLAYER, 0}} );
+				break;
+			case NEAR_NET_TOP:
+			{
+				// collision response, see PhysicWorld::handleBallWorldCollisions
+				Vector2 ball_position{mBallPositionX[i], mBallPositionY[i]};
+				Vector2 ball_velocity{mBallVelocityX[i], mBallVelocityY[i]};
+
+				Vector2 normal = Vector2(ball_position,	Vector2(NET_POSITION_X, NET_SPHERE_POSITION)).normalise();
+
+				float perp_ekin = normal.dotProduct(ball_velocity);
+				perp_ekin *= perp_ekin;
+				float para_ekin = ball_velocity.lengthSQ() - perp_ekin;
+
+				perp_ekin *= 0.7;
+				para_ekin *= 0.9;
+
+				float new_speed = std::sqrt( perp_ekin + para_ekin );
+
+				ball_velocity = Vector2(ball_velocity.reflect(normal).normalise().scale(new_speed));
+				ball_position = (Vector2(NET_POSITION_X, NET_SPHERE_POSITION) - normal * (NET_RADIUS + BALL_RADIUS));
+
+				mBallPositionX[i] = ball_position.x;
+				mBallPositionY[i] = ball_position.y;
+				mBallVelocityX[i] = ball_velocity.x;
+				mBallVelocityY[i] = ball_velocity.y;
+
+				mEvents.push_back( Event{i, MatchEvent{MatchEvent::BALL_HIT_NET_TOP, NO_PLAYER, 0}} );
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
+void PhysicWorldBatch::handleBlobWorldCollisions()
+{
+	blobWorldKernel(mActive, mBlobs[LEFT_PLAYER].positionX.data(), mBlobs[RIGHT_PLAYER].positionX.data());
+}
+
+void PhysicWorldBatch::rotateBalls()
+{
+	rotateBallKernel(mActive, mGameRunning.data(), mBallVelocityX.data(), mBallVelocityY.data(),
+					mBallAngularVelocity.data(), mBallRotation.data());
+}
@@ -0,0 +1,122 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <vector>
+
+#include "Global.h"
+#include "PlayerInput.h"
+#include "PhysicState.h"
+#include "MatchEvents.h"
+#include "BlobbyDebug.h"
+
+class PhysicWorld;
+
+/*! \class PhysicWorldBatch
+	\brief steps many physic worlds at once
+	\details Holds a number of worlds in structure of arrays form and steps all of them together. The
+			common part of a step (blob movement, ball movement, collision tests, wall and ground
+			responses) is done by loops over the arrays that the compiler vectorizes; only the rare
+			ball-blob and net top collisions are handled world by world.
+			The results are bit-identical to stepping each world with PhysicWorld::step.
+			Events are collected for all worlds together instead of in one MatchEventBuffer per world, see getEvents.
+*/
+class PhysicWorldBatch : public ObjectCounter<PhysicWorldBatch>
+{
+	public:
+		/// an event that happened in the world with index \p world during the last step
+		struct Event
+		{
+			int world;
+			MatchEvent event;
+		};
+
+		/// creates \p size worlds in the initial state of a new PhysicWorld
+		explicit PhysicWorldBatch(int size);
+		~PhysicWorldBatch();
+
+		int size() const { return mSize; }
+
+		/// copies the complete state of \p source, including the blob animation, into world \p index
+		void load(int index, const PhysicWorld& source);
+		/// copies world \p index into \p target
+		void store(int index, PhysicWorld& target) const;
+
+		PhysicState getState(int index) const;
+		/// sets the state of world \p index, like PhysicWorld::setState
+		void setState(int index, const PhysicState& state);
+
+		/// sets the parameters for the next steps of world \p index, see PhysicWorld::step
+		void setInput(int index, const PlayerInput& leftInput, const PlayerInput& rightInput,
+						bool isBallValid, bool isGameRunning);
+
+		/// steps all worlds
+		void step() { step(mSize); }
+		/// steps the worlds with an index below \p count. The other worlds are left as they are and
+		/// have no events.
+		void step(int count);
+
+		/// events of the last step. For each single world, they are in the order in which PhysicWorld
+		/// would push them into its MatchEventBuffer.
+		const std::vector<Event>& getEvents() const { return mEvents; }
+
+	private:
+		struct BlobArrays
+		{
+			std::vector<float> positionX;
+			std::vector<float> positionY;
+			std::vector<float> velocityX;
+			std::vector<float> velocityY;
+			std::vector<float> state;
+			std::vector<float> animationSpeed;
+		};
+
+		// kernels
+		void stepBlobs(PlayerSide player);
+		void moveBalls();
+		void handleBlobbyBallCollisions(PlayerSide player);
+		void handleBallWorldCollisions();
+		void handleBlobWorldCollisions();
+		void rotateBalls();
+
+		int mSize;
+		/// number of worlds the kernels of the current step work on
+		int mActive;
+
+		BlobArrays mBlobs[MAX_PLAYERS];
+		std::vector<float> mBallPositionX;
+		std::vector<float> mBallPositionY;
+		std::vector<float> mBallVelocityX;
+		std::vector<float> mBallVelocityY;
+		std::vector<float> mBallRotation;
+		std::vector<float> mBallAngularVelocity;
+
+		// inputs, as given by PlayerInput::getAll. These are ints instead of bytes, so the kernels
+		// only work on elements of the same width.
+		std::vector<int> mInput[MAX_PLAYERS];
+		std::vector<int> mBallValid;
+		std::vector<int> mGameRunning;
+
+		// collision results of the vectorized kernels, evaluated world by world
+		std::vector<int> mCollision;
+
+		std::vector<Event> mEvents;
+};
@@ -45,6 +45,7 @@ ScriptedInputSource::ScriptedInputSource(const std::string& filename, PlayerSide
 	// set game constants
 	setGameConstants();
 	setGameFunctions();
+	setTrajectoryCache(match->getTrajectoryCache());
 
 	// push infos into script
 	lua_pushnumber(mState, mDifficulty / 25.0);
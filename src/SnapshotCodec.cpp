@@ -0,0 +1,322 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "SnapshotCodec.h"
+
+/* includes */
+#include <cmath>
+#include <limits>
+
+#include "raknet/BitStream.h"
+
+/* implementation */
+
+namespace
+{
+	const float POSITION_SCALE = 256.f;
+	const float ROTATION_SCALE = 4096.f;
+
+	std::int32_t quantize(float value, float scale)
+	{
+		double scaled = std::round((double)value * scale);
+		if(scaled > std::numeric_limits<std::int32_t>::max())
+			return std::numeric_limits<std::int32_t>::max();
+		if(scaled < std::numeric_limits<std::int32_t>::min())
+			return std::numeric_limits<std::int32_t>::min();
+		return (std::int32_t)scaled;
+	}
+
+	float dequantize(std::int32_t value, float scale)
+	{
+		return value / scale;
+	}
+
+	void writeVarint(RakNet::BitStream& stream, std::uint32_t value)
+	{
+		while(value >= 0x80)
+		{
+			stream.Write((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		stream.Write((unsigned char)value);
+	}
+
+	bool readVarint(RakNet::BitStream& stream, std::uint32_t& value)
+	{
+		value = 0;
+		for(int shift = 0; shift < 35; shift += 7)
+		{
+			unsigned char byte;
+			if(!stream.Read(byte))
+				return false;
+			value |= std::uint32_t(byte & 0x7F) << shift;
+			if((byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	// differences are computed modulo 2^32 and mapped so that small negative values stay small
+	std::uint32_t zigzag(std::uint32_t difference)
+	{
+		std::uint32_t sign = (difference & 0x80000000u) ? 0xFFFFFFFFu : 0;
+		return (difference << 1) ^ sign;
+	}
+
+	std::uint32_t unzigzag(std::uint32_t value)
+	{
+		return (value >> 1) ^ (0u - (value & 1));
+	}
+
+	// true if sequence number a is newer than b, taking wrap-around into account
+	bool isNewer(std::uint32_t a, std::uint32_t b)
+	{
+		return (std::int32_t)(a - b) > 0;
+	}
+
+	// bit layout of the FLAGS field
+	enum
+	{
+		FLAG_GAME_RUNNING = 1 << 0,
+		FLAG_BALL_VALID = 1 << 1,
+		SHIFT_SERVING = 2,
+		SHIFT_WINNING = 4,
+		SHIFT_LEFT_INPUT = 6,
+		SHIFT_RIGHT_INPUT = 9
+	};
+}
+
+QuantizedMatchState QuantizedMatchState::fromState(const DuelMatchState& state)
+{
+	const PhysicState& world = state.worldState;
+	const GameLogicState& logic = state.logicState;
+
+	QuantizedMatchState q;
+	q.fields[BLOB_LEFT_X] = quantize(world.blobPosition[LEFT_PLAYER].x, POSITION_SCALE);
+	q.fields[BLOB_LEFT_Y] = quantize(world.blobPosition[LEFT_PLAYER].y, POSITION_SCALE);
+	q.fields[BLOB_LEFT_VX] = quantize(world.blobVelocity[LEFT_PLAYER].x, POSITION_SCALE);
+	q.fields[BLOB_LEFT_VY] = quantize(world.blobVelocity[LEFT_PLAYER].y, POSITION_SCALE);
+	q.fields[BLOB_RIGHT_X] = quantize(world.blobPosition[RIGHT_PLAYER].x, POSITION_SCALE);
+	q.fields[BLOB_RIGHT_Y] = quantize(world.blobPosition[RIGHT_PLAYER].y, POSITION_SCALE);
+	q.fields[BLOB_RIGHT_VX] = quantize(world.blobVelocity[RIGHT_PLAYER].x, POSITION_SCALE);
+	q.fields[BLOB_RIGHT_VY] = quantize(world.blobVelocity[RIGHT_PLAYER].y, POSITION_SCALE);
+	q.fields[BLOB_LEFT_STATE] = quantize(world.blobState[LEFT_PLAYER], POSITION_SCALE);
+	q.fields[BLOB_RIGHT_STATE] = quantize(world.blobState[RIGHT_PLAYER], POSITION_SCALE);
+	q.fields[BALL_X] = quantize(world.ballPosition.x, POSITION_SCALE);
+	q.fields[BALL_Y] = quantize(world.ballPosition.y, POSITION_SCALE);
+	q.fields[BALL_VX] = quantize(world.ballVelocity.x, POSITION_SCALE);
+	q.fields[BALL_VY] = quantize(world.ballVelocity.y, POSITION_SCALE);
+	q.fields[BALL_ROTATION] = quantize(world.ballRotation, ROTATION_SCALE);
+	q.fields[BALL_ANGULAR_VELOCITY] = quantize(world.ballAngularVelocity, ROTATION_SCALE);
+
+	q.fields[LEFT_SCORE] = logic.leftScore;
+	q.fields[RIGHT_SCORE] = logic.rightScore;
+	q.fields[LEFT_HITCOUNT] = logic.hitCount[LEFT_PLAYER];
+	q.fields[RIGHT_HITCOUNT] = logic.hitCount[RIGHT_PLAYER];
+	q.fields[LEFT_SQUISH] = logic.squish[LEFT_PLAYER];
+	q.fields[RIGHT_SQUISH] = logic.squish[RIGHT_PLAYER];
+	q.fields[SQUISH_WALL] = logic.squishWall;
+	q.fields[SQUISH_GROUND] = logic.squishGround;
+
+	std::int32_t flags = 0;
+	if(logic.isGameRunning)
+		flags |= FLAG_GAME_RUNNING;
+	if(logic.isBallValid)
+		flags |= FLAG_BALL_VALID;
+	flags |= (logic.servingPlayer + 1) << SHIFT_SERVING;
+	flags |= (logic.winningPlayer + 1) << SHIFT_WINNING;
+	flags |= state.playerInput[LEFT_PLAYER].getAll() << SHIFT_LEFT_INPUT;
+	flags |= state.playerInput[RIGHT_PLAYER].getAll() << SHIFT_RIGHT_INPUT;
+	q.fields[FLAGS] = flags;
+
+	return q;
+}
+
+void QuantizedMatchState::toState(DuelMatchState& state) const
+{
+	PhysicState& world = state.worldState;
+	GameLogicState& logic = state.logicState;
+
+	world.blobPosition[LEFT_PLAYER].x = dequantize(fields[BLOB_LEFT_X], POSITION_SCALE);
+	world.blobPosition[LEFT_PLAYER].y = dequantize(fields[BLOB_LEFT_Y], POSITION_SCALE);
+	world.blobVelocity[LEFT_PLAYER].x = dequantize(fields[BLOB_LEFT_VX], POSITION_SCALE);
+	world.blobVelocity[LEFT_PLAYER].y = dequantize(fields[BLOB_LEFT_VY], POSITION_SCALE);
+	world.blobPosition[RIGHT_PLAYER].x = dequantize(fields[BLOB_RIGHT_X], POSITION_SCALE);
+	world.blobPosition[RIGHT_PLAYER].y = dequantize(fields[BLOB_RIGHT_Y], POSITION_SCALE);
+	world.blobVelocity[RIGHT_PLAYER].x = dequantize(fields[BLOB_RIGHT_VX], POSITION_SCALE);
+	world.blobVelocity[RIGHT_PLAYER].y = dequantize(fields[BLOB_RIGHT_VY], POSITION_SCALE);
+	world.blobState[LEFT_PLAYER] = dequantize(fields[BLOB_LEFT_STATE], POSITION_SCALE);
+	world.blobState[RIGHT_PLAYER] = dequantize(fields[BLOB_RIGHT_STATE], POSITION_SCALE);
+	world.ballPosition.x = dequantize(fields[BALL_X], POSITION_SCALE);
+	world.ballPosition.y = dequantize(fields[BALL_Y], POSITION_SCALE);
+	world.ballVelocity.x = dequantize(fields[BALL_VX], POSITION_SCALE);
+	world.ballVelocity.y = dequantize(fields[BALL_VY], POSITION_SCALE);
+	world.ballRotation = dequantize(fields[BALL_ROTATION], ROTATION_SCALE);
+	world.ballAngularVelocity = dequantize(fields[BALL_ANGULAR_VELOCITY], ROTATION_SCALE);
+
+	logic.leftScore = fields[LEFT_SCORE];
+	logic.rightScore = fields[RIGHT_SCORE];
+	logic.hitCount[LEFT_PLAYER] = fields[LEFT_HITCOUNT];
+	logic.hitCount[RIGHT_PLAYER] = fields[RIGHT_HITCOUNT];
+	logic.squish[LEFT_PLAYER] = fields[LEFT_SQUISH];
+	logic.squish[RIGHT_PLAYER] = fields[RIGHT_SQUISH];
+	logic.squishWall = fields[SQUISH_WALL];
+	logic.squishGround = fields[SQUISH_GROUND];
+
+	std::int32_t flags = fields[FLAGS];
+	logic.isGameRunning = flags & FLAG_GAME_RUNNING;
+	logic.isBallValid = flags & FLAG_BALL_VALID;
+	logic.servingPlayer = PlayerSide(((flags >> SHIFT_SERVING) & 3) - 1);
+	logic.winningPlayer = PlayerSide(((flags >> SHIFT_WINNING) & 3) - 1);
+	state.playerInput[LEFT_PLAYER].setAll((flags >> SHIFT_LEFT_INPUT) & 7);
+	state.playerInput[RIGHT_PLAYER].setAll((flags >> SHIFT_RIGHT_INPUT) & 7);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+SnapshotHistory::SnapshotHistory()
+{
+	for(auto& entry : mEntries)
+		entry.sequence = 0;
+}
+
+void SnapshotHistory::store(std::uint32_t sequence, const QuantizedMatchState& state)
+{
+	Entry& entry = mEntries[sequence % SNAPSHOT_HISTORY_SIZE];
+	entry.sequence = sequence;
+	entry.state = state;
+}
+
+const QuantizedMatchState* SnapshotHistory::find(std::uint32_t sequence) const
+{
+	const Entry& entry = mEntries[sequence % SNAPSHOT_HISTORY_SIZE];
+	if(sequence == 0 || entry.sequence != sequence)
+		return nullptr;
+	return &entry.state;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+SnapshotEncoder::SnapshotEncoder() : mNextSequence(1), mAcknowledged(0), mKeyframes(0)
+{
+}
+
+void SnapshotEncoder::acknowledge(std::uint32_t sequence)
+{
+	// ignore outdated acks, and acks for snapshots we have not sent yet
+	if(sequence == 0 || !isNewer(mNextSequence, sequence))
+		return;
+	if(mAcknowledged == 0 || isNewer(sequence, mAcknowledged))
+		mAcknowledged = sequence;
+}
+
+void SnapshotEncoder::encode(const DuelMatchState& state, RakNet::BitStream& stream)
+{
+	std::uint32_t sequence = mNextSequence++;
+	if(mNextSequence == 0)
+		mNextSequence = 1;
+
+	QuantizedMatchState current = QuantizedMatchState::fromState(state);
+
+	const QuantizedMatchState* base = nullptr;
+	std::uint32_t base_offset = sequence - mAcknowledged;
+	if(mAcknowledged != 0 && base_offset < SNAPSHOT_HISTORY_SIZE)
+		base = mHistory.find(mAcknowledged);
+
+	if(!base)
+	{
+		base_offset = 0;
+		++mKeyframes;
+	}
+
+	writeVarint(stream, sequence);
+	writeVarint(stream, base_offset);
+
+	std::uint32_t differences[QuantizedMatchState::FIELD_COUNT];
+	for(int i = 0; i < QuantizedMatchState::FIELD_COUNT; ++i)
+	{
+		std::uint32_t previous = base ? (std::uint32_t)base->fields[i] : 0;
+		differences[i] = (std::uint32_t)current.fields[i] - previous;
+		if(differences[i] != 0)
+			stream.Write1();
+		else
+			stream.Write0();
+	}
+
+	for(int i = 0; i < QuantizedMatchState::FIELD_COUNT; ++i)
+	{
+		if(differences[i] != 0)
+			writeVarint(stream, zigzag(differences[i]));
+	}
+
+	mHistory.store(sequence, current);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+SnapshotDecoder::SnapshotDecoder() : mLastSequence(0)
+{
+}
+
+bool SnapshotDecoder::decode(RakNet::BitStream& stream, DuelMatchState& state)
+{
+	std::uint32_t sequence;
+	std::uint32_t base_offset;
+	if(!readVarint(stream, sequence) || !readVarint(stream, base_offset) || sequence == 0)
+		return false;
+
+	if(mLastSequence != 0 && !isNewer(sequence, mLastSequence))
+		return false;
+
+	const QuantizedMatchState* base = nullptr;
+	if(base_offset != 0)
+	{
+		base = mHistory.find(sequence - base_offset);
+		if(!base)
+			return false;
+	}
+
+	bool changed[QuantizedMatchState::FIELD_COUNT];
+	for(int i = 0; i < QuantizedMatchState::FIELD_COUNT; ++i)
+	{
+		if(!stream.Read(changed[i]))
+			return false;
+	}
+
+	QuantizedMatchState current;
+	for(int i = 0; i < QuantizedMatchState::FIELD_COUNT; ++i)
+	{
+		std::uint32_t value = base ? (std::uint32_t)base->fields[i] : 0;
+		if(changed[i])
+		{
+			std::uint32_t difference;
+			if(!readVarint(stream, difference))
+				return false;
+			value += unzigzag(difference);
+		}
+		current.fields[i] = (std::int32_t)value;
+	}
+
+	mHistory.store(sequence, current);
+	mLastSequence = sequence;
+	current.toState(state);
+	return true;
+}
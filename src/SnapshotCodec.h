@@ -0,0 +1,135 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "DuelMatchState.h"
+
+namespace RakNet
+{
+	class BitStream;
+}
+
+/// number of snapshots that are remembered as possible bases for delta encoding
+const unsigned SNAPSHOT_HISTORY_SIZE = 32;
+
+/*! \struct QuantizedMatchState
+	\brief DuelMatchState converted into a fixed set of integer fields.
+	\details Positions, velocities and the blob animation state are stored in 1/256 pixel (per step),
+			rotations in 1/4096 rad, which is far below anything that is visible on screen. Values are
+			rounded to the nearest step, so after toState they differ from the original state by at most
+			1/512 pixel and 1/8192 rad (for values below 65536, which covers everything the physics
+			produces). All other fields are transferred exactly. All logic flags and both
+			player inputs are packed into the single FLAGS field.
+*/
+struct QuantizedMatchState
+{
+	enum Field
+	{
+		BLOB_LEFT_X, BLOB_LEFT_Y, BLOB_LEFT_VX, BLOB_LEFT_VY,
+		BLOB_RIGHT_X, BLOB_RIGHT_Y, BLOB_RIGHT_VX, BLOB_RIGHT_VY,
+		BLOB_LEFT_STATE, BLOB_RIGHT_STATE,
+		BALL_X, BALL_Y, BALL_VX, BALL_VY,
+		BALL_ROTATION, BALL_ANGULAR_VELOCITY,
+		LEFT_SCORE, RIGHT_SCORE,
+		LEFT_HITCOUNT, RIGHT_HITCOUNT,
+		LEFT_SQUISH, RIGHT_SQUISH, SQUISH_WALL, SQUISH_GROUND,
+		FLAGS,
+		FIELD_COUNT
+	};
+
+	std::array<std::int32_t, FIELD_COUNT> fields;
+
+	static QuantizedMatchState fromState(const DuelMatchState& state);
+	void toState(DuelMatchState& state) const;
+};
+
+/*! \class SnapshotHistory
+	\brief ring buffer of the last SNAPSHOT_HISTORY_SIZE snapshots, indexed by sequence number.
+*/
+class SnapshotHistory
+{
+	public:
+		SnapshotHistory();
+
+		void store(std::uint32_t sequence, const QuantizedMatchState& state);
+		/// \return the snapshot with the given sequence number, or nullptr if it is no longer (or was never) stored.
+		const QuantizedMatchState* find(std::uint32_t sequence) const;
+
+	private:
+		struct Entry
+		{
+			std::uint32_t sequence;
+			QuantizedMatchState state;
+		};
+		std::array<Entry, SNAPSHOT_HISTORY_SIZE> mEntries;
+};
+
+/*! \class SnapshotEncoder
+	\brief writes compact ID_GAME_UPDATE snapshots for a single client.
+	\details Every snapshot gets a sequence number, which the client sends back with its input
+			to acknowledge the last snapshot it received. New snapshots are encoded as difference to
+			that snapshot: a bit mask marks the fields that changed, followed by the zigzag/varint
+			encoded differences of those fields. If nothing has been acknowledged, or the acknowledged
+			snapshot is too old, a keyframe is sent, which is simply the difference to an all-zero state.
+			Sequence number 0 is never used and means "nothing received".
+*/
+class SnapshotEncoder
+{
+	public:
+		SnapshotEncoder();
+
+		/// the client reports the last snapshot it decoded.
+		void acknowledge(std::uint32_t sequence);
+
+		/// appends the encoded snapshot of \p state to \p stream.
+		void encode(const DuelMatchState& state, RakNet::BitStream& stream);
+
+		unsigned getKeyframeCount() const { return mKeyframes; }
+
+	private:
+		std::uint32_t mNextSequence;
+		std::uint32_t mAcknowledged;
+		SnapshotHistory mHistory;
+		unsigned mKeyframes;
+};
+
+/*! \class SnapshotDecoder
+	\brief client side counterpart of SnapshotEncoder.
+*/
+class SnapshotDecoder
+{
+	public:
+		SnapshotDecoder();
+
+		/// reads a snapshot from \p stream and, if successful, writes it to \p state.
+		/// \return false, if the snapshot is older than the last decoded one, or its base is unknown.
+		bool decode(RakNet::BitStream& stream, DuelMatchState& state);
+
+		/// sequence number of the newest decoded snapshot, to be sent back to the server.
+		std::uint32_t getLastSequence() const { return mLastSequence; }
+
+	private:
+		std::uint32_t mLastSequence;
+		SnapshotHistory mHistory;
+};
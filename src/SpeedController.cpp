@@ -22,28 +22,36 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "SpeedController.h"
 
 /* includes */
-#include <algorithm>
-
-#include <SDL.h>
+#include <thread>
 
 /* implementation */
-/// this is required to reduce rounding errors. now we have a resolution of
-/// 1�s. This is much better than SDL_Delay can handle, but we prevent 
-/// accumulation errors.
-const int PRECISION_FACTOR = 1000;
+
+/// the controller sleeps until this long before a deadline and busy waits for the rest.
+/// Sleeps regularly overshoot by a fraction of a millisecond, which is more than we can afford.
+/// On the Miyoo Mini, spinning on the single core costs about a tenth of the CPU time, so we accept
+/// slightly late frames there. The deadlines do not depend on the wakeup time, so this does not drift.
+#ifdef MIYOO_MINI
+const SpeedController::clock_type::duration SPIN_THRESHOLD = std::chrono::microseconds(0);
+#else
+const SpeedController::clock_type::duration SPIN_THRESHOLD = std::chrono::microseconds(1500);
+#endif
+
+/// if we are more than this far behind the schedule (e.g. after loading a level), we do not try
+/// to catch up by running frames back to back but restart the schedule at the current time.
+const SpeedController::clock_type::duration MAX_FRAME_BACKLOG = std::chrono::milliseconds(250);
 
 SpeedController* SpeedController::mMainInstance = nullptr;
 
-SpeedController::SpeedController(float gameFPS)
+SpeedController::SpeedController(float gameFPS) :
+	mGameFPS(gameFPS),
+	mFPS(0),
+	mFPSCounter(0),
+	mFramedrop(false),
+	mDrawFPS(true)
 {
-	mGameFPS = gameFPS;
-	mFramedrop = false;
-	mDrawFPS = true;
-	mFPSCounter = 0;
-	mOldTicks = SDL_GetTicks();
-	mFPS = 0;
-	mBeginSecond = mOldTicks;
-	mCounter = 0;
+	mFrameDuration = std::chrono::duration_cast<clock_type::duration>( std::chrono::duration<double>(1.0 / gameFPS) );
+	mNextFrame = clock_type::now();
+	mFPSSecond = mNextFrame;
 }
 
 SpeedController::~SpeedController() = default;
@@ -52,11 +60,13 @@ void SpeedController::setGameSpeed(float fps)
 {
 	if (fps < 5)
 		fps = 5;
-	mGameFPS = fps;
-	
+
 	/// \todo maybe we should reset only if speed changed?
-	mBeginSecond = mOldTicks;
-	mCounter = 0;
+	// the next deadline is one new frame after the last one
+	mNextFrame -= mFrameDuration;
+	mGameFPS = fps;
+	mFrameDuration = std::chrono::duration_cast<clock_type::duration>( std::chrono::duration<double>(1.0 / fps) );
+	mNextFrame += mFrameDuration;
 }
 
 bool SpeedController::doFramedrop() const
@@ -64,51 +74,51 @@ bool SpeedController::doFramedrop() const
 	return mFramedrop;
 }
 
+void SpeedController::resetTickStatistics()
+{
+	mStatistics = TickStatistics();
+}
+
+void SpeedController::waitUntil(clock_type::time_point deadline)
+{
+	if (clock_type::now() + SPIN_THRESHOLD < deadline)
+		std::this_thread::sleep_until(deadline - SPIN_THRESHOLD);
+
+	while (clock_type::now() < deadline)
+		std::this_thread::yield();
+}
+
 void SpeedController::update()
 {
-	int rateTicks = std::max( static_cast<int>(PRECISION_FACTOR * 1000 / mGameFPS), 1);
-	
-	static int lastTicks = SDL_GetTicks();
+	waitUntil(mNextFrame);
 
-	if (mCounter == mGameFPS)
-	{
-		const int delta = SDL_GetTicks() - mBeginSecond;
-		int wait = 1000 - delta;
-		if (wait > 0)
-			SDL_Delay(wait);
-	}
-	if (mBeginSecond + 1000 <= SDL_GetTicks())
-	{
-		mBeginSecond = SDL_GetTicks();
-		mCounter = 0;
-	}
+	clock_type::time_point now = clock_type::now();
+	clock_type::duration lateness = now - mNextFrame;
+	mStatistics.record(lateness);
 
-	const int delta = SDL_GetTicks() - mBeginSecond;
-	if ( (PRECISION_FACTOR * delta) / rateTicks <= mCounter)
-	{
-		int wait = ((mCounter+1)*rateTicks/PRECISION_FACTOR) - delta;
-		if (wait > 0)
-			SDL_Delay(wait);
-	}
-	
 	// do we need framedrop?
-	// if passed time > time when we should have drawn next frame
-	// maybe we should limit the number of consecutive framedrops?
+	// if we are already past the time when we should draw the next frame, we skip drawing this one.
 	// for now: we can't do a framedrop if we did a framedrop last frame
-	if ( delta * PRECISION_FACTOR > rateTicks * (mCounter + 1) && !mFramedrop)
-	{
-		mFramedrop = true;
-	} else
-		mFramedrop = false;
+	mFramedrop = lateness > mFrameDuration && !mFramedrop;
 
-	mCounter++;
+	// the next deadline is computed from the schedule, not from the current time, so a late frame
+	// makes the following one shorter instead of delaying every frame after it.
+	if (lateness > MAX_FRAME_BACKLOG)
+	{
+		mNextFrame = now + mFrameDuration;
+		mStatistics.resyncs++;
+	}
+	else
+	{
+		mNextFrame += mFrameDuration;
+	}
 
 	//calculate the FPS of drawn frames:
 	if (mDrawFPS)
 	{
-		if (lastTicks >= mOldTicks + 1000)
+		if (now >= mFPSSecond + std::chrono::seconds(1))
 		{
-			mOldTicks = lastTicks;
+			mFPSSecond = now;
 			mFPS = mFPSCounter;
 			mFPSCounter = 0;
 		}
@@ -116,9 +126,5 @@ void SpeedController::update()
 		if (!mFramedrop)
 			mFPSCounter++;
 	}
-
-	//update for next call:
-	lastTicks = SDL_GetTicks();
 }
 
-
@@ -25,7 +25,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <chrono>
+
 #include "BlobbyDebug.h"
+#include "TickStatistics.h"
 
 /// \brief class controlling game speed
 /// \details This class can control the game speed and the displayed FPS.
@@ -36,11 +39,18 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 /// FPS is reached with framedropping
 /// The class can report how much time is actually waited. If this value
 /// is close to zero, the real speed can be altered.
+/// The frames follow a fixed schedule on the steady clock: each deadline is the previous
+/// deadline plus one frame, so rounding errors and late wakeups do not accumulate. The controller
+/// sleeps until shortly before the deadline and spins for the rest, because the sleep granularity of
+/// the OS is too coarse for evenly spaced frames at 75 FPS. On the Miyoo Mini, the spinning costs
+/// too much CPU time and battery, so it only sleeps there.
 
 
 class SpeedController : public ObjectCounter<SpeedController>
 {
 	public:
+		typedef std::chrono::steady_clock clock_type;
+
 		explicit SpeedController(float gameFPS);
 		~SpeedController();
 
@@ -58,20 +68,26 @@ class SpeedController : public ObjectCounter<SpeedController>
 	/// This updates everything and waits the necessary time
 		void update();
 
+		const TickStatistics& getTickStatistics() const { return mStatistics; }
+		void resetTickStatistics();
+
 		static void setMainInstance(SpeedController* inst) { mMainInstance = inst; }
 		static SpeedController* getMainInstance() { return mMainInstance; }
 	private:
+		void waitUntil(clock_type::time_point deadline);
+
 		float mGameFPS;
 		int mFPS;
 		int mFPSCounter;
 		bool mFramedrop;
 		bool mDrawFPS;
 		static SpeedController* mMainInstance;
-		int mOldTicks;
 
 		// internal data
-		unsigned int mBeginSecond;
-		int mCounter;
-};
+		clock_type::duration mFrameDuration;
+		clock_type::time_point mNextFrame;		///< deadline of the next frame
+		clock_type::time_point mFPSSecond;		///< start of the second for which drawn frames are counted
 
+		TickStatistics mStatistics;
+};
 
@@ -184,6 +184,10 @@ void TextManager::setDefault()
 	mStrings[RP_SAVE_NAME] = "name of the replay:";
 	mStrings[RP_WAIT_REPLAY] = "receiving replay...";
 	mStrings[RP_SAVE] = "save replay";
+	mStrings[RP_SORT_NAME] = "sort: name";
+	mStrings[RP_SORT_DATE] = "sort: date";
+	mStrings[RP_FILTER] = "filter:";
+	mStrings[RP_LOADING] = "loading replay...";
 
 	mStrings[GAME_WIN] = "has won the game!";
 	mStrings[GAME_TRY_AGAIN] = "try again";
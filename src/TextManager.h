@@ -76,6 +76,10 @@ class TextManager
 			RP_SAVE_NAME,
 			RP_WAIT_REPLAY,
 			RP_SAVE,
+			RP_SORT_NAME,
+			RP_SORT_DATE,
+			RP_FILTER,
+			RP_LOADING,
 
 			// game texts
 			GAME_WIN,
@@ -0,0 +1,54 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+/// ticks that start later than this after their deadline are counted as late
+const std::chrono::steady_clock::duration LATE_TICK_THRESHOLD = std::chrono::milliseconds(1);
+
+/*! \struct TickStatistics
+	\brief statistics about how accurately the deadlines of a fixed tick schedule are met.
+	\details Used for the frames of the SpeedController as well as for the game ticks of the server.
+*/
+struct TickStatistics
+{
+	std::uint64_t ticks = 0;		///< number of ticks performed
+	std::uint64_t lateTicks = 0;	///< number of ticks that started more than LATE_TICK_THRESHOLD late
+	std::uint64_t resyncs = 0;		///< number of times the schedule was reset because we fell too far behind
+	double meanLatenessMs = 0;		///< average delay between deadline and actual tick start
+	double maxLatenessMs = 0;		///< maximum delay between deadline and actual tick start
+	double totalLatenessMs = 0;		///< sum of all delays, to update the mean
+
+	/// records a tick that started \p lateness after its deadline
+	void record(std::chrono::steady_clock::duration lateness)
+	{
+		double late_ms = std::chrono::duration<double, std::milli>(lateness).count();
+		ticks++;
+		if(lateness > LATE_TICK_THRESHOLD)
+			lateTicks++;
+		totalLatenessMs += late_ms;
+		meanLatenessMs = totalLatenessMs / ticks;
+		maxLatenessMs = std::max(maxLatenessMs, late_ms);
+	}
+};
@@ -0,0 +1,131 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "TrajectoryCache.h"
+
+/* includes */
+#include <cstring>
+
+/* implementation */
+
+namespace
+{
+	std::uint32_t floatBits(float value)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+}
+
+TrajectoryCache::Key::Key(Query query, int steps, Vector2 position, Vector2 velocity)
+{
+	mWords[0] = (std::uint32_t)query;
+	mWords[1] = (std::uint32_t)steps;
+	setVectors(position, velocity);
+}
+
+TrajectoryCache::Key::Key(Query query, float target, Vector2 position, Vector2 velocity)
+{
+	mWords[0] = (std::uint32_t)query;
+	mWords[1] = floatBits(target);
+	setVectors(position, velocity);
+}
+
+void TrajectoryCache::Key::setVectors(Vector2 position, Vector2 velocity)
+{
+	mWords[2] = floatBits(position.x);
+	mWords[3] = floatBits(position.y);
+	mWords[4] = floatBits(velocity.x);
+	mWords[5] = floatBits(velocity.y);
+}
+
+std::uint32_t TrajectoryCache::Key::hash() const
+{
+	// FNV-1a over the words
+	std::uint32_t hash = 2166136261u;
+	for(std::uint32_t word : mWords)
+	{
+		hash ^= word;
+		hash *= 16777619u;
+	}
+	// the low bits select the slot, so mix in the high bits
+	return hash ^ (hash >> 16);
+}
+
+TrajectoryCache::TrajectoryCache() = default;
+
+const TrajectoryCache::Result* TrajectoryCache::find(const Key& key)
+{
+	std::uint32_t slot = key.hash();
+	for(int i = 0; i < PROBES; ++i)
+	{
+		const Entry& entry = mEntries[(slot + i) % SIZE];
+		if(entry.generation != mGeneration)
+			break;
+		if(entry.key == key)
+		{
+			++mHits;
+			return &entry.result;
+		}
+	}
+
+	++mMisses;
+	return nullptr;
+}
+
+void TrajectoryCache::insert(const Key& key, const Result& result)
+{
+	std::uint32_t slot = key.hash();
+	// use the first empty slot. If there is none, replace the entry in the first slot.
+	Entry* target = &mEntries[slot % SIZE];
+	for(int i = 0; i < PROBES; ++i)
+	{
+		Entry& entry = mEntries[(slot + i) % SIZE];
+		if(entry.generation != mGeneration)
+		{
+			target = &entry;
+			break;
+		}
+	}
+
+	target->generation = mGeneration;
+	target->key = key;
+	target->result = result;
+}
+
+void TrajectoryCache::invalidate()
+{
+	++mGeneration;
+	// after a wrap around, old entries could become valid again
+	if(mGeneration == 0)
+	{
+		for(auto& entry : mEntries)
+			entry.generation = 0;
+		mGeneration = 1;
+	}
+}
+
+double TrajectoryCache::getHitRate() const
+{
+	std::uint64_t queries = mHits + mMisses;
+	return queries == 0 ? 0.0 : (double)mHits / queries;
+}
@@ -0,0 +1,103 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Vector.h"
+#include "BlobbyDebug.h"
+
+/*! \class TrajectoryCache
+	\brief remembers the results of the ball simulations of the bots
+	\details The bots often run the same simulate and simulate_until queries several times per frame.
+			Their results only depend on the query parameters, so they are stored in a small hash
+			table, which is shared by the bots of a match and emptied once per frame.
+			Parameters are compared bit by bit, so a hit returns exactly what the simulation
+			would have computed.
+*/
+class TrajectoryCache : public ObjectCounter<TrajectoryCache>
+{
+	public:
+		enum class Query : std::uint32_t
+		{
+			SIMULATE,
+			UNTIL_X,
+			UNTIL_Y
+		};
+
+		struct Result
+		{
+			int steps;
+			Vector2 position;
+			Vector2 velocity;
+		};
+
+		/// parameters of a query. \p parameter is the number of steps for simulate and the target
+		/// coordinate for simulate_until.
+		struct Key
+		{
+			Key(Query query, int steps, Vector2 position, Vector2 velocity);
+			Key(Query query, float target, Vector2 position, Vector2 velocity);
+
+			bool operator==(const Key& other) const { return mWords == other.mWords; }
+			std::uint32_t hash() const;
+
+			private:
+				void setVectors(Vector2 position, Vector2 velocity);
+				std::array<std::uint32_t, 6> mWords;
+		};
+
+		/// number of stored results
+		static const int SIZE = 256;
+		/// number of slots that are searched for a key, starting at the one selected by its hash
+		static const int PROBES = 8;
+
+		TrajectoryCache();
+
+		/// returns the stored result for \p key, or nullptr if there is none
+		const Result* find(const Key& key);
+		void insert(const Key& key, const Result& result);
+
+		/// forgets all stored results
+		void invalidate();
+
+		// statistics
+		std::uint64_t getHits() const { return mHits; }
+		std::uint64_t getMisses() const { return mMisses; }
+		/// fraction of the queries that were answered from the cache
+		double getHitRate() const;
+
+	private:
+		struct Entry
+		{
+			// entries whose generation differs from mGeneration are empty
+			std::uint32_t generation = 0;
+			Key key{Query::SIMULATE, 0, Vector2(), Vector2()};
+			Result result;
+		};
+
+		std::array<Entry, SIZE> mEntries;
+		std::uint32_t mGeneration = 1;
+
+		std::uint64_t mHits = 0;
+		std::uint64_t mMisses = 0;
+};
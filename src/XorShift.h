@@ -0,0 +1,71 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "PlayerInput.h"
+
+/*! \struct XorShift
+	\brief tiny xorshift random number generator.
+	\details Unlike the std distributions, the generated numbers are the same with every compiler and
+			standard library, so benchmarks and tests that use it simulate the same matches everywhere.
+*/
+struct XorShift
+{
+	std::uint32_t state;
+
+	/// \p seed must not be 0
+	explicit XorShift(std::uint32_t seed = 1) : state(seed)
+	{
+	}
+
+	std::uint32_t next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	/// a random integer in [low, high]
+	int integer(int low, int high)
+	{
+		return low + (int)(next() % (std::uint32_t)(high - low + 1));
+	}
+
+	/// a random combination of the three keys
+	PlayerInput input()
+	{
+		std::uint32_t bits = next();
+		return PlayerInput(bits & 1, bits & 2, bits & 4);
+	}
+
+	/// replaces \p current by a random input with a probability of 1/8, so players keep their
+	/// input for a few steps, like a human would.
+	PlayerInput holdInput(const PlayerInput& current)
+	{
+		std::uint32_t bits = next();
+		if(bits % 8 != 0)
+			return current;
+		return PlayerInput(bits & 0x100, bits & 0x200, bits & 0x400);
+	}
+};
@@ -0,0 +1,726 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <SDL.h>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include "Global.h"
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "FileSystem.h"
+#include "FixedPhysicWorld.h"
+#include "GameLogic.h"
+#include "GenericIO.h"
+#include "InputSource.h"
+#include "MatchSnapshot.h"
+#include "PhysicWorld.h"
+#include "ScriptedInputSource.h"
+#include "XorShift.h"
+#include "replays/ReplayRecorder.h"
+#include "raknet/BitStream.h"
+
+/* implementation */
+
+// Micro benchmarks for the simulation core. The command line flags and the json output follow
+// Google Benchmark, so the usual tools for comparing its results between versions can be used:
+//   blobby-bench --benchmark_format=json --benchmark_out=results.json
+// Has to be started in the directory that contains the data directory.
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const std::uint64_t MAX_ITERATIONS = 1000000000;
+
+	/// keeps the compiler from optimizing away the computation of \p value
+	template<class T>
+	inline void doNotOptimize(const T& value)
+	{
+	#if defined(__GNUC__)
+		asm volatile("" : : "r,m"(value) : "memory");
+	#else
+		const volatile char* address = reinterpret_cast<const volatile char*>(&value);
+		(void)*address;
+	#endif
+	}
+
+	/// \brief state of a running benchmark
+	/// \details The benchmark function does its setup, then runs the measured code in a
+	///			while(state.keepRunning()) loop. Only the loop is timed.
+	class BenchmarkState
+	{
+		public:
+			explicit BenchmarkState(std::uint64_t iterations) : mIterations(iterations), mRemaining(iterations)
+			{
+			}
+
+			bool keepRunning()
+			{
+				if(!mStarted)
+				{
+					mStarted = true;
+					mCpuStart = std::clock();
+					mRealStart = Clock::now();
+				}
+
+				if(mRemaining == 0)
+				{
+					mRealSeconds = std::chrono::duration<double>(Clock::now() - mRealStart).count();
+					mCpuSeconds = double(std::clock() - mCpuStart) / CLOCKS_PER_SEC;
+					return false;
+				}
+
+				--mRemaining;
+				return true;
+			}
+
+			/// reports an additional value with the results, e.g. a size in bytes
+			void setCounter(const std::string& name, double value) { mCounters[name] = value; }
+			/// marks the benchmark as failed. It must not enter the measured loop afterwards.
+			void skipWithError(const std::string& message) { mError = message; }
+
+			std::uint64_t getIterations() const { return mIterations; }
+			double getRealSeconds() const { return mRealSeconds; }
+			double getCpuSeconds() const { return mCpuSeconds; }
+			const std::map<std::string, double>& getCounters() const { return mCounters; }
+			const std::string& getError() const { return mError; }
+
+		private:
+			std::uint64_t mIterations;
+			std::uint64_t mRemaining;
+			bool mStarted = false;
+			std::clock_t mCpuStart = 0;
+			Clock::time_point mRealStart;
+			double mRealSeconds = 0;
+			double mCpuSeconds = 0;
+			std::map<std::string, double> mCounters;
+			std::string mError;
+	};
+
+	struct Benchmark
+	{
+		std::string name;
+		std::function<void(BenchmarkState&)> function;
+	};
+
+	struct Result
+	{
+		std::string name;
+		std::string aggregate;		// empty for a single repetition, else mean, median or stddev
+		int repetitionIndex;
+		std::uint64_t iterations;
+		double realTime;			// per iteration, in ns
+		double cpuTime;
+		std::map<std::string, double> counters;
+		std::string error;
+	};
+
+	struct Options
+	{
+		std::string filter = ".";
+		std::string format = "console";
+		std::string out;
+		double minTime = 0.5;
+		int repetitions = 1;
+		bool list = false;
+	};
+
+	// -----------------------------------------------------------------------------------------------------------------
+	//  test data
+	// -----------------------------------------------------------------------------------------------------------------
+
+	const std::size_t INPUT_COUNT = 4096;	// power of two, so the index wraps with a mask
+
+	/// random inputs that are the same on every machine. Players keep their input for a few steps.
+	const std::vector<PlayerInput>& randomInputs()
+	{
+		static std::vector<PlayerInput> inputs;
+		if(inputs.empty())
+		{
+			XorShift random;
+			PlayerInput current;
+			for(std::size_t i = 0; i < INPUT_COUNT; ++i)
+			{
+				current = random.holdInput(current);
+				inputs.push_back(current);
+			}
+		}
+		return inputs;
+	}
+
+	/// a match with the fallback rules, played with random input
+	class RandomMatch
+	{
+		public:
+			explicit RandomMatch(const std::string& rules = FALLBACK_RULES_NAME,
+								 PhysicBackend backend = PhysicBackend::FLOAT) :
+				match(false, rules, 1000, backend),
+				mLeft(std::make_shared<InputSource>()),
+				mRight(std::make_shared<InputSource>())
+			{
+				match.setInputSources(mLeft, mRight);
+			}
+
+			void step()
+			{
+				const auto& inputs = randomInputs();
+				mLeft->setInput(inputs[mIndex]);
+				mRight->setInput(inputs[(mIndex + INPUT_COUNT / 2) & (INPUT_COUNT - 1)]);
+				mIndex = (mIndex + 1) & (INPUT_COUNT - 1);
+				match.step();
+			}
+
+			DuelMatch match;
+
+		private:
+			std::shared_ptr<InputSource> mLeft;
+			std::shared_ptr<InputSource> mRight;
+			std::size_t mIndex = 0;
+	};
+
+	/// consecutive states of a match with the fallback rules
+	const std::vector<DuelMatchState>& recordedStates()
+	{
+		static std::vector<DuelMatchState> states;
+		if(states.empty())
+		{
+			RandomMatch game;
+			for(std::size_t i = 0; i < INPUT_COUNT; ++i)
+			{
+				game.step();
+				states.push_back(game.match.getState());
+			}
+		}
+		return states;
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	//  benchmarks
+	// -----------------------------------------------------------------------------------------------------------------
+
+	template<class World>
+	void benchWorldStep(BenchmarkState& state)
+	{
+		const auto& inputs = randomInputs();
+		World world;
+		const PhysicState start = world.getState();
+		std::size_t index = 0;
+		while(state.keepRunning())
+		{
+			// restart before the ball comes to rest, so there are collisions all the time
+			if(index == 0)
+				world.setState(start);
+			world.step(inputs[index], inputs[(index + INPUT_COUNT / 2) & (INPUT_COUNT - 1)], true, true);
+			index = (index + 1) & (INPUT_COUNT - 1);
+		}
+		doNotOptimize(world.getState());
+	}
+
+	void benchMatchStep(BenchmarkState& state, const std::string& rules, PhysicBackend backend)
+	{
+		RandomMatch game(rules, backend);
+		while(state.keepRunning())
+		{
+			game.step();
+		}
+		doNotOptimize(game.match.getState());
+	}
+
+	void benchGetState(BenchmarkState& state)
+	{
+		RandomMatch game;
+		for(int i = 0; i < 1000; ++i)
+			game.step();
+
+		while(state.keepRunning())
+		{
+			DuelMatchState match_state = game.match.getState();
+			doNotOptimize(match_state);
+		}
+	}
+
+	void benchSetState(BenchmarkState& state)
+	{
+		const auto& states = recordedStates();
+		RandomMatch game;
+		std::size_t index = 0;
+		while(state.keepRunning())
+		{
+			game.match.setState(states[index]);
+			index = (index + 1) & (INPUT_COUNT - 1);
+		}
+		doNotOptimize(game.match.getState());
+	}
+
+	void benchSaveSnapshot(BenchmarkState& state, const std::string& rules)
+	{
+		RandomMatch game(rules);
+		for(int i = 0; i < 1000; ++i)
+			game.step();
+
+		MatchSnapshot snapshot;
+		while(state.keepRunning())
+		{
+			game.match.saveSnapshot(snapshot);
+		}
+		state.setCounter("script_bytes", snapshot.script.globals.size());
+	}
+
+	void benchRestoreSnapshot(BenchmarkState& state, const std::string& rules)
+	{
+		RandomMatch game(rules);
+		for(int i = 0; i < 1000; ++i)
+			game.step();
+
+		MatchSnapshot snapshot;
+		game.match.saveSnapshot(snapshot);
+		while(state.keepRunning())
+		{
+			game.match.restoreSnapshot(snapshot);
+		}
+		doNotOptimize(game.match.getState());
+	}
+
+	void benchReset(BenchmarkState& state, const std::string& rules)
+	{
+		RandomMatch game(rules);
+		while(state.keepRunning())
+		{
+			game.match.reset();
+		}
+		doNotOptimize(game.match.getState());
+	}
+
+	void benchWriteState(BenchmarkState& state)
+	{
+		const auto& states = recordedStates();
+		RakNet::BitStream stream;
+		auto writer = createGenericWriter(&stream);
+		std::size_t index = 0;
+		while(state.keepRunning())
+		{
+			stream.Reset();
+			writer->generic<DuelMatchState>(states[index]);
+			index = (index + 1) & (INPUT_COUNT - 1);
+		}
+		state.setCounter("bytes", stream.GetNumberOfBytesUsed());
+	}
+
+	void benchReadState(BenchmarkState& state)
+	{
+		RakNet::BitStream stream;
+		createGenericWriter(&stream)->generic<DuelMatchState>(recordedStates()[INPUT_COUNT / 2]);
+		auto reader = createGenericReader(&stream);
+		DuelMatchState match_state;
+		while(state.keepRunning())
+		{
+			stream.ResetReadPointer();
+			reader->generic<DuelMatchState>(match_state);
+		}
+		doNotOptimize(match_state);
+	}
+
+	void benchRecord(BenchmarkState& state)
+	{
+		const auto& states = recordedStates();
+		ReplayRecorder recorder;
+		recorder.setGameSpeed(75);
+		std::size_t index = 0;
+		while(state.keepRunning())
+		{
+			recorder.record(states[index]);
+			index = (index + 1) & (INPUT_COUNT - 1);
+		}
+	}
+
+	/// the bot controls the left player of a match with the fallback rules, so each iteration also
+	/// contains one match step
+	void benchBot(BenchmarkState& state, const std::string& bot)
+	{
+		RandomMatch game;
+		std::unique_ptr<ScriptedInputSource> source;
+		try
+		{
+			source.reset(new ScriptedInputSource("scripts/" + bot, LEFT_PLAYER, 0, &game.match));
+		}
+		catch (const std::exception& ex)
+		{
+			state.skipWithError("could not load scripts/" + bot + ": " + ex.what());
+			return;
+		}
+		source->setWaitTime(0);
+
+		auto left = std::make_shared<InputSource>();
+		game.match.setInputSources(left, nullptr);
+		while(state.keepRunning())
+		{
+			left->setInput( source->getNextInput().toPlayerInput(&game.match) );
+			game.step();
+		}
+	}
+
+	std::vector<Benchmark> createBenchmarks()
+	{
+		std::vector<Benchmark> benchmarks{
+			{"PhysicWorld/step", benchWorldStep<PhysicWorld>},
+			{"FixedPhysicWorld/step", benchWorldStep<FixedPhysicWorld>},
+			{"DuelMatch/step/fallback", [](BenchmarkState& state) { benchMatchStep(state, FALLBACK_RULES_NAME, PhysicBackend::FLOAT); }},
+			{"DuelMatch/step/fallback/fixed_point", [](BenchmarkState& state) { benchMatchStep(state, FALLBACK_RULES_NAME, PhysicBackend::FIXED_POINT); }},
+			{"DuelMatch/step/default.lua", [](BenchmarkState& state) { benchMatchStep(state, DEFAULT_RULES_FILE, PhysicBackend::FLOAT); }},
+			{"DuelMatch/getState", benchGetState},
+			{"DuelMatch/setState", benchSetState},
+			{"DuelMatch/saveSnapshot/fallback", [](BenchmarkState& state) { benchSaveSnapshot(state, FALLBACK_RULES_NAME); }},
+			{"DuelMatch/saveSnapshot/default.lua", [](BenchmarkState& state) { benchSaveSnapshot(state, DEFAULT_RULES_FILE); }},
+			{"DuelMatch/restoreSnapshot/fallback", [](BenchmarkState& state) { benchRestoreSnapshot(state, FALLBACK_RULES_NAME); }},
+			{"DuelMatch/restoreSnapshot/default.lua", [](BenchmarkState& state) { benchRestoreSnapshot(state, DEFAULT_RULES_FILE); }},
+			{"DuelMatch/reset/default.lua", [](BenchmarkState& state) { benchReset(state, DEFAULT_RULES_FILE); }},
+			{"GenericOut/DuelMatchState", benchWriteState},
+			{"GenericIn/DuelMatchState", benchReadState},
+			{"ReplayRecorder/record", benchRecord},
+		};
+
+		auto bots = FileSystem::getSingleton().enumerateFiles("scripts", ".lua");
+		std::sort(bots.begin(), bots.end());
+		for(const auto& bot : bots)
+		{
+			benchmarks.push_back({"ScriptedInputSource/getNextInput/" + bot,
+								  [bot](BenchmarkState& state) { benchBot(state, bot); }});
+		}
+		return benchmarks;
+	}
+
+	// -----------------------------------------------------------------------------------------------------------------
+	//  runner
+	// -----------------------------------------------------------------------------------------------------------------
+
+	Result makeResult(const std::string& name, const BenchmarkState& state, int repetition)
+	{
+		double iterations = std::max<std::uint64_t>(state.getIterations(), 1);
+		return Result{name, "", repetition, state.getIterations(), state.getRealSeconds() * 1e9 / iterations,
+					  state.getCpuSeconds() * 1e9 / iterations, state.getCounters(), state.getError()};
+	}
+
+	/// increases the number of iterations until a run takes at least the minimum time
+	BenchmarkState calibrate(const Benchmark& benchmark, double min_time)
+	{
+		std::uint64_t iterations = 1;
+		while(true)
+		{
+			BenchmarkState state(iterations);
+			benchmark.function(state);
+			double seconds = state.getRealSeconds();
+			if(!state.getError().empty() || seconds >= min_time || iterations >= MAX_ITERATIONS)
+				return state;
+
+			// aim a bit higher than the minimum time, but do not trust the estimate of very short runs
+			double multiplier = seconds > min_time / 10 ? 1.4 * min_time / seconds : 10;
+			iterations = std::min(MAX_ITERATIONS, std::max(iterations + 1, std::uint64_t(iterations * multiplier)));
+		}
+	}
+
+	Result aggregate(const std::vector<Result>& runs, const std::string& name)
+	{
+		Result result = runs.front();
+		result.aggregate = name;
+		result.repetitionIndex = -1;
+
+		auto combine = [&](std::function<double(const Result&)> value)
+		{
+			std::vector<double> values;
+			for(const auto& run : runs)
+				values.push_back(value(run));
+
+			double mean = 0;
+			for(double v : values)
+				mean += v;
+			mean /= values.size();
+
+			if(name == "mean")
+				return mean;
+
+			if(name == "median")
+			{
+				std::sort(values.begin(), values.end());
+				std::size_t middle = values.size() / 2;
+				return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+			}
+
+			double variance = 0;
+			for(double v : values)
+				variance += (v - mean) * (v - mean);
+			return values.size() > 1 ? std::sqrt(variance / (values.size() - 1)) : 0.0;
+		};
+
+		result.realTime = combine([](const Result& run) { return run.realTime; });
+		result.cpuTime = combine([](const Result& run) { return run.cpuTime; });
+		for(auto& counter : result.counters)
+		{
+			const std::string& counter_name = counter.first;
+			counter.second = combine([&counter_name](const Result& run) { return run.counters.at(counter_name); });
+		}
+		return result;
+	}
+
+	std::vector<Result> runBenchmark(const Benchmark& benchmark, const Options& options)
+	{
+		std::vector<Result> runs;
+		try
+		{
+			BenchmarkState first = calibrate(benchmark, options.minTime);
+			runs.push_back(makeResult(benchmark.name, first, 0));
+
+			for(int repetition = 1; repetition < options.repetitions && first.getError().empty(); ++repetition)
+			{
+				BenchmarkState state(first.getIterations());
+				benchmark.function(state);
+				runs.push_back(makeResult(benchmark.name, state, repetition));
+			}
+		}
+		catch (const std::exception& ex)
+		{
+			BenchmarkState failed(0);
+			failed.skipWithError(ex.what());
+			return {makeResult(benchmark.name, failed, 0)};
+		}
+
+		if(runs.size() > 1)
+		{
+			std::vector<Result> results = runs;
+			for(const char* name : {"mean", "median", "stddev"})
+				results.push_back(aggregate(runs, name));
+			return results;
+		}
+		return runs;
+	}
+
+	std::string displayName(const Result& result)
+	{
+		return result.aggregate.empty() ? result.name : result.name + "_" + result.aggregate;
+	}
+
+	void printConsoleHeader(std::ostream& stream)
+	{
+		stream << std::left << std::setw(50) << "Benchmark" << std::right << std::setw(14) << "Time (ns)"
+			   << std::setw(14) << "CPU (ns)" << std::setw(14) << "Iterations" << "\n";
+		stream << std::string(92, '-') << "\n";
+	}
+
+	void printConsole(std::ostream& stream, const Result& result)
+	{
+		stream << std::left << std::setw(50) << displayName(result) << std::right;
+		if(!result.error.empty())
+		{
+			stream << "ERROR: " << result.error << "\n";
+			return;
+		}
+
+		stream << std::fixed << std::setprecision(1) << std::setw(14) << result.realTime << std::setw(14)
+			   << result.cpuTime << std::setw(14) << result.iterations;
+		stream << std::defaultfloat << std::setprecision(6);
+		for(const auto& counter : result.counters)
+			stream << "  " << counter.first << "=" << counter.second;
+		stream << "\n";
+	}
+
+	std::string jsonString(const std::string& text)
+	{
+		std::string quoted = "\"";
+		for(char c : text)
+		{
+			if(c == '"' || c == '\\')
+				quoted += '\\';
+			if((unsigned char)c < 0x20)
+				continue;
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	void writeJson(std::ostream& stream, const std::vector<Result>& results, const Options& options, const char* executable)
+	{
+		char date[64];
+		std::time_t now = std::time(nullptr);
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+
+		stream << "{\n  \"context\": {\n";
+		stream << "    \"date\": " << jsonString(date) << ",\n";
+		stream << "    \"executable\": " << jsonString(executable) << ",\n";
+		stream << "    \"blobby_version\": " << jsonString(std::to_string(BLOBBY_VERSION_MAJOR) + "." + std::to_string(BLOBBY_VERSION_MINOR)) << ",\n";
+	#ifdef NDEBUG
+		stream << "    \"library_build_type\": \"release\"\n";
+	#else
+		stream << "    \"library_build_type\": \"debug\"\n";
+	#endif
+		stream << "  },\n  \"benchmarks\": [";
+
+		stream << std::setprecision(10);
+		for(std::size_t i = 0; i < results.size(); ++i)
+		{
+			const Result& result = results[i];
+			stream << (i ? ",\n" : "\n") << "    {\n";
+			stream << "      \"name\": " << jsonString(displayName(result)) << ",\n";
+			stream << "      \"run_name\": " << jsonString(result.name) << ",\n";
+			stream << "      \"run_type\": " << (result.aggregate.empty() ? "\"iteration\"" : "\"aggregate\"") << ",\n";
+			stream << "      \"repetitions\": " << options.repetitions << ",\n";
+			if(result.aggregate.empty())
+				stream << "      \"repetition_index\": " << result.repetitionIndex << ",\n";
+			else
+				stream << "      \"aggregate_name\": " << jsonString(result.aggregate) << ",\n";
+			if(!result.error.empty())
+			{
+				stream << "      \"error_occurred\": true,\n";
+				stream << "      \"error_message\": " << jsonString(result.error) << ",\n";
+			}
+			stream << "      \"iterations\": " << result.iterations << ",\n";
+			stream << "      \"real_time\": " << result.realTime << ",\n";
+			stream << "      \"cpu_time\": " << result.cpuTime << ",\n";
+			for(const auto& counter : result.counters)
+				stream << "      " << jsonString(counter.first) << ": " << counter.second << ",\n";
+			stream << "      \"time_unit\": \"ns\"\n";
+			stream << "    }";
+		}
+		stream << "\n  ]\n}\n";
+	}
+
+	void printUsage(const char* name)
+	{
+		std::cerr << "Usage: " << name << " [--benchmark_filter=REGEX] [--benchmark_format=console|json]"
+				  << " [--benchmark_out=FILE] [--benchmark_min_time=SECONDS] [--benchmark_repetitions=N]"
+				  << " [--benchmark_list_tests]\n";
+	}
+
+	bool parseOptions(int argc, char* argv[], Options& options)
+	{
+		for(int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			std::size_t separator = arg.find('=');
+			std::string flag = arg.substr(0, separator);
+			std::string value = separator == std::string::npos ? "" : arg.substr(separator + 1);
+
+			if(flag == "--benchmark_filter")
+				options.filter = value;
+			else if(flag == "--benchmark_format" && (value == "console" || value == "json"))
+				options.format = value;
+			else if(flag == "--benchmark_out")
+				options.out = value;
+			else if(flag == "--benchmark_min_time")
+				options.minTime = std::atof(value.c_str());
+			else if(flag == "--benchmark_repetitions")
+				options.repetitions = std::max(1, std::atoi(value.c_str()));
+			else if(flag == "--benchmark_list_tests")
+				options.list = true;
+			else
+				return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if(!parseOptions(argc, argv, options))
+	{
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	FileSystem filesys(argv[0]);
+	filesys.addToSearchPath("data");
+	SDL_Init(0);
+
+	try
+	{
+		std::regex filter(options.filter);
+		std::vector<Benchmark> benchmarks;
+		for(auto& benchmark : createBenchmarks())
+		{
+			if(std::regex_search(benchmark.name, filter))
+				benchmarks.push_back(std::move(benchmark));
+		}
+
+		if(options.list)
+		{
+			for(const auto& benchmark : benchmarks)
+				std::cout << benchmark.name << "\n";
+			return EXIT_SUCCESS;
+		}
+
+		// the rules and bots print messages to std::cout, which must not end up in the json output
+		std::ostream output(std::cout.rdbuf());
+		bool console = options.format == "console";
+		if(console)
+			printConsoleHeader(output);
+		else
+			std::cout.rdbuf(std::cerr.rdbuf());
+
+		std::vector<Result> results;
+		for(const auto& benchmark : benchmarks)
+		{
+			for(const auto& result : runBenchmark(benchmark, options))
+			{
+				if(console)
+					printConsole(output, result);
+				results.push_back(result);
+			}
+		}
+
+		if(!console)
+			writeJson(output, results, options, argv[0]);
+
+		if(!options.out.empty())
+		{
+			std::ofstream file(options.out);
+			writeJson(file, results, options, argv[0]);
+			if(!file)
+			{
+				std::cerr << "could not write " << options.out << "\n";
+				return EXIT_FAILURE;
+			}
+		}
+	} catch (const boost::exception& ex) {
+		std::cerr << boost::diagnostic_information(ex);
+		return EXIT_FAILURE;
+	} catch (const std::exception& ex) {
+		std::cerr << ex.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -19,12 +19,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 =============================================================================*/
 
 /* includes */
+#include <chrono>
 #include <ctime>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
 #include <atomic>
 #include <thread>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #include <SDL.h>
 
@@ -33,6 +37,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "FileSystem.h"
 #include "ScriptedInputSource.h"
 #include "DuelMatch.h"
+#include "PhysicWorldBatch.h"
+#include "TrajectoryCache.h"
 #include "replays/ReplayRecorder.h"
 #include "FileWrite.h"
 
@@ -47,17 +53,27 @@ struct DuelResult {
 };
 
 DuelResult duel(std::string left, std::string right, bool verbose=false);
+std::vector<DuelResult> duelBatch(const std::string& left, const std::string& right, int count);
 void present(const DuelResult& result);
 
+// stop at 12 hours
+const int MAX_STEPS = 75 * 60 * 60 * 12;
+
 int main(int argc, char* argv[])
 {
 	if(argc < 3) {
-		std::cerr << "Usage: " << argv[0] << " [LEFT] [RIGHT]\n";
+		std::cerr << "Usage: " << argv[0] << " [LEFT] [RIGHT] [MATCHES]\n";
 		return EXIT_FAILURE;
 	}
 
 	std::string left_bot = argv[1];
 	std::string right_bot = argv[2];
+	// more than one match are played at once, with their physics stepped together
+	int match_count = argc > 3 ? std::atoi(argv[3]) : 1;
+	if(match_count < 1) {
+		std::cerr << "Invalid number of matches: " << argv[3] << "\n";
+		return EXIT_FAILURE;
+	}
 
 	FileSystem filesys(argv[0]);
 	filesys.setWriteDir("/tmp");
@@ -68,8 +84,16 @@ int main(int argc, char* argv[])
 
 	try
 	{
-		auto result = duel( left_bot, right_bot, true );
-		present( result );
+		if(match_count == 1) {
+			auto result = duel( left_bot, right_bot, true );
+			present( result );
+		} else {
+			auto start = std::chrono::steady_clock::now();
+			for(const auto& result : duelBatch( left_bot, right_bot, match_count ))
+				present( result );
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			std::cout << match_count << " matches in " << elapsed.count() << " s\n";
+		}
 	} catch (const boost::exception& ex) {
 		// error handling
 		std::cerr <<  boost::diagnostic_information(ex);
@@ -110,8 +134,7 @@ DuelResult duel(std::string left, std::string right, bool verbose) {
 			std::cout << match.getScore(LEFT_PLAYER) << " - " << match.getScore(RIGHT_PLAYER) << "\n";
 		}
 
-		// stop at 12 hours
-		if(timer > 75 * 60 * 60 * 12) {
+		if(timer > MAX_STEPS) {
 			break;
 		}
 	}
@@ -122,9 +145,56 @@ DuelResult duel(std::string left, std::string right, bool verbose) {
 	FileWrite save_target{"bot-fight.bvr"};
 	recorder.save(save_target);
 
+	if(verbose) {
+		const auto& cache = *match.getTrajectoryCache();
+		std::cout << "trajectory cache: " << cache.getHits() << " hits, " << cache.getMisses() << " misses ("
+		          << 100 * cache.getHitRate() << "%)\n";
+	}
+
 	return {std::move(left), std::move(right), match.getScore(LEFT_PLAYER), match.getScore(RIGHT_PLAYER), timer / 75};
 }
 
+std::vector<DuelResult> duelBatch(const std::string& left, const std::string& right, int count) {
+	std::vector<std::unique_ptr<DuelMatch>> matches;
+	for(int i = 0; i < count; ++i) {
+		matches.emplace_back(new DuelMatch{false, "default.lua"});
+		DuelMatch& match = *matches.back();
+		auto leftInput = std::make_shared<ScriptedInputSource>("scripts/" + left, LEFT_PLAYER, 0, &match);
+		auto rightInput = std::make_shared<ScriptedInputSource>("scripts/" + right, RIGHT_PLAYER, 0, &match);
+		leftInput->setWaitTime(5);
+		rightInput->setWaitTime(5);
+
+		match.setPlayers(PlayerIdentity{}, PlayerIdentity{});
+		match.setInputSources(leftInput, rightInput);
+	}
+
+	PhysicWorldBatch batch(count);
+	std::vector<DuelMatch*> running;
+	std::vector<int> durations(count, 0);
+	for(int timer = 1; timer <= MAX_STEPS; ++timer) {
+		// finished matches drop out of the batch
+		running.clear();
+		for(int i = 0; i < count; ++i) {
+			if(matches[i]->winningPlayer() == NO_PLAYER) {
+				running.push_back(matches[i].get());
+				durations[i] = timer;
+			}
+		}
+		if(running.empty()) {
+			break;
+		}
+
+		DuelMatch::stepBatch(running, batch);
+	}
+
+	std::vector<DuelResult> results;
+	for(int i = 0; i < count; ++i) {
+		const DuelMatch& match = *matches[i];
+		results.push_back({left, right, match.getScore(LEFT_PLAYER), match.getScore(RIGHT_PLAYER), durations[i] / 75});
+	}
+	return results;
+}
+
 void present(const DuelResult& result) {
 	std::cout << result.LeftPlayer << " vs " << result.RightPlayer << ": "
 	          << result.LeftScore << " - " << result.RightScore << " in "
@@ -0,0 +1,657 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Global.h"
+#include "DuelMatchState.h"
+#include "GenericIO.h"
+#include "NetworkMessage.h"
+#include "PlayerIdentity.h"
+#include "PlayerInput.h"
+#include "SnapshotCodec.h"
+#include "raknet/RakClient.h"
+#include "raknet/BitStream.h"
+
+/* implementation */
+
+// Opens pairs of client connections to a running blobby-server. Each pair enters the lobby,
+// one client opens a game, the other one joins it and both play the match with random input
+// until somebody wins. Then the pair reconnects and starts the next match. At the end, the
+// update rate and timing as seen by the clients and the CPU time used by the server are reported.
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const int DESIRED_GAME_SPEED = 75;
+	const int RECONNECT_DELAY_MS = 500;
+	const int START_TIMEOUT_MS = 10000;		// pairs that did not start a match in this time reconnect
+
+	/// counts samples in buckets of 0.1 ms, up to two seconds. Larger samples go into the last bucket.
+	class LatencyHistogram
+	{
+		public:
+			LatencyHistogram() : mBuckets(20001, 0) {}
+
+			void add(double ms)
+			{
+				long bucket = std::lround(ms * 10);
+				bucket = std::max(0L, std::min(bucket, (long)mBuckets.size() - 1));
+				++mBuckets[bucket];
+				++mCount;
+				mSum += ms;
+				mMax = std::max(mMax, ms);
+			}
+
+			double percentile(double p) const
+			{
+				if(mCount == 0)
+					return 0;
+				std::uint64_t target = std::ceil(p / 100.0 * mCount);
+				std::uint64_t seen = 0;
+				for(std::size_t i = 0; i < mBuckets.size(); ++i)
+				{
+					seen += mBuckets[i];
+					if(seen >= target && seen > 0)
+						return i / 10.0;
+				}
+				return mMax;
+			}
+
+			std::uint64_t count() const { return mCount; }
+			double mean() const { return mCount ? mSum / mCount : 0; }
+			double max() const { return mMax; }
+
+		private:
+			std::vector<std::uint64_t> mBuckets;
+			std::uint64_t mCount = 0;
+			double mSum = 0;
+			double mMax = 0;
+	};
+
+	struct Options
+	{
+		std::string host = "localhost";
+		int port = BLOBBY_PORT;
+		unsigned pairs = 10;
+		double duration = 60;
+		double ramp = 10;		// pairs started per second
+		unsigned points = 3;
+		int serverPid = 0;
+	};
+
+	struct Statistics
+	{
+		LatencyHistogram rtt;
+		LatencyHistogram jitter;		// deviation of the update interval from the tick period
+		std::vector<double> updateRates;
+		unsigned matchesFinished = 0;
+		unsigned matchesAborted = 0;
+		unsigned connectionErrors = 0;
+		std::uint64_t updatesReceived = 0;
+		std::uint64_t undecodableUpdates = 0;
+	};
+
+	enum class ClientState
+	{
+		CONNECTING,
+		HANDSHAKE,		// waiting for ID_BLOBBY_SERVER_PRESENT
+		ENTERING,		// waiting for the first lobby status
+		LOBBY,
+		WAITING,		// opened or joined a game, waiting for the match to start
+		PLAYING,
+		FINISHED,
+		FAILED
+	};
+
+	unsigned clientTime(Clock::time_point start)
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+	}
+
+	double elapsedMs(Clock::time_point from, Clock::time_point to)
+	{
+		return std::chrono::duration<double, std::milli>(to - from).count();
+	}
+
+	struct LoadClient
+	{
+		std::unique_ptr<RakClient> client;
+		ClientState state = ClientState::FAILED;
+		bool isHost = false;
+		SnapshotDecoder decoder;
+		std::mt19937 random;
+
+		PlayerInputAbs input;
+		Clock::time_point nextInput;
+		Clock::time_point nextInputChange;
+
+		double tickPeriod = 1000.0 / DESIRED_GAME_SPEED;
+		Clock::time_point playStart;
+		Clock::time_point lastUpdate;
+		unsigned updates = 0;
+	};
+
+	struct ClientPair
+	{
+		LoadClient host;
+		LoadClient guest;
+		bool active = false;
+		bool gameKnown = false;
+		unsigned gameId = 0;
+		unsigned index = 0;
+		Clock::time_point connectedAt;
+		Clock::time_point restartAt;
+	};
+
+	void connect(LoadClient& client, const Options& options, bool host, unsigned seed)
+	{
+		client = LoadClient{};
+		client.isHost = host;
+		client.random.seed(seed);
+		client.client.reset(new RakClient());
+		if(client.client->Connect(options.host.c_str(), options.port, 0, 0, RAKNET_THREAD_SLEEP_TIME))
+			client.state = ClientState::CONNECTING;
+	}
+
+	void startPair(ClientPair& pair, const Options& options)
+	{
+		static unsigned seed = 0;
+		connect(pair.host, options, true, ++seed);
+		connect(pair.guest, options, false, ++seed);
+		pair.active = true;
+		pair.gameKnown = false;
+		pair.connectedAt = Clock::now();
+	}
+
+	void recordUpdateRate(const LoadClient& client, Statistics& stats, Clock::time_point now)
+	{
+		if(client.state == ClientState::PLAYING && client.updates > 1)
+		{
+			double seconds = elapsedMs(client.playStart, now) / 1000.0;
+			if(seconds > 1)
+				stats.updateRates.push_back(client.updates / seconds);
+		}
+	}
+
+	/// ends the current match of this client and closes the connection. Must not be called while a
+	/// packet received by this client is still alive, because the packet is returned to the client on deletion.
+	void finishClient(LoadClient& client, Statistics& stats, Clock::time_point now)
+	{
+		recordUpdateRate(client, stats, now);
+		if(client.client)
+			client.client->Disconnect(0);
+		client.client.reset();
+	}
+
+	void send(LoadClient& client, RakNet::BitStream& stream)
+	{
+		client.client->Send(&stream, HIGH_PRIORITY, RELIABLE_ORDERED, 0);
+	}
+
+	void sendInput(LoadClient& client, Clock::time_point start, Clock::time_point now)
+	{
+		// change the held buttons every few hundred milliseconds, so the blobs actually move around
+		if(now >= client.nextInputChange)
+		{
+			std::uniform_int_distribution<int> buttons(0, 7);
+			std::uniform_int_distribution<int> hold(100, 600);
+			int b = buttons(client.random);
+			client.input = PlayerInputAbs(b & 1, (b & 2) && !(b & 1), b & 4);
+			client.nextInputChange = now + std::chrono::milliseconds(hold(client.random));
+		}
+
+		RakNet::BitStream stream;
+		stream.Write((unsigned char)ID_INPUT_UPDATE);
+		stream.Write(clientTime(start));
+		client.input.writeTo(stream);
+		stream.Write(client.decoder.getLastSequence());
+		client.client->Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
+	}
+
+	void openGame(LoadClient& client, const std::vector<unsigned>& speeds, const Options& options)
+	{
+		// use the offered speed closest to the usual 75 fps
+		unsigned speed_index = 0;
+		for(unsigned i = 0; i < speeds.size(); ++i)
+		{
+			if(std::abs((int)speeds[i] - DESIRED_GAME_SPEED) < std::abs((int)speeds[speed_index] - DESIRED_GAME_SPEED))
+				speed_index = i;
+		}
+
+		RakNet::BitStream stream;
+		stream.Write((unsigned char)ID_LOBBY);
+		stream.Write((unsigned char)LobbyPacketType::OPEN_GAME);
+		auto writer = createGenericWriter(&stream);
+		writer->generic<unsigned int>(speed_index);
+		writer->generic<unsigned int>(options.points);
+		writer->generic<unsigned int>(0);
+		writer->generic<std::string>("");
+		send(client, stream);
+	}
+
+	void joinGame(LoadClient& client, unsigned id)
+	{
+		RakNet::BitStream stream;
+		stream.Write((unsigned char)ID_LOBBY);
+		stream.Write((unsigned char)LobbyPacketType::JOIN_GAME);
+		auto writer = createGenericWriter(&stream);
+		writer->generic<unsigned int>(id);
+		writer->generic<std::string>("");
+		send(client, stream);
+	}
+
+	void handleLobbyPacket(ClientPair& pair, LoadClient& client, RakNet::BitStream& stream, const Options& options)
+	{
+		auto in = createGenericReader(&stream);
+		unsigned char type;
+		in->byte(type);
+		in->byte(type);
+
+		if((LobbyPacketType)type == LobbyPacketType::SERVER_STATUS)
+		{
+			if(client.state != ClientState::ENTERING)
+				return;
+
+			std::uint32_t waiting;
+			std::vector<unsigned int> speeds;
+			in->uint32(waiting);
+			in->generic<std::vector<unsigned int>>(speeds);
+
+			client.state = ClientState::LOBBY;
+			if(client.isHost)
+			{
+				openGame(client, speeds, options);
+				client.state = ClientState::WAITING;
+			}
+		}
+		else if((LobbyPacketType)type == LobbyPacketType::GAME_STATUS)
+		{
+			std::uint32_t id;
+			PlayerID creator;
+			std::string name;
+			std::uint32_t speed, rules, points;
+			std::vector<PlayerID> others;
+			in->uint32(id);
+			in->generic<PlayerID>(creator);
+			in->string(name);
+			in->uint32(speed);
+			in->uint32(rules);
+			in->uint32(points);
+			in->generic<std::vector<PlayerID>>(others);
+
+			if(!client.isHost)
+				return;
+
+			pair.gameId = id;
+			pair.gameKnown = true;
+			if(!others.empty())
+			{
+				RakNet::BitStream start;
+				start.Write((unsigned char)ID_LOBBY);
+				start.Write((unsigned char)LobbyPacketType::START_GAME);
+				createGenericWriter(&start)->generic<PlayerID>(others.front());
+				send(client, start);
+			}
+		}
+		// REMOVED_FROM_GAME is also sent when the match starts, so it is no reason to give up
+	}
+
+	void handlePacket(ClientPair& pair, LoadClient& client, const packet_ptr& packet, const Options& options,
+					  Statistics& stats, Clock::time_point start, Clock::time_point now)
+	{
+		RakNet::BitStream stream(packet->data, packet->length, false);
+		switch(packet->data[0])
+		{
+			case ID_CONNECTION_REQUEST_ACCEPTED:
+			{
+				RakNet::BitStream present;
+				present.Write((unsigned char)ID_BLOBBY_SERVER_PRESENT);
+				present.Write(BLOBBY_VERSION_MAJOR);
+				present.Write(BLOBBY_VERSION_MINOR);
+				send(client, present);
+				client.state = ClientState::HANDSHAKE;
+				break;
+			}
+			case ID_BLOBBY_SERVER_PRESENT:
+			{
+				PlayerIdentity identity("loadgen" + std::to_string(pair.index) + (client.isHost ? "h" : "g"),
+										Color(255, 0, 0), false, client.isHost ? LEFT_PLAYER : RIGHT_PLAYER);
+				RakNet::BitStream enter;
+				makeEnterServerPacket(enter, identity);
+				send(client, enter);
+				client.state = ClientState::ENTERING;
+				break;
+			}
+			case ID_VERSION_MISMATCH:
+				std::cerr << "server version does not match\n";
+				client.state = ClientState::FAILED;
+				break;
+			case ID_LOBBY:
+				handleLobbyPacket(pair, client, stream, options);
+				break;
+			case ID_RULES_CHECKSUM:
+			{
+				RakNet::BitStream rules;
+				rules.Write((unsigned char)ID_RULES);
+				rules.Write(false);
+				send(client, rules);
+				break;
+			}
+			case ID_GAME_READY:
+			{
+				int speed;
+				stream.IgnoreBytes(1);
+				stream.Read(speed);
+				client.tickPeriod = 1000.0 / std::max(speed, 1);
+				client.state = ClientState::PLAYING;
+				client.playStart = now;
+				client.nextInput = now;
+				client.nextInputChange = now;
+				break;
+			}
+			case ID_GAME_UPDATE:
+			{
+				unsigned time_back;
+				stream.IgnoreBytes(1);
+				stream.Read(time_back);
+				// the server sends -1 until it received our first input
+				unsigned time = clientTime(start);
+				if(time_back <= time)
+					stats.rtt.add(time - time_back);
+
+				DuelMatchState state;
+				if(!client.decoder.decode(stream, state))
+					++stats.undecodableUpdates;
+
+				if(client.updates > 0)
+					stats.jitter.add(std::abs(elapsedMs(client.lastUpdate, now) - client.tickPeriod));
+				client.lastUpdate = now;
+				++client.updates;
+				++stats.updatesReceived;
+				break;
+			}
+			case ID_WIN_NOTIFICATION:
+				recordUpdateRate(client, stats, now);
+				client.state = ClientState::FINISHED;
+				break;
+			case ID_OPPONENT_DISCONNECTED:
+				if(client.state != ClientState::FINISHED)
+				{
+					recordUpdateRate(client, stats, now);
+					client.state = ClientState::FAILED;
+				}
+				break;
+			case ID_CONNECTION_ATTEMPT_FAILED:
+			case ID_NO_FREE_INCOMING_CONNECTIONS:
+			case ID_DISCONNECTION_NOTIFICATION:
+			case ID_CONNECTION_LOST:
+				++stats.connectionErrors;
+				client.state = ClientState::FAILED;
+				break;
+			default:
+				break;
+		}
+	}
+
+	bool isDone(const LoadClient& client)
+	{
+		return client.state == ClientState::FINISHED || client.state == ClientState::FAILED;
+	}
+
+	bool isPlaying(const LoadClient& client)
+	{
+		return client.client && client.state == ClientState::PLAYING;
+	}
+
+	void pollClient(ClientPair& pair, LoadClient& client, const Options& options, Statistics& stats,
+					Clock::time_point start)
+	{
+		if(!client.client)
+			return;
+
+		while(!isDone(client))
+		{
+			packet_ptr packet = client.client->Receive();
+			if(!packet)
+				break;
+			handlePacket(pair, client, packet, options, stats, start, Clock::now());
+		}
+
+		Clock::time_point now = Clock::now();
+		if(client.state == ClientState::LOBBY && !client.isHost && pair.gameKnown)
+		{
+			joinGame(client, pair.gameId);
+			client.state = ClientState::WAITING;
+		}
+		else if(client.state == ClientState::PLAYING && now >= client.nextInput)
+		{
+			sendInput(client, start, now);
+			client.nextInput += std::chrono::microseconds((long)(client.tickPeriod * 1000));
+			// do not try to catch up after a stall
+			if(client.nextInput < now)
+				client.nextInput = now;
+		}
+	}
+
+	/// user and system time of process \p pid, in seconds. Returns a negative value if it cannot be read.
+	double processCpuTime(int pid)
+	{
+		std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+		std::string content;
+		std::getline(file, content);
+		// the process name may contain spaces, so start after its closing parenthesis
+		std::size_t name_end = content.rfind(')');
+		if(!file || name_end == std::string::npos)
+			return -1;
+
+		std::istringstream fields(content.substr(name_end + 1));
+		std::string field;
+		unsigned long utime = 0, stime = 0;
+		// fields 3 to 13 of /proc/<pid>/stat are not of interest
+		for(int i = 3; i <= 13; ++i)
+			fields >> field;
+		fields >> utime >> stime;
+		return double(utime + stime) / sysconf(_SC_CLK_TCK);
+	}
+
+	void printUsage(const char* name)
+	{
+		std::cerr << "Usage: " << name << " [--host HOST] [--port PORT] [--clients N] [--duration SECONDS]"
+				  << " [--ramp PAIRS_PER_SECOND] [--points POINTS] [--server-pid PID]\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	unsigned clients = 2 * options.pairs;
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if(i + 1 >= argc)
+		{
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+		std::string value = argv[++i];
+		if(arg == "--host")
+			options.host = value;
+		else if(arg == "--port")
+			options.port = std::atoi(value.c_str());
+		else if(arg == "--clients")
+			clients = std::atoi(value.c_str());
+		else if(arg == "--duration")
+			options.duration = std::atof(value.c_str());
+		else if(arg == "--ramp")
+			options.ramp = std::atof(value.c_str());
+		else if(arg == "--points")
+			options.points = std::atoi(value.c_str());
+		else if(arg == "--server-pid")
+			options.serverPid = std::atoi(value.c_str());
+		else
+		{
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	options.pairs = std::max(1u, clients / 2);
+	options.ramp = std::max(options.ramp, 0.1);
+
+	std::cout << "starting " << 2 * options.pairs << " clients against " << options.host << ":" << options.port
+			  << " for " << options.duration << " s\n";
+
+	std::vector<ClientPair> pairs(options.pairs);
+	for(unsigned i = 0; i < pairs.size(); ++i)
+		pairs[i].index = i;
+
+	Statistics stats;
+	const Clock::time_point start = Clock::now();
+	const Clock::time_point end = start + std::chrono::milliseconds((long)(options.duration * 1000));
+	const double cpu_start = options.serverPid ? processCpuTime(options.serverPid) : -1;
+
+	unsigned started = 0;
+	double game_seconds = 0;		// integral of the number of running games over time
+	Clock::time_point last_sample = start;
+	Clock::time_point next_report = start + std::chrono::seconds(5);
+	std::uint64_t updates_at_report = 0;
+
+	while(true)
+	{
+		Clock::time_point now = Clock::now();
+		if(now >= end)
+			break;
+
+		// ramp up slowly, so the lobby is not flooded with connection attempts
+		unsigned should_run = std::min<unsigned>(pairs.size(), 1 + elapsedMs(start, now) / 1000.0 * options.ramp);
+		while(started < should_run)
+			startPair(pairs[started++], options);
+
+		unsigned running_games = 0;
+		unsigned connected = 0;
+		for(auto& pair : pairs)
+		{
+			if(!pair.active)
+				continue;
+
+			pollClient(pair, pair.host, options, stats, start);
+			pollClient(pair, pair.guest, options, stats, start);
+
+			if(isPlaying(pair.host) || isPlaying(pair.guest))
+				++running_games;
+			connected += (pair.host.client != nullptr) + (pair.guest.client != nullptr);
+
+			bool stalled = !isPlaying(pair.host) && !isPlaying(pair.guest)
+						&& elapsedMs(pair.connectedAt, now) > START_TIMEOUT_MS;
+			if(pair.restartAt == Clock::time_point{} && (isDone(pair.host) || isDone(pair.guest) || stalled))
+			{
+				if(pair.host.state == ClientState::FINISHED || pair.guest.state == ClientState::FINISHED)
+					++stats.matchesFinished;
+				else
+					++stats.matchesAborted;
+
+				finishClient(pair.host, stats, now);
+				finishClient(pair.guest, stats, now);
+				pair.restartAt = now + std::chrono::milliseconds(RECONNECT_DELAY_MS);
+			}
+			else if(pair.restartAt != Clock::time_point{} && now >= pair.restartAt)
+			{
+				pair.restartAt = Clock::time_point{};
+				startPair(pair, options);
+			}
+		}
+
+		game_seconds += running_games * elapsedMs(last_sample, now) / 1000.0;
+		last_sample = now;
+
+		if(now >= next_report)
+		{
+			std::cout << std::fixed << std::setprecision(1) << elapsedMs(start, now) / 1000.0 << " s: "
+					  << connected << " clients, " << running_games << " games, "
+					  << (stats.updatesReceived - updates_at_report) / 5.0 << " updates/s, "
+					  << stats.matchesFinished << " matches finished\n";
+			updates_at_report = stats.updatesReceived;
+			next_report += std::chrono::seconds(5);
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	Clock::time_point now = Clock::now();
+	const double cpu_end = options.serverPid ? processCpuTime(options.serverPid) : -1;
+	const double seconds = elapsedMs(start, now) / 1000.0;
+	for(auto& pair : pairs)
+	{
+		finishClient(pair.host, stats, now);
+		finishClient(pair.guest, stats, now);
+	}
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "\nmatches: " << stats.matchesFinished << " finished, " << stats.matchesAborted << " aborted, "
+			  << stats.connectionErrors << " connection errors\n";
+	std::cout << "average concurrent games: " << game_seconds / seconds << "\n";
+
+	if(!stats.updateRates.empty())
+	{
+		std::sort(stats.updateRates.begin(), stats.updateRates.end());
+		double sum = 0;
+		for(double rate : stats.updateRates)
+			sum += rate;
+		std::cout << "update rate per client [1/s]: mean " << sum / stats.updateRates.size()
+				  << ", min " << stats.updateRates.front()
+				  << ", p5 " << stats.updateRates[stats.updateRates.size() / 20] << "\n";
+	}
+	std::cout << "updates received: " << stats.updatesReceived << ", " << stats.undecodableUpdates << " undecodable\n";
+	std::cout << "update jitter [ms]: mean " << stats.jitter.mean() << ", p50 " << stats.jitter.percentile(50)
+			  << ", p99 " << stats.jitter.percentile(99) << ", max " << stats.jitter.max() << "\n";
+	std::cout << "round trip time [ms]: p50 " << stats.rtt.percentile(50) << ", p90 " << stats.rtt.percentile(90)
+			  << ", p99 " << stats.rtt.percentile(99) << ", max " << stats.rtt.max() << "\n";
+
+	if(cpu_start >= 0 && cpu_end >= 0)
+	{
+		double cpu = cpu_end - cpu_start;
+		std::cout << "server cpu: " << 100 * cpu / seconds << " % of one core";
+		if(game_seconds > 0)
+			std::cout << ", " << 100 * cpu / game_seconds << " % per game";
+		std::cout << "\n";
+	}
+	else if(options.serverPid)
+	{
+		std::cerr << "could not read the cpu time of process " << options.serverPid << "\n";
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Global.h"
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "FixedPhysicWorld.h"
+#include "GameLogic.h"
+#include "GenericIO.h"
+#include "InputSource.h"
+#include "PhysicWorld.h"
+#include "XorShift.h"
+#include "raknet/BitStream.h"
+
+/* implementation */
+
+// Compares the step cost of the float physics and the fixed point physics, for the bare physic worlds
+// and for whole matches with the fallback rules. Run it on each architecture that has to take part in
+// a match, e.g. on the ARM handhelds and on the x86 server.
+
+namespace
+{
+	using bench_clock = std::chrono::steady_clock;
+
+	// random inputs that are the same on every machine, so all architectures simulate the same match
+	std::vector<PlayerInput> randomInputs(int count)
+	{
+		std::vector<PlayerInput> inputs;
+		inputs.reserve(count);
+		XorShift random;
+		PlayerInput current;
+		for(int i = 0; i < count; ++i)
+		{
+			current = random.holdInput(current);
+			inputs.push_back(current);
+		}
+		return inputs;
+	}
+
+	double nanosecondsPerStep(bench_clock::duration time, int steps)
+	{
+		return std::chrono::duration<double, std::nano>(time).count() / steps;
+	}
+
+	template<class World>
+	double benchWorld(const std::vector<PlayerInput>& inputs, int rounds)
+	{
+		World world;
+		auto start = bench_clock::now();
+		for(int round = 0; round < rounds; ++round)
+		{
+			world.setState( World().getState() );
+			for(std::size_t i = 0; i + 1 < inputs.size(); ++i)
+				world.step(inputs[i], inputs[i + 1], true, true);
+		}
+		return nanosecondsPerStep(bench_clock::now() - start, rounds * (inputs.size() - 1));
+	}
+
+	double benchMatch(PhysicBackend backend, const std::vector<PlayerInput>& inputs, int rounds)
+	{
+		auto start = bench_clock::now();
+		for(int round = 0; round < rounds; ++round)
+		{
+			DuelMatch match(false, FALLBACK_RULES_NAME, 1000, backend);
+			auto left = std::make_shared<InputSource>();
+			auto right = std::make_shared<InputSource>();
+			match.setInputSources(left, right);
+
+			for(std::size_t i = 0; i + 1 < inputs.size(); ++i)
+			{
+				left->setInput(inputs[i]);
+				right->setInput(inputs[i + 1]);
+				match.step();
+			}
+		}
+		return nanosecondsPerStep(bench_clock::now() - start, rounds * (inputs.size() - 1));
+	}
+
+	template<class State>
+	unsigned serializedSize(const State& state)
+	{
+		RakNet::BitStream stream;
+		createGenericWriter(&stream)->generic<State>(state);
+		return stream.GetNumberOfBytesUsed();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int steps = argc > 1 ? std::atoi(argv[1]) : 100000;
+	int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+	if(steps < 2 || rounds < 1) {
+		std::cerr << "Usage: " << argv[0] << " [STEPS] [ROUNDS]\n";
+		return EXIT_FAILURE;
+	}
+
+	auto inputs = randomInputs(steps);
+
+	// warm up caches and clock frequency
+	benchWorld<PhysicWorld>(inputs, 1);
+
+	double float_world = benchWorld<PhysicWorld>(inputs, rounds);
+	double fixed_world = benchWorld<FixedPhysicWorld>(inputs, rounds);
+	double float_match = benchMatch(PhysicBackend::FLOAT, inputs, rounds);
+	double fixed_match = benchMatch(PhysicBackend::FIXED_POINT, inputs, rounds);
+
+	std::cout << "world step:  float " << float_world << " ns, fixed point " << fixed_world << " ns ("
+			  << fixed_world / float_world << "x)\n";
+	std::cout << "match step:  float " << float_match << " ns, fixed point " << fixed_match << " ns ("
+			  << fixed_match / float_match << "x)\n";
+	std::cout << "state size:  float " << serializedSize(PhysicWorld().getState()) << " bytes, fixed point "
+			  << serializedSize(FixedPhysicWorld().getFixedState()) << " bytes\n";
+
+	return EXIT_SUCCESS;
+}
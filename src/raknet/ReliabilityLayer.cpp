@@ -2250,7 +2250,10 @@ bool ReliabilityLayer::IsExpiredTime(unsigned int input, unsigned int currentTim
 	if (IsReceivedPacketHole(input, currentTime))
 		input -= TIMEOUT_TIME*100;
 
-	if (input < currentTime - TIMEOUT_TIME)
+	// GetTime starts at zero, so currentTime - TIMEOUT_TIME would wrap around during the first seconds
+	// and every entry would expire immediately. Late packets filling a hole were then dropped as duplicates
+	// after they had already been acknowledged.
+	if (input + TIMEOUT_TIME < currentTime)
 		return true;
 
 	return false;
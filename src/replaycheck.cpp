@@ -0,0 +1,179 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <SDL.h>
+
+#include "Global.h"
+#include "FileSystem.h"
+#include "FileWrite.h"
+#include "DuelMatch.h"
+#include "IUserConfigReader.h"
+#include "replays/IReplayLoader.h"
+#include "replays/ReplayCheck.h"
+
+/* implementation */
+
+// Re-simulates all replays in a directory and checks that the simulation reproduces every savepoint
+// stored in the replays bit by bit. This is used to verify that changes to the physics or the rules
+// keep old replays deterministic. The replays are distributed over several threads, each of them
+// simulating one replay at a time in its own DuelMatch.
+
+namespace
+{
+	struct CheckResult : ReplayCheckResult
+	{
+		std::string error;			///< set if the replay could not be checked at all
+	};
+
+	/// simulates the replay \p file from the start of the match and compares the state at each savepoint.
+	/// \param rules_name name of the rules file this thread uses for the rules of the replay
+	CheckResult checkReplayFile(const std::string& file, const std::string& rules_name, int score_to_win)
+	{
+		CheckResult result;
+		try
+		{
+			std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader(file));
+
+			FileWrite rules_file("rules/" + rules_name);
+			rules_file.write(loader->getRules());
+			rules_file.close();
+
+			DuelMatch match(false, rules_name, score_to_win, loader->getPhysicBackend());
+			static_cast<ReplayCheckResult&>(result) = checkReplay(*loader, match);
+		}
+		catch(const std::exception& ex)
+		{
+			result.error = ex.what();
+			if(result.error.empty())
+				result.error = "could not read replay";
+		}
+
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " [REPLAY DIRECTORY] [THREADS]\n";
+		return EXIT_FAILURE;
+	}
+
+	std::string replay_dir = argv[1];
+	unsigned thread_count = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+	thread_count = std::max(thread_count, 1u);
+
+	// the rules of the replays are written to a private directory, so checks running in parallel
+	// do not overwrite each other's rules
+	char temp_dir[] = "/tmp/replaycheck.XXXXXX";
+	if(!mkdtemp(temp_dir)) {
+		std::cerr << "Could not create a temporary directory\n";
+		return EXIT_FAILURE;
+	}
+
+	FileSystem filesys(argv[0]);
+	filesys.setWriteDir(temp_dir);
+	filesys.mkdir("rules");
+	filesys.addToSearchPath("data");
+	filesys.addToSearchPath(replay_dir);
+
+	SDL_Init(0);
+
+	// the replays do not store the score needed to win, so we use the configured one like ReplayState.
+	// The config is read here because its cache must not be used by several threads.
+	int score_to_win = IUserConfigReader::createUserConfigReader("config.xml")->getInteger("scoretowin");
+
+	std::vector<std::string> files = filesys.enumerateFiles("", ".bvr", true);
+	std::sort(files.begin(), files.end());
+	std::vector<CheckResult> results(files.size());
+
+	std::atomic<std::size_t> next_file{0};
+	auto worker = [&](unsigned index)
+	{
+		std::string rules_name = "replaycheck_" + std::to_string(index) + ".lua";
+		for(std::size_t file = next_file++; file < files.size(); file = next_file++)
+		{
+			results[file] = checkReplayFile(files[file], rules_name, score_to_win);
+		}
+		filesys.deleteFile("rules/" + rules_name);
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < thread_count; ++i)
+		threads.emplace_back(worker, i);
+	for(auto& thread : threads)
+		thread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	filesys.deleteFile("rules");
+	rmdir(temp_dir);
+
+	// report
+	std::uint64_t steps = 0;
+	std::uint64_t savepoints = 0;
+	unsigned diverged = 0;
+	unsigned failed = 0;
+	for(std::size_t i = 0; i < files.size(); ++i)
+	{
+		const CheckResult& result = results[i];
+		steps += result.steps;
+		savepoints += result.savepoints;
+		if(!result.error.empty())
+		{
+			++failed;
+			std::cout << files[i] << ": ERROR " << result.error << "\n";
+		}
+		else if(result.divergence >= 0)
+		{
+			++diverged;
+			// the simulation can only be compared at the savepoints, so the actual divergence happened
+			// somewhere after the last matching one
+			std::cout << files[i] << ": DIVERGED ";
+			if(result.lastMatch >= 0)
+				std::cout << "between step " << result.lastMatch << " and " << result.divergence;
+			else
+				std::cout << "before step " << result.divergence;
+			std::cout << ": " << result.difference << "\n";
+		}
+	}
+
+	std::cout << files.size() << " replays checked with " << thread_count << " threads in " << seconds << " s\n";
+	std::cout << files.size() - diverged - failed << " ok, " << diverged << " diverged, " << failed << " failed\n";
+	std::cout << steps << " steps simulated, " << savepoints << " savepoints compared, "
+			  << (seconds > 0 ? steps / seconds : 0) << " steps/s\n";
+
+	return diverged == 0 && failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,134 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <SDL.h>
+
+#include "Global.h"
+#include "FileSystem.h"
+#include "IUserConfigReader.h"
+#include "replays/ReplayExport.h"
+
+/* implementation */
+
+// Exports the state of every frame of a set of replays, see replays/ReplayExport.h. The replays are
+// processed by several threads.
+
+int main(int argc, char* argv[])
+{
+	bool csv = false;
+	unsigned thread_count = std::thread::hardware_concurrency();
+	std::vector<std::string> arguments;
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if(argument == "--csv")
+			csv = true;
+		else if(argument == "--threads" && i + 1 < argc)
+			thread_count = std::atoi(argv[++i]);
+		else
+			arguments.push_back(argument);
+	}
+	thread_count = std::max(thread_count, 1u);
+
+	if(arguments.size() != 2) {
+		std::cerr << "Usage: " << argv[0] << " [--csv] [--threads THREADS] [REPLAY DIRECTORY] [OUTPUT DIRECTORY]\n";
+		return EXIT_FAILURE;
+	}
+
+	std::string replay_dir = arguments[0];
+	std::string output_dir = arguments[1];
+
+	// the rules of the replays are written to a private directory, see replaycheck
+	char temp_dir[] = "/tmp/replayexport.XXXXXX";
+	if(!mkdtemp(temp_dir)) {
+		std::cerr << "Could not create a temporary directory\n";
+		return EXIT_FAILURE;
+	}
+
+	FileSystem filesys(argv[0]);
+	filesys.setWriteDir(temp_dir);
+	filesys.mkdir("rules");
+	filesys.addToSearchPath("data");
+	filesys.addToSearchPath(replay_dir);
+
+	SDL_Init(0);
+
+	int score_to_win = IUserConfigReader::createUserConfigReader("config.xml")->getInteger("scoretowin");
+
+	std::vector<std::string> files = filesys.enumerateFiles("", ".bvr");
+	std::sort(files.begin(), files.end());
+	std::vector<ReplayExportResult> results(files.size());
+
+	std::atomic<std::size_t> next_file{0};
+	auto worker = [&](unsigned index)
+	{
+		std::string rules_name = "replayexport_" + std::to_string(index) + ".lua";
+		for(std::size_t file = next_file++; file < files.size(); file = next_file++)
+		{
+			results[file] = exportReplay(files[file] + ".bvr", output_dir + "/" + files[file], csv,
+										 rules_name, score_to_win);
+		}
+		filesys.deleteFile("rules/" + rules_name);
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < thread_count; ++i)
+		threads.emplace_back(worker, i);
+	for(auto& thread : threads)
+		thread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	filesys.deleteFile("rules");
+	rmdir(temp_dir);
+
+	std::uint64_t frames = 0;
+	std::uint64_t bytes = 0;
+	unsigned failed = 0;
+	for(std::size_t i = 0; i < files.size(); ++i)
+	{
+		frames += results[i].frames;
+		bytes += results[i].bytes;
+		if(!results[i].error.empty())
+		{
+			++failed;
+			std::cout << files[i] << ".bvr: ERROR " << results[i].error << "\n";
+		}
+	}
+
+	std::cout << files.size() - failed << " of " << files.size() << " replays exported with " << thread_count
+			  << " threads in " << seconds << " s\n";
+	std::cout << frames << " frames, " << bytes << " bytes, " << (seconds > 0 ? frames / seconds : 0) << " frames/s\n";
+
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
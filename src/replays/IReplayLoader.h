@@ -19,10 +19,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 =============================================================================*/
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <ctime>	// for time_t
 #include <memory>
 
+#include "Global.h"
 #include "ReplaySavePoint.h"
 #include "BlobbyDebug.h"
 #include "GenericIOFwd.h"
@@ -80,6 +82,11 @@ class IReplayLoader : public ObjectCounter<IReplayLoader>
 
 		/// gets the speed this game was played
 		virtual int getSpeed() const = 0;
+		/// gets the physics the game was played with. Replays before version 3.1 always used the float physics.
+		virtual PhysicBackend getPhysicBackend() const
+		{
+			return PhysicBackend::FLOAT;
+		}
 		/// gets the duration of the game in seconds
 		virtual int getDuration() const = 0;
 		/// gets the length of the replay in physic steps
@@ -122,6 +129,17 @@ class IReplayLoader : public ObjectCounter<IReplayLoader>
 		/// \brief get the rules script as a string
 		virtual std::string getRules() const = 0;
 
+		/// \brief reads the replay data ahead of playback.
+		/// \details Loaders that read their data on demand read the rest of the file here, so it is
+		///			not loaded from disk during playback. This is meant to be called from a background
+		///			thread while the replay is played, so it must not change the state of the loader.
+		/// \param progress[out] fraction of the data that has been read
+		/// \param cancel stops reading when set
+		virtual void prefetch(std::atomic<float>& progress, const std::atomic<bool>& cancel) const
+		{
+			progress = 1.f;
+		}
+
 	protected:
 		/// \brief protected constructor.
 		/// \details Create IReplayLoaders with createReplayLoader functions.
@@ -0,0 +1,285 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ReplayCatalogue.h"
+
+/* includes */
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+#include "IReplayLoader.h"
+#include "FileSystem.h"
+#include "FileRead.h"
+#include "FileWrite.h"
+#include "GenericIO.h"
+
+/* implementation */
+
+namespace
+{
+	const std::string CATALOGUE_FILE = "replays/catalogue.dat";
+	/// the catalogue is written to this file first, so a crash while saving cannot destroy the old one
+	const std::string CATALOGUE_TEMP_FILE = "replays/catalogue.dat.tmp";
+	const unsigned int CATALOGUE_VERSION = 1;
+	/// number of newly loaded replays after which the entries are published to the ui
+	const std::size_t PUBLISH_INTERVAL = 16;
+
+	void write64(GenericOut& out, std::uint64_t value)
+	{
+		out.uint32(value & 0xFFFFFFFF);
+		out.uint32(value >> 32);
+	}
+
+	std::uint64_t read64(GenericIn& in)
+	{
+		unsigned int low, high;
+		in.uint32(low);
+		in.uint32(high);
+		return std::uint64_t(low) | (std::uint64_t(high) << 32);
+	}
+
+	bool byName(const ReplayInfo& a, const ReplayInfo& b)
+	{
+		return a.name < b.name;
+	}
+}
+
+ReplayCatalogue::ReplayCatalogue() : mRevision(0), mUpdating(false), mStop(false)
+{
+}
+
+ReplayCatalogue::~ReplayCatalogue()
+{
+	mStop = true;
+	if(mThread.joinable())
+		mThread.join();
+}
+
+void ReplayCatalogue::update()
+{
+	if(mThread.joinable())
+	{
+		if(mUpdating)
+			return;
+		mThread.join();
+	}
+
+	mUpdating = true;
+	mThread = std::thread(&ReplayCatalogue::run, this);
+}
+
+bool ReplayCatalogue::isUpdating() const
+{
+	return mUpdating;
+}
+
+std::vector<ReplayInfo> ReplayCatalogue::getEntries() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mEntries;
+}
+
+unsigned int ReplayCatalogue::getRevision() const
+{
+	return mRevision;
+}
+
+void ReplayCatalogue::remove(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.erase(std::remove_if(mEntries.begin(), mEntries.end(), [&](const ReplayInfo& info) { return info.name == name; }),
+				   mEntries.end());
+	++mRevision;
+}
+
+void ReplayCatalogue::publish(std::vector<ReplayInfo> entries)
+{
+	std::sort(entries.begin(), entries.end(), byName);
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries = std::move(entries);
+	++mRevision;
+}
+
+void ReplayCatalogue::run()
+{
+	try
+	{
+		std::vector<ReplayInfo> stored = load();
+		std::sort(stored.begin(), stored.end(), byName);
+
+		// first, take everything that is still up to date from the stored catalogue
+		std::vector<ReplayInfo> entries;
+		std::vector<ReplayInfo> outdated;
+		for(const auto& name : FileSystem::getSingleton().enumerateFiles("replays", ".bvr"))
+		{
+			ReplayInfo info;
+			info.name = name;
+			if(!FileSystem::getSingleton().getFileInfo("replays/" + name + ".bvr", info.size, info.modified))
+				continue;
+
+			auto found = std::lower_bound(stored.begin(), stored.end(), info, byName);
+			if(found != stored.end() && found->name == name && found->size == info.size && found->modified == info.modified)
+				entries.push_back(*found);
+			else
+				outdated.push_back(info);
+		}
+
+		bool changed = !outdated.empty() || entries.size() != stored.size();
+		publish(entries);
+
+		// then load the replays that are new or have changed
+		std::size_t loaded = 0;
+		for(const auto& info : outdated)
+		{
+			if(mStop)
+				break;
+
+			entries.push_back(readReplay(info.name, info.size, info.modified));
+			if(++loaded % PUBLISH_INTERVAL == 0)
+				publish(entries);
+		}
+		publish(entries);
+
+		if(changed)
+			save(entries);
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << "could not update replay catalogue: " << e.what() << std::endl;
+	}
+
+	mUpdating = false;
+}
+
+ReplayInfo ReplayCatalogue::readReplay(const std::string& name, std::uint64_t size, std::int64_t modified)
+{
+	ReplayInfo info;
+	info.name = name;
+	info.size = size;
+	info.modified = modified;
+
+	try
+	{
+		std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader("replays/" + name + ".bvr"));
+		info.playerNames[LEFT_PLAYER] = loader->getPlayerName(LEFT_PLAYER);
+		info.playerNames[RIGHT_PLAYER] = loader->getPlayerName(RIGHT_PLAYER);
+		info.finalScore[LEFT_PLAYER] = loader->getFinalScore(LEFT_PLAYER);
+		info.finalScore[RIGHT_PLAYER] = loader->getFinalScore(RIGHT_PLAYER);
+		info.speed = loader->getSpeed();
+		info.duration = loader->getDuration();
+		info.date = loader->getDate();
+		info.valid = true;
+	}
+	catch(std::exception& e)
+	{
+		// keep the entry, so we don't try again until the file changes
+		std::cerr << "could not read replay " << name << ": " << e.what() << std::endl;
+	}
+
+	return info;
+}
+
+std::vector<ReplayInfo> ReplayCatalogue::load()
+{
+	std::vector<ReplayInfo> entries;
+	if(!FileSystem::getSingleton().exists(CATALOGUE_FILE))
+		return entries;
+
+	try
+	{
+		auto in = createGenericReader(std::make_shared<FileRead>(CATALOGUE_FILE));
+
+		unsigned int version, count;
+		in->uint32(version);
+		if(version != CATALOGUE_VERSION)
+			return entries;
+
+		in->uint32(count);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			ReplayInfo info;
+			in->string(info.name);
+			info.size = read64(*in);
+			info.modified = read64(*in);
+			in->boolean(info.valid);
+			if(info.valid)
+			{
+				in->string(info.playerNames[LEFT_PLAYER]);
+				in->string(info.playerNames[RIGHT_PLAYER]);
+				in->uint32(info.finalScore[LEFT_PLAYER]);
+				in->uint32(info.finalScore[RIGHT_PLAYER]);
+				in->uint32(info.speed);
+				in->uint32(info.duration);
+				info.date = read64(*in);
+			}
+			entries.push_back(info);
+		}
+	}
+	catch(std::exception& e)
+	{
+		// a broken catalogue is simply rebuilt
+		std::cerr << "could not read replay catalogue: " << e.what() << std::endl;
+		entries.clear();
+	}
+
+	return entries;
+}
+
+void ReplayCatalogue::save(const std::vector<ReplayInfo>& entries)
+{
+	try
+	{
+		auto file = std::make_shared<FileWrite>(CATALOGUE_TEMP_FILE);
+		auto out = createGenericWriter(file);
+		out->uint32(CATALOGUE_VERSION);
+		out->uint32(entries.size());
+		for(const auto& info : entries)
+		{
+			out->string(info.name);
+			write64(*out, info.size);
+			write64(*out, info.modified);
+			out->boolean(info.valid);
+			if(info.valid)
+			{
+				out->string(info.playerNames[LEFT_PLAYER]);
+				out->string(info.playerNames[RIGHT_PLAYER]);
+				out->uint32(info.finalScore[LEFT_PLAYER]);
+				out->uint32(info.finalScore[RIGHT_PLAYER]);
+				out->uint32(info.speed);
+				out->uint32(info.duration);
+				write64(*out, info.date);
+			}
+		}
+		file->close();
+
+		if(!FileSystem::getSingleton().rename(CATALOGUE_TEMP_FILE, CATALOGUE_FILE))
+		{
+			std::cerr << "could not replace replay catalogue" << std::endl;
+			FileSystem::getSingleton().deleteFile(CATALOGUE_TEMP_FILE);
+		}
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << "could not write replay catalogue: " << e.what() << std::endl;
+		FileSystem::getSingleton().deleteFile(CATALOGUE_TEMP_FILE);
+	}
+}
@@ -0,0 +1,99 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Global.h"
+#include "BlobbyDebug.h"
+
+/// \brief metadata of a single replay file, as stored in the ReplayCatalogue
+struct ReplayInfo
+{
+	std::string name;			///< file name without directory and extension
+	std::uint64_t size = 0;		///< file size, used to detect changes
+	std::int64_t modified = 0;	///< modification time, used to detect changes
+
+	bool valid = false;			///< false if the replay could not be loaded. All other fields are unset then.
+	std::string playerNames[MAX_PLAYERS];
+	unsigned int finalScore[MAX_PLAYERS] = {0, 0};
+	unsigned int speed = 0;
+	unsigned int duration = 0;	///< in seconds
+	std::time_t date = 0;
+};
+
+/*! \class ReplayCatalogue
+	\brief index of the metadata of all replays.
+	\details The catalogue is stored in the write dir, with an entry for each replay file. An entry
+			is only refreshed when size or modification time of its replay changed, so the replays
+			themselves only have to be opened once. The update runs in a background thread, and
+			getEntries can be polled while it is running.
+*/
+class ReplayCatalogue : public ObjectCounter<ReplayCatalogue>
+{
+	public:
+		ReplayCatalogue();
+		/// stops a running update
+		~ReplayCatalogue();
+
+		ReplayCatalogue(const ReplayCatalogue&) = delete;
+		ReplayCatalogue& operator=(const ReplayCatalogue&) = delete;
+
+		/// \brief starts updating the catalogue in a background thread.
+		/// \details The stored entries are available as soon as the catalogue file has been read,
+		///			new and changed replays are added as they are loaded.
+		void update();
+		/// \return true while the background update is running
+		bool isUpdating() const;
+
+		/// \brief all entries known so far, sorted by name.
+		std::vector<ReplayInfo> getEntries() const;
+		/// \brief a number that changes whenever the entries change
+		unsigned int getRevision() const;
+
+		/// \brief removes the entry of a replay, e.g. after the file has been deleted.
+		void remove(const std::string& name);
+
+		/// \brief reads the metadata directly from a replay file.
+		/// \details If the replay cannot be loaded, the returned info is not valid.
+		static ReplayInfo readReplay(const std::string& name, std::uint64_t size = 0, std::int64_t modified = 0);
+
+	private:
+		void run();
+		void publish(std::vector<ReplayInfo> entries);
+
+		static std::vector<ReplayInfo> load();
+		static void save(const std::vector<ReplayInfo>& entries);
+
+		mutable std::mutex mMutex;
+		std::vector<ReplayInfo> mEntries;
+		std::atomic<unsigned int> mRevision;
+
+		std::thread mThread;
+		std::atomic<bool> mUpdating;
+		std::atomic<bool> mStop;
+};
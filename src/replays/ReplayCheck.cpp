@@ -0,0 +1,140 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ReplayCheck.h"
+
+/* includes */
+#include <cstring>
+#include <sstream>
+
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "IReplayLoader.h"
+
+/* implementation */
+
+namespace
+{
+	bool sameBits(float a, float b)
+	{
+		return std::memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	template<class T>
+	void compare(std::ostream& out, const char* name, const T& simulated, const T& recorded)
+	{
+		if(!(simulated == recorded))
+			out << name << ": " << simulated << " != " << recorded << "; ";
+	}
+
+	void compare(std::ostream& out, const char* name, float simulated, float recorded)
+	{
+		if(!sameBits(simulated, recorded))
+			out << name << ": " << simulated << " != " << recorded << "; ";
+	}
+
+	void compare(std::ostream& out, const char* name, const Vector2& simulated, const Vector2& recorded)
+	{
+		if(!sameBits(simulated.x, recorded.x) || !sameBits(simulated.y, recorded.y))
+			out << name << ": (" << simulated.x << ", " << simulated.y << ") != ("
+				<< recorded.x << ", " << recorded.y << "); ";
+	}
+}
+
+std::string describeStateDifference(const DuelMatchState& simulated, const DuelMatchState& recorded)
+{
+	std::ostringstream out;
+	out.precision(9);
+
+	const PhysicState& sw = simulated.worldState;
+	const PhysicState& rw = recorded.worldState;
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		const char* side = i == LEFT_PLAYER ? "left " : "right ";
+		compare(out, (side + std::string("blob position")).c_str(), sw.blobPosition[i], rw.blobPosition[i]);
+		compare(out, (side + std::string("blob velocity")).c_str(), sw.blobVelocity[i], rw.blobVelocity[i]);
+		compare(out, (side + std::string("blob state")).c_str(), sw.blobState[i], rw.blobState[i]);
+	}
+	compare(out, "ball position", sw.ballPosition, rw.ballPosition);
+	compare(out, "ball velocity", sw.ballVelocity, rw.ballVelocity);
+	compare(out, "ball rotation", sw.ballRotation, rw.ballRotation);
+	compare(out, "ball angular velocity", sw.ballAngularVelocity, rw.ballAngularVelocity);
+
+	const GameLogicState& sl = simulated.logicState;
+	const GameLogicState& rl = recorded.logicState;
+	compare(out, "left score", sl.leftScore, rl.leftScore);
+	compare(out, "right score", sl.rightScore, rl.rightScore);
+	compare(out, "serving player", (int)sl.servingPlayer, (int)rl.servingPlayer);
+	compare(out, "winning player", (int)sl.winningPlayer, (int)rl.winningPlayer);
+	compare(out, "squish wall", sl.squishWall, rl.squishWall);
+	compare(out, "squish ground", sl.squishGround, rl.squishGround);
+	compare(out, "game running", sl.isGameRunning, rl.isGameRunning);
+	compare(out, "ball valid", sl.isBallValid, rl.isBallValid);
+	for(int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		const char* side = i == LEFT_PLAYER ? "left " : "right ";
+		compare(out, (side + std::string("hit count")).c_str(), sl.hitCount[i], rl.hitCount[i]);
+		compare(out, (side + std::string("squish")).c_str(), sl.squish[i], rl.squish[i]);
+		compare(out, (side + std::string("input")).c_str(),
+				(int)simulated.playerInput[i].getAll(), (int)recorded.playerInput[i].getAll());
+	}
+
+	return out.str();
+}
+
+ReplayCheckResult checkReplay(IReplayLoader& loader, DuelMatch& match)
+{
+	ReplayCheckResult result;
+	InputSource* left = match.getInputSource(LEFT_PLAYER).get();
+	InputSource* right = match.getInputSource(RIGHT_PLAYER).get();
+
+	// the recorder saves the state before each step, so savepoint n is the state after n steps, and input n
+	// is the input of the n-th step. Input 0 is the input before the first step, which is not simulated.
+	// This is the same order ReplayPlayer::play uses.
+	ReplaySavePoint reference;
+	int length = loader.getLength();
+	for(int step = 0; step < length; ++step)
+	{
+		if(step > 0)
+		{
+			loader.getInputAt(step, left, right);
+			match.step();
+			++result.steps;
+		}
+
+		int point;
+		if(!loader.isSavePoint(step, point))
+			continue;
+
+		loader.readSavePoint(point, reference);
+		++result.savepoints;
+		std::string difference = describeStateDifference(match.getState(), reference.state);
+		if(!difference.empty())
+		{
+			result.divergence = step;
+			result.difference = difference;
+			break;
+		}
+		result.lastMatch = step;
+	}
+
+	return result;
+}
@@ -0,0 +1,46 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <string>
+
+struct DuelMatchState;
+class DuelMatch;
+class IReplayLoader;
+
+/// \brief result of re-simulating a replay with checkReplay
+struct ReplayCheckResult
+{
+	int steps = 0;				///< simulated steps
+	int savepoints = 0;			///< savepoints that have been compared
+	int lastMatch = -1;			///< last savepoint step that was reproduced correctly
+	int divergence = -1;		///< first savepoint step at which the simulation differs from the replay
+	std::string difference;		///< description of the difference at that step
+};
+
+/// \brief lists all fields in which the states differ. An empty string means the states are identical.
+/// \details floats are compared by their bit pattern, so -0 and 0 are different and NaN equals itself.
+std::string describeStateDifference(const DuelMatchState& simulated, const DuelMatchState& recorded);
+
+/// \brief simulates the replay of \p loader and compares the state at each savepoint bit by bit.
+/// \details \p match has to be a new match with the rules and the physics of the replay. The check stops
+///			at the first savepoint that is not reproduced.
+ReplayCheckResult checkReplay(IReplayLoader& loader, DuelMatch& match);
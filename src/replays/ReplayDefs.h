@@ -20,13 +20,85 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <cstdint>
+
 struct ReplaySavePoint;
 
 constexpr const char legacyHeader[4] = { 'B', 'V', '2', 'R' };	//!< header of replay file
 /// \todo add warning when trying to read old files
 
-constexpr const unsigned char REPLAY_FILE_VERSION_MAJOR = 2;
-constexpr const unsigned char REPLAY_FILE_VERSION_MINOR = 0;
+constexpr const char replayHeaderV3[4] = { 'B', 'V', '3', 'R' };	//!< magic of binary (v3) replay files
+
+constexpr const unsigned char REPLAY_FILE_VERSION_MAJOR = 3;
+constexpr const unsigned char REPLAY_FILE_VERSION_MINOR = 1;
+
+/*
+	Layout of binary replay files (version 3.1). All integers are little endian, all offsets are
+	counted from the start of the file. The sections can be used directly from a memory mapped file.
+
+	header (REPLAY_V3_HEADER_SIZE bytes)
+		 0	char[4]	magic "BV3R"
+		 4	u8		major version, u8 minor version, u16 header size
+		 8	u32		metadata offset,		u32 metadata size
+		16	u32		rules offset,			u32 rules size
+		24	u32		savepoint index offset,	u32 savepoint count
+		32	u32		savepoint data offset,	u32 savepoint data size
+		40	u32		input offset,			u32 input size
+		48	u32		input encoding (REPLAY_V3_INPUT_RAW or REPLAY_V3_INPUT_RLE)
+		52	reserved, zero
+	metadata
+		 0	u32		game speed, u32 length in steps, u32 duration in seconds,
+			u32		physic backend (REPLAY_V3_PHYSICS_FLOAT or REPLAY_V3_PHYSICS_FIXED_POINT, 3.1 and later)
+		16	i64		date
+		24	u32		score left, u32 score right, u32 color left, u32 color right
+		40	u16		length of left name, u16 length of right name, u32 reserved
+		48	left name, right name (not null terminated)
+	rules: the rules script as text
+	savepoint index: per savepoint u32 step, u32 offset into savepoint data, u32 size,
+		u32 offset into the input where decoding of this step can start
+	savepoint data: the savepoints, each serialized with GenericOut into its own byte range
+	input: either one byte per step, as in the v2 format, or run length encoded as described
+		in ReplayInputCodec.h
+*/
+constexpr const std::uint32_t REPLAY_V3_HEADER_SIZE = 64;
+constexpr const std::uint32_t REPLAY_V3_METADATA_SIZE = 48;	//!< size of the metadata without the names
+constexpr const std::uint32_t REPLAY_V3_INDEX_ENTRY_SIZE = 16;
+constexpr const std::uint32_t REPLAY_V3_INPUT_RAW = 0;
+constexpr const std::uint32_t REPLAY_V3_INPUT_RLE = 1;
+constexpr const std::uint32_t REPLAY_V3_PHYSICS_FLOAT = 0;	//!< also the value of the reserved field in 3.0 files
+constexpr const std::uint32_t REPLAY_V3_PHYSICS_FIXED_POINT = 1;
+
+inline std::uint16_t readLE16(const unsigned char* data)
+{
+	return data[0] | (data[1] << 8);
+}
+
+inline std::uint32_t readLE32(const unsigned char* data)
+{
+	return std::uint32_t(data[0]) | (std::uint32_t(data[1]) << 8) | (std::uint32_t(data[2]) << 16) | (std::uint32_t(data[3]) << 24);
+}
+
+inline std::uint64_t readLE64(const unsigned char* data)
+{
+	return std::uint64_t(readLE32(data)) | (std::uint64_t(readLE32(data + 4)) << 32);
+}
+
+inline void writeLE(unsigned char* target, std::uint64_t value, int bytes)
+{
+	for(int i = 0; i < bytes; ++i)
+		target[i] = (value >> (8 * i)) & 0xFF;
+}
 
 // 10 secs for normal gamespeed
 const int REPLAY_SAVEPOINT_PERIOD = 750;
+
+// default distance of the additional savepoints the ReplayPlayer keeps in memory for seeking, 2 secs
+const int REPLAY_SEEK_SAVEPOINT_DISTANCE = 150;
+
+// maximum number of these savepoints, about 250 kB. When it is reached, the one farthest from the current
+// position is dropped, so the savepoints cover the 17 minutes around the position at the default distance.
+const int REPLAY_SEEK_CACHE_SIZE = 512;
+
+// number of consecutive states the ReplayPlayer keeps for reverse playback, 10 secs.
+// Resimulating from a savepoint fills the whole buffer, so this has to be at least REPLAY_SAVEPOINT_PERIOD.
+const int REPLAY_REWIND_BUFFER_SIZE = REPLAY_SAVEPOINT_PERIOD;
@@ -0,0 +1,321 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ReplayExport.h"
+
+/* includes */
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "FileWrite.h"
+#include "ReplayDefs.h"
+#include "ReplayPlayer.h"
+
+/* implementation */
+
+// Exports the state of every frame of a set of replays, so they can be analysed without resimulating
+// them. Each replay is played with a ReplayPlayer and written to <name>.frames,
+// and optionally to <name>.csv and <name>.events.csv.
+//
+// The .frames format is columnar and written in blocks, so exporting needs only memory for a single
+// block, no matter how long the replay is. All numbers are little endian.
+//	header:	"BVXF", u16 version, u16 column count,
+//			for each column: u8 type, u8 name length, name
+//			types are 'f' (32 bit float), 'i' (32 bit signed integer) and 'b' (8 bit signed integer)
+//	blocks until the end of the file:
+//			u32 frame count n, u32 event count m,
+//			n values of each column in header order,
+//			the event columns: m x i32 frame, m x b type, m x b side, m x f intensity
+//			event types are the values of MatchEvent::EventType
+
+namespace
+{
+	const std::uint16_t EXPORT_VERSION = 1;
+	const int EXPORT_BLOCK_FRAMES = 4096;
+
+	struct ColumnInfo
+	{
+		const char* name;
+		char type;
+	};
+
+	/// columns of the frame data, in the order writeFrame produces them
+	const ColumnInfo FRAME_COLUMNS[] = {
+		{"frame", 'i'},
+		{"left_blob_x", 'f'}, {"left_blob_y", 'f'}, {"left_blob_vx", 'f'}, {"left_blob_vy", 'f'}, {"left_blob_state", 'f'},
+		{"right_blob_x", 'f'}, {"right_blob_y", 'f'}, {"right_blob_vx", 'f'}, {"right_blob_vy", 'f'}, {"right_blob_state", 'f'},
+		{"ball_x", 'f'}, {"ball_y", 'f'}, {"ball_vx", 'f'}, {"ball_vy", 'f'},
+		{"ball_rotation", 'f'}, {"ball_angular_velocity", 'f'},
+		{"left_score", 'i'}, {"right_score", 'i'}, {"left_hits", 'i'}, {"right_hits", 'i'},
+		{"serving_player", 'b'}, {"winning_player", 'b'},
+		{"left_squish", 'i'}, {"right_squish", 'i'}, {"squish_wall", 'i'}, {"squish_ground", 'i'},
+		{"game_running", 'b'}, {"ball_valid", 'b'},
+		{"left_input", 'b'}, {"right_input", 'b'}
+	};
+	const int FRAME_COLUMN_COUNT = sizeof(FRAME_COLUMNS) / sizeof(FRAME_COLUMNS[0]);
+
+	/*! \class FrameExporter
+		\brief writes the frames of a single replay
+		\details Values are collected per column until a block is full, and then written as a whole.
+				The CSV files are written row by row.
+	*/
+	class FrameExporter
+	{
+		public:
+			FrameExporter(const std::string& path, bool csv) : mColumns(FRAME_COLUMN_COUNT), mColumn(0), mFrames(0),
+				mEvents(0), mBytes(0)
+			{
+				mBinary.open(path + ".frames", std::ios::binary);
+				if(csv)
+				{
+					mCsv.open(path + ".csv");
+					mEventCsv.open(path + ".events.csv");
+				}
+				if(!mBinary || (csv && (!mCsv || !mEventCsv)))
+					throw std::runtime_error("could not create " + path + ".frames");
+
+				for(auto& column : mColumns)
+					column.reserve(EXPORT_BLOCK_FRAMES * sizeof(float));
+
+				// header
+				unsigned char header[8] = {'B', 'V', 'X', 'F'};
+				writeLE(header + 4, EXPORT_VERSION, 2);
+				writeLE(header + 6, FRAME_COLUMN_COUNT, 2);
+				write(header, sizeof(header));
+				for(const auto& column : FRAME_COLUMNS)
+				{
+					unsigned char info[2] = {(unsigned char)column.type, (unsigned char)std::strlen(column.name)};
+					write(info, 2);
+					write(column.name, info[1]);
+				}
+
+				if(mCsv)
+				{
+					for(int i = 0; i < FRAME_COLUMN_COUNT; ++i)
+						mCsv << (i ? "," : "") << FRAME_COLUMNS[i].name;
+					mCsv << "\n";
+					mEventCsv << "frame,type,side,intensity\n";
+				}
+			}
+
+			void addFrame(int frame, const DuelMatchState& state, const MatchEventBuffer& events)
+			{
+				mColumn = 0;
+				value(frame);
+				const PhysicState& world = state.worldState;
+				for(int side = LEFT_PLAYER; side <= RIGHT_PLAYER; ++side)
+				{
+					value(world.blobPosition[side].x);
+					value(world.blobPosition[side].y);
+					value(world.blobVelocity[side].x);
+					value(world.blobVelocity[side].y);
+					value(world.blobState[side]);
+				}
+				value(world.ballPosition.x);
+				value(world.ballPosition.y);
+				value(world.ballVelocity.x);
+				value(world.ballVelocity.y);
+				value(world.ballRotation);
+				value(world.ballAngularVelocity);
+
+				const GameLogicState& logic = state.logicState;
+				value((int)logic.leftScore);
+				value((int)logic.rightScore);
+				value((int)logic.hitCount[LEFT_PLAYER]);
+				value((int)logic.hitCount[RIGHT_PLAYER]);
+				value((signed char)logic.servingPlayer);
+				value((signed char)logic.winningPlayer);
+				value((int)logic.squish[LEFT_PLAYER]);
+				value((int)logic.squish[RIGHT_PLAYER]);
+				value((int)logic.squishWall);
+				value((int)logic.squishGround);
+				value((signed char)logic.isGameRunning);
+				value((signed char)logic.isBallValid);
+				value((signed char)state.playerInput[LEFT_PLAYER].getAll());
+				value((signed char)state.playerInput[RIGHT_PLAYER].getAll());
+				assert(mColumn == FRAME_COLUMN_COUNT);
+
+				if(mCsv)
+					mCsv << "\n";
+
+				for(const auto& event : events)
+				{
+					append(mEventColumns[0], frame, 4);
+					append(mEventColumns[1], event.event, 1);
+					append(mEventColumns[2], event.side, 1);
+					append(mEventColumns[3], floatBits(event.intensity), 4);
+					++mEvents;
+
+					if(mEventCsv)
+						mEventCsv << frame << "," << (int)event.event << "," << (int)event.side << "," << event.intensity << "\n";
+				}
+
+				if(++mFrames == EXPORT_BLOCK_FRAMES)
+					flushBlock();
+			}
+
+			/// writes the last block
+			/// \return number of bytes of the binary file
+			std::uint64_t finish()
+			{
+				flushBlock();
+				mBinary.close();
+				mCsv.close();
+				mEventCsv.close();
+				if(!mBinary)
+					throw std::runtime_error("could not write frames");
+				return mBytes;
+			}
+
+		private:
+			static std::uint32_t floatBits(float value)
+			{
+				std::uint32_t bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				return bits;
+			}
+
+			static void append(std::vector<unsigned char>& target, std::uint32_t value, int bytes)
+			{
+				unsigned char buffer[4];
+				writeLE(buffer, value, bytes);
+				target.insert(target.end(), buffer, buffer + bytes);
+			}
+
+			void value(float data)
+			{
+				assert(FRAME_COLUMNS[mColumn].type == 'f');
+				append(mColumns[mColumn], floatBits(data), 4);
+				if(mCsv)
+					mCsv << (mColumn ? "," : "") << data;
+				++mColumn;
+			}
+
+			void value(int data)
+			{
+				assert(FRAME_COLUMNS[mColumn].type == 'i');
+				append(mColumns[mColumn], data, 4);
+				if(mCsv)
+					mCsv << (mColumn ? "," : "") << data;
+				++mColumn;
+			}
+
+			void value(signed char data)
+			{
+				assert(FRAME_COLUMNS[mColumn].type == 'b');
+				append(mColumns[mColumn], (unsigned char)data, 1);
+				if(mCsv)
+					mCsv << (mColumn ? "," : "") << (int)data;
+				++mColumn;
+			}
+
+			void write(const void* data, std::size_t length)
+			{
+				mBinary.write((const char*)data, length);
+				mBytes += length;
+			}
+
+			void flushBlock()
+			{
+				if(mFrames == 0)
+					return;
+
+				unsigned char counts[8];
+				writeLE(counts, mFrames, 4);
+				writeLE(counts + 4, mEvents, 4);
+				write(counts, sizeof(counts));
+
+				for(auto& column : mColumns)
+				{
+					write(column.data(), column.size());
+					column.clear();
+				}
+				for(auto& column : mEventColumns)
+				{
+					write(column.data(), column.size());
+					column.clear();
+				}
+
+				mFrames = 0;
+				mEvents = 0;
+			}
+
+			std::ofstream mBinary;
+			std::ofstream mCsv;
+			std::ofstream mEventCsv;
+
+			std::vector<std::vector<unsigned char>> mColumns;
+			std::vector<unsigned char> mEventColumns[4];
+			int mColumn;
+			int mFrames;				///< frames in the current block
+			int mEvents;				///< events in the current block
+			std::uint64_t mBytes;
+	};
+}
+
+ReplayExportResult exportReplay(const std::string& file, const std::string& output, bool csv,
+								const std::string& rules_name, int score_to_win)
+{
+	ReplayExportResult result;
+	try
+	{
+		ReplayPlayer player;
+		player.load(file);
+		// the in-memory savepoints are only needed for seeking, and would grow with the replay length
+		player.setSavePointDistance(std::numeric_limits<int>::max());
+
+		FileWrite rules_file("rules/" + rules_name);
+		rules_file.write(player.getRules());
+		rules_file.close();
+
+		DuelMatch match(false, rules_name, score_to_win, player.getPhysicBackend());
+		match.setPlayers(PlayerIdentity{player.getPlayerName(LEFT_PLAYER)},
+						 PlayerIdentity{player.getPlayerName(RIGHT_PLAYER)});
+
+		FrameExporter exporter(output, csv);
+
+		// start from the state recorded for the first step
+		player.gotoPlayingPosition(0, &match);
+		exporter.addFrame(0, match.getState(), MatchEventBuffer());
+		++result.frames;
+		while(player.play(&match))
+		{
+			exporter.addFrame(player.getReplayPosition(), match.getState(), match.getEvents());
+			++result.frames;
+		}
+
+		result.bytes = exporter.finish();
+	}
+	catch(const std::exception& ex)
+	{
+		result.error = ex.what();
+		if(result.error.empty())
+			result.error = "could not read replay";
+	}
+
+	return result;
+}
@@ -0,0 +1,40 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/// \brief result of exporting a replay with exportReplay
+struct ReplayExportResult
+{
+	std::string error;			///< empty if the replay has been exported
+	std::uint64_t frames = 0;	///< exported frames
+	std::uint64_t bytes = 0;	///< size of the .frames file
+};
+
+/// \brief plays the replay \p file and writes the state of every frame to \p output.frames, and to
+///		\p output.csv and \p output.events.csv if \p csv is set.
+/// \details The match uses the physics backend that the replay was recorded with.
+/// \param rules_name name of the rules file the rules of the replay are written to. Each thread needs
+///		its own.
+ReplayExportResult exportReplay(const std::string& file, const std::string& output, bool csv,
+								const std::string& rules_name, int score_to_win);
@@ -0,0 +1,123 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ReplayInputCodec.h"
+
+/* includes */
+#include <cassert>
+#include <stdexcept>
+
+#include <boost/throw_exception.hpp>
+
+/* implementation */
+
+namespace
+{
+	const std::uint8_t RUN_START_BIT = 1u << 7u;
+	const std::uint8_t INPUT_MASK = 0x3F;
+
+	void writeRun(std::uint8_t packet, unsigned int length, std::vector<std::uint8_t>& target)
+	{
+		// the marker bit is always set, the finishing padding of the recorder uses 0
+		target.push_back(RUN_START_BIT | (packet & INPUT_MASK));
+		for(unsigned int rest = length - 1; rest != 0; rest >>= 7u)
+			target.push_back(rest & 0x7F);
+	}
+}
+
+ReplayInputEncoder::ReplayInputEncoder() : mPacket(0), mRunLength(0)
+{
+}
+
+void ReplayInputEncoder::add(std::uint8_t packet, std::vector<std::uint8_t>& target)
+{
+	packet = RUN_START_BIT | (packet & INPUT_MASK);
+	if(mRunLength > 0 && (packet != mPacket || mRunLength == MAX_RUN_LENGTH))
+		finishRun(target);
+
+	mPacket = packet;
+	++mRunLength;
+}
+
+void ReplayInputEncoder::finishRun(std::vector<std::uint8_t>& target)
+{
+	writePending(target);
+	mRunLength = 0;
+}
+
+void ReplayInputEncoder::writePending(std::vector<std::uint8_t>& target) const
+{
+	if(mRunLength > 0)
+		writeRun(mPacket, mRunLength, target);
+}
+
+void ReplayInputEncoder::reset()
+{
+	mRunLength = 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+ReplayInputDecoder::ReplayInputDecoder(const std::uint8_t* data, std::size_t size) :
+	mData(data), mSize(size), mRunOffset(0), mNextOffset(0), mRunStep(0), mRunLength(0), mPacket(0)
+{
+}
+
+void ReplayInputDecoder::seek(std::size_t offset, unsigned int step)
+{
+	mRunOffset = offset;
+	mNextOffset = offset;
+	mRunStep = step;
+	mRunLength = 0;
+}
+
+std::uint8_t ReplayInputDecoder::get(unsigned int step)
+{
+	assert(step >= mRunStep);
+
+	while(step - mRunStep >= mRunLength)
+	{
+		mRunStep += mRunLength;
+		mRunOffset = mNextOffset;
+		readRun();
+	}
+
+	return mPacket;
+}
+
+void ReplayInputDecoder::readRun()
+{
+	if(mNextOffset >= mSize || !(mData[mNextOffset] & RUN_START_BIT))
+		BOOST_THROW_EXCEPTION( std::runtime_error("corrupt replay input") );
+
+	mPacket = mData[mNextOffset++];
+
+	unsigned int rest = 0;
+	for(unsigned int shift = 0; mNextOffset < mSize && !(mData[mNextOffset] & RUN_START_BIT); shift += 7)
+	{
+		if(shift > 28 || (shift == 28 && mData[mNextOffset] > 0xF))
+			BOOST_THROW_EXCEPTION( std::runtime_error("corrupt replay input") );
+		rest |= (unsigned int)mData[mNextOffset++] << shift;
+	}
+	if(rest == ReplayInputEncoder::MAX_RUN_LENGTH)
+		BOOST_THROW_EXCEPTION( std::runtime_error("corrupt replay input") );
+	mRunLength = rest + 1;
+}
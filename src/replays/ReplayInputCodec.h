@@ -0,0 +1,97 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+	Run length encoded replay input (REPLAY_V3_INPUT_RLE).
+
+	The input is stored as a sequence of runs of steps with identical input. A run starts with the
+	input byte of its steps, which always has the highest bit set. It is followed by zero or more
+	length bytes with the highest bit cleared, which contain (run length - 1) in groups of 7 bits,
+	least significant group first. A run of a single step is thus just the input byte. Runs are at
+	most ReplayInputEncoder::MAX_RUN_LENGTH steps long, longer ones are split.
+
+	Runs never continue across savepoints: every savepoint step starts a new run, so decoding can
+	start at the offset of any savepoint.
+*/
+
+/*! \class ReplayInputEncoder
+	\brief streaming encoder for replay input.
+	\details Keeps the run that is currently being recorded and appends completed runs to a buffer.
+*/
+class ReplayInputEncoder
+{
+	public:
+		/// longest run that fits into the length bytes
+		static const unsigned int MAX_RUN_LENGTH = 0xFFFFFFFFu;
+
+		ReplayInputEncoder();
+
+		/// adds the input of the next step. Completed runs are appended to \p target.
+		void add(std::uint8_t packet, std::vector<std::uint8_t>& target);
+		/// ends the current run, so the next step starts a new one.
+		void finishRun(std::vector<std::uint8_t>& target);
+		/// appends the current, unfinished run to \p target without ending it.
+		void writePending(std::vector<std::uint8_t>& target) const;
+		/// drops the current run.
+		void reset();
+
+	private:
+		std::uint8_t mPacket;
+		unsigned int mRunLength;
+};
+
+/*! \class ReplayInputDecoder
+	\brief decodes run length encoded replay input.
+	\details Decoding is sequential, starting at the beginning of the input or at a run start set
+			with seek. The decoder does not own the data.
+	\exception std::runtime_error if the input is corrupt
+*/
+class ReplayInputDecoder
+{
+	public:
+		ReplayInputDecoder(const std::uint8_t* data, std::size_t size);
+
+		/// continue decoding with the run at \p offset, which starts at \p step.
+		void seek(std::size_t offset, unsigned int step);
+		/// gets the input of \p step. \p step must not be before the current run.
+		std::uint8_t get(unsigned int step);
+
+		/// offset of the current run
+		std::size_t getRunOffset() const { return mRunOffset; }
+		/// first step of the current run
+		unsigned int getRunStep() const { return mRunStep; }
+
+	private:
+		void readRun();
+
+		const std::uint8_t* mData;
+		std::size_t mSize;
+		std::size_t mRunOffset;
+		std::size_t mNextOffset;
+		unsigned int mRunStep;
+		unsigned int mRunLength;
+		std::uint8_t mPacket;
+};
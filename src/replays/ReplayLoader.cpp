@@ -22,11 +22,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "IReplayLoader.h"
 
 /* includes */
+#include <algorithm>
 #include <cassert>
 #include <vector>
 #include <ctime>
 #include <memory>
 #include <iostream> // debugging
+#include <limits>
+#include <stdexcept>
+
+#include <boost/throw_exception.hpp>
 
 #include "tinyxml2.h"
 
@@ -34,6 +39,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "InputSource.h"
 #include "FileRead.h"
+#include "MappedFile.h"
+#include "ReplayInputCodec.h"
 #include "GenericIO.h"
 #include "base64.h"
 #include "ReplayDefs.h"
@@ -42,7 +49,18 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 /* implementation */
 IReplayLoader* IReplayLoader::createReplayLoader(const std::string& filename)
 {
-	std::unique_ptr<IReplayLoader> loader(createReplayLoader(0));
+	// binary replays start with a magic number, everything else is treated as an xml (v2) replay
+	int major = 2;
+	{
+		FileRead file(filename);
+		char magic[4] = {0};
+		if(file.length() >= 4)
+			file.readRawBytes(magic, 4);
+		if(std::equal(magic, magic + 4, replayHeaderV3))
+			major = 3;
+	}
+
+	std::unique_ptr<IReplayLoader> loader(createReplayLoader(major));
 	loader->initLoading(filename);
 
 	return loader.release();
@@ -78,7 +96,7 @@ class ReplayLoader_V2X: public IReplayLoader
 			if(player == RIGHT_PLAYER)
 				return mRightPlayerName;
 
-			assert(0);
+			BOOST_THROW_EXCEPTION(std::invalid_argument("invalid player side"));
 		}
 
 		Color getBlobColor(PlayerSide player) const override
@@ -88,7 +106,7 @@ class ReplayLoader_V2X: public IReplayLoader
 			if(player == RIGHT_PLAYER)
 				return mRightColor;
 
-			assert(0);
+			BOOST_THROW_EXCEPTION(std::invalid_argument("invalid player side"));
 		}
 
 
@@ -99,7 +117,7 @@ class ReplayLoader_V2X: public IReplayLoader
 			if(player == RIGHT_PLAYER)
 				return mRightFinalScore;
 
-			assert(0);
+			BOOST_THROW_EXCEPTION(std::invalid_argument("invalid player side"));
 		}
 
 		int getSpeed() const override
@@ -151,42 +169,17 @@ class ReplayLoader_V2X: public IReplayLoader
 			return save_position != -1 && foundPos == position;
 		}
 
-		// TODO: add optional argument: int previous = 0;
-		// 		so we can start from it when calling
-		// 		getSavePoint in a row (without "jumping").
-		// 		we can save this parameter in ReplayPlayer
 		int getSavePoint(int targetPosition, int& savepoint) const override
 		{
-			// desired index can't be lower that this value,
-			// cause additional savepoints could shift it only right
-			int index = targetPosition / REPLAY_SAVEPOINT_PERIOD;
+			// savepoints are sorted by step, so we search for the first one after targetPosition
+			auto next = std::upper_bound(mSavePoints.begin(), mSavePoints.end(), targetPosition,
+										 [](int position, const ReplaySavePoint& sp) { return position < (int)sp.step; });
 
-			if(index >= static_cast<int>(mSavePoints.size()))
+			if(next == mSavePoints.begin())
 				return -1;
 
+			int index = (next - mSavePoints.begin()) - 1;
 			savepoint = mSavePoints[index].step;
-
-			// watch right from initial index,
-			// cause best savepoint could be there.
-			// we have no much additional savepoints,
-			// so this cycle would be fast,
-			// maybe even faster than binary search.
-			do
-			{
-				int nextIndex = index + 1;
-
-				if (nextIndex >= static_cast<int>(mSavePoints.size()))
-					break;
-
-				int nextPos = mSavePoints[nextIndex].step;
-
-				if (nextPos > targetPosition)
-					break;
-
-				index = nextIndex;
-				savepoint = nextPos;
-			} while (true);
-
 			return index;
 		}
 
@@ -321,7 +314,292 @@ class ReplayLoader_V2X: public IReplayLoader
 };
 
 
+/***************************************************************************************************
+			              R E P L A Y   L O A D E R    V 3.x
+***************************************************************************************************/
+
+
+/*! \class ReplayLoader_V3X
+	\brief Replay Loader V 3.x
+	\details Replay Loader for binary replays. The file is memory mapped and all data is read directly
+			from the mapping when it is requested, so loading only has to validate the header. See
+			ReplayDefs.h for the layout.
+*/
+class ReplayLoader_V3X: public IReplayLoader
+{
+	public:
+		ReplayLoader_V3X() : mDecoder(nullptr, 0)
+		{
+		}
+
+		~ReplayLoader_V3X() override = default;
+
+		int getVersionMajor() const override { return 3; };
+		int getVersionMinor() const override { return mFile->data()[5]; };
+
+		std::string getPlayerName(PlayerSide player) const override
+		{
+			const unsigned char* meta = mFile->data() + mMetadataOffset;
+			std::size_t left_length = readLE16(meta + 40);
+			const char* names = (const char*)meta + REPLAY_V3_METADATA_SIZE;
+			if(player == LEFT_PLAYER)
+				return std::string(names, left_length);
+			if(player == RIGHT_PLAYER)
+				return std::string(names + left_length, readLE16(meta + 42));
+
+			BOOST_THROW_EXCEPTION(std::invalid_argument("invalid player side"));
+		}
+
+		Color getBlobColor(PlayerSide player) const override
+		{
+			if(player == LEFT_PLAYER)
+				return Color(readMeta(32));
+			if(player == RIGHT_PLAYER)
+				return Color(readMeta(36));
+
+			BOOST_THROW_EXCEPTION(std::invalid_argument("invalid player side"));
+		}
+
+		int getFinalScore(PlayerSide player) const override
+		{
+			if(player == LEFT_PLAYER)
+				return readMeta(24);
+			if(player == RIGHT_PLAYER)
+				return readMeta(28);
+
+			BOOST_THROW_EXCEPTION(std::invalid_argument("invalid player side"));
+		}
+
+		int getSpeed() const override
+		{
+			return readMeta(0);
+		};
+
+		int getDuration() const override
+		{
+			return readMeta(8);
+		};
+
+		PhysicBackend getPhysicBackend() const override
+		{
+			return readMeta(12) == REPLAY_V3_PHYSICS_FIXED_POINT ? PhysicBackend::FIXED_POINT : PhysicBackend::FLOAT;
+		}
+
+		int getLength()  const override
+		{
+			return readMeta(4);
+		};
+
+		std::time_t getDate() const override
+		{
+			return (std::time_t)readLE64(mFile->data() + mMetadataOffset + 16);
+		};
+
+		std::string getRules() const override
+		{
+			return std::string((const char*)mFile->data() + mRulesOffset, mRulesSize);
+		}
+
+		void getInputAt(int step, InputSource* left, InputSource* right) override
+		{
+			assert( step < getLength() );
+
+			unsigned char packet;
+			if(mInputEncoding == REPLAY_V3_INPUT_RAW)
+			{
+				packet = mFile->data()[mInputOffset + step];
+			}
+			else
+			{
+				// playback decodes sequentially. For jumps, decoding starts at the closest savepoint.
+				unsigned int run_step = mDecoder.getRunStep();
+				if((unsigned int)step < run_step || (unsigned int)step - run_step > REPLAY_SAVEPOINT_PERIOD)
+				{
+					int savepoint_step;
+					int index = getSavePoint(step, savepoint_step);
+					if(index < 0)
+						mDecoder.seek(0, 0);
+					else if((unsigned int)step < run_step || (unsigned int)savepoint_step > run_step)
+						mDecoder.seek(readLE32(getIndexEntry(index) + 12), savepoint_step);
+				}
+				packet = mDecoder.get(step);
+			}
+
+			left->setInput(PlayerInput((bool)(packet & 32), (bool)(packet & 16), (bool)(packet & 8)));
+			right->setInput(PlayerInput((bool)(packet & 4), (bool)(packet & 2), (bool)(packet & 1)));
+		}
+
+		bool isSavePoint(int position, int& save_position) const override
+		{
+			int foundPos;
+			save_position = getSavePoint(position, foundPos);
+			return save_position != -1 && foundPos == position;
+		}
+
+		int getSavePoint(int targetPosition, int& savepoint) const override
+		{
+			// the index is sorted by step, so we search for the last entry that is not after targetPosition
+			int first = 0;
+			int last = mSavePointCount;
+			while(first < last)
+			{
+				int middle = first + (last - first) / 2;
+				if((int)getSavePointStep(middle) <= targetPosition)
+					first = middle + 1;
+				else
+					last = middle;
+			}
+
+			int index = first - 1;
+			if(index < 0)
+				return -1;
+
+			savepoint = getSavePointStep(index);
+			return index;
+		}
+
+		void prefetch(std::atomic<float>& progress, const std::atomic<bool>& cancel) const override
+		{
+			// input first, as playback needs it continuously; the savepoints are needed for seeking
+			const std::size_t CHUNK_SIZE = 256 * 1024;
+			const std::pair<std::size_t, std::size_t> sections[] = { {mInputOffset, mInputSize},
+																	 {mSavePointDataOffset, mSavePointDataSize} };
+			std::size_t total = mInputSize + mSavePointDataSize;
+			std::size_t done = 0;
+			for(const auto& section : sections)
+			{
+				for(std::size_t offset = 0; offset < section.second && !cancel; offset += CHUNK_SIZE)
+				{
+					std::size_t length = std::min(CHUNK_SIZE, section.second - offset);
+					mFile->prefetch(section.first + offset, length);
+					done += length;
+					progress = (float)done / total;
+				}
+			}
+			progress = 1.f;
+		}
+
+		void readSavePoint(int index, ReplaySavePoint& state) const override
+		{
+			if(index < 0 || index >= (int)mSavePointCount)
+				BOOST_THROW_EXCEPTION(std::out_of_range("invalid savepoint index"));
+
+			const unsigned char* entry = getIndexEntry(index);
+			RakNet::BitStream stream((unsigned char*)mFile->data() + mSavePointDataOffset + readLE32(entry + 4),
+									 readLE32(entry + 8), false);
+			auto convert = createGenericReader(&stream);
+			convert->generic<ReplaySavePoint>(state);
+		}
+
+	private:
+		void initLoading(std::string filename) override
+		{
+			mFile.reset(new MappedFile(filename));
+
+			const unsigned char* data = mFile->data();
+			std::size_t size = mFile->size();
+			if(size < REPLAY_V3_HEADER_SIZE || !std::equal(replayHeaderV3, replayHeaderV3 + 4, (const char*)data))
+				BOOST_THROW_EXCEPTION(std::runtime_error("not a binary replay file"));
+			if(data[4] != 3)
+				BOOST_THROW_EXCEPTION(std::runtime_error("unsupported replay version"));
+
+			std::uint32_t header_size = readLE16(data + 6);
+			if(header_size < REPLAY_V3_HEADER_SIZE || header_size > size)
+				BOOST_THROW_EXCEPTION(std::runtime_error("invalid replay header"));
+
+			mInputEncoding = readLE32(data + 48);
+			if(mInputEncoding != REPLAY_V3_INPUT_RAW && mInputEncoding != REPLAY_V3_INPUT_RLE)
+				BOOST_THROW_EXCEPTION(std::runtime_error("unsupported replay input encoding"));
+
+			mMetadataOffset = readLE32(data + 8);
+			std::uint32_t metadata_size = readLE32(data + 12);
+			mRulesOffset = readLE32(data + 16);
+			mRulesSize = readLE32(data + 20);
+			mIndexOffset = readLE32(data + 24);
+			mSavePointCount = readLE32(data + 28);
+			mSavePointDataOffset = readLE32(data + 32);
+			mSavePointDataSize = readLE32(data + 36);
+			mInputOffset = readLE32(data + 40);
+			mInputSize = readLE32(data + 44);
+
+			// all later accesses rely on the sections being inside the file
+			checkSection(mMetadataOffset, metadata_size, size);
+			checkSection(mRulesOffset, mRulesSize, size);
+			checkSection(mIndexOffset, (std::uint64_t)mSavePointCount * REPLAY_V3_INDEX_ENTRY_SIZE, size);
+			checkSection(mSavePointDataOffset, mSavePointDataSize, size);
+			checkSection(mInputOffset, mInputSize, size);
+
+			if(metadata_size < REPLAY_V3_METADATA_SIZE ||
+				metadata_size < REPLAY_V3_METADATA_SIZE + readLE16(data + mMetadataOffset + 40) + readLE16(data + mMetadataOffset + 42))
+				BOOST_THROW_EXCEPTION(std::runtime_error("invalid replay metadata"));
+
+			std::uint32_t physics = readMeta(12);
+			if(physics != REPLAY_V3_PHYSICS_FLOAT && physics != REPLAY_V3_PHYSICS_FIXED_POINT)
+				BOOST_THROW_EXCEPTION(std::runtime_error("unsupported physic backend"));
+
+			std::uint32_t length = readMeta(4);
+			if(length > (std::uint32_t)std::numeric_limits<int>::max() || mSavePointCount > (std::uint32_t)std::numeric_limits<int>::max())
+				BOOST_THROW_EXCEPTION(std::runtime_error("replay too long"));
+			if(mInputEncoding == REPLAY_V3_INPUT_RAW && length > mInputSize)
+				BOOST_THROW_EXCEPTION(std::runtime_error("replay input too short"));
+
+			std::uint32_t last_step = 0;
+			for(std::uint32_t i = 0; i < mSavePointCount; ++i)
+			{
+				const unsigned char* entry = getIndexEntry(i);
+				std::uint32_t step = readLE32(entry);
+				if(step < last_step)
+					BOOST_THROW_EXCEPTION(std::runtime_error("replay savepoints are not sorted"));
+				last_step = step;
+				checkSection(readLE32(entry + 4), readLE32(entry + 8), mSavePointDataSize);
+				if(readLE32(entry + 12) > mInputSize)
+					BOOST_THROW_EXCEPTION(std::runtime_error("corrupt replay file"));
+			}
+
+			mDecoder = ReplayInputDecoder(data + mInputOffset, mInputSize);
+		}
+
+		static void checkSection(std::uint64_t offset, std::uint64_t length, std::uint64_t size)
+		{
+			if(offset > size || length > size - offset)
+				BOOST_THROW_EXCEPTION(std::runtime_error("corrupt replay file"));
+		}
+
+		std::uint32_t readMeta(std::uint32_t field) const
+		{
+			return readLE32(mFile->data() + mMetadataOffset + field);
+		}
+
+		const unsigned char* getIndexEntry(int index) const
+		{
+			return mFile->data() + mIndexOffset + index * REPLAY_V3_INDEX_ENTRY_SIZE;
+		}
+
+		std::uint32_t getSavePointStep(int index) const
+		{
+			return readLE32(getIndexEntry(index));
+		}
+
+		std::unique_ptr<MappedFile> mFile;
+
+		std::uint32_t mMetadataOffset;
+		std::uint32_t mRulesOffset;
+		std::uint32_t mRulesSize;
+		std::uint32_t mIndexOffset;
+		std::uint32_t mSavePointCount;
+		std::uint32_t mSavePointDataOffset;
+		std::uint32_t mSavePointDataSize;
+		std::uint32_t mInputOffset;
+		std::uint32_t mInputSize;
+		std::uint32_t mInputEncoding;
+
+		ReplayInputDecoder mDecoder;
+};
+
+
 IReplayLoader* IReplayLoader::createReplayLoader(int major)
 {
+	if(major == 3)
+		return new ReplayLoader_V3X();
 	return new ReplayLoader_V2X();
 }
@@ -22,15 +22,26 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ReplayPlayer.h"
 
 /* includes */
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 
 #include "IReplayLoader.h"
 #include "DuelMatch.h"
 
 /* implementation */
-ReplayPlayer::ReplayPlayer() = default;
+ReplayPlayer::ReplayPlayer() : mPosition(0), mLength(0), mSavePointDistance(REPLAY_SEEK_SAVEPOINT_DISTANCE),
+	mRecentStates(REPLAY_REWIND_BUFFER_SIZE), mRecentFirst(0), mRecentCount(0), mRecentHead(0),
+	mLoadState(LOAD_FINISHED), mLoadProgress(1.f), mCancelLoading(false)
+{
+}
 
-ReplayPlayer::~ReplayPlayer() = default;
+ReplayPlayer::~ReplayPlayer()
+{
+	mCancelLoading = true;
+	if(mLoadThread.joinable())
+		mLoadThread.join();
+}
 
 bool ReplayPlayer::endOfFile() const
 {
@@ -39,13 +50,71 @@ bool ReplayPlayer::endOfFile() const
 
 void ReplayPlayer::load(const std::string& filename)
 {
-	loader.reset(IReplayLoader::createReplayLoader(filename));
+	initPlayback(std::unique_ptr<IReplayLoader>(IReplayLoader::createReplayLoader(filename)));
+}
+
+void ReplayPlayer::loadAsync(const std::string& filename)
+{
+	assert(!mLoadThread.joinable());
+
+	mLoadState = LOAD_RUNNING;
+	mLoadProgress = 0.f;
+	mLoadThread = std::thread([this, filename]()
+	{
+		const IReplayLoader* replay_loader = nullptr;
+		try
+		{
+			mLoadedLoader.reset(IReplayLoader::createReplayLoader(filename));
+			replay_loader = mLoadedLoader.get();
+			mLoadState = LOAD_FINISHED;
+		}
+		catch(...)
+		{
+			mLoadError = std::current_exception();
+			mLoadState = LOAD_FAILED;
+			return;
+		}
+
+		// the loader is used by the main thread from now on, prefetch does not change it.
+		replay_loader->prefetch(mLoadProgress, mCancelLoading);
+	});
+}
+
+bool ReplayPlayer::isLoaded()
+{
+	if(loader)
+		return true;
+
+	switch(mLoadState)
+	{
+		case LOAD_FINISHED:
+			initPlayback(std::move(mLoadedLoader));
+			return true;
+		case LOAD_FAILED:
+			if(mLoadThread.joinable())
+				mLoadThread.join();
+			std::rethrow_exception(mLoadError);
+		default:
+			return false;
+	}
+}
+
+float ReplayPlayer::getLoadProgress() const
+{
+	return mLoadProgress;
+}
+
+void ReplayPlayer::initPlayback(std::unique_ptr<IReplayLoader> replay_loader)
+{
+	loader = std::move(replay_loader);
 
 	mPlayerNames[LEFT_PLAYER] = loader->getPlayerName(LEFT_PLAYER);
 	mPlayerNames[RIGHT_PLAYER] = loader->getPlayerName(RIGHT_PLAYER);
 
 	mPosition = 0;
 	mLength = loader->getLength();
+	mStateCache.clear();
+	mRecentCount = 0;
 }
 
 std::string ReplayPlayer::getPlayerName(const PlayerSide side) const
@@ -63,6 +132,11 @@ int ReplayPlayer::getGameSpeed() const
 	return loader->getSpeed();
 }
 
+PhysicBackend ReplayPlayer::getPhysicBackend() const
+{
+	return loader->getPhysicBackend();
+}
+
 float ReplayPlayer::getPlayProgress() const
 {
 	return (float)mPosition / mLength;
@@ -78,6 +152,11 @@ int ReplayPlayer::getReplayLength() const
 	return mLength;
 }
 
+int ReplayPlayer::getCachedStateCount() const
+{
+	return mStateCache.size();
+}
+
 std::string ReplayPlayer::getRules() const
 {
 	return loader->getRules();
@@ -101,6 +180,8 @@ bool ReplayPlayer::play(DuelMatch* virtual_match)
 			virtual_match->setState(reference.state);
 		}
 
+		cacheState(virtual_match);
+		storeRecentState(virtual_match);
 
 		// everything was as expected
 		return true;
@@ -110,53 +191,144 @@ bool ReplayPlayer::play(DuelMatch* virtual_match)
 	return false;
 }
 
+bool ReplayPlayer::playBackwards(DuelMatch* virtual_match)
+{
+	if(mPosition <= 0)
+		return false;
+
+	// if the previous state is no longer buffered, this simulates from the closest savepoint
+	// and thereby refills the rewind buffer.
+	return gotoPlayingPosition(mPosition - 1, virtual_match);
+}
+
 bool ReplayPlayer::gotoPlayingPosition(int rep_position, DuelMatch* virtual_match)
 {
-	/// \todo add validity check for rep_position
 	/// \todo replay clock does not work!
+	rep_position = std::max(0, std::min(rep_position, mLength));
+
+	// recently played positions do not need any simulation
+	int recent = findRecentState(rep_position);
+	if(recent >= 0)
+	{
+		virtual_match->restoreSnapshot(mRecentStates[recent]);
+		mPosition = rep_position;
+		return true;
+	}
 
-	// find next safepoint
+	// find the closest state before rep_position we can start from.
+	// the current position is the best candidate, if we move forward
+	int start = rep_position >= mPosition ? mPosition : -1;
+
+	// savepoint from the replay file
 	int save_position = -1;
 	int savepoint = loader->getSavePoint(rep_position, save_position);
-	// save position contains game step at which the save point is
-	// savepoint is index of save point in array
+	if(savepoint < 0)
+		save_position = -1;
+
+	// in-memory savepoint
+	auto cached = mStateCache.upper_bound(rep_position);
+	int cache_position = -1;
+	if(cached != mStateCache.begin())
+	{
+		--cached;
+		cache_position = cached->first;
+	}
 
-	// now compare safepoint and actual position
-	// if we have to forward and save_position is nearer than current position, jump
-	if( (rep_position < mPosition || save_position > mPosition) && savepoint >= 0)
+	// a savepoint at the current position is used as well, so seeking to 0 after loading starts
+	// from the recorded state instead of a fresh match. The savepoints of the file lack the blob animation
+	// and the script variables, so an in-memory savepoint up to one savepoint distance before is preferred.
+	bool use_cache = cache_position >= 0 && save_position - cache_position < mSavePointDistance;
+	if(savepoint >= 0 && save_position >= start && !use_cache)
 	{
-		// can't use mPosition
-		// set match to safepoint
 		ReplaySavePoint state;
 		loader->readSavePoint(savepoint, state);
-
-		// set position and update match
-		mPosition = save_position;
 		virtual_match->setState(state.state);
+		mPosition = save_position;
 	}
-	// otherwise, use current position
-
-	// this is legacy code which will make fast forwarding possible even
-	// when we have no safepoint and have to go back
-	if(rep_position < mPosition)
+	else if(cache_position > start)
 	{
-		// reset the match and simulate from start!
+		virtual_match->restoreSnapshot(cached->second);
+		mPosition = cache_position;
+	}
+	else if(start < 0)
+	{
+		// no savepoint at all, simulate from start
 		virtual_match->reset();
 		mPosition = 0;
 	}
 
-	// in the end, simulate the remaining steps
-	// maximum: 100 steps
-	for(int i = 0; i < 100; ++i)
-	{
-		// check if we have to do another step
-		if(endOfFile() || rep_position == mPosition)
-			return true;
+	// the simulated steps refill the rewind buffer, starting from the savepoint
+	storeRecentState(virtual_match);
 
-		// do one play step
+	// simulate the remaining steps. Their number is bounded by the savepoint distances.
+	while(!endOfFile() && mPosition < rep_position)
+	{
 		play(virtual_match);
+	}
+
+	return mPosition == rep_position;
+}
+
+void ReplayPlayer::setSavePointDistance(int steps)
+{
+	assert(steps > 0);
+	mSavePointDistance = steps;
+	mStateCache.clear();
+}
+
+void ReplayPlayer::cacheState(const DuelMatch* virtual_match)
+{
+	if(mPosition % mSavePointDistance != 0 || mStateCache.count(mPosition) != 0)
+		return;
 
+	MatchSnapshot snapshot;
+	if((int)mStateCache.size() >= REPLAY_SEEK_CACHE_SIZE)
+	{
+		// drop the state farthest from the current position, and reuse its script buffer
+		auto first = mStateCache.begin();
+		auto last = std::prev(mStateCache.end());
+		auto dropped = mPosition - first->first > last->first - mPosition ? first : last;
+		snapshot = std::move(dropped->second);
+		mStateCache.erase(dropped);
 	}
 
-	return false;
+	virtual_match->saveSnapshot(snapshot);
+	mStateCache.emplace(mPosition, std::move(snapshot));
+}
+
+void ReplayPlayer::storeRecentState(const DuelMatch* virtual_match)
+{
+	const int capacity = mRecentStates.size();
+
+	// a position that does not continue the buffered ones starts a new sequence
+	if(mRecentCount == 0 || mPosition < mRecentFirst || mPosition > mRecentFirst + mRecentCount)
+	{
+		mRecentFirst = mPosition;
+		mRecentCount = 0;
+		mRecentHead = 0;
+	}
+
+	if(mPosition == mRecentFirst + mRecentCount)
+	{
+		if(mRecentCount == capacity)
+		{
+			// replace the oldest state
+			++mRecentFirst;
+			mRecentHead = (mRecentHead + 1) % capacity;
+		}
+		else
+		{
+			++mRecentCount;
+		}
+	}
+
+	virtual_match->saveSnapshot( mRecentStates[(mRecentHead + mPosition - mRecentFirst) % capacity] );
+}
+
+int ReplayPlayer::findRecentState(int position) const
+{
+	if(position < mRecentFirst || position >= mRecentFirst + mRecentCount)
+		return -1;
+
+	return (mRecentHead + position - mRecentFirst) % mRecentStates.size();
 }
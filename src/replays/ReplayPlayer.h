@@ -20,9 +20,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <atomic>
+#include <exception>
+#include <map>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "Color.h"
+#include "MatchSnapshot.h"
 #include "ReplayDefs.h"
 #include "PlayerInput.h"
 #include "BlobbyDebug.h"
@@ -43,6 +50,18 @@ class ReplayPlayer : public ObjectCounter<ReplayPlayer>
 		~ReplayPlayer();
 
 		void load(const std::string& filename);
+
+		/// \brief loads a replay in a background thread.
+		/// \details The replay can be played as soon as isLoaded returns true, which is the case once
+		///			the header has been read. The rest of the file is then read in the background while
+		///			the replay is played, see getLoadProgress.
+		void loadAsync(const std::string& filename);
+		/// \brief checks whether a replay loaded with loadAsync is ready to be played.
+		/// \exception rethrows the exception that occurred while loading the replay
+		bool isLoaded();
+		/// \brief fraction of the replay file that has been read so far
+		float getLoadProgress() const;
+
 		std::string getRules() const;
 
 		// -----------------------------------------------------------------------------------------
@@ -52,6 +71,7 @@ class ReplayPlayer : public ObjectCounter<ReplayPlayer>
 		std::string getPlayerName(const PlayerSide side) const;
 		Color getBlobColor(const PlayerSide side) const;
 		int getGameSpeed() const;
+		PhysicBackend getPhysicBackend() const;
 
 		// -----------------------------------------------------------------------------------------
 		// 							Status information
@@ -77,6 +97,10 @@ class ReplayPlayer : public ObjectCounter<ReplayPlayer>
 		/// \details returns the replay length in steps.
 		int getReplayLength() const;
 
+		/// \brief number of in-memory savepoints
+		/// \details This is at most REPLAY_SEEK_CACHE_SIZE.
+		int getCachedStateCount() const;
+
 		// -----------------------------------------------------------------------------------------
 		// 							replaying interface
 		// -----------------------------------------------------------------------------------------
@@ -84,19 +108,71 @@ class ReplayPlayer : public ObjectCounter<ReplayPlayer>
 		/// \brief advances the game one step
 		bool play(DuelMatch* virtual_match);
 
+		/// \brief goes back one step
+		/// \details The states of the last REPLAY_REWIND_BUFFER_SIZE steps that have been played are kept in a
+		///			ring buffer, so going back usually just restores a state from there. When the buffer runs
+		///			dry, it is refilled by simulating from the closest savepoint before the current position.
+		///			This costs at most one savepoint distance of simulated steps, once for each
+		///			buffer length played in reverse.
+		/// \return false if the replay is already at the start
+		bool playBackwards(DuelMatch* virtual_match);
+
 		/// \brief Jumps to a position in replay.
-		/// \details Goes to a certain position in replay. Simulates at most 100 steps per call
-		///			to prevent visual lags, so it is possible that this function has to be called
-		///			several times to reach the target.
-		/// \param rep_position target position in number of physic steps.
+		/// \details Goes to a certain position in replay within a single call. Positions that were played
+		///			recently are restored from the rewind buffer directly. Otherwise, the match is restored
+		///			from the closest savepoint before the target, either one from the replay file or one
+		///			of the additional savepoints kept in memory, and the remaining steps are simulated.
+		///			The savepoints in memory are complete snapshots of the match, so they are preferred
+		///			over a savepoint of the file that is less than one savepoint distance closer.
+		/// \param rep_position target position in number of physic steps. It is clamped to the replay length.
 		/// \return True, if desired position could be reached.
 		bool gotoPlayingPosition(int rep_position, DuelMatch* virtual_match);
 
+		/// \brief sets the distance of the in-memory savepoints.
+		/// \details While the replay is played or seeked, the match state is remembered every \p steps
+		///			steps, so seeking to a position that has been passed before never has to simulate
+		///			more than \p steps steps. Without a cached state, seeking simulates at most
+		///			up to the distance of the savepoints in the replay file. At most REPLAY_SEEK_CACHE_SIZE
+		///			states are kept, the ones farthest from the current position are dropped first.
+		void setSavePointDistance(int steps);
+
 	private:
+		/// sets up playback for the loader
+		void initPlayback(std::unique_ptr<IReplayLoader> replay_loader);
+		/// remembers the state of the match if the current position is on the savepoint grid
+		void cacheState(const DuelMatch* virtual_match);
+		/// stores the state of the match in the rewind buffer
+		void storeRecentState(const DuelMatch* virtual_match);
+		/// index of \p position in the rewind buffer, or -1 if the state is not in the buffer
+		int findRecentState(int position) const;
 
 		int mPosition;
 		int mLength;
+		int mSavePointDistance;
+		std::map<int, MatchSnapshot> mStateCache;
 		std::unique_ptr<IReplayLoader> loader;
 
+		// rewind buffer. It holds the states of the consecutive positions
+		// mRecentFirst ... mRecentFirst + mRecentCount - 1, the first one at index mRecentHead.
+		std::vector<MatchSnapshot> mRecentStates;
+		int mRecentFirst;
+		int mRecentCount;
+		int mRecentHead;
+
 		std::string mPlayerNames[MAX_PLAYERS];
+
+		// asynchronous loading
+		enum LoadState
+		{
+			LOAD_RUNNING,
+			LOAD_FINISHED,
+			LOAD_FAILED
+		};
+
+		std::thread mLoadThread;
+		std::atomic<int> mLoadState;
+		std::atomic<float> mLoadProgress;
+		std::atomic<bool> mCancelLoading;
+		std::unique_ptr<IReplayLoader> mLoadedLoader;	///< handed over to the main thread by isLoaded
+		std::exception_ptr mLoadError;
 };
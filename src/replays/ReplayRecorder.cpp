@@ -22,12 +22,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ReplayRecorder.h"
 
 /* includes */
+#include <algorithm>
+#include <cassert>
 #include <iostream>
+#include <cstdio>
 #include <ctime>
+#include <stdexcept>
 
 #include <boost/algorithm/string/trim_all.hpp>
-
-#include "tinyxml2.h"
+#include <boost/throw_exception.hpp>
 
 #include "raknet/BitStream.h"
 
@@ -37,15 +40,127 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "GenericIO.h"
 #include "FileRead.h"
 #include "FileWrite.h"
-#include "base64.h"
-
-#ifdef __SWITCH__
-#define SIZET_TYPE unsigned int
-#else
-#define SIZET_TYPE std::uint64_t
-#endif
 
 /* implementation */
+
+/// number of encoded input bytes that are kept in memory before they are moved to the spool file
+const std::size_t SPOOL_INPUT_WINDOW = 4096;
+/// number of savepoints that are kept in memory before they are moved to the spool file
+const std::size_t SPOOL_SAVEPOINT_WINDOW = 4;
+
+/*! \class ReplaySpool
+	\brief temporary files holding the already recorded part of a replay.
+	\details The encoded input bytes are stored as they are. Savepoints are stored as length-prefixed
+			serialized blobs, because their serialized size is not a whole number of bytes.
+			Write errors are reported to the caller, which then keeps the data in memory and retries later.
+*/
+class ReplaySpool : public ObjectCounter<ReplaySpool>
+{
+	public:
+		ReplaySpool() : mInput(std::tmpfile()), mStates(std::tmpfile()), mInputSize(0), mStatesSize(0), mSavePointCount(0)
+		{
+		}
+
+		~ReplaySpool()
+		{
+			if(mInput)
+				std::fclose(mInput);
+			if(mStates)
+				std::fclose(mStates);
+		}
+
+		ReplaySpool(const ReplaySpool&) = delete;
+		ReplaySpool& operator=(const ReplaySpool&) = delete;
+
+		bool isValid() const { return mInput && mStates; }
+		std::size_t getInputSize() const { return mInputSize; }
+		unsigned int getSavePointCount() const { return mSavePointCount; }
+
+		bool appendInput(const std::vector<uint8_t>& data)
+		{
+			if(!append(mInput, mInputSize, data.data(), data.size()))
+				return false;
+			mInputSize += data.size();
+			return true;
+		}
+
+		bool appendSavePoints(const std::vector<ReplaySavePoint>& savepoints)
+		{
+			RakNet::BitStream stream;
+			auto writer = createGenericWriter(&stream);
+			std::vector<unsigned char> blobs;
+			for(const auto& sp : savepoints)
+			{
+				stream.Reset();
+				writer->generic<ReplaySavePoint>(sp);
+				uint32_t length = stream.GetNumberOfBytesUsed();
+				blobs.insert(blobs.end(), (unsigned char*)&length, (unsigned char*)&length + sizeof(length));
+				blobs.insert(blobs.end(), stream.GetData(), stream.GetData() + length);
+			}
+
+			if(!append(mStates, mStatesSize, blobs.data(), blobs.size()))
+				return false;
+			mStatesSize += blobs.size();
+			mSavePointCount += savepoints.size();
+			return true;
+		}
+
+		/// calls \p chunk for consecutive blocks of the spooled input
+		template<class F>
+		void readInput(F chunk) const
+		{
+			std::fseek(mInput, 0, SEEK_SET);
+			char buffer[SPOOL_INPUT_WINDOW];
+			std::size_t remaining = mInputSize;
+			while(remaining > 0)
+			{
+				std::size_t read = std::fread(buffer, 1, std::min(sizeof(buffer), remaining), mInput);
+				if(read == 0)
+					BOOST_THROW_EXCEPTION( std::runtime_error("could not read replay spool file") );
+				chunk(buffer, read);
+				remaining -= read;
+			}
+		}
+
+		/// calls \p visit for every spooled savepoint
+		template<class F>
+		void readSavePoints(F visit) const
+		{
+			std::fseek(mStates, 0, SEEK_SET);
+			std::vector<unsigned char> buffer;
+			for(unsigned int i = 0; i < mSavePointCount; ++i)
+			{
+				uint32_t length;
+				if(std::fread(&length, sizeof(length), 1, mStates) != 1)
+					BOOST_THROW_EXCEPTION( std::runtime_error("could not read replay spool file") );
+				buffer.resize(length);
+				if(std::fread(buffer.data(), 1, length, mStates) != length)
+					BOOST_THROW_EXCEPTION( std::runtime_error("could not read replay spool file") );
+
+				RakNet::BitStream stream(buffer.data(), length, false);
+				ReplaySavePoint sp;
+				createGenericReader(&stream)->generic<ReplaySavePoint>(sp);
+				visit(sp);
+			}
+		}
+
+	private:
+		// writes \p data at \p end. Anything that was written after a failed write is overwritten
+		// by the next attempt, and never read as we only read up to the recorded sizes.
+		static bool append(std::FILE* file, std::size_t end, const void* data, std::size_t length)
+		{
+			return std::fseek(file, end, SEEK_SET) == 0 &&
+				   std::fwrite(data, 1, length, file) == length &&
+				   std::fflush(file) == 0;
+		}
+
+		std::FILE* mInput;
+		std::FILE* mStates;
+		std::size_t mInputSize;
+		std::size_t mStatesSize;
+		unsigned int mSavePointCount;
+};
+
 VersionMismatchException::VersionMismatchException(const std::string& filename, uint8_t major, uint8_t minor)
 {
 	std::stringstream errorstr;
@@ -66,72 +181,122 @@ const char* VersionMismatchException::what() const noexcept
 
 
 
-ReplayRecorder::ReplayRecorder()
+ReplayRecorder::ReplayRecorder() : mRecordedSteps(0), mEndScore{0, 0}, mPhysicBackend(PhysicBackend::FLOAT)
 {
 	mGameSpeed = -1;
 }
 
-ReplayRecorder::~ReplayRecorder() = default;
-template<class T>
-void writeAttribute(tinyxml2::XMLPrinter& printer, const char* name, const T& value)
+bool ReplayRecorder::enableSpooling()
 {
-	printer.OpenElement("var");
-	printer.PushAttribute("name", name);
-	printer.PushAttribute("value", value);
-	printer.CloseElement();
+	assert(mRecordedSteps == 0);
+	std::unique_ptr<ReplaySpool> spool(new ReplaySpool());
+	if(!spool->isValid())
+		return false;
+
+	mSpool = std::move(spool);
+	return true;
 }
 
-void ReplayRecorder::save(FileWrite& file) const
+ReplayRecorder::~ReplayRecorder() = default;
+namespace
 {
-	tinyxml2::XMLPrinter printer;
-	printer.PushHeader(false, true);
-	printer.OpenElement("replay");
-	printer.OpenElement("version");
-	printer.PushAttribute("major", REPLAY_FILE_VERSION_MAJOR);
-	printer.PushAttribute("minor", REPLAY_FILE_VERSION_MINOR);
-	printer.CloseElement();
-
-	// the explicit template arguments below are to prevent ambiguities on OSX where
-	// size_t = unsigned long != unsigned int != uint64_t; same for time_t
-	writeAttribute(printer, "game_speed", mGameSpeed);
-	writeAttribute<SIZET_TYPE>(printer, "game_length", mSaveData.size());
-	writeAttribute<SIZET_TYPE>(printer, "game_duration", mSaveData.size() / mGameSpeed);
-	writeAttribute<std::int64_t>(printer, "game_date", std::time(nullptr));
-
-	writeAttribute(printer, "score_left", mEndScore[LEFT_PLAYER]);
-	writeAttribute(printer, "score_right", mEndScore[RIGHT_PLAYER]);
+	/// appends a little endian integer of \p bytes bytes
+	void appendLE(std::vector<unsigned char>& target, std::uint64_t value, int bytes)
+	{
+		target.resize(target.size() + bytes);
+		writeLE(&target[target.size() - bytes], value, bytes);
+	}
 
-	writeAttribute(printer, "name_left", mPlayerNames[LEFT_PLAYER].c_str());
-	writeAttribute(printer, "name_right", mPlayerNames[RIGHT_PLAYER].c_str());
+	/// fills in the offset and size fields at \p field of the header for a section starting at \p start
+	void finishSection(std::vector<unsigned char>& file, std::size_t field, std::size_t start)
+	{
+		writeLE(&file[field], start, 4);
+		writeLE(&file[field + 4], file.size() - start, 4);
+	}
+}
 
+void ReplayRecorder::save(FileWrite& file) const
+{
+	// saving needs the whole replay at once, so we collect the spooled parts first
+	std::vector<uint8_t> input;
+	std::vector<ReplaySavePoint> savepoints;
+	if(mSpool)
+	{
+		input.reserve(mSpool->getInputSize() + mSaveData.size());
+		mSpool->readInput([&](const char* data, std::size_t length){ input.insert(input.end(), data, data + length); });
+		mSpool->readSavePoints([&](const ReplaySavePoint& sp){ savepoints.push_back(sp); });
+	}
+	input.insert(input.end(), mSaveData.begin(), mSaveData.end());
+	mEncoder.writePending(input);
+	savepoints.insert(savepoints.end(), mSavePoints.begin(), mSavePoints.end());
+
+	// see ReplayDefs.h for the file layout
+	std::vector<unsigned char> data(REPLAY_V3_HEADER_SIZE, 0);
+	std::copy(replayHeaderV3, replayHeaderV3 + 4, data.begin());
+	data[4] = REPLAY_FILE_VERSION_MAJOR;
+	data[5] = REPLAY_FILE_VERSION_MINOR;
+	writeLE(&data[6], REPLAY_V3_HEADER_SIZE, 2);
+	writeLE(&data[48], REPLAY_V3_INPUT_RLE, 4);
+
+	// metadata
+	std::size_t start = data.size();
+	appendLE(data, mGameSpeed, 4);
+	appendLE(data, mRecordedSteps, 4);
+	appendLE(data, mRecordedSteps / mGameSpeed, 4);
+	appendLE(data, mPhysicBackend == PhysicBackend::FIXED_POINT ? REPLAY_V3_PHYSICS_FIXED_POINT : REPLAY_V3_PHYSICS_FLOAT, 4);
+	appendLE(data, std::time(nullptr), 8);
+	appendLE(data, mEndScore[LEFT_PLAYER], 4);
+	appendLE(data, mEndScore[RIGHT_PLAYER], 4);
 	/// \todo would be nice if we could write the actual colors instead of integers
-	writeAttribute(printer, "color_left", mPlayerColors[LEFT_PLAYER].toInt());
-	writeAttribute(printer, "color_right", mPlayerColors[RIGHT_PLAYER].toInt());
-
-	// write the game rules
-	printer.OpenElement("rules");
-	printer.PushText(mGameRules.c_str());
-	printer.CloseElement();
-
-	// now comes the actual replay data
-	printer.OpenElement("input");
-	std::string binary = encode(mSaveData, 80);
-	printer.PushText(binary.c_str());
-	printer.CloseElement();
-
-	// finally, write the save points
-	// first, convert them into a POD
-	printer.OpenElement("states");
+	appendLE(data, mPlayerColors[LEFT_PLAYER].toInt(), 4);
+	appendLE(data, mPlayerColors[RIGHT_PLAYER].toInt(), 4);
+	appendLE(data, mPlayerNames[LEFT_PLAYER].size(), 2);
+	appendLE(data, mPlayerNames[RIGHT_PLAYER].size(), 2);
+	appendLE(data, 0, 4);
+	data.insert(data.end(), mPlayerNames[LEFT_PLAYER].begin(), mPlayerNames[LEFT_PLAYER].end());
+	data.insert(data.end(), mPlayerNames[RIGHT_PLAYER].begin(), mPlayerNames[RIGHT_PLAYER].end());
+	finishSection(data, 8, start);
+
+	// game rules
+	start = data.size();
+	data.insert(data.end(), mGameRules.begin(), mGameRules.end());
+	finishSection(data, 16, start);
+
+	// savepoints: each one is serialized on its own, so it can be read without touching the others.
+	// every savepoint starts a new input run, so it also marks where the input can be decoded from.
+	std::vector<unsigned char> index;
+	std::vector<unsigned char> states;
 	RakNet::BitStream stream;
 	auto convert = createGenericWriter(&stream);
-	convert->generic<std::vector<ReplaySavePoint> > (mSavePoints);
+	ReplayInputDecoder decoder(input.data(), input.size());
+	for(const auto& sp : savepoints)
+	{
+		stream.Reset();
+		convert->generic<ReplaySavePoint>(sp);
+		decoder.get(sp.step);
+		assert(decoder.getRunStep() == sp.step);
+
+		appendLE(index, sp.step, 4);
+		appendLE(index, states.size(), 4);
+		appendLE(index, stream.GetNumberOfBytesUsed(), 4);
+		appendLE(index, decoder.getRunOffset(), 4);
+		states.insert(states.end(), stream.GetData(), stream.GetData() + stream.GetNumberOfBytesUsed());
+	}
+
+	writeLE(&data[24], data.size(), 4);
+	writeLE(&data[28], savepoints.size(), 4);
+	data.insert(data.end(), index.begin(), index.end());
 
-	binary = encode((char*)stream.GetData(), (char*)stream.GetData() + stream.GetNumberOfBytesUsed(), 80);
-	printer.PushText(binary.c_str());
-	printer.CloseElement();
+	start = data.size();
+	data.insert(data.end(), states.begin(), states.end());
+	finishSection(data, 32, start);
 
-	printer.CloseElement();  // </replay>
-	file.write(printer.CStr(), printer.CStrSize() - 1); // do not save the terminating \0 character
+	// now comes the actual replay data
+	start = data.size();
+	data.insert(data.end(), input.begin(), input.end());
+	finishSection(data, 40, start);
+
+	file.write((const char*)data.data(), data.size());
 }
 
 void ReplayRecorder::send(GenericOut& target) const
@@ -147,9 +312,33 @@ void ReplayRecorder::send(GenericOut& target) const
 	target.uint32( mEndScore[RIGHT_PLAYER] );
 
 	target.string(mGameRules);
+	target.boolean( mPhysicBackend == PhysicBackend::FIXED_POINT );
+
+	target.uint32( mRecordedSteps );
 
-	target.generic<std::vector<unsigned char> >(mSaveData);
-	target.generic<std::vector<ReplaySavePoint> > (mSavePoints);
+	std::vector<uint8_t> pending;
+	mEncoder.writePending(pending);
+
+	if(!mSpool)
+	{
+		std::vector<uint8_t> input(mSaveData);
+		input.insert(input.end(), pending.begin(), pending.end());
+		target.generic<std::vector<unsigned char> >(input);
+		target.generic<std::vector<ReplaySavePoint> > (mSavePoints);
+		return;
+	}
+
+	// write the same format as the containers above, but stream the spooled part from disk.
+	// array produces the same bytes as a sequence of byte() calls for the binary writers.
+	target.uint32( mSpool->getInputSize() + mSaveData.size() + pending.size() );
+	mSpool->readInput([&](const char* data, std::size_t length){ target.array(data, length); });
+	target.array((const char*)mSaveData.data(), mSaveData.size());
+	target.array((const char*)pending.data(), pending.size());
+
+	target.uint32( mSpool->getSavePointCount() + mSavePoints.size() );
+	mSpool->readSavePoints([&](const ReplaySavePoint& sp){ target.generic<ReplaySavePoint>(sp); });
+	for(const auto& sp : mSavePoints)
+		target.generic<ReplaySavePoint>(sp);
 }
 
 void ReplayRecorder::receive(GenericIn& source)
@@ -165,7 +354,15 @@ void ReplayRecorder::receive(GenericIn& source)
 	source.uint32( mEndScore[RIGHT_PLAYER] );
 
 	source.string(mGameRules);
+	bool fixed_point;
+	source.boolean( fixed_point );
+	mPhysicBackend = fixed_point ? PhysicBackend::FIXED_POINT : PhysicBackend::FLOAT;
+
+	source.uint32( mRecordedSteps );
 
+	// received replays are always kept in memory
+	mSpool.reset();
+	mEncoder.reset();
 	source.generic<std::vector<unsigned char> >(mSaveData);
 	source.generic<std::vector<ReplaySavePoint> > (mSavePoints);
 }
@@ -174,14 +371,17 @@ void ReplayRecorder::record(const DuelMatchState& state)
 {
 	// save the state every REPLAY_SAVEPOINT_PERIOD frames
 	// or when something interesting occurs
-	if(mSaveData.size() % REPLAY_SAVEPOINT_PERIOD == 0 ||
+	if(mRecordedSteps % REPLAY_SAVEPOINT_PERIOD == 0 ||
 		mEndScore[LEFT_PLAYER] != state.logicState.leftScore ||
 		mEndScore[RIGHT_PLAYER] != state.logicState.rightScore)
 	{
 		ReplaySavePoint sp;
 		sp.state = state;
-		sp.step = mSaveData.size();
+		sp.step = mRecordedSteps;
 		mSavePoints.push_back(sp);
+
+		// decoding has to be able to start at the savepoint
+		mEncoder.finishRun(mSaveData);
 	}
 
 	// we save this 1 here just for compatibility
@@ -189,7 +389,7 @@ void ReplayRecorder::record(const DuelMatchState& state)
 	unsigned char packet = 1u << 7u;
 	packet |= (state.playerInput[LEFT_PLAYER].getAll() & 7u) << 3u;
 	packet |= (state.playerInput[RIGHT_PLAYER].getAll() & 7u) ;
-	mSaveData.push_back(packet);
+	appendInput(packet);
 
 	// update the score
 	mEndScore[LEFT_PLAYER] = state.logicState.leftScore;
@@ -215,6 +415,11 @@ void ReplayRecorder::setGameSpeed(int fps)
 	mGameSpeed = fps;
 }
 
+void ReplayRecorder::setPhysicBackend(PhysicBackend backend)
+{
+	mPhysicBackend = backend;
+}
+
 void ReplayRecorder::setGameRules( const std::string& rules )
 {
 	FileRead file(FileRead::makeLuaFilename("rules/"+rules));
@@ -232,6 +437,24 @@ void ReplayRecorder::finalize(unsigned int left, unsigned int right)
 	for(int i = 0; i < 75; ++i)
 	{
 		unsigned char packet = 0;
-		mSaveData.push_back(packet);
+		appendInput(packet);
 	}
 }
+
+void ReplayRecorder::appendInput(uint8_t packet)
+{
+	mEncoder.add(packet, mSaveData);
+	++mRecordedSteps;
+
+	if(mSpool && (mSaveData.size() >= SPOOL_INPUT_WINDOW || mSavePoints.size() >= SPOOL_SAVEPOINT_WINDOW))
+		flushSpool();
+}
+
+void ReplayRecorder::flushSpool()
+{
+	// if writing fails (e.g. disk full), the data simply stays in memory and we try again later
+	if(!mSavePoints.empty() && mSpool->appendSavePoints(mSavePoints))
+		mSavePoints.clear();
+	if(!mSaveData.empty() && mSpool->appendInput(mSaveData))
+		mSaveData.clear();
+}
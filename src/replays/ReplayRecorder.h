@@ -30,6 +30,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "Color.h"
 #include "ReplaySavePoint.h"
+#include "ReplayInputCodec.h"
 #include "PlayerInput.h"
 #include "BlobbyDebug.h"
 #include "GenericIOFwd.h"
@@ -40,6 +41,7 @@ namespace RakNet
 }
 
 class FileWrite;
+class ReplaySpool;
 
 /*! \class VersionMismatchException
 	\brief thrown when replays of incompatible version are loaded.
@@ -58,14 +60,22 @@ struct VersionMismatchException : public std::exception, public ObjectCounter<Ve
 };
 
 /// \brief recording game
-/// \todo we safe replays in continuous storage (array or std::vector)
-///			which might be ineffective for huge replays (1h ~ 270kb)
+/// \details By default, the whole replay is kept in memory. If spooling is enabled, the recorded
+///			input and savepoints are moved to a temporary file whenever the in-memory window is full,
+///			so memory usage does not grow with the length of the match. The spool file is only read
+///			back when the replay is saved or sent.
 class ReplayRecorder : public ObjectCounter<ReplayRecorder>
 {
 	public:
 		ReplayRecorder();
 		~ReplayRecorder();
 
+		/// \brief stream the recorded data to a temporary file.
+		/// \details Has to be called before recording starts. The file is removed automatically when
+		///			the recorder is destroyed.
+		/// \return false if no temporary file could be created. The recorder then keeps everything in memory.
+		bool enableSpooling();
+
 		void save(FileWrite& target) const;
 
 		void send(GenericOut& stream) const;
@@ -82,10 +92,19 @@ class ReplayRecorder : public ObjectCounter<ReplayRecorder>
 		void setPlayerColors(Color left, Color right);
 		void setGameSpeed(int fps);
 		void setGameRules( const std::string& rules );
+		void setPhysicBackend(PhysicBackend backend);
 
 	private:
+		void appendInput(uint8_t packet);
+		void flushSpool();
+
+		// run length encoded input, see ReplayInputCodec.h. Without spooling, this contains all completed
+		// runs, otherwise only the part that has not been spooled yet. The current run is kept in mEncoder.
 		std::vector<uint8_t> mSaveData;
+		ReplayInputEncoder mEncoder;
 		std::vector<ReplaySavePoint> mSavePoints;
+		unsigned int mRecordedSteps;
+		std::unique_ptr<ReplaySpool> mSpool;
 
 		// general replay attributes
 		std::string mPlayerNames[MAX_PLAYERS];
@@ -93,4 +112,5 @@ class ReplayRecorder : public ObjectCounter<ReplayRecorder>
 		unsigned int mEndScore[MAX_PLAYERS];
 		unsigned int mGameSpeed;
 		std::string mGameRules;
+		PhysicBackend mPhysicBackend;
 };
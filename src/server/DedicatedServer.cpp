@@ -32,6 +32,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ThreadSafeRakServer.h"
 #include "NetworkGame.h"
 #include "GenericIO.h"
+#include "ServerMetrics.h"
 
 #ifndef WIN32
 #ifndef __ANDROID__
@@ -41,23 +42,27 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #endif
 #endif
 
-extern int SWLS_PacketCount;
-extern int SWLS_Connections;
-extern int SWLS_Games;
 
 #ifdef __ANDROID__
 extern "C"
 #endif
 void syslog(int pri, const char* format, ...);
 
+/// number of non-game packets that can be queued between two iterations of the server main loop
+const std::size_t SERVER_PACKET_QUEUE_SIZE = 4096;
+
 DedicatedServer::DedicatedServer(ServerInfo info,
 								const std::vector<std::string>& rulefiles,
 								const std::vector<float>& gamespeeds,
-								int max_clients, bool local_server)
+								int max_clients, bool local_server,
+								unsigned game_threads)
 : mServer(new ThreadSafeRakServer())
 , mAcceptNewPlayers(true)
 , mPlayerHosted( local_server )
 , mServerInfo(std::move(info))
+, mPacketQueue(SERVER_PACKET_QUEUE_SIZE)
+, mWakeRequested(false)
+, mScheduler(game_threads, [this](){ wakeUp(); })
 {
 	if (!mServer->access([&](RakServer& srv){ return srv.Start(max_clients, 1, mServerInfo.port);}))
 	{
@@ -80,21 +85,24 @@ DedicatedServer::DedicatedServer(ServerInfo info,
 		mMatchMaker.addRuleOption( f );
 
 	mServer->access([&](RakServer& srv){
-		srv.setUpdateCallback([this](){ queuePackets(); }
+		srv.setUpdateCallback([this](){ mServer->flushSendQueue(); queuePackets(); }
 	);} );
 }
 
 DedicatedServer::~DedicatedServer()
 {
+	// stop stepping the games before the connection goes down
+	mScheduler.shutdown();
 	mServer->access( [](RakServer& srv){ srv.Disconnect(50); } );
 }
 
 void DedicatedServer::queuePackets()
 {
+	bool queued = false;
 	packet_ptr packet;
 	while ((packet = mServer->access( [](RakServer& srv){ return srv.Receive(); })))
 	{
-		SWLS_PacketCount++;
+		ServerMetrics::get().packetsReceived.increment();
 
 		switch(packet->data[0])
 		{
@@ -105,11 +113,10 @@ void DedicatedServer::queuePackets()
 			case ID_ENTER_SERVER:
 			case ID_LOBBY:
 			case ID_BLOBBY_SERVER_PRESENT:
-			{
-				std::lock_guard<std::mutex> lock( mPacketQueueMutex );
-				mPacketQueue.push_back( packet );
+				// connection changes are never dropped, a full queue spills into the overflow list
+				mPacketQueue.push( packet, true );
+				queued = true;
 				break;
-			}
 			// game progress packets
 			case ID_INPUT_UPDATE:
 			case ID_PAUSE:
@@ -125,7 +132,12 @@ void DedicatedServer::queuePackets()
 				// delete the disconnectiong player
 				if( player != mPlayerMap.end() && player->second->getGame() )
 				{
-					player->second->getGame() ->injectPacket( packet );
+					if( !player->second->getGame()->injectPacket( packet ) )
+					{
+						ServerMetrics::get().packetsDropped.increment();
+						syslog(LOG_ERR, "Game packet queue full, dropping input update (%d) from %s",
+							   int(packet->data[0]), packet->playerId.toString().c_str());
+					}
 				} else {
 					syslog(LOG_ERR, "received packet from player not in playerlist!");
 				}
@@ -136,6 +148,27 @@ void DedicatedServer::queuePackets()
 				syslog(LOG_DEBUG, "Unknown packet %d received\n", int(packet->data[0]));
 		}
 	}
+
+	// one wakeup per batch is enough, the main loop drains the whole queue
+	if( queued )
+		wakeUp();
+}
+
+bool DedicatedServer::waitForPackets(std::chrono::steady_clock::time_point deadline)
+{
+	std::unique_lock<std::mutex> lock( mWakeMutex );
+	bool woken = mWakeCondition.wait_until(lock, deadline, [this](){ return mWakeRequested; });
+	mWakeRequested = false;
+	return woken;
+}
+
+void DedicatedServer::wakeUp()
+{
+	{
+		std::lock_guard<std::mutex> lock( mWakeMutex );
+		mWakeRequested = true;
+	}
+	mWakeCondition.notify_one();
 }
 
 /*!
@@ -145,15 +178,9 @@ void DedicatedServer::queuePackets()
  */
 void DedicatedServer::processPackets()
 {
-	while (!mPacketQueue.empty())
+	packet_ptr packet;
+	while (mPacketQueue.tryPop(packet))
 	{
-		packet_ptr packet;
-		{
-			std::lock_guard<std::mutex> lock(mPacketQueueMutex);
-			packet = mPacketQueue.front();
-			mPacketQueue.pop_front();
-		}
-		SWLS_PacketCount++;
 
 		int packet_id = packet->data[0];
 		if(packet_id != ID_NEW_INCOMING_CONNECTION && !isConnected(packet->playerId)) {
@@ -166,7 +193,7 @@ void DedicatedServer::processPackets()
 		{
 			// connection status changes
 			case ID_NEW_INCOMING_CONNECTION:
-				SWLS_Connections++;
+				ServerMetrics::get().connectionsAccepted.increment();
 				if ( !mAcceptNewPlayers )
 				{
 					RakNet::BitStream stream;
@@ -193,10 +220,10 @@ void DedicatedServer::processPackets()
 				if( player != mPlayerMap.end() )
 				{
 					const std::string playerName = player->second->getName();
+					// the game must not miss the disconnect. Reliable packets are never dropped
+					// by injectPacket, so this does not have to wait for a full queue.
 					if( player->second->getGame() )
-					{
 						player->second->getGame()->injectPacket( packet );
-					}
 
 					// no longer count this player as connected. protect this change with a mutex
 					{
@@ -241,17 +268,9 @@ void DedicatedServer::updateGames()
 		mMatchMaker.setAllowNewGames(mMatchMaker.getOpenGamesCount() == 0);
 	}
 
-	// this loop ensures that all games that have finished (e.g. because one
-	// player left) still process network packets, to let the other player
-	// finalize its interactions (sending replays etc).
-	for(auto& it : mPlayerMap)
-	{
-		auto game = it.second->getGame();
-		if(game && !game->isGameValid())
-		{
-			game->processPackets();
-		}
-	}
+	// games that have finished (e.g. because one player left) are still kept by the
+	// scheduler to process network packets, so the other player can finalize its
+	// interactions (sending replays etc).
 
 	// remove dead games from gamelist
 	for (auto iter = mGameList.begin(); iter != mGameList.end();  )
@@ -269,6 +288,13 @@ void DedicatedServer::updateGames()
 			++iter;
 		}
 	}
+
+	ServerMetrics& metrics = ServerMetrics::get();
+	metrics.activeGames.set( mGameList.size() );
+	metrics.scheduledGames.set( mScheduler.getScheduledGamesCount() );
+	metrics.connectedClients.set( getConnectedClients() );
+	metrics.connectedPlayers.set( mPlayerMap.size() );
+	metrics.sendQueueDepth.set( mServer->getSendStatistics().queueDepth );
 }
 
 bool DedicatedServer::hasActiveGame() const
@@ -325,6 +351,16 @@ void DedicatedServer::printAllGames(std::ostream& stream) const
 	}
 }
 
+void DedicatedServer::printSchedulerStatistics(std::ostream& stream) const
+{
+	mScheduler.printTickStatistics(stream);
+}
+
+void DedicatedServer::printSendStatistics(std::ostream& stream) const
+{
+	mServer->printSendStatistics(stream);
+}
+
 // special packet processing
 void DedicatedServer::processBlobbyServerPresent( PlayerID source, RakNet::BitStream& stream )
 {
@@ -451,12 +487,13 @@ void DedicatedServer::createGame(NetworkPlayer& left,
 	left.setGame( newgame );
 	right.setGame( newgame );
 
-	SWLS_Games++;
+	ServerMetrics::get().gamesStarted.increment();
 
 	/// \todo add some logging?
 	syslog(LOG_DEBUG, "Created game '%s' vs. '%s', rules: '%s'",
 		   left.getName().c_str(), right.getName().c_str(), rules.c_str());
 	mGameList.push_back(newgame);
+	mScheduler.addGame(newgame, gamespeed);
 }
 
 
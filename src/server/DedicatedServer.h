@@ -24,7 +24,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <map>
 #include <list>
 #include <mutex>
-#include <deque>
+#include <chrono>
+#include <condition_variable>
 #include <iosfwd>
 #include <memory>
 #include <set>
@@ -32,6 +33,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "NetworkPlayer.h"
 #include "NetworkMessage.h"
 #include "server/MatchMaker.h"
+#include "server/GameScheduler.h"
+#include "server/PacketInbox.h"
 
 class ThreadSafeRakServer;
 
@@ -53,8 +56,11 @@ class DedicatedServer
 		/// simultaneous connections
 		/// \todo Maybe two classes for server info: local server info for a server, and remote for data sent to client
 		/// \param is_local: Set to true, to indicate a locally hosted server intended for a single game.
+		/// \param game_threads: Number of worker threads that step the games. If zero, one thread per
+		///						 hardware thread is used.
 		DedicatedServer(ServerInfo info, const std::vector<std::string>& rulefile,
-						const std::vector<float>& speeds, int max_clients, bool is_local = false);
+						const std::vector<float>& speeds, int max_clients, bool is_local = false,
+						unsigned game_threads = 0);
 		~DedicatedServer();
 
 		// server processing
@@ -63,6 +69,13 @@ class DedicatedServer
 		void processPackets();
 		void updateGames();
 
+		/// blocks until queuePackets() has new packets for processPackets(), wakeUp() is called or
+		/// \p deadline is reached. Lets the main loop sleep while the server is idle.
+		/// \return false if the deadline was reached without being woken up.
+		bool waitForPackets(std::chrono::steady_clock::time_point deadline);
+		/// wakes up a thread waiting in waitForPackets(), e.g. so it notices that it should stop.
+		void wakeUp();
+
 		// status queries
 		bool hasActiveGame() const;
 		int getActiveGamesCount() const;
@@ -74,6 +87,8 @@ class DedicatedServer
 		// debug functions
 		void printAllPlayers(std::ostream& stream) const;
 		void printAllGames(std::ostream& stream) const;
+		void printSchedulerStatistics(std::ostream& stream) const;
+		void printSendStatistics(std::ostream& stream) const;
 
 
 		// server settings
@@ -113,9 +128,16 @@ class DedicatedServer
 		bool isConnected(PlayerID player) const;
 		bool addConnection(PlayerID player);
 
-		// packet queue
-		std::deque<packet_ptr> mPacketQueue;
-		std::mutex mPacketQueueMutex;
+		// packet queue, filled by the raknet thread and processed in the server main loop
+		PacketInbox mPacketQueue;
+		// signalled by the raknet thread when mPacketQueue received new packets
+		std::mutex mWakeMutex;
+		std::condition_variable mWakeCondition;
+		bool mWakeRequested;
 
 		MatchMaker mMatchMaker;
+
+		// steps all games. Declared last, so the workers are stopped before anything
+		// the games might reference is destroyed.
+		GameScheduler mScheduler;
 };
@@ -0,0 +1,197 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "GameScheduler.h"
+
+/* includes */
+#include <algorithm>
+#include <cassert>
+#include <ostream>
+#include <utility>
+
+#include "NetworkGame.h"
+#include "ServerMetrics.h"
+
+/* implementation */
+
+/// if a game is more than this far behind its schedule, we do not try to catch up
+/// but restart its schedule at the current time.
+const GameScheduler::clock_type::duration MAX_TICK_BACKLOG = std::chrono::milliseconds(250);
+
+GameScheduler::GameScheduler(unsigned worker_count, std::function<void()> game_finished) :
+	mGameFinished(std::move(game_finished)),
+	mRunning(true),
+	mGameCount(0)
+{
+	if(worker_count == 0)
+		worker_count = std::max(1u, std::thread::hardware_concurrency());
+
+	for(unsigned i = 0; i < worker_count; ++i)
+	{
+		mWorkers.emplace_back( [this](){ workerLoop(); } );
+	}
+}
+
+GameScheduler::~GameScheduler()
+{
+	shutdown();
+}
+
+void GameScheduler::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mRunning = false;
+	}
+	mWakeup.notify_all();
+
+	for(auto& worker : mWorkers)
+	{
+		if(worker.joinable())
+			worker.join();
+	}
+	mWorkers.clear();
+
+	// release the games outside of the lock, their destructors might take a while
+	std::vector<Entry> remaining;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		std::swap(remaining, mQueue);
+		mGameCount = 0;
+	}
+}
+
+void GameScheduler::addGame(std::shared_ptr<NetworkGame> game, float game_speed)
+{
+	assert(game);
+	assert(game_speed > 0);
+
+	Entry entry;
+	entry.period = std::chrono::duration_cast<clock_type::duration>( std::chrono::duration<double>(1.0 / game_speed) );
+	entry.deadline = clock_type::now();
+	entry.game = std::move(game);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		++mGameCount;
+		pushEntry(std::move(entry));
+	}
+	mWakeup.notify_one();
+}
+
+unsigned GameScheduler::getWorkerCount() const
+{
+	return mWorkers.size();
+}
+
+int GameScheduler::getScheduledGamesCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mGameCount;
+}
+
+TickStatistics GameScheduler::getTickStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStatistics;
+}
+
+void GameScheduler::printTickStatistics(std::ostream& stream) const
+{
+	TickStatistics stats = getTickStatistics();
+	stream << " scheduler workers: " << getWorkerCount() << "\n";
+	stream << " scheduled games: " << getScheduledGamesCount() << "\n";
+	stream << " game ticks: " << stats.ticks << " (" << stats.lateTicks << " late, "
+		   << stats.resyncs << " resyncs)\n";
+	stream << " tick lateness: mean " << stats.meanLatenessMs << " ms, max " << stats.maxLatenessMs << " ms";
+}
+
+void GameScheduler::pushEntry(Entry entry)
+{
+	mQueue.push_back(std::move(entry));
+	std::push_heap(mQueue.begin(), mQueue.end(), laterDeadline);
+}
+
+void GameScheduler::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while(mRunning)
+	{
+		if(mQueue.empty())
+		{
+			mWakeup.wait(lock);
+			continue;
+		}
+
+		// sleep until the next game is due. Another worker might take it before us, or a game with an
+		// earlier deadline might be added in the meantime, so we have to re-check after waking up.
+		clock_type::time_point deadline = mQueue.front().deadline;
+		if(clock_type::now() < deadline)
+		{
+			mWakeup.wait_until(lock, deadline);
+			continue;
+		}
+
+		std::pop_heap(mQueue.begin(), mQueue.end(), laterDeadline);
+		Entry entry = std::move(mQueue.back());
+		mQueue.pop_back();
+		lock.unlock();
+
+		clock_type::time_point start = clock_type::now();
+		bool keep = true;
+		if(entry.game->isGameValid())
+		{
+			entry.game->tick();
+			if(!entry.game->isGameValid() && mGameFinished)
+				mGameFinished();
+		}
+		else
+		{
+			// finished games only handle their remaining packets, until nobody else references them
+			entry.game->processPackets();
+			keep = entry.game.use_count() > 1;
+		}
+
+		clock_type::duration lateness = start - entry.deadline;
+		ServerMetrics& metrics = ServerMetrics::get();
+		metrics.tickDuration.observe( std::chrono::duration<double>(clock_type::now() - start).count() );
+		metrics.tickLateness.observe( std::chrono::duration<double>(lateness).count() );
+		entry.deadline += entry.period;
+
+		// if we fell far behind, don't try to catch up with a burst of ticks
+		bool resync = lateness > MAX_TICK_BACKLOG;
+		if(resync)
+			entry.deadline = clock_type::now() + entry.period;
+
+		if(!keep)
+			entry.game.reset();
+
+		lock.lock();
+		mStatistics.record(lateness);
+		if(resync)
+			mStatistics.resyncs++;
+
+		if(keep)
+			pushEntry(std::move(entry));
+		else
+			--mGameCount;
+	}
+}
@@ -0,0 +1,102 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BlobbyDebug.h"
+#include "TickStatistics.h"
+
+class NetworkGame;
+
+/*! \class GameScheduler
+	\brief steps all running NetworkGames on a fixed pool of worker threads.
+	\details Every game is registered with its own tick period (derived from its game speed). The scheduler
+			keeps all games in a single queue ordered by their next deadline. Whenever a worker is idle, it
+			takes the game that is due next, ticks it and puts it back with its next deadline. As no worker
+			is bound to a particular game, a worker that is stuck in a long tick never delays other games as
+			long as any other worker is free.
+			A game is only ever ticked by one worker at a time, so NetworkGame does not need to protect its
+			internal state against concurrent ticks.
+			Once a game becomes invalid, it is no longer stepped, but its packet queue is still processed (to
+			let the remaining player request the replay) until the scheduler holds the last reference to it.
+*/
+class GameScheduler : public ObjectCounter<GameScheduler>
+{
+	public:
+		typedef std::chrono::steady_clock clock_type;
+
+		/// \param worker_count number of worker threads. If zero, one worker per hardware thread is used.
+		/// \param game_finished called from a worker thread whenever a tick ended a game, so the owner can
+		///			remove it from its lists right away instead of polling isGameValid().
+		explicit GameScheduler(unsigned worker_count = 0, std::function<void()> game_finished = nullptr);
+		~GameScheduler();
+
+		GameScheduler(const GameScheduler&) = delete;
+		GameScheduler& operator=(const GameScheduler&) = delete;
+
+		/// adds a game which is then ticked \p game_speed times per second.
+		void addGame(std::shared_ptr<NetworkGame> game, float game_speed);
+
+		/// stops all workers and releases all games. Called automatically by the destructor.
+		void shutdown();
+
+		unsigned getWorkerCount() const;
+		/// number of games currently managed by the scheduler, including finished games that are still
+		/// processing their remaining packets.
+		int getScheduledGamesCount() const;
+
+		TickStatistics getTickStatistics() const;
+		void printTickStatistics(std::ostream& stream) const;
+
+	private:
+		struct Entry
+		{
+			clock_type::time_point deadline;
+			clock_type::duration period;
+			std::shared_ptr<NetworkGame> game;
+		};
+
+		// ordering for the heap: the entry with the earliest deadline is on top
+		static bool laterDeadline(const Entry& a, const Entry& b) { return a.deadline > b.deadline; }
+
+		void workerLoop();
+		void pushEntry(Entry entry);
+
+		mutable std::mutex mMutex;
+		std::condition_variable mWakeup;
+		std::vector<Entry> mQueue;	// binary heap ordered by laterDeadline
+		const std::function<void()> mGameFinished;
+		bool mRunning;
+		int mGameCount;
+
+		// tick statistics, protected by mMutex
+		TickStatistics mStatistics;
+
+		std::vector<std::thread> mWorkers;
+};
@@ -0,0 +1,165 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/*! \class MPSCQueue
+	\brief bounded, lock-free queue for many producers and a single consumer.
+	\details All memory is allocated in the constructor, pushing and popping never allocate and never block.
+			Every slot of the ring carries a sequence number which tells whether it is free for the producer
+			that claimed position \p pos (sequence == pos) or holds a value that can be consumed
+			(sequence == pos + 1). Producers claim a position with a CAS on the enqueue counter, write the
+			value and then publish it with a release store of the sequence number. The consumer owns the
+			dequeue counter exclusively, so popping needs no read-modify-write operation at all.
+			Only one thread may pop at any time. Ownership of the consumer side may move between threads,
+			as long as the hand-over is synchronized externally.
+*/
+template<class T>
+class MPSCQueue
+{
+	public:
+		/// creates a queue that can hold at least \p capacity elements. The capacity is rounded up to
+		/// the next power of two.
+		explicit MPSCQueue(std::size_t capacity) :
+			mEnqueuePos(0),
+			mDequeuePos(0)
+		{
+			std::size_t size = 2;
+			while(size < capacity)
+				size *= 2;
+
+			mMask = size - 1;
+			mCells.reset(new Cell[size]);
+			for(std::size_t i = 0; i < size; ++i)
+				mCells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		/// adds \p value to the queue. Can be called from any thread.
+		/// \return false if the queue is full. In that case, \p value is left untouched.
+		bool tryPush(T&& value)
+		{
+			Cell* cell;
+			std::size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+			while(true)
+			{
+				cell = &mCells[pos & mMask];
+				std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+				std::intptr_t diff = (std::intptr_t)seq - (std::intptr_t)pos;
+				if(diff == 0)
+				{
+					// slot is free, try to claim it
+					if(mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if(diff < 0)
+				{
+					// slot still holds a value from the last round: queue is full
+					return false;
+				}
+				else
+				{
+					// another producer was faster
+					pos = mEnqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+
+			cell->value = std::move(value);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool tryPush(const T& value)
+		{
+			T copy(value);
+			return tryPush(std::move(copy));
+		}
+
+		/// removes the oldest element and stores it in \p value. May only be called by the consumer.
+		/// \return false if no element is available.
+		bool tryPop(T& value)
+		{
+			Cell& cell = mCells[mDequeuePos & mMask];
+			std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+			if(seq != mDequeuePos + 1)
+				return false;
+
+			value = std::move(cell.value);
+			// don't keep the moved-from value (e.g. a shared_ptr) alive in the ring
+			cell.value = T();
+			cell.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+			++mDequeuePos;
+			return true;
+		}
+
+		/// pops all elements that are currently available and passes each of them to \p consumer.
+		/// At most capacity() elements are handled, so producers can not keep the consumer busy forever.
+		/// May only be called by the consumer.
+		/// \return number of processed elements.
+		template<class F>
+		std::size_t drain(F&& consumer)
+		{
+			std::size_t count = 0;
+			T value;
+			while(count <= mMask && tryPop(value))
+			{
+				consumer(value);
+				++count;
+			}
+			return count;
+		}
+
+		/// true if the queue holds no element that is ready to be consumed. May only be called by the consumer.
+		bool empty() const
+		{
+			return mCells[mDequeuePos & mMask].sequence.load(std::memory_order_acquire) != mDequeuePos + 1;
+		}
+
+		std::size_t capacity() const
+		{
+			return mMask + 1;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<std::size_t> sequence;
+			T value;
+		};
+
+		static const std::size_t CACHE_LINE_SIZE = 64;
+
+		std::unique_ptr<Cell[]> mCells;
+		std::size_t mMask;
+
+		// keep the producer and consumer counters on separate cache lines
+		char mPad0[CACHE_LINE_SIZE];
+		std::atomic<std::size_t> mEnqueuePos;
+		char mPad1[CACHE_LINE_SIZE];
+		std::size_t mDequeuePos;
+};
@@ -41,8 +41,23 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "PhysicWorld.h"
 #include "NetworkPlayer.h"
 #include "InputSource.h"
+#include "ServerMetrics.h"
 
-extern int SWLS_GameSteps;
+#ifndef WIN32
+#ifndef __ANDROID__
+#ifndef __SWITCH__
+#include <sys/syslog.h>
+#endif
+#endif
+#endif
+
+#ifdef __ANDROID__
+extern "C"
+#endif
+void syslog(int pri, const char* format, ...);
+
+/// number of packets that can be queued for a game between two ticks
+const std::size_t GAME_PACKET_QUEUE_SIZE = 256;
 
 /* implementation */
 
@@ -50,8 +65,9 @@ NetworkGame::NetworkGame(ThreadSafeRakServer* server, NetworkPlayer& leftPlayer,
 			NetworkPlayer& rightPlayer, PlayerSide switchedSide,
 			std::string rules, int scoreToWin, float speed) :
 	mServer(server),
+	mPacketQueue(GAME_PACKET_QUEUE_SIZE),
 	mMatch(new DuelMatch(false, rules, scoreToWin)),
-	mSpeedController(speed),
+	mGameSpeed(speed),
 	mLeftInput (new InputSource()),
 	mRightInput(new InputSource()),
 	mLeftLastTime(-1),
@@ -77,10 +93,16 @@ NetworkGame::NetworkGame(ThreadSafeRakServer* server, NetworkPlayer& leftPlayer,
 	mRightPlayer = rightPlayer.getID();
 	mSwitchedSide = switchedSide;
 
+	// the server may run many long games at once, so keep their replays out of memory
+	if(!mRecorder->enableSpooling())
+	{
+		syslog(LOG_WARNING, "Could not create replay spool file, recording replay in memory");
+	}
 	mRecorder->setPlayerNames(leftPlayer.getName(), rightPlayer.getName());
 	mRecorder->setPlayerColors(leftPlayer.getColor(), rightPlayer.getColor());
-	mRecorder->setGameSpeed(mSpeedController.getGameSpeed());
+	mRecorder->setGameSpeed(mGameSpeed);
 	mRecorder->setGameRules(rules);
+	mRecorder->setPhysicBackend(mMatch->getPhysicBackend());
 
 	// read rulesfile into a string
 	mRulesSent[0] = false;
@@ -98,31 +120,17 @@ NetworkGame::NetworkGame(ThreadSafeRakServer* server, NetworkPlayer& leftPlayer,
 	stream.Write(mMatch->getScoreToWin());
 	/// \todo write file author and title, too; maybe add a version number in scripts, too.
 	broadcastBitstream(stream);
-
-	// game loop
-	mGameThread = std::thread(
-		[this]()
-		{
-			while(mGameValid)
-			{
-				processPackets();
-				step();
-				SWLS_GameSteps++;
-				mSpeedController.update();
-			}
-		}					);
 }
 
 NetworkGame::~NetworkGame()
 {
 	mGameValid = false;
-	mGameThread.join();
 }
 
-void NetworkGame::injectPacket(const packet_ptr& packet)
+bool NetworkGame::injectPacket(const packet_ptr& packet)
 {
-	std::lock_guard<std::mutex> lock(mPacketQueueMutex);
-	mPacketQueue.push_back(packet);
+	// input updates are sent unreliable and superseded by the next one anyway
+	return mPacketQueue.push(packet, packet->data[0] != ID_INPUT_UPDATE);
 }
 
 void NetworkGame::broadcastBitstream(const RakNet::BitStream& stream, const RakNet::BitStream& switchedstream)
@@ -157,19 +165,9 @@ void NetworkGame::broadcastBitstream(const RakNet::BitStream& stream)
 	mServer->Send(stream, HIGH_PRIORITY, RELIABLE_ORDERED, mRightPlayer);
 }
 
-void NetworkGame::processPackets()
+std::size_t NetworkGame::processPackets()
 {
-	while (!mPacketQueue.empty())
-	{
-		packet_ptr packet;
-		{
-			std::lock_guard<std::mutex> lock(mPacketQueueMutex);
-			packet = mPacketQueue.front();
-			mPacketQueue.pop_front();
-		}
-
-		processPacket( packet );
-	}
+	return mPacketQueue.drain( [this](const packet_ptr& packet) { processPacket( packet ); } );
 }
 
 /// this function processes a single packet received for this network game
@@ -198,6 +196,9 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 			stream.IgnoreBytes(1);
 			stream.Read(time);
 			PlayerInputAbs newInput(stream);
+			// last game update the client received
+			std::uint32_t ack = 0;
+			stream.Read(ack);
 
 			if (packet->playerId == mLeftPlayer)
 			{
@@ -205,6 +206,7 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 					newInput.swapSides();
 				mLeftInput->setInput(newInput);
 				mLeftLastTime = time;
+				mSnapshotEncoder[LEFT_PLAYER].acknowledge(ack);
 			}
 			if (packet->playerId == mRightPlayer)
 			{
@@ -212,6 +214,7 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 					newInput.swapSides();
 				mRightInput->setInput(newInput);
 				mRightLastTime = time;
+				mSnapshotEncoder[RIGHT_PLAYER].acknowledge(ack);
 			}
 			break;
 		}
@@ -297,7 +300,7 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 				// writing data into leftStream
 				RakNet::BitStream leftStream;
 				leftStream.Write((unsigned char)ID_GAME_READY);
-				leftStream.Write((int)mSpeedController.getGameSpeed());
+				leftStream.Write((int)mGameSpeed);
 				strncpy(name, mMatch->getPlayer(RIGHT_PLAYER).getName().c_str(), sizeof(name));
 				leftStream.Write(name, sizeof(name));
 				leftStream.Write(mMatch->getPlayer(RIGHT_PLAYER).getStaticColor().toInt());
@@ -305,7 +308,7 @@ void NetworkGame::processPacket( const packet_ptr& packet )
 				// writing data into rightStream
 				RakNet::BitStream rightStream;
 				rightStream.Write((unsigned char)ID_GAME_READY);
-				rightStream.Write((int)mSpeedController.getGameSpeed());
+				rightStream.Write((int)mGameSpeed);
 				strncpy(name, mMatch->getPlayer(LEFT_PLAYER).getName().c_str(), sizeof(name));
 				rightStream.Write(name, sizeof(name));
 				rightStream.Write(mMatch->getPlayer(LEFT_PLAYER).getStaticColor().toInt());
@@ -329,6 +332,19 @@ bool NetworkGame::isGameValid() const
 	return mGameValid;
 }
 
+float NetworkGame::getGameSpeed() const
+{
+	return mGameSpeed;
+}
+
+void NetworkGame::tick()
+{
+	ServerMetrics& metrics = ServerMetrics::get();
+	metrics.gamePacketBatch.observe( processPackets() );
+	step();
+	metrics.gameSteps.increment();
+}
+
 
 void NetworkGame::step()
 {
@@ -367,7 +383,7 @@ void NetworkGame::step()
 	}
 }
 
-void NetworkGame::broadcastPhysicState(const DuelMatchState& state) const
+void NetworkGame::broadcastPhysicState(const DuelMatchState& state)
 {
 	DuelMatchState ms = state;	// modifiable copy
 
@@ -375,13 +391,10 @@ void NetworkGame::broadcastPhysicState(const DuelMatchState& state) const
 	stream.Write((unsigned char)ID_GAME_UPDATE);
 	stream.Write( mLeftLastTime );
 
-	/// \todo this required dynamic memory allocation! not good!
-	std::shared_ptr<GenericOut> out = createGenericWriter( &stream );
-
 	if (mSwitchedSide == LEFT_PLAYER)
 		ms.swapSides();
 
-	out->generic<DuelMatchState> (ms);
+	mSnapshotEncoder[LEFT_PLAYER].encode(ms, stream);
 	mServer->Send(stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, mLeftPlayer);
 
 	// reset state and stream
@@ -389,14 +402,11 @@ void NetworkGame::broadcastPhysicState(const DuelMatchState& state) const
 	stream.Write((unsigned char)ID_GAME_UPDATE);
 	stream.Write( mRightLastTime );
 
-	out = createGenericWriter( &stream );
-
 	// either switch back, or perform switching for right side
 	if (mSwitchedSide == LEFT_PLAYER || mSwitchedSide == RIGHT_PLAYER)
 		ms.swapSides();
 
-	out->generic<DuelMatchState> (ms);
-
+	mSnapshotEncoder[RIGHT_PLAYER].encode(ms, stream);
 	mServer->Send(stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, mRightPlayer);
 }
 
@@ -416,7 +426,7 @@ void NetworkGame::broadcastGameEvents() const
 {
 	RakNet::BitStream stream;
 
-	auto events = mMatch->getEvents();
+	const auto& events = mMatch->getEvents();
 	// send the events
 	if( events.empty() )
 		return;
@@ -20,24 +20,20 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
-#include <list>
-#include <mutex>
-#include <thread>
 #include <memory>
 
 #include "Global.h"
 #include "raknet/NetworkTypes.h"
 #include "raknet/BitStream.h"
-#include "SpeedController.h"
 #include "DuelMatch.h"
+#include "SnapshotCodec.h"
 #include "BlobbyDebug.h"
+#include "PacketInbox.h"
 
 class ThreadSafeRakServer;
 class ReplayRecorder;
 class NetworkPlayer;
 
-typedef std::list<packet_ptr> PacketQueue;
-
 class NetworkGame : public ObjectCounter<NetworkGame>
 {
 	public:
@@ -55,7 +51,10 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 
 		~NetworkGame();
 
-		void injectPacket(const packet_ptr& packet);
+		/// queues a packet for processing in the next tick. Can be called from any thread and never blocks.
+		/// Reliable packets are always queued, input updates are dropped if the queue is full.
+		/// \return false, if the packet was dropped.
+		bool injectPacket(const packet_ptr& packet);
 
 		/// It returns whether both clients are still connected.
 		bool isGameValid() const;
@@ -65,17 +64,25 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 		// the current state and outstanding messages to the clients.
 		void step();
 
+		/// performs a single game tick: processes the queued packets and steps the game.
+		/// Called by the GameScheduler with the frequency given by getGameSpeed().
+		void tick();
+
 		/// This function processes all queued network packets.
-		void processPackets();
+		/// It must not be called concurrently with itself or step().
+		/// \return the number of processed packets.
+		std::size_t processPackets();
 
 		// game info
 		/// gets network IDs of players
 		PlayerID getPlayerID( PlayerSide side ) const;
+		/// gets the number of game steps per second
+		float getGameSpeed() const;
 
 	private:
 		void broadcastBitstream(const RakNet::BitStream& stream, const RakNet::BitStream& switchedstream);
 		void broadcastBitstream(const RakNet::BitStream& stream);
-		void broadcastPhysicState(const DuelMatchState& state) const;
+		void broadcastPhysicState(const DuelMatchState& state);
 		void broadcastGameEvents() const;
 		void writeEventToStream(RakNet::BitStream& stream, MatchEvent e, bool switchSides ) const;
 		bool isGameStarted() { return mRulesSent[LEFT_PLAYER] && mRulesSent[RIGHT_PLAYER]; }
@@ -88,16 +95,15 @@ class NetworkGame : public ObjectCounter<NetworkGame>
 		PlayerID mRightPlayer;
 		PlayerSide mSwitchedSide;
 
-		PacketQueue mPacketQueue;
-		std::mutex mPacketQueueMutex;
+		PacketInbox mPacketQueue;
 
 		const std::unique_ptr<DuelMatch> mMatch;
-		SpeedController mSpeedController;
+		float mGameSpeed;
 		std::shared_ptr<InputSource> mLeftInput;
 		std::shared_ptr<InputSource> mRightInput;
 		unsigned mLeftLastTime;
 		unsigned mRightLastTime;
-		std::thread mGameThread;
+		SnapshotEncoder mSnapshotEncoder[MAX_PLAYERS];
 
 		const std::unique_ptr<ReplayRecorder> mRecorder;
 
@@ -0,0 +1,110 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "raknet/NetworkTypes.h"
+#include "MPSCQueue.h"
+
+/*! \class PacketInbox
+	\brief queue of received packets that never loses a reliable packet.
+	\details Packets are passed through a bounded MPSCQueue, so the common case neither locks nor allocates.
+			When the queue is full, reliable packets (chat, replays, rules, connection changes...) are
+			moved to an unbounded overflow list that is protected by a mutex. Only unreliable packets are
+			dropped, the client resends those anyway. Once the overflow list is in use, all further
+			packets are appended to it until the consumer has emptied it, so the order of the packets
+			of a producer is preserved.
+*/
+class PacketInbox
+{
+	public:
+		explicit PacketInbox(std::size_t capacity) : mQueue(capacity), mOverflowing(false)
+		{
+		}
+
+		/// queues \p packet. Can be called from any thread and never blocks on the consumer.
+		/// \param reliable if true, the packet is kept even if the queue is full.
+		/// \return false, if the queue is full and the (unreliable) packet was dropped.
+		bool push(const packet_ptr& packet, bool reliable)
+		{
+			if(!mOverflowing.load(std::memory_order_acquire) && mQueue.tryPush(packet))
+				return true;
+
+			if(!reliable)
+				return false;
+
+			std::lock_guard<std::mutex> lock(mOverflowMutex);
+			mOverflow.push_back(packet);
+			mOverflowing.store(true, std::memory_order_release);
+			return true;
+		}
+
+		/// removes the oldest packet and stores it in \p packet. May only be called by the consumer.
+		/// \return false if no packet is available.
+		bool tryPop(packet_ptr& packet)
+		{
+			if(mQueue.tryPop(packet))
+				return true;
+			if(!mOverflowing.load(std::memory_order_acquire))
+				return false;
+
+			std::lock_guard<std::mutex> lock(mOverflowMutex);
+			if(mOverflow.empty())
+				return false;
+			packet = std::move(mOverflow.front());
+			mOverflow.pop_front();
+			if(mOverflow.empty())
+				mOverflowing.store(false, std::memory_order_release);
+			return true;
+		}
+
+		/// passes all queued packets to \p consumer. May only be called by the consumer.
+		/// \return number of processed packets.
+		template<class F>
+		std::size_t drain(F&& consumer)
+		{
+			std::size_t count = mQueue.drain(consumer);
+			if(!mOverflowing.load(std::memory_order_acquire))
+				return count;
+
+			std::deque<packet_ptr> overflow;
+			{
+				std::lock_guard<std::mutex> lock(mOverflowMutex);
+				overflow.swap(mOverflow);
+				mOverflowing.store(false, std::memory_order_release);
+			}
+			for(const auto& packet : overflow)
+				consumer(packet);
+			return count + overflow.size();
+		}
+
+	private:
+		MPSCQueue<packet_ptr> mQueue;
+
+		std::mutex mOverflowMutex;
+		std::deque<packet_ptr> mOverflow;
+		std::atomic<bool> mOverflowing;
+};
@@ -0,0 +1,224 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ServerMetrics.h"
+
+/* includes */
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+
+/* implementation */
+
+namespace
+{
+	void atomicAdd(std::atomic<double>& target, double amount)
+	{
+		double current = target.load(std::memory_order_relaxed);
+		while(!target.compare_exchange_weak(current, current + amount, std::memory_order_relaxed))
+		{
+		}
+	}
+}
+
+void MetricGauge::add(double amount)
+{
+	atomicAdd(mValue, amount);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+MetricHistogram::MetricHistogram(std::vector<double> bounds) :
+	mBounds(std::move(bounds)),
+	mBuckets(new std::atomic<std::uint64_t>[mBounds.size() + 1]),
+	mSum(0)
+{
+	for(std::size_t i = 0; i <= mBounds.size(); ++i)
+		mBuckets[i].store(0, std::memory_order_relaxed);
+}
+
+void MetricHistogram::observe(double value)
+{
+	std::size_t index = std::lower_bound(mBounds.begin(), mBounds.end(), value) - mBounds.begin();
+	mBuckets[index].fetch_add(1, std::memory_order_relaxed);
+	atomicAdd(mSum, value);
+}
+
+std::uint64_t MetricHistogram::getBucketCount(std::size_t index) const
+{
+	return mBuckets[index].load(std::memory_order_relaxed);
+}
+
+std::uint64_t MetricHistogram::getCount() const
+{
+	std::uint64_t count = 0;
+	for(std::size_t i = 0; i <= mBounds.size(); ++i)
+		count += getBucketCount(i);
+	return count;
+}
+
+double MetricHistogram::getSum() const
+{
+	return mSum.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+struct MetricsRegistry::Entry
+{
+	std::string name;
+	std::string help;
+	std::unique_ptr<MetricCounter> counter;
+	std::unique_ptr<MetricGauge> gauge;
+	std::unique_ptr<MetricHistogram> histogram;
+};
+
+MetricsRegistry::MetricsRegistry() = default;
+MetricsRegistry::~MetricsRegistry() = default;
+
+MetricCounter& MetricsRegistry::createCounter(const std::string& name, const std::string& help)
+{
+	std::unique_ptr<Entry> entry(new Entry{name, help, nullptr, nullptr, nullptr});
+	entry->counter.reset(new MetricCounter());
+	MetricCounter& result = *entry->counter;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.push_back(std::move(entry));
+	return result;
+}
+
+MetricGauge& MetricsRegistry::createGauge(const std::string& name, const std::string& help)
+{
+	std::unique_ptr<Entry> entry(new Entry{name, help, nullptr, nullptr, nullptr});
+	entry->gauge.reset(new MetricGauge());
+	MetricGauge& result = *entry->gauge;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.push_back(std::move(entry));
+	return result;
+}
+
+MetricHistogram& MetricsRegistry::createHistogram(const std::string& name, const std::string& help,
+												  std::vector<double> bounds)
+{
+	std::unique_ptr<Entry> entry(new Entry{name, help, nullptr, nullptr, nullptr});
+	entry->histogram.reset(new MetricHistogram(std::move(bounds)));
+	MetricHistogram& result = *entry->histogram;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.push_back(std::move(entry));
+	return result;
+}
+
+void MetricsRegistry::writePrometheus(std::ostream& stream) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for(const auto& entry : mEntries)
+	{
+		stream << "# HELP " << entry->name << " " << entry->help << "\n";
+		if(entry->counter)
+		{
+			stream << "# TYPE " << entry->name << " counter\n";
+			stream << entry->name << " " << entry->counter->value() << "\n";
+		}
+		else if(entry->gauge)
+		{
+			stream << "# TYPE " << entry->name << " gauge\n";
+			stream << entry->name << " " << entry->gauge->value() << "\n";
+		}
+		else if(entry->histogram)
+		{
+			const MetricHistogram& histogram = *entry->histogram;
+			const auto& bounds = histogram.getBounds();
+			stream << "# TYPE " << entry->name << " histogram\n";
+
+			// prometheus buckets are cumulative
+			std::uint64_t cumulative = 0;
+			for(std::size_t i = 0; i < bounds.size(); ++i)
+			{
+				cumulative += histogram.getBucketCount(i);
+				stream << entry->name << "_bucket{le=\"" << bounds[i] << "\"} " << cumulative << "\n";
+			}
+			cumulative += histogram.getBucketCount(bounds.size());
+			stream << entry->name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+			stream << entry->name << "_sum " << histogram.getSum() << "\n";
+			stream << entry->name << "_count " << cumulative << "\n";
+		}
+	}
+}
+
+bool MetricsRegistry::writePrometheusFile(const std::string& path) const
+{
+	std::string temp_path = path + ".tmp";
+	{
+		std::ofstream file(temp_path);
+		if(!file)
+			return false;
+		writePrometheus(file);
+		if(!file)
+			return false;
+	}
+	return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+std::vector<double> MetricsRegistry::exponentialBuckets(double start, double factor, int count)
+{
+	std::vector<double> bounds;
+	for(int i = 0; i < count; ++i)
+	{
+		bounds.push_back(start);
+		start *= factor;
+	}
+	return bounds;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+ServerMetrics::ServerMetrics() :
+	packetsReceived( registry.createCounter("blobby_packets_received_total", "Packets received from clients.") ),
+	packetsDropped( registry.createCounter("blobby_packets_dropped_total", "Received packets dropped because a queue was full.") ),
+	connectionsAccepted( registry.createCounter("blobby_connections_total", "Incoming connections.") ),
+	gamesStarted( registry.createCounter("blobby_games_started_total", "Games that have been started.") ),
+	gameSteps( registry.createCounter("blobby_game_steps_total", "Simulated game steps over all games.") ),
+	blockedSends( registry.createCounter("blobby_blocked_sends_total", "Packets that had to be sent while holding the server lock because the send queue was full.") ),
+	uptime( registry.createGauge("blobby_uptime_seconds", "Time since the server was started.") ),
+	activeGames( registry.createGauge("blobby_active_games", "Games that are currently running.") ),
+	scheduledGames( registry.createGauge("blobby_scheduled_games", "Games handled by the game scheduler, including finished games that still process packets.") ),
+	connectedClients( registry.createGauge("blobby_connected_clients", "Open client connections.") ),
+	connectedPlayers( registry.createGauge("blobby_connected_players", "Players that entered the server.") ),
+	sendQueueDepth( registry.createGauge("blobby_send_queue_depth", "Outgoing packets waiting for the network thread.") ),
+	tickDuration( registry.createHistogram("blobby_game_tick_duration_seconds", "Time needed for a single game tick.",
+										   MetricsRegistry::exponentialBuckets(0.00005, 2, 12)) ),
+	tickLateness( registry.createHistogram("blobby_game_tick_lateness_seconds", "Delay between the scheduled and the actual start of a game tick.",
+										   MetricsRegistry::exponentialBuckets(0.0001, 2, 12)) ),
+	gamePacketBatch( registry.createHistogram("blobby_game_packet_batch_size", "Packets waiting in a game queue at the start of a tick.",
+											  {0, 1, 2, 4, 8, 16, 32, 64, 128}) ),
+	sendLatency( registry.createHistogram("blobby_send_queue_latency_seconds", "Time between queueing an outgoing packet and handing it to the network layer.",
+										  MetricsRegistry::exponentialBuckets(0.0001, 2, 12)) )
+{
+}
+
+ServerMetrics& ServerMetrics::get()
+{
+	static ServerMetrics metrics;
+	return metrics;
+}
@@ -0,0 +1,145 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// monotonically increasing value, e.g. number of received packets.
+class MetricCounter
+{
+	public:
+		MetricCounter() : mValue(0) {}
+
+		void increment(std::uint64_t amount = 1) { mValue.fetch_add(amount, std::memory_order_relaxed); }
+		std::uint64_t value() const { return mValue.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<std::uint64_t> mValue;
+};
+
+/// value that can go up and down, e.g. number of active games.
+class MetricGauge
+{
+	public:
+		MetricGauge() : mValue(0) {}
+
+		void set(double value) { mValue.store(value, std::memory_order_relaxed); }
+		void add(double amount);
+		double value() const { return mValue.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<double> mValue;
+};
+
+/// distribution of observed values, counted in fixed buckets.
+class MetricHistogram
+{
+	public:
+		/// \param bounds upper bounds of the buckets, in increasing order. A final bucket for
+		///			all larger values is added automatically.
+		explicit MetricHistogram(std::vector<double> bounds);
+
+		void observe(double value);
+
+		const std::vector<double>& getBounds() const { return mBounds; }
+		/// number of observations in bucket \p index (not cumulative). The last index is the overflow bucket.
+		std::uint64_t getBucketCount(std::size_t index) const;
+		std::uint64_t getCount() const;
+		double getSum() const;
+
+	private:
+		std::vector<double> mBounds;
+		std::unique_ptr<std::atomic<std::uint64_t>[]> mBuckets;
+		std::atomic<double> mSum;
+};
+
+/*! \class MetricsRegistry
+	\brief owns a set of named metrics and exports them in the Prometheus text format.
+	\details Metrics are created once and then updated without any locking, so they can be used from
+			every thread. The registry itself is only locked while creating metrics and while exporting.
+*/
+class MetricsRegistry
+{
+	public:
+		MetricsRegistry();
+		~MetricsRegistry();
+
+		MetricsRegistry(const MetricsRegistry&) = delete;
+		MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+		MetricCounter& createCounter(const std::string& name, const std::string& help);
+		MetricGauge& createGauge(const std::string& name, const std::string& help);
+		MetricHistogram& createHistogram(const std::string& name, const std::string& help, std::vector<double> bounds);
+
+		void writePrometheus(std::ostream& stream) const;
+		/// writes the Prometheus text to \p path. The data is first written to a temporary file which then
+		/// replaces \p path, so readers never see a partially written file.
+		/// \return false if the file could not be written.
+		bool writePrometheusFile(const std::string& path) const;
+
+		/// creates \p count bucket bounds, starting at \p start and growing by \p factor.
+		static std::vector<double> exponentialBuckets(double start, double factor, int count);
+
+	private:
+		struct Entry;
+
+		mutable std::mutex mMutex;
+		std::vector<std::unique_ptr<Entry>> mEntries;
+};
+
+/*! \struct ServerMetrics
+	\brief all metrics collected by the blobby server.
+	\details Replaces the old SWLS_* globals. The histograms measure durations in seconds.
+*/
+struct ServerMetrics
+{
+	MetricsRegistry registry;
+
+	MetricCounter& packetsReceived;
+	MetricCounter& packetsDropped;
+	MetricCounter& connectionsAccepted;
+	MetricCounter& gamesStarted;
+	MetricCounter& gameSteps;
+	MetricCounter& blockedSends;
+
+	MetricGauge& uptime;
+	MetricGauge& activeGames;
+	MetricGauge& scheduledGames;
+	MetricGauge& connectedClients;
+	MetricGauge& connectedPlayers;
+	MetricGauge& sendQueueDepth;
+
+	MetricHistogram& tickDuration;
+	MetricHistogram& tickLateness;
+	MetricHistogram& gamePacketBatch;
+	MetricHistogram& sendLatency;
+
+	static ServerMetrics& get();
+
+	private:
+		ServerMetrics();
+};
@@ -0,0 +1,137 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* header include */
+#include "ThreadSafeRakServer.h"
+
+/* includes */
+#include <algorithm>
+#include <ostream>
+
+#include "ServerMetrics.h"
+
+/* implementation */
+
+/// number of outgoing packets that can wait for the network thread. The network thread flushes the queue
+/// every few milliseconds, while each game sends a handful of packets per tick.
+const std::size_t SEND_QUEUE_SIZE = 8192;
+
+ThreadSafeRakServer::ThreadSafeRakServer() :
+	mServer(new RakServer()),
+	mSendQueue(SEND_QUEUE_SIZE),
+	mQueuedSends(0),
+	mBlockedSends(0),
+	mBlockedWaitNs(0),
+	mSentFromQueue(0),
+	mFlushes(0),
+	mMaxBatchSize(0),
+	mTotalQueueLatencyMs(0),
+	mMaxQueueLatencyMs(0)
+{
+}
+
+ThreadSafeRakServer::~ThreadSafeRakServer() = default;
+
+void ThreadSafeRakServer::Send(const RakNet::BitStream& stream, PacketPriority priority, PacketReliability reliability,
+							   PlayerID target, bool broadcast)
+{
+	OutgoingPacket packet;
+	packet.data.assign(stream.GetData(), stream.GetData() + stream.GetNumberOfBytesUsed());
+	packet.bits = stream.GetNumberOfBitsUsed();
+	packet.priority = priority;
+	packet.reliability = reliability;
+	packet.target = target;
+	packet.broadcast = broadcast;
+	packet.queued = clock_type::now();
+
+	if(mSendQueue.tryPush(std::move(packet)))
+	{
+		mQueuedSends++;
+		return;
+	}
+
+	// the network thread is lagging behind; send directly, this keeps the order of our own packets
+	// because access flushes the queue first.
+	auto start = clock_type::now();
+	access([&](RakServer& server)
+	{
+		mBlockedWaitNs += std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count();
+		server.Send(&stream, priority, reliability, 0, target, broadcast);
+	});
+	mBlockedSends++;
+	ServerMetrics::get().blockedSends.increment();
+}
+
+void ThreadSafeRakServer::flushSendQueue()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	flushSendQueueLocked();
+}
+
+void ThreadSafeRakServer::flushSendQueueLocked()
+{
+	if(mSendQueue.empty())
+		return;
+
+	auto now = clock_type::now();
+	MetricHistogram& latency_histogram = ServerMetrics::get().sendLatency;
+	std::size_t count = mSendQueue.drain([&](OutgoingPacket& packet)
+	{
+		RakNet::BitStream stream(packet.data.data(), packet.data.size(), false);
+		stream.SetWriteOffset(packet.bits);
+		mServer->Send(&stream, packet.priority, packet.reliability, 0, packet.target, packet.broadcast);
+
+		double latency = std::chrono::duration<double, std::milli>(now - packet.queued).count();
+		mTotalQueueLatencyMs += latency;
+		mMaxQueueLatencyMs = std::max(mMaxQueueLatencyMs, latency);
+		latency_histogram.observe(latency / 1000.0);
+	});
+
+	mSentFromQueue += count;
+	mFlushes++;
+	mMaxBatchSize = std::max(mMaxBatchSize, count);
+}
+
+ThreadSafeRakServer::SendStatistics ThreadSafeRakServer::getSendStatistics() const
+{
+	SendStatistics stats;
+	stats.queuedSends = mQueuedSends;
+	stats.blockedSends = mBlockedSends;
+	stats.blockedWaitMs = mBlockedWaitNs / 1e6;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	stats.flushes = mFlushes;
+	stats.queueDepth = stats.queuedSends > mSentFromQueue ? stats.queuedSends - mSentFromQueue : 0;
+	stats.maxBatchSize = mMaxBatchSize;
+	stats.meanQueueLatencyMs = mSentFromQueue > 0 ? mTotalQueueLatencyMs / mSentFromQueue : 0;
+	stats.maxQueueLatencyMs = mMaxQueueLatencyMs;
+	return stats;
+}
+
+void ThreadSafeRakServer::printSendStatistics(std::ostream& stream) const
+{
+	SendStatistics stats = getSendStatistics();
+	stream << " sent packets: " << stats.queuedSends << " queued, " << stats.blockedSends << " blocked ("
+		   << stats.blockedWaitMs << " ms waiting)\n";
+	stream << " send queue: depth " << stats.queueDepth << ", " << stats.flushes << " batches, max batch "
+		   << stats.maxBatchSize << "\n";
+	stream << " send queue latency: mean " << stats.meanQueueLatencyMs << " ms, max "
+		   << stats.maxQueueLatencyMs << " ms";
+}
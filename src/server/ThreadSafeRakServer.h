@@ -20,11 +20,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
 #include <mutex>
 #include <memory>
+#include <vector>
 #include "raknet/PacketPriority.h"
 #include "raknet/NetworkTypes.h"
 #include "raknet/RakServer.h"
+#include "MPSCQueue.h"
 
 /*! \brief Wraps a RakServer, so that it can only be accessed while a mutex is locked.
  *  \details Any interaction with the underlying RakServer has to go through the `access`
@@ -32,24 +38,76 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *  with the actual server.
  *
  *  As `Send`ing a packet is by far the most common operation, we provide a specialized convenience
- *  function.
+ *  function. It does not lock the mutex, but copies the packet into a lock-free submission queue.
+ *  The queue is handed to the RakServer in batches by `flushSendQueue`, which should be called
+ *  from the network thread, and before every `access`, so packets sent by one thread are
+ *  always processed before anything else this thread does with the server. Only if the queue
+ *  is full, `Send` falls back to locking the server directly.
  */
 class ThreadSafeRakServer {
 public:
-	ThreadSafeRakServer() : mServer(new RakServer()) {};
+	/// counters describing the load on the send path.
+	struct SendStatistics
+	{
+		std::uint64_t queuedSends = 0;	///< packets that went through the submission queue
+		std::uint64_t blockedSends = 0;	///< packets sent directly because the queue was full
+		std::uint64_t flushes = 0;		///< number of non-empty batches handed to the server
+		std::size_t queueDepth = 0;		///< packets currently waiting in the queue
+		std::size_t maxBatchSize = 0;	///< largest batch handed to the server at once
+		double meanQueueLatencyMs = 0;	///< average time between Send and handing the packet to the server
+		double maxQueueLatencyMs = 0;	///< maximum time between Send and handing the packet to the server
+		double blockedWaitMs = 0;		///< total time blocked sends waited for the server lock
+	};
+
+	ThreadSafeRakServer();
+	~ThreadSafeRakServer();
 
 	template<class F>
 	auto access(F&& f) -> decltype(f(std::declval<RakServer&>())) {
 		std::lock_guard<std::mutex> lock(mMutex);
+		flushSendQueueLocked();
 		return f(*mServer);
 	}
 
+	/// queues \p stream for sending. Can be called from any thread, and only blocks if the send queue is full.
 	void Send(const RakNet::BitStream& stream, PacketPriority priority, PacketReliability reliability, PlayerID target,
-			  bool broadcast=false) {
-		access([&](RakServer& server){ server.Send(&stream, priority, reliability, 0, target, broadcast); });
-	}
+			  bool broadcast=false);
+
+	/// hands all queued packets to the RakServer.
+	void flushSendQueue();
+
+	SendStatistics getSendStatistics() const;
+	void printSendStatistics(std::ostream& stream) const;
 
 private:
-	std::mutex mMutex;
+	typedef std::chrono::steady_clock clock_type;
+
+	struct OutgoingPacket
+	{
+		std::vector<unsigned char> data;
+		int bits;
+		PacketPriority priority;
+		PacketReliability reliability;
+		PlayerID target;
+		bool broadcast;
+		clock_type::time_point queued;
+	};
+
+	// requires mMutex to be locked
+	void flushSendQueueLocked();
+
+	mutable std::mutex mMutex;
 	std::unique_ptr<RakServer> mServer;
-};
\ No newline at end of file
+
+	MPSCQueue<OutgoingPacket> mSendQueue;
+
+	// statistics. The atomics are written by the sending threads, the rest is protected by mMutex.
+	std::atomic<std::uint64_t> mQueuedSends;
+	std::atomic<std::uint64_t> mBlockedSends;
+	std::atomic<std::uint64_t> mBlockedWaitNs;
+	std::uint64_t mSentFromQueue;
+	std::uint64_t mFlushes;
+	std::size_t mMaxBatchSize;
+	double mTotalQueueLatencyMs;
+	double mMaxQueueLatencyMs;
+};
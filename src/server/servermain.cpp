@@ -26,6 +26,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iostream>
 #include <cstdio>
 #include <ctime>
+#include <chrono>
 #include <future>
 
 #include <cerrno>
@@ -36,7 +37,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <SDL.h>
 
 #include "DedicatedServer.h"
-#include "SpeedController.h"
+#include "ServerMetrics.h"
 #include "FileSystem.h"
 #include "UserConfig.h"
 #include "Global.h"
@@ -64,22 +65,19 @@ static bool g_run_in_foreground = false;
 static bool g_print_syslog_to_stderr = false;
 static std::string g_config_file = "server.xml";
 static std::atomic<bool> g_run_server(true); // set this variable to false to stop the server
+static std::string g_metrics_file;			// if not empty, metrics are written to this file
+static int g_metrics_interval = 15;			// seconds between two metrics snapshots
+static const auto g_start_time = std::chrono::steady_clock::now();
 
 // ...
 void printHelp();
 void process_arguments(int argc, char** argv);
 void fork_to_background();
 void setup_physfs(char* argv0);
-std::string statistics();
+std::string statistics(const DedicatedServer& server);
 
-// server workload statistics
-int SWLS_PacketCount = 0;
-int SWLS_Connections = 0;
-int SWLS_Games		 = 0;
-int SWLS_GameSteps	 = 0;
-int SWLS_RunningTime = 0;
-
-const int UPDATE_FREQUENCY = 10;
+// the main loop sleeps until packets arrive or a game ends, but wakes up at least this often for housekeeping
+const auto HOUSEKEEPING_INTERVAL = std::chrono::seconds(1);
 
 void main_loop(DedicatedServer& server);
 
@@ -103,6 +101,7 @@ int main(int argc, char** argv)
 	setup_physfs(argv[0]);
 
 	int maxClients = 100;
+	int gameThreads = 0;
 	std::string rulesFile = DEFAULT_RULES_FILE;
 	std::string gameSpeeds = "75";
 
@@ -113,10 +112,20 @@ int main(int argc, char** argv)
 		maxClients = config.getInteger("maximum_clients");
 		rulesFile  = config.getString("rules", DEFAULT_RULES_FILE);
 		gameSpeeds = config.getString("speeds", gameSpeeds);
+		gameThreads = config.getInteger("game_threads", gameThreads);
+		g_metrics_file = config.getString("metrics_file", g_metrics_file);
+		g_metrics_interval = config.getInteger("metrics_interval", g_metrics_interval);
 
 		// bring that value into a sane range
 		if(maxClients <= 0 || maxClients > 150)
 			maxClients = 150;
+
+		// zero means one thread per core
+		if(gameThreads < 0)
+			gameThreads = 0;
+
+		if(g_metrics_interval < 1)
+			g_metrics_interval = 1;
 	}
 	catch (std::exception& e)
 	{
@@ -133,7 +142,7 @@ int main(int argc, char** argv)
 	std::vector<float> speed_vec;
 	std::transform(speed_vec_str.begin(), speed_vec_str.end(), std::back_inserter(speed_vec), [](const std::string& v ){ return std::stof(v);});
 
-	DedicatedServer server(myinfo, rule_vec, speed_vec, maxClients);
+	DedicatedServer server(myinfo, rule_vec, speed_vec, maxClients, false, gameThreads);
 
 	syslog(LOG_NOTICE, "Blobby Volley 2 dedicated server version %i.%i started", BLOBBY_VERSION_MAJOR, BLOBBY_VERSION_MINOR);
 
@@ -157,6 +166,7 @@ int main(int argc, char** argv)
 		{
 			/// \todo check for confirmation if there are still players connected!
 			g_run_server = false;
+			server.wakeUp();
 			break;
 		}
 		else if ( cmd_vec[0] == "players" )
@@ -169,7 +179,7 @@ int main(int argc, char** argv)
 		}
 		else if ( cmd_vec[0] == "status" )
 		{
-			std::cout << statistics() << std::endl;
+			std::cout << statistics(server) << std::endl;
 		}
 
 	}
@@ -190,25 +200,44 @@ int main(int argc, char** argv)
 // ------------------------------
 void main_loop( DedicatedServer& server)
 {
-	SpeedController scontroller( UPDATE_FREQUENCY );
+	using std::chrono::steady_clock;
+	auto next_housekeeping = steady_clock::now() + HOUSEKEEPING_INTERVAL;
+	auto next_statistics = steady_clock::now() + std::chrono::hours(1);
+	auto next_metrics = steady_clock::now() + std::chrono::seconds(g_metrics_interval);
 
 	while ( g_run_server )
 	{
+		// sleep until the network thread queued lobby packets, a game has ended, or housekeeping is due
+		server.waitForPackets( next_housekeeping );
+
 		// -------------------------------------------------------------------------------
-		//  step through all network games and process input - if a game ended, delete it
+		//  process lobby packets and update the game list
 		// -------------------------------------------------------------------------------
 
-		SWLS_RunningTime++;
+		server.processPackets();
+		server.updateGames();
+
+		auto now = steady_clock::now();
+		if( now < next_housekeeping )
+			continue;
+		next_housekeeping = now + HOUSEKEEPING_INTERVAL;
 
-		if(SWLS_RunningTime % (UPDATE_FREQUENCY * 60 * 60 /*1h*/) == 0 )
+		if( now >= next_statistics )
 		{
-			syslog(LOG_DEBUG, "%s", statistics().c_str());
+			syslog(LOG_DEBUG, "%s", statistics(server).c_str());
+			next_statistics += std::chrono::hours(1);
 		}
 
-		server.processPackets();
-		server.updateGames();
-
-		scontroller.update();
+		ServerMetrics& metrics = ServerMetrics::get();
+		metrics.uptime.set( std::chrono::duration<double>(now - g_start_time).count() );
+		if( !g_metrics_file.empty() && now >= next_metrics )
+		{
+			if(!metrics.registry.writePrometheusFile(g_metrics_file))
+			{
+				syslog(LOG_ERR, "Could not write metrics to %s", g_metrics_file.c_str());
+			}
+			next_metrics = now + std::chrono::seconds(g_metrics_interval);
+		}
 	}
 }
 
@@ -300,14 +329,19 @@ void setup_physfs(char* argv0)
 	fs.addToSearchPath(fs.join("data", "rules.zip"));
 }
 
-std::string statistics()
+std::string statistics(const DedicatedServer& server)
 {
 	std::ostringstream oss;
-	oss << "Blobby Server Status Report " << (SWLS_RunningTime / UPDATE_FREQUENCY / 60 / 60) << "h running \n";
-	oss << " packet count: " << SWLS_PacketCount << "\n";
-	oss << " accepted connections: " << SWLS_Connections << "\n";
-	oss << " started games: " << SWLS_Games << "\n";
-	oss << " game steps: " << SWLS_GameSteps;
+	const ServerMetrics& metrics = ServerMetrics::get();
+	int hours = std::chrono::duration_cast<std::chrono::hours>(std::chrono::steady_clock::now() - g_start_time).count();
+	oss << "Blobby Server Status Report " << hours << "h running \n";
+	oss << " packet count: " << metrics.packetsReceived.value() << " (" << metrics.packetsDropped.value() << " dropped)\n";
+	oss << " accepted connections: " << metrics.connectionsAccepted.value() << "\n";
+	oss << " started games: " << metrics.gamesStarted.value() << "\n";
+	oss << " game steps: " << metrics.gameSteps.value() << "\n";
+	server.printSchedulerStatistics(oss);
+	oss << "\n";
+	server.printSendStatistics(oss);
 	return oss.str();
 }
 
@@ -0,0 +1,124 @@
+/*=============================================================================
+Blobby Volley 2
+Copyright (C) 2023 Daniel Knobe (daniel-knobe@web.de)
+Copyright (C) 2023 Erik Schultheis (erik-schultheis@freenet.de)
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+=============================================================================*/
+
+/* includes */
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <SDL.h>
+
+#include "Global.h"
+#include "FileSystem.h"
+#include "ScriptedInputSource.h"
+#include "DuelMatch.h"
+#include "GenericIO.h"
+#include "NetworkMessage.h"
+#include "SnapshotCodec.h"
+#include "raknet/BitStream.h"
+
+/* implementation */
+
+// Measures the size of the ID_GAME_UPDATE packets for a bot match, comparing the old full
+// DuelMatchState serialization against the delta snapshots. Packet loss and the delay until
+// the client's acknowledgement arrives at the server are simulated.
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3) {
+		std::cerr << "Usage: " << argv[0] << " [LEFT] [RIGHT] [LOSS PERCENT] [ACK DELAY STEPS]\n";
+		return EXIT_FAILURE;
+	}
+
+	std::string left_bot = argv[1];
+	std::string right_bot = argv[2];
+	double loss = argc > 3 ? std::atof(argv[3]) / 100.0 : 0.0;
+	unsigned ack_delay = argc > 4 ? std::atoi(argv[4]) : 6;
+
+	FileSystem filesys(argv[0]);
+	filesys.setWriteDir("/tmp");
+	filesys.addToSearchPath("data");
+
+	SDL_Init(0);
+
+	DuelMatch match{false, "default.lua"};
+	auto leftInput = std::make_shared<ScriptedInputSource>("scripts/" + left_bot, LEFT_PLAYER, 0, &match);
+	auto rightInput = std::make_shared<ScriptedInputSource>("scripts/" + right_bot, RIGHT_PLAYER, 0, &match);
+	match.setPlayers(PlayerIdentity{}, PlayerIdentity{});
+	match.setInputSources(leftInput, rightInput);
+
+	SnapshotEncoder encoder;
+	SnapshotDecoder decoder;
+	std::deque<std::uint32_t> acks;		// acknowledgements on their way to the server
+	std::mt19937 random(42);
+	std::bernoulli_distribution lost(loss);
+
+	std::uint64_t full_bytes = 0;
+	std::uint64_t snapshot_bytes = 0;
+	unsigned steps = 0;
+	unsigned dropped = 0;
+
+	// ten minutes of game time at most
+	while (match.winningPlayer() == NO_PLAYER && steps < 75 * 60 * 10)
+	{
+		match.step();
+		++steps;
+
+		RakNet::BitStream full;
+		full.Write((unsigned char)ID_GAME_UPDATE);
+		full.Write(0u);
+		createGenericWriter(&full)->generic<DuelMatchState>(match.getState());
+		full_bytes += full.GetNumberOfBytesUsed();
+
+		RakNet::BitStream snapshot;
+		snapshot.Write((unsigned char)ID_GAME_UPDATE);
+		snapshot.Write(0u);
+		encoder.encode(match.getState(), snapshot);
+		snapshot_bytes += snapshot.GetNumberOfBytesUsed();
+
+		if(lost(random))
+		{
+			++dropped;
+		}
+		else
+		{
+			DuelMatchState decoded;
+			snapshot.IgnoreBytes(5);
+			decoder.decode(snapshot, decoded);
+		}
+
+		acks.push_back(decoder.getLastSequence());
+		if(acks.size() > ack_delay)
+		{
+			encoder.acknowledge(acks.front());
+			acks.pop_front();
+		}
+	}
+
+	double seconds = steps / 75.0;
+	std::cout << steps << " steps, " << dropped << " packets lost, " << encoder.getKeyframeCount() << " keyframes\n";
+	std::cout << "full state: " << full_bytes / steps << " bytes/packet, " << full_bytes / seconds << " bytes/s\n";
+	std::cout << "snapshots:  " << snapshot_bytes / steps << " bytes/packet, " << snapshot_bytes / seconds << " bytes/s\n";
+	std::cout << "ratio: " << (double)full_bytes / snapshot_bytes << "\n";
+
+	return EXIT_SUCCESS;
+}
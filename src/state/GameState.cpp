@@ -63,7 +63,11 @@ void GameState::presentGame()
 		rmanager.setBlobColor(RIGHT_PLAYER, mMatch->getPlayer(RIGHT_PLAYER).getStaticColor());
 	}
 
-	auto events = mMatch->getEvents( );
+	presentEvents( mMatch->getEvents() );
+}
+
+void GameState::presentEvents(const MatchEventBuffer& events)
+{
 	for(const auto& e : events )
 	{
 		if( e.event == MatchEvent::BALL_HIT_BLOB )
@@ -27,6 +27,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <functional>
 #include <tuple>
 
+class MatchEventBuffer;
+
 /*! \class GameState
 	\brief base class for any game related state (Local, Network, Replay)
 */
@@ -48,6 +50,10 @@ protected:
 	/// LocalGameState, NetworkGameState and ReplayState
 	void presentGame();
 
+	/// plays the sounds and spills the blood of \p events. presentGame does this for the
+	/// events of the last frame of the match.
+	void presentEvents(const MatchEventBuffer& events);
+
 	/// this draws the ui in the game, i.e. clock, score and player names
 	void presentGameUI();
 
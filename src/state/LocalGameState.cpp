@@ -80,7 +80,8 @@ void LocalGameState::init()
 
 	playSound(SoundManager::WHISTLE, ROUND_START_SOUND_VOLUME);
 
-	mMatch.reset(new DuelMatch( false, config->getString("rules")));
+	PhysicBackend backend = config->getBool("fixed_point_physics") ? PhysicBackend::FIXED_POINT : PhysicBackend::FLOAT;
+	mMatch.reset(new DuelMatch( false, config->getString("rules"), 0, backend));
 	std::shared_ptr<InputSource> leftInput = createInputSource(*config, LEFT_PLAYER, mMatch.get());
 	std::shared_ptr<InputSource> rightInput = createInputSource(*config, RIGHT_PLAYER, mMatch.get());
 	mMatch->setPlayers(leftPlayer, rightPlayer);
@@ -90,6 +91,7 @@ void LocalGameState::init()
 	mRecorder->setPlayerColors( leftPlayer.getStaticColor(), rightPlayer.getStaticColor() );
 	mRecorder->setGameSpeed((float)config->getInteger("gamefps"));
 	mRecorder->setGameRules( config->getString("rules") );
+	mRecorder->setPhysicBackend( backend );
 }
 
 
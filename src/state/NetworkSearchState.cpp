@@ -362,17 +362,16 @@ void NetworkSearchState::step_impl()
 			std::vector<std::string> rule_vec{config.getString("rules")};
 
 
-			DedicatedServer server(info, rule_vec, std::vector<float>{ SpeedController::getMainInstance()->getGameSpeed() }, 4, true);
-			SpeedController scontroller( 10 );
+			DedicatedServer server(info, rule_vec, std::vector<float>{ SpeedController::getMainInstance()->getGameSpeed() }, 4, true, 1);
 			gKillHostThread = false;
 			while(!gKillHostThread)
 			{
-				// now run the server
+				// now run the server. The timeout bounds how long it takes to notice gKillHostThread.
 				server.allowNewPlayers(!server.hasActiveGame());
 
 				server.processPackets();
 				server.updateGames();
-				scontroller.update();
+				server.waitForPackets(std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
 			}
 		};
 
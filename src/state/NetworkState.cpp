@@ -137,12 +137,10 @@ void NetworkGameState::step_impl()
 				stream.Read(timeBack);
 				CURRENT_NETWORK_LAG = SDL_GetTicks() - timeBack;
 				DuelMatchState ms;
-				/// \todo this is a performance nightmare: we create a new reader for every packet!
-				///			there should be a better way to do that
-				std::shared_ptr<GenericIn> in = createGenericReader(&stream);
-				in->generic<DuelMatchState> (ms);
-				// inject network data into game
-				mMatch->setState( ms );
+				// inject network data into game. Updates whose base we no longer know are dropped,
+				// the server then falls back to a keyframe.
+				if( mSnapshotDecoder.decode(stream, ms) )
+					mMatch->setState( ms );
 				break;
 			}
 
@@ -151,7 +149,10 @@ void NetworkGameState::step_impl()
 				RakNet::BitStream stream(packet->data, packet->length, false);
 				stream.IgnoreBytes(1);	//ID_GAME_EVENTS
 				//printf("Physic packet received. Time: %d\n", ival);
-				// read events
+				// read events. A packet holds the events of one server frame, so they fit into one
+				// buffer. They are presented right away, because after a stall many packets can arrive
+				// in a single client frame.
+				MatchEventBuffer events;
 				char event = 0;
 				for(stream.Read(event); event != 0; stream.Read(event))
 				{
@@ -160,9 +161,11 @@ void NetworkGameState::step_impl()
 					stream.Read(side);
 					if( event == MatchEvent::BALL_HIT_BLOB )
 						stream.Read(intensity);
-					MatchEvent me{ MatchEvent::EventType(event), (PlayerSide)side, intensity };
-					mMatch->trigger( me );
+					events.push( MatchEvent{ MatchEvent::EventType(event), (PlayerSide)side, intensity } );
 				}
+				if( events.getDropped() > 0 )
+					printf("Dropped %d events of an oversized event packet\n", events.getDropped());
+				presentEvents( events );
 				break;
 			}
 			case ID_WIN_NOTIFICATION:
@@ -490,12 +493,12 @@ void NetworkGameState::step_impl()
 			stream.Write((unsigned char)ID_INPUT_UPDATE);
 			stream.Write( SDL_GetTicks() );
 			input.writeTo(stream);
+			stream.Write( mSnapshotDecoder.getLastSequence() );
 			mClient->Send(&stream, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
 			break;
 		}
 		case PLAYER_WON:
 		{
-			mMatch->updateEvents(); // so the last whistle will be sounded
 			displayWinningPlayerScreen(mWinningPlayer);
 			if (imgui.doButton(GEN_ID, Vector2(290, 360), TextManager::LBL_OK))
 			{
@@ -562,9 +565,3 @@ void syslog(int pri, const char* format, ...)
 	// do nothing?
 }
 
-// debug counters
-int SWLS_PacketCount;
-int SWLS_Connections;
-int SWLS_Games;
-int SWLS_GameSteps;
-int SWLS_ServerEntered;
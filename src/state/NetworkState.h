@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "GameState.h"
 #include "NetworkMessage.h"
 #include "PlayerIdentity.h"
+#include "SnapshotCodec.h"
 
 #include <vector>
 #include <memory>
@@ -78,6 +79,9 @@ private:
 	PlayerSide mOwnSide;
 	PlayerSide mWinningPlayer;
 
+	// decodes the game updates, and tells us which update to acknowledge
+	SnapshotDecoder mSnapshotDecoder;
+
 	// Chat Vars
 	std::vector<std::string> mChatlog;
 	std::vector<bool > mChatOrigin;
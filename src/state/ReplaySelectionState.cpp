@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 /* includes */
 #include <algorithm>
+#include <cctype>
 #include <ctime>
 #include <iostream> // for cerr
 
@@ -31,13 +32,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "TextManager.h"
 #include "SpeedController.h"
 #include "FileSystem.h"
-#include "replays/IReplayLoader.h"
 
 
 /* implementation */
 ReplaySelectionState::ReplaySelectionState() :
 	mSelectedReplay(0),
 	mShowReplayInfo(false),
+	mCatalogueRevision(0),
+	mSortByDate(false),
+	mFilterPosition(0),
 	mChecksumError(false),
 	mVersionError(false)
 {
@@ -45,14 +48,68 @@ ReplaySelectionState::ReplaySelectionState() :
 
 void ReplaySelectionState::init()
 {
-	mReplayFiles = FileSystem::getSingleton().enumerateFiles("replays", ".bvr");
-	if (mReplayFiles.empty())
-		mSelectedReplay = -1;
-	std::sort(mReplayFiles.rbegin(), mReplayFiles.rend());
+	// the file names are available immediately, the metadata is added as the catalogue is updated
+	mAllReplays = FileSystem::getSingleton().enumerateFiles("replays", ".bvr");
+	updateList();
+	mCatalogue.update();
 
 	SpeedController::getMainInstance()->setGameSpeed(75);
 }
 
+namespace
+{
+	std::string toLower(std::string text)
+	{
+		std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+		return text;
+	}
+}
+
+void ReplaySelectionState::updateList()
+{
+	std::string selected;
+	if(mSelectedReplay < mReplayFiles.size())
+		selected = mReplayFiles[mSelectedReplay];
+
+	// filter by file and player names
+	std::string filter = toLower(mFilter);
+	mReplayFiles.clear();
+	for(const auto& name : mAllReplays)
+	{
+		bool match = toLower(name).find(filter) != std::string::npos;
+		auto info = mCatalogueEntries.find(name);
+		if(!match && info != mCatalogueEntries.end())
+		{
+			match = toLower(info->second.playerNames[LEFT_PLAYER]).find(filter) != std::string::npos ||
+					toLower(info->second.playerNames[RIGHT_PLAYER]).find(filter) != std::string::npos;
+		}
+		if(match)
+			mReplayFiles.push_back(name);
+	}
+
+	if(mSortByDate)
+	{
+		// newest first. Replays we have no info about yet go to the end.
+		auto date = [&](const std::string& name) -> std::time_t
+		{
+			auto info = mCatalogueEntries.find(name);
+			return info != mCatalogueEntries.end() && info->second.valid ? info->second.date : 0;
+		};
+		std::stable_sort(mReplayFiles.begin(), mReplayFiles.end(),
+						 [&](const std::string& a, const std::string& b) { return date(a) > date(b); });
+	}
+	else
+	{
+		std::sort(mReplayFiles.rbegin(), mReplayFiles.rend());
+	}
+
+	auto found = std::find(mReplayFiles.begin(), mReplayFiles.end(), selected);
+	if(found != mReplayFiles.end())
+		mSelectedReplay = found - mReplayFiles.begin();
+	else
+		mSelectedReplay = mReplayFiles.empty() ? -1 : 0;
+}
+
 void ReplaySelectionState::step_impl()
 {
 	IMGUI& imgui = getIMGUI();
@@ -64,6 +121,15 @@ void ReplaySelectionState::step_impl()
 	imgui.doImage(GEN_ID, Vector2(400.0, 300.0), "background");
 	imgui.doOverlay(GEN_ID, Vector2(0.0, 0.0), Vector2(800.0, 600.0));
 
+	if(mCatalogue.getRevision() != mCatalogueRevision)
+	{
+		mCatalogueRevision = mCatalogue.getRevision();
+		mCatalogueEntries.clear();
+		for(auto& info : mCatalogue.getEntries())
+			mCatalogueEntries[info.name] = info;
+		updateList();
+	}
+
 	if (imgui.doButton(GEN_ID, Vector2(224.0, 10.0), TextManager::RP_PLAY) &&
 				(mSelectedReplay != -1u))
 	{
@@ -98,21 +164,27 @@ void ReplaySelectionState::step_impl()
 		return;
 	}
 	else
-		imgui.doSelectbox(GEN_ID, Vector2(34.0, 50.0), Vector2(634.0, 550.0), mReplayFiles, mSelectedReplay);
+		imgui.doSelectbox(GEN_ID, Vector2(34.0, 50.0), Vector2(634.0, 520.0), mReplayFiles, mSelectedReplay);
+
+	imgui.doText(GEN_ID, Vector2(34.0, 540.0), TextManager::RP_FILTER);
+	imgui.doEditbox(GEN_ID, Vector2(210.0, 535.0), 17, mFilter, mFilterPosition);
+	if(mFilter != mAppliedFilter)
+	{
+		mAppliedFilter = mFilter;
+		updateList();
+	}
 
 	if (imgui.doButton(GEN_ID, Vector2(644.0, 60.0), TextManager::RP_INFO))
 	{
 		if (!mReplayFiles.empty())
 		{
-			try
-			{
-				mReplayLoader.reset(IReplayLoader::createReplayLoader(std::string("replays/" + mReplayFiles[mSelectedReplay] + ".bvr")));
-				mShowReplayInfo = true;
-			}
-			catch (std::exception& e)
-			{
-				std::cerr << e.what() << std::endl;
-			}
+			// use the catalogue if possible, so we don't have to open the replay
+			auto info = mCatalogueEntries.find(mReplayFiles[mSelectedReplay]);
+			if(info != mCatalogueEntries.end() && info->second.valid)
+				mReplayInfo = info->second;
+			else
+				mReplayInfo = ReplayCatalogue::readReplay(mReplayFiles[mSelectedReplay]);
+			mShowReplayInfo = mReplayInfo.valid;
 		}
 	}
 	if (imgui.doButton(GEN_ID, Vector2(644.0, 95.0), TextManager::RP_DELETE))
@@ -120,24 +192,32 @@ void ReplaySelectionState::step_impl()
 		if (!mReplayFiles.empty())
 		if (FileSystem::getSingleton().deleteFile("replays/" + mReplayFiles[mSelectedReplay] + ".bvr"))
 		{
+			std::string name = mReplayFiles[mSelectedReplay];
+			mAllReplays.erase(std::remove(mAllReplays.begin(), mAllReplays.end(), name), mAllReplays.end());
+			mCatalogue.remove(name);
 			mReplayFiles.erase(mReplayFiles.begin()+mSelectedReplay);
 			if (mSelectedReplay >= mReplayFiles.size())
 				mSelectedReplay = mReplayFiles.size()-1;
 		}
 	}
+	if (imgui.doButton(GEN_ID, Vector2(644.0, 130.0), mSortByDate ? TextManager::RP_SORT_DATE : TextManager::RP_SORT_NAME))
+	{
+		mSortByDate = !mSortByDate;
+		updateList();
+	}
 
 	if(mShowReplayInfo)
 	{
 		// setup
-		std::string left =  mReplayLoader->getPlayerName(LEFT_PLAYER);
-		std::string right =  mReplayLoader->getPlayerName(RIGHT_PLAYER);
+		std::string left =  mReplayInfo.playerNames[LEFT_PLAYER];
+		std::string right =  mReplayInfo.playerNames[RIGHT_PLAYER];
 
 		const int MARGIN = std::min(std::max(int(300 - 24*(std::max(left.size(),right.size()))), 50), 150);
 
 		const int RIGHT = 800 - MARGIN;
 		imgui.doInactiveMode(false);
 		imgui.doOverlay(GEN_ID, Vector2(MARGIN, 180), Vector2(800-MARGIN, 445));
-		std::string repname = mReplayFiles[mSelectedReplay];
+		std::string repname = mReplayInfo.name;
 		imgui.doText(GEN_ID, Vector2(400-repname.size()*12, 190), repname);
 
 		// calculate text positions
@@ -147,7 +227,7 @@ void ReplaySelectionState::step_impl()
 		imgui.doText(GEN_ID, Vector2(400-24, 225), "vs");
 		imgui.doText(GEN_ID, Vector2(RIGHT - 20 - 24*right.size(), 225), right);
 
-		time_t rd = mReplayLoader->getDate();
+		time_t rd = mReplayInfo.date;
 		struct tm* ptm;
 		ptm = gmtime ( &rd );
 		//std::
@@ -157,23 +237,23 @@ void ReplaySelectionState::step_impl()
 		imgui.doText(GEN_ID, Vector2(400 - 12*date.size(), 255), date);
 
 		imgui.doText(GEN_ID, Vector2(MARGIN+20, 300), TextManager::OP_SPEED);
-		std::string speed = std::to_string(mReplayLoader->getSpeed() *100 / 75) + "%" ;
+		std::string speed = std::to_string(mReplayInfo.speed *100 / 75) + "%" ;
 		imgui.doText(GEN_ID, Vector2(RIGHT - 20 - 24*speed.size(), 300), speed);
 
 		imgui.doText(GEN_ID, Vector2(MARGIN+20, 335), TextManager::RP_DURATION);
 		std::string dur;
-		if(mReplayLoader->getDuration() > 99)
+		if(mReplayInfo.duration > 99)
 		{
 			// +30 because of rounding
-			dur = std::to_string((mReplayLoader->getDuration() + 30) / 60) + "min";
+			dur = std::to_string((mReplayInfo.duration + 30) / 60) + "min";
 		} else
 		{
-			dur = std::to_string(mReplayLoader->getDuration()) + "s";
+			dur = std::to_string(mReplayInfo.duration) + "s";
 		}
 		imgui.doText(GEN_ID, Vector2(RIGHT - 20 - 24*dur.size(), 335), dur);
 
 		std::string res;
-		res = std::to_string(mReplayLoader->getFinalScore(LEFT_PLAYER)) + " : " +  std::to_string(mReplayLoader->getFinalScore(RIGHT_PLAYER));
+		res = std::to_string(mReplayInfo.finalScore[LEFT_PLAYER]) + " : " +  std::to_string(mReplayInfo.finalScore[RIGHT_PLAYER]);
 
 		imgui.doText(GEN_ID, Vector2(MARGIN+20, 370), TextManager::RP_RESULT);
 		imgui.doText(GEN_ID, Vector2(RIGHT - 20 - 24*res.size(), 370), res);
@@ -23,11 +23,13 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "State.h"
 
 #include <vector>
+#include <map>
 #include <memory>
 
+#include "replays/ReplayCatalogue.h"
+
 class DuelMatch;
 class ReplayPlayer;
-class IReplayLoader;
 
 /*! \class ReplaySelectionState
 	\brief State for replay selection screen
@@ -41,11 +43,23 @@ public:
 	const char* getStateName() const override;
 
 private:
+	/// rebuilds mReplayFiles from all replays, applying filter and sort order
+	void updateList();
 
-	std::vector<std::string> mReplayFiles;
+	std::vector<std::string> mAllReplays;
+	std::vector<std::string> mReplayFiles;	///< the replays that are displayed
 	unsigned mSelectedReplay;
 	bool mShowReplayInfo;
-	std::unique_ptr<IReplayLoader> mReplayLoader;
+	ReplayInfo mReplayInfo;					///< info of the selected replay, when mShowReplayInfo is set
+
+	ReplayCatalogue mCatalogue;
+	std::map<std::string, ReplayInfo> mCatalogueEntries;
+	unsigned int mCatalogueRevision;
+
+	bool mSortByDate;
+	std::string mFilter;
+	std::string mAppliedFilter;
+	unsigned mFilterPosition;
 
 	bool mChecksumError;
 	bool mVersionError;
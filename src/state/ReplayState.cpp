@@ -22,6 +22,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ReplayState.h"
 
 /* includes */
+#include <algorithm>
+#include <iostream>
+
 #include "IMGUI.h"
 #include "replays/ReplayPlayer.h"
 #include "DuelMatch.h"
@@ -37,10 +40,14 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 extern const std::string DUMMY_RULES_NAME;
 
+// how far the rewind button jumps back
+const int REWIND_SECONDS = 5;
+
 ReplayState::ReplayState()
 {
 	mPositionJump = -1;
 	mPaused = false;
+	mReverse = false;
 
 	mSpeedValue = 8;
 	mSpeedTimer = 0;
@@ -56,15 +63,19 @@ ReplayState::~ReplayState() = default;
 
 void ReplayState::loadReplay(const std::string& file)
 {
+	// the replay is loaded in the background, playback starts in step_impl once it is ready
 	mReplayPlayer.reset( new ReplayPlayer() );
+	mReplayPlayer->loadAsync(std::string("replays/" + file + ".bvr"));
+}
 
+void ReplayState::startPlayback()
+{
 	//try
 	//{
-		mReplayPlayer->load(std::string("replays/" + file + ".bvr"));
 		FileWrite rulesFile("rules/"+TEMP_RULES_NAME);
 		rulesFile.write(mReplayPlayer->getRules());
 		rulesFile.close();
-		mMatch.reset(new DuelMatch(false, TEMP_RULES_NAME));
+		mMatch.reset(new DuelMatch(false, TEMP_RULES_NAME, 0, mReplayPlayer->getPhysicBackend()));
 
 		mMatch->setPlayers(PlayerIdentity{mReplayPlayer->getPlayerName(LEFT_PLAYER)},
 		                   PlayerIdentity{mReplayPlayer->getPlayerName(RIGHT_PLAYER)});
@@ -87,10 +98,53 @@ void ReplayState::loadReplay(const std::string& file)
 	/// \todo reintroduce error handling
 }
 
+void ReplayState::displayLoadingScreen()
+{
+	IMGUI& imgui = getIMGUI();
+
+	imgui.doImage(GEN_ID, Vector2(400.0, 300.0), "background");
+	imgui.doOverlay(GEN_ID, Vector2(0.0, 0.0), Vector2(800.0, 600.0));
+	imgui.doText(GEN_ID, Vector2(400, 250), TextManager::RP_LOADING, TF_ALIGN_CENTER);
+
+	Vector2 prog_pos = Vector2(50, 300);
+	imgui.doOverlay(GEN_ID, prog_pos, Vector2(750, 322), Color(0,0,0));
+	imgui.doOverlay(GEN_ID, prog_pos, Vector2(700*mReplayPlayer->getLoadProgress()+50, 322), Color(0,255,0));
+
+	if (is_exiting())
+	{
+		switchState(new ReplaySelectionState());
+	}
+}
+
 void ReplayState::step_impl()
 {
 	IMGUI& imgui = getIMGUI();
 
+	if(!mMatch)
+	{
+		bool loaded;
+		try
+		{
+			loaded = mReplayPlayer->isLoaded();
+		}
+		catch (std::exception& e)
+		{
+			std::cerr << e.what() << "\n";
+			switchState(new ReplaySelectionState());
+			return;
+		}
+
+		if(!loaded)
+		{
+			displayLoadingScreen();
+			return;
+		}
+
+		startPlayback();
+		// the widgets of the previous state must not keep the keyboard focus
+		imgui.resetSelection();
+	}
+
 	// only draw cursor when mouse moved or clicked in the last second
 	if(mLastMousePosition != getInputMgr().position() || clicked())
 	{
@@ -111,14 +165,24 @@ void ReplayState::step_impl()
 
 	if(mPositionJump != -1)
 	{
-		if(mReplayPlayer->gotoPlayingPosition(mPositionJump, mMatch.get()))
-			mPositionJump = -1;
+		// seeking always reaches the target within this frame
+		mReplayPlayer->gotoPlayingPosition(mPositionJump, mMatch.get());
+		mPositionJump = -1;
 	}
 	else if(!mPaused)
 	{
 		while( mSpeedTimer >= 8)
 		{
-			mPaused = !mReplayPlayer->play(mMatch.get());
+			if(mReverse)
+			{
+				// at the start of the replay, we stop and continue forward when play is pressed
+				mPaused = !mReplayPlayer->playBackwards(mMatch.get());
+				mReverse = !mPaused;
+			}
+			else
+			{
+				mPaused = !mReplayPlayer->play(mMatch.get());
+			}
 			mSpeedTimer -= 8;
 			presentGame();
 		}
@@ -131,6 +195,9 @@ void ReplayState::step_impl()
 	// draw the progress bar
 	Vector2 prog_pos = Vector2(50, 600-22);
 	imgui.doOverlay(GEN_ID, prog_pos, Vector2(750, 600-3), Color(0,0,0));
+	// the part of the file that has been read in the background
+	if(mReplayPlayer->getLoadProgress() < 1.f)
+		imgui.doOverlay(GEN_ID, prog_pos, Vector2(700*mReplayPlayer->getLoadProgress()+50, 600-3), Color(96,96,96));
 	imgui.doOverlay(GEN_ID, prog_pos, Vector2(700*mReplayPlayer->getPlayProgress()+50, 600-3), Color(0,255,0));
 
 	PlayerSide side = NO_PLAYER;
@@ -148,7 +215,9 @@ void ReplayState::step_impl()
 	}
 
 	// play/pause button
-	imgui.doOverlay(GEN_ID, Vector2(350, 535.0), Vector2(450, 575.0));
+	imgui.doOverlay(GEN_ID, Vector2(290, 535.0), Vector2(450, 575.0));
+	bool rewind_click = imgui.doImageButton(GEN_ID, Vector2(310, 555), Vector2(24, 24), "gfx/btn_rewind.bmp");
+	bool reverse_click = imgui.doImageButton(GEN_ID, Vector2(340, 555), Vector2(24, 24), "gfx/btn_reverse.bmp");
 	bool pause_click = imgui.doImageButton(GEN_ID, Vector2(400, 555), Vector2(24, 24), mPaused ? "gfx/btn_play.bmp" : "gfx/btn_pause.bmp");
 	bool fast_click = imgui.doImageButton(GEN_ID, Vector2(430, 555), Vector2(24, 24),  "gfx/btn_fast.bmp");
 	bool slow_click = imgui.doImageButton(GEN_ID, Vector2(370, 555), Vector2(24, 24),  "gfx/btn_slow.bmp");
@@ -179,6 +248,19 @@ void ReplayState::step_impl()
 			mPaused = !mPaused;
 		}
 
+		if (reverse_click)
+		{
+			mReverse = !mReverse;
+			mPaused = false;
+		}
+
+		// the left key only rewinds while it is not needed for keyboard navigation
+		if (rewind_click || (getInputMgr().left() && !imgui.hasFocus()))
+		{
+			// recently played positions are restored from the rewind buffer without any simulation
+			mPositionJump = std::max(0, mReplayPlayer->getReplayPosition() - REWIND_SECONDS * mReplayPlayer->getGameSpeed());
+		}
+
 		if (fast_click)
 		{
 			mSpeedValue *= 2;
@@ -221,7 +303,9 @@ void ReplayState::step_impl()
 				);
 
 			mPaused = false;
+			mReverse = false;
 			mPositionJump = 0;
+			imgui.resetSelection();
 		}
 #ifndef MIYOO_MINI
 		imgui.doCursor();
@@ -42,6 +42,11 @@ public:
 	void loadReplay(const std::string& replay);
 
 private:
+	/// creates the match once the replay has been loaded
+	void startPlayback();
+	/// shows the loading screen until the replay can be played
+	void displayLoadingScreen();
+
 	std::unique_ptr<ReplayPlayer> mReplayPlayer;
 
 	//bool mChecksumError;
@@ -53,6 +58,7 @@ private:
 	// controls
 	int mPositionJump;
 	bool mPaused;
+	bool mReverse;
 
 	// replay speed control
 	int mSpeedValue;
@@ -0,0 +1,213 @@
+#include <boost/test/unit_test.hpp>
+
+#include "BallTrajectory.h"
+#include "GameConstants.h"
+#include "MatchEvents.h"
+#include "PhysicWorld.h"
+#include "XorShift.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// the limit of the frame by frame simulation of simulate_until
+	const int MAX_STEPS = 75 * 5;
+
+	// compares bit by bit, so that e.g. 0.f and -0.f are different
+	bool sameVector(const Vector2& a, const Vector2& b)
+	{
+		return std::memcmp(&a, &b, sizeof(Vector2)) == 0;
+	}
+
+	bool sameEvents(const MatchEventBuffer& a, const MatchEventBuffer& b)
+	{
+		if(a.size() != b.size())
+			return false;
+		for(int i = 0; i < a.size(); ++i)
+		{
+			if(a[i].event != b[i].event || a[i].side != b[i].side)
+				return false;
+		}
+		return true;
+	}
+
+	bool hitGround(const MatchEventBuffer& events)
+	{
+		return std::any_of(events.begin(), events.end(), [](const MatchEvent& event) {
+			return event.event == MatchEvent::BALL_HIT_GROUND;
+		});
+	}
+
+	float uniform(XorShift& random, float low, float high)
+	{
+		return low + (high - low) * (random.next() / 4294967296.f);
+	}
+
+	struct BallState
+	{
+		Vector2 position;
+		Vector2 velocity;
+	};
+
+	/// a ball anywhere in the field, also close to the walls, the ground and the net
+	BallState randomBall(XorShift& random)
+	{
+		BallState ball;
+		ball.position = Vector2(uniform(random, LEFT_PLANE + BALL_RADIUS, RIGHT_PLANE - BALL_RADIUS),
+								uniform(random, -200, GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS));
+		ball.velocity = Vector2(uniform(random, -20, 20), uniform(random, -25, 15));
+
+		// the interesting cases are rare with uniform positions, so some balls start next to the net
+		if(random.integer(0, 3) == 0)
+		{
+			ball.position.x = NET_POSITION_X + uniform(random, -80, 80);
+			ball.position.y = uniform(random, NET_SPHERE_POSITION - 100, NET_SPHERE_POSITION + 50);
+		}
+		return ball;
+	}
+
+	/// the ball as simulated by stepping a PhysicWorld frame by frame, like the bots did before BallTrajectory
+	struct FrameByFrame
+	{
+		PhysicWorld world;
+		MatchEventBuffer events;
+
+		explicit FrameByFrame(const BallState& ball)
+		{
+			world.setEventSink(&events);
+			world.setBallPosition(ball.position);
+			world.setBallVelocity(ball.velocity);
+		}
+
+		void step()
+		{
+			world.step(PlayerInput(), PlayerInput(), false, true);
+		}
+	};
+}
+
+BOOST_AUTO_TEST_SUITE( BallTrajectoryTest )
+
+// advance gives the same ball after every number of frames, and the frames in which the ball hits
+// the net, the walls or the ground are stepped by the world of the trajectory
+BOOST_AUTO_TEST_CASE( advance )
+{
+	XorShift random(5);
+	for(int ball_index = 0; ball_index < 2000; ++ball_index)
+	{
+		BallState ball = randomBall(random);
+		FrameByFrame reference(ball);
+
+		PhysicWorld world;
+		MatchEventBuffer events;
+		world.setEventSink(&events);
+		BallTrajectory trajectory(world, ball.position, ball.velocity);
+
+		int step = 0;
+		while(step < 500)
+		{
+			// advance in pieces of various length, so that they end before, on and after the contacts
+			int steps = random.integer(1, 60);
+			// a ball rolling on the ground hits it in every frame, so only the events of one piece are compared
+			events.clear();
+			reference.events.clear();
+			for(int i = 0; i < steps; ++i)
+				reference.step();
+			trajectory.advance(steps);
+			step += steps;
+
+			BOOST_REQUIRE_MESSAGE( sameVector(trajectory.getPosition(), reference.world.getBallPosition()),
+									"position of ball " << ball_index << " differs after " << step << " frames" );
+			BOOST_REQUIRE_MESSAGE( sameVector(trajectory.getVelocity(), reference.world.getBallVelocity()),
+									"velocity of ball " << ball_index << " differs after " << step << " frames" );
+			BOOST_REQUIRE_MESSAGE( sameEvents(events, reference.events),
+									"hits of ball " << ball_index << " differ after " << step << " frames" );
+		}
+	}
+}
+
+// advanceUntil stops in the same frame as the frame by frame loop of simulate_until
+BOOST_AUTO_TEST_CASE( advance_until )
+{
+	XorShift random(9);
+	int stopped = 0;
+	for(int ball_index = 0; ball_index < 5000; ++ball_index)
+	{
+		BallState ball = randomBall(random);
+		auto axis = random.integer(0, 1) ? BallTrajectory::Axis::X : BallTrajectory::Axis::Y;
+		// e.g. the height at which the ball can be played, or the position of a blob
+		float coordinate = axis == BallTrajectory::Axis::X ? uniform(random, 0, 800) : uniform(random, 0, 500);
+		float start = axis == BallTrajectory::Axis::X ? ball.position.x : 600 - ball.position.y;
+		bool below = start < coordinate;
+
+		FrameByFrame reference(ball);
+		int reference_steps = 0;
+		while(reference_steps < MAX_STEPS)
+		{
+			reference.step();
+			++reference_steps;
+			Vector2 position = reference.world.getBallPosition();
+			float value = axis == BallTrajectory::Axis::X ? position.x : 600 - position.y;
+			if( (value < coordinate) != below )
+				break;
+		}
+
+		PhysicWorld world;
+		MatchEventBuffer events;
+		world.setEventSink(&events);
+		BallTrajectory trajectory(world, ball.position, ball.velocity);
+		int steps = trajectory.advanceUntil(axis, coordinate, below, MAX_STEPS);
+
+		BOOST_REQUIRE_MESSAGE( steps == reference_steps, "ball " << ball_index << " stops after " << steps
+								<< " instead of " << reference_steps << " frames" );
+		BOOST_REQUIRE_MESSAGE( sameVector(trajectory.getPosition(), reference.world.getBallPosition()),
+								"stop position of ball " << ball_index << " differs" );
+		BOOST_REQUIRE_MESSAGE( sameVector(trajectory.getVelocity(), reference.world.getBallVelocity()),
+								"stop velocity of ball " << ball_index << " differs" );
+		BOOST_REQUIRE_MESSAGE( sameEvents(events, reference.events), "hits of ball " << ball_index << " differ" );
+
+		if(steps < MAX_STEPS)
+			++stopped;
+	}
+
+	// most balls reach the coordinate, so the stop condition has been tested
+	BOOST_CHECK_GT( stopped, 2500 );
+}
+
+// the ball lands where the frame by frame simulation lets it land
+BOOST_AUTO_TEST_CASE( landing )
+{
+	XorShift random(13);
+	for(int ball_index = 0; ball_index < 2000; ++ball_index)
+	{
+		BallState ball = randomBall(random);
+
+		FrameByFrame reference(ball);
+		int reference_steps = 0;
+		while(!hitGround(reference.events))
+		{
+			reference.step();
+			++reference_steps;
+			BOOST_REQUIRE_LT( reference_steps, MAX_STEPS );
+		}
+
+		// the ball is put onto the ground in the frame in which it hits it, and never gets lower
+		PhysicWorld world;
+		MatchEventBuffer events;
+		world.setEventSink(&events);
+		BallTrajectory trajectory(world, ball.position, ball.velocity);
+		const float ground = 600 - (GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS);
+		int steps = trajectory.advanceUntil(BallTrajectory::Axis::Y, std::nextafter(ground, 600.f), false, MAX_STEPS);
+
+		BOOST_REQUIRE_MESSAGE( steps == reference_steps, "ball " << ball_index << " lands after " << steps
+								<< " instead of " << reference_steps << " frames" );
+		BOOST_REQUIRE_MESSAGE( sameVector(trajectory.getPosition(), reference.world.getBallPosition()),
+								"landing position of ball " << ball_index << " differs" );
+		BOOST_REQUIRE_MESSAGE( sameEvents(events, reference.events), "hits of ball " << ball_index << " differ" );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+#define BOOST_TEST_MODULE DuelMatch
+#include <boost/test/unit_test.hpp>
+
+#include "TestHelpers.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// This test replaces the global operator new, so it is built as its own executable
+// and does not affect the other tests.
+namespace
+{
+	std::atomic<long> gAllocations{0};
+}
+
+void* operator new(std::size_t size)
+{
+	++gAllocations;
+	if(void* memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+BOOST_AUTO_TEST_SUITE( DuelMatchTest )
+
+// once a match is running, stepping it must not touch the heap, neither in the physics,
+// nor in the rules or the event handling.
+BOOST_AUTO_TEST_CASE( step_does_not_allocate )
+{
+	RandomMatch game(FALLBACK_RULES_NAME, PhysicBackend::FLOAT, 1000);
+
+	std::size_t step = 0;
+	int events = 0;
+	int dropped = 0;
+	auto play = [&](int steps)
+	{
+		for(int i = 0; i < steps; ++i)
+		{
+			game.play(step++);
+			events += game.match.getEvents().size();
+			dropped += game.match.getEvents().getDropped();
+		}
+	};
+
+	// let everything that is initialized lazily happen first
+	play(1000);
+
+	long before = gAllocations;
+	play(20000);
+	BOOST_CHECK_EQUAL( gAllocations - before, 0 );
+	// make sure the steps included hits, errors and new serves
+	BOOST_CHECK_GT( events, 100 );
+	BOOST_CHECK_GT( game.totalScore(), 5 );
+	BOOST_CHECK_EQUAL( dropped, 0 );
+}
+
+// events that do not fit into the buffer are counted, also across clear
+BOOST_AUTO_TEST_CASE( event_buffer_overflow )
+{
+	const int capacity = MatchEventBuffer::CAPACITY;
+	MatchEventBuffer buffer;
+	for(int i = 0; i < capacity; ++i)
+		BOOST_REQUIRE( buffer.push(MatchEvent(MatchEvent::BALL_HIT_WALL, LEFT_PLAYER)) );
+	BOOST_CHECK_EQUAL( buffer.getDropped(), 0 );
+
+	BOOST_CHECK( !buffer.push(MatchEvent(MatchEvent::BALL_HIT_NET, RIGHT_PLAYER)) );
+	BOOST_CHECK( !buffer.push(MatchEvent(MatchEvent::BALL_HIT_NET, RIGHT_PLAYER)) );
+	BOOST_CHECK_EQUAL( buffer.size(), capacity );
+	BOOST_CHECK_EQUAL( buffer.getDropped(), 2 );
+	BOOST_CHECK_EQUAL( buffer[capacity - 1].event, MatchEvent::BALL_HIT_WALL );
+
+	buffer.clear();
+	BOOST_CHECK( buffer.push(MatchEvent(MatchEvent::BALL_HIT_NET, RIGHT_PLAYER)) );
+	BOOST_CHECK_EQUAL( buffer.getDropped(), 2 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,24 +4,17 @@
 #include "FileRead.h"
 #include "FileWrite.h"
 #include "FileSystem.h"
+#include "TestHelpers.h"
+#include <algorithm>
 #include <iostream>
 #include <cstring>
+#include <vector>
 #include <physfs.h>
 
-#define TEST_EXECUTION_PATH "./test/"
-
 // helper
 static void init_Physfs()
 {
-	static bool initialised = false;
-	if(!initialised) 
-	{
-		std::cout << "initialising physfs to " << TEST_EXECUTION_PATH << "\n";
-		static FileSystem fs( TEST_EXECUTION_PATH );
-		fs.setWriteDir(".");
-		fs.addToSearchPath(".", true);
-		initialised = true;
-	}
+	testFileSystem();
 }
 
 // Tests of common FileSystem functions
@@ -29,51 +22,39 @@ static void init_Physfs()
 
 BOOST_AUTO_TEST_SUITE( FileSystemTest )
 
+// physfs can only be initialised once per program, so all tests share the file system of testFileSystem
 BOOST_AUTO_TEST_CASE( default_constructor )
 {
-	/// \todo spec what happens here; currently asserts
-	// FileSystem::getSingleton();
-	
-	/// \todo how to make this a sensible path on all platforms?
-	{
-		FileSystem fs( TEST_EXECUTION_PATH );
-	
-		BOOST_CHECK_EQUAL( &fs, &FileSystem::getSingleton());
-	
-		/// \todo currently, an assertion fails here!
-		// try to init again
-		//FileSystem fs2("C:\\Dokumente und Einstellungen\\Erik\\Eigene Dateien\\Blobby Volley 2\\test\\bin\\debug\\");
-	}
-	// here, fs is deleted so we can create a new file system
-	// try to create it with spam path
-	/// \todo spec, what error happens here
-	FileSystem fs3("__SPAM__");
+	FileSystem& fs = testFileSystem();
+	BOOST_CHECK_EQUAL( &fs, &FileSystem::getSingleton());
 }
 
 // the functions deleteFile, exists, isDirectory, addToSearchPath, removeFromSearchPath, setWriteDir and getBaseDir
 // currently just wrap PHYSFS functions, so they actually don't do anything. Thus, these functions are not
 // tested here. Once we have a defined error reporting policy etc, tests will be added.
 
-/// \todo test EnumerateFiles
 BOOST_AUTO_TEST_CASE( enumerate_files )
 {
-	/// \todo spec what happens here; currently asserts
-	// FileSystem::getSingleton();
-	
-	/// \todo how to make this a sensible path on all platforms?
-	{
-		FileSystem fs( TEST_EXECUTION_PATH );
-	
-		BOOST_CHECK_EQUAL( &fs, &FileSystem::getSingleton());
-	
-		/// \todo currently, an assertion fails here!
-		// try to init again
-		//FileSystem fs2("C:\\Dokumente und Einstellungen\\Erik\\Eigene Dateien\\Blobby Volley 2\\test\\bin\\debug\\");
-	}
-	// here, fs is deleted so we can create a new file system
-	// try to create it with spam path
-	/// \todo spec, what error happens here
-	FileSystem fs3("__SPAM__");
+	FileSystem& fs = testFileSystem();
+	fs.mkdir("enumerate_files");
+	FileWrite("enumerate_files/first.tmp").write("test");
+	FileWrite("enumerate_files/second.tmp").write("test");
+	FileWrite("enumerate_files/other.txt").write("test");
+
+	std::vector<std::string> files = fs.enumerateFiles("enumerate_files", ".tmp");
+	std::sort(files.begin(), files.end());
+	BOOST_REQUIRE_EQUAL( files.size(), 2u );
+	BOOST_CHECK_EQUAL( files[0], "first" );
+	BOOST_CHECK_EQUAL( files[1], "second" );
+
+	files = fs.enumerateFiles("enumerate_files", ".txt", true);
+	BOOST_REQUIRE_EQUAL( files.size(), 1u );
+	BOOST_CHECK_EQUAL( files[0], "other.txt" );
+
+	fs.deleteFile("enumerate_files/first.tmp");
+	fs.deleteFile("enumerate_files/second.tmp");
+	fs.deleteFile("enumerate_files/other.txt");
+	fs.deleteFile("enumerate_files");
 }
 /// \todo test probeDir
 
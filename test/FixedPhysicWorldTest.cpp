@@ -0,0 +1,151 @@
+#include <boost/test/unit_test.hpp>
+
+#include "FixedPhysicWorld.h"
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "PhysicState.h"
+#include "GameLogic.h"
+#include "GenericIO.h"
+#include "TestHelpers.h"
+#include "raknet/BitStream.h"
+
+#include <cstdint>
+#include <vector>
+
+// The fixed point physics only uses integer operations, so unlike the float physics, its results
+// have to be the same for every architecture and compiler.
+
+namespace
+{
+	const int CHECKPOINT_DISTANCE = 2500;
+	const int CHECKPOINT_COUNT = 8;
+
+	// state hashes of randomMatch at the checkpoints. These are the same on all platforms.
+	const std::uint64_t GOLDEN_RANDOM_MATCH[CHECKPOINT_COUNT] = {
+		0x80c7a6223f3fcb43ull, 0x5d40e30bfe717f06ull, 0xef675945a04247daull, 0xf56c8a670b835281ull,
+		0x35e9af35e077151eull, 0x2acfa0d34dbc7f99ull, 0xec59efd515abce89ull, 0x564ff851291b88bcull
+	};
+
+	std::uint64_t hashState(const FixedPhysicState& state)
+	{
+		RakNet::BitStream stream;
+		createGenericWriter(&stream)->generic<FixedPhysicState>(state);
+
+		StateHash hash;
+		hash.add(stream.GetData(), stream.GetNumberOfBytesUsed());
+		return hash.value;
+	}
+
+	/// plays with random inputs, and with the ball reset to a random serve whenever it stops
+	void randomMatch(FixedPhysicWorld& world, XorShift& random, int steps)
+	{
+		for(int step = 0; step < steps; ++step)
+		{
+			PlayerInput left = random.input();
+			PlayerInput right = random.input();
+			world.step(left, right, true, true);
+
+			FixedPhysicState state = world.getFixedState();
+			if(state.ballPosition.y > Fixed::fromInt(430) && abs(state.ballVelocity.y) < Fixed::fromRatio(3, 2))
+			{
+				state.ballPosition = FixedVector2(Fixed::fromInt(random.next() % 2 ? 200 : 600), Fixed::fromRatio(601, 2));
+				state.ballVelocity = FixedVector2();
+				world.setFixedState(state);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( FixedPhysicWorldTest )
+
+BOOST_AUTO_TEST_CASE( fixed_point_arithmetic )
+{
+	BOOST_CHECK_EQUAL( Fixed::fromRatio(1, 3).raw(), 5461 );
+	BOOST_CHECK_EQUAL( Fixed::fromRatio(-1, 3).raw(), -5461 );
+	BOOST_CHECK_EQUAL( Fixed::fromRatio(1, 2 * Fixed::ONE).raw(), 1 );
+	BOOST_CHECK_EQUAL( Fixed::fromFloat(0.1f).raw(), 1638 );
+	BOOST_CHECK_EQUAL( Fixed::fromFloat(-0.1f).raw(), -1638 );
+	BOOST_CHECK_EQUAL( sqrt(Fixed::fromInt(2)).raw(), 23170 );
+	BOOST_CHECK( sqrt(Fixed::fromInt(9)) == Fixed::fromInt(3) );
+	BOOST_CHECK_EQUAL( (FixedVector2(Fixed::fromInt(3), Fixed::fromInt(4)).length()).toFloat(), 5.f );
+
+	// truncation towards zero keeps mirrored computations mirrored
+	Fixed a = Fixed::fromRatio(7, 3);
+	Fixed b = Fixed::fromRatio(5, 11);
+	BOOST_CHECK( (-a) * b == -(a * b) );
+	BOOST_CHECK( (-a) / b == -(a / b) );
+}
+
+BOOST_AUTO_TEST_CASE( float_view_is_exact )
+{
+	FixedPhysicWorld world;
+	XorShift random(7);
+	for(int i = 0; i < 200; ++i)
+	{
+		randomMatch(world, random, 100);
+
+		FixedPhysicWorld copy;
+		copy.setState( world.getState() );
+		BOOST_REQUIRE_EQUAL( hashState(copy.getFixedState()), hashState(world.getFixedState()) );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( state_serialisation )
+{
+	FixedPhysicWorld world;
+	XorShift random(3);
+	randomMatch(world, random, 1000);
+
+	RakNet::BitStream stream;
+	createGenericWriter(&stream)->generic<FixedPhysicState>(world.getFixedState());
+	// 16 numbers with 4 bytes each
+	BOOST_CHECK_EQUAL( stream.GetNumberOfBytesUsed(), 64 );
+
+	FixedPhysicState read;
+	createGenericReader(&stream)->generic<FixedPhysicState>(read);
+	BOOST_CHECK_EQUAL( hashState(read), hashState(world.getFixedState()) );
+}
+
+BOOST_AUTO_TEST_CASE( golden_random_match )
+{
+	FixedPhysicWorld world;
+	XorShift random(1);
+	std::vector<std::uint64_t> checkpoints;
+	for(int checkpoint = 0; checkpoint < CHECKPOINT_COUNT; ++checkpoint)
+	{
+		randomMatch(world, random, CHECKPOINT_DISTANCE);
+		checkpoints.push_back( hashState(world.getFixedState()) );
+	}
+	checkCheckpoints( checkpoints, GOLDEN_RANDOM_MATCH, CHECKPOINT_DISTANCE );
+}
+
+// the rules change the ball velocity through the float interface of the match. These changes have to
+// end up in the fixed point world, so all values the match reports are fixed point numbers.
+BOOST_AUTO_TEST_CASE( duel_match_with_fixed_physics )
+{
+	RandomMatch game(FALLBACK_RULES_NAME, PhysicBackend::FIXED_POINT, 1000);
+	DuelMatch& match = game.match;
+	BOOST_CHECK( match.getPhysicBackend() == PhysicBackend::FIXED_POINT );
+
+	match.setServingPlayer(RIGHT_PLAYER);
+	BOOST_CHECK_EQUAL( match.getBallPosition().x, 600.f );
+	BOOST_CHECK_EQUAL( match.getBallVelocity().y, 0.f );
+
+	int off_grid = 0;
+	for(int step = 0; step < 20000; ++step)
+	{
+		game.play(step);
+
+		PhysicState state = match.getState().worldState;
+		PhysicState rounded = FixedPhysicState::fromPhysicState(state).toPhysicState();
+		if(rounded.ballVelocity.x != state.ballVelocity.x || rounded.ballVelocity.y != state.ballVelocity.y ||
+			rounded.ballPosition.x != state.ballPosition.x || rounded.ballPosition.y != state.ballPosition.y)
+			++off_grid;
+	}
+
+	BOOST_CHECK_EQUAL( off_grid, 0 );
+	// make sure there were errors and new serves
+	BOOST_CHECK_GT( match.getScore(LEFT_PLAYER) + match.getScore(RIGHT_PLAYER), 5 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
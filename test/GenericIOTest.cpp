@@ -17,17 +17,10 @@
 #include <list>
 #include <deque>
 
-#define TEST_EXECUTION_PATH "./test"
+#include "TestHelpers.h"
 
 //#define DISABLE_COMPILATION_TEST
 
-struct FSFixture {
-	FSFixture() : mFS(TEST_EXECUTION_PATH) {
-		mFS.setWriteDir(".");
-	}
-	FileSystem mFS;
-};
-
 // helper
 
 void generic_io_types_test_f(std::shared_ptr<GenericIn> in, std::shared_ptr<GenericOut> out);
@@ -42,7 +35,7 @@ void generic_io_types_test_special_f(std::shared_ptr<GenericIn> in, std::shared_
 
 BOOST_AUTO_TEST_SUITE(GenericIOTest)
 
-BOOST_FIXTURE_TEST_CASE( generic_io_create, FSFixture )
+BOOST_FIXTURE_TEST_CASE( generic_io_create, DataFixture )
 {
 	std::shared_ptr<FileWrite> write = std::make_shared<FileWrite>("test.tmp");
 	std::shared_ptr<FileRead> read = std::make_shared<FileRead>("test.tmp");
@@ -55,7 +48,7 @@ BOOST_FIXTURE_TEST_CASE( generic_io_create, FSFixture )
 	createGenericWriter( &stream );
 }
 
-BOOST_FIXTURE_TEST_CASE( generic_io_types_test_file, FSFixture )
+BOOST_FIXTURE_TEST_CASE( generic_io_types_test_file, DataFixture )
 {
 
 	std::shared_ptr<FileWrite> write = std::make_shared<FileWrite>("test.tmp");
@@ -75,7 +68,7 @@ BOOST_AUTO_TEST_CASE( generic_io_types_test_stream )
 	generic_io_types_test_f( ins, outs );
 };
 
-BOOST_FIXTURE_TEST_CASE( generic_io_generic_types_file, FSFixture )
+BOOST_FIXTURE_TEST_CASE( generic_io_generic_types_file, DataFixture )
 {
 	std::shared_ptr<FileWrite> write = std::make_shared<FileWrite>("test.tmp");
 	std::shared_ptr<FileRead> read = std::make_shared<FileRead>("test.tmp");
@@ -95,7 +88,7 @@ BOOST_AUTO_TEST_CASE( generic_io_generic_types_stream )
 	generic_io_types_test_generics_f( ins, outs);
 };
 
-BOOST_FIXTURE_TEST_CASE( generic_io_seek_tell, FSFixture )
+BOOST_FIXTURE_TEST_CASE( generic_io_seek_tell, DataFixture )
 {
 	std::shared_ptr<FileWrite> write = std::make_shared<FileWrite>("test.tmp");
 	std::shared_ptr<FileRead> read = std::make_shared<FileRead>("test.tmp");
@@ -111,7 +104,7 @@ BOOST_FIXTURE_TEST_CASE( generic_io_seek_tell, FSFixture )
 	generic_io_seek_tell_f( ins, outs);
 };
 
-BOOST_FIXTURE_TEST_CASE( generic_io_generic_types_vector, FSFixture )
+BOOST_FIXTURE_TEST_CASE( generic_io_generic_types_vector, DataFixture )
 {
 	std::shared_ptr<FileWrite> write = std::make_shared<FileWrite>("test.tmp");
 	std::shared_ptr<FileRead> read = std::make_shared<FileRead>("test.tmp");
@@ -132,7 +125,7 @@ BOOST_FIXTURE_TEST_CASE( generic_io_generic_types_vector, FSFixture )
 };
 
 
-BOOST_FIXTURE_TEST_CASE( generic_io_special_types, FSFixture )
+BOOST_FIXTURE_TEST_CASE( generic_io_special_types, DataFixture )
 {
 	std::shared_ptr<FileWrite> write = std::make_shared<FileWrite>("test.tmp");
 	std::shared_ptr<FileRead> read = std::make_shared<FileRead>("test.tmp");
@@ -0,0 +1,102 @@
+#include <boost/test/unit_test.hpp>
+
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "MatchSnapshot.h"
+#include "GameLogic.h"
+#include "TestHelpers.h"
+
+#include <vector>
+
+namespace
+{
+	/// plays a match and restores a snapshot every \p distance steps. After each restore, the match
+	/// has to continue exactly as it did the first time.
+	void checkRestore(const std::string& rules, PhysicBackend backend, int steps, int distance)
+	{
+		RandomMatch game(rules, backend);
+
+		std::vector<DuelMatchState> states;
+		MatchSnapshot snapshot;
+		int points = 0;
+		for(int step = 0; step < steps; ++step)
+		{
+			if(step % distance == 0)
+			{
+				game.match.saveSnapshot(snapshot);
+				// play ahead, go back, and play the same steps again
+				states.clear();
+				for(int ahead = 0; ahead < distance; ++ahead)
+				{
+					game.play(step + ahead);
+					states.push_back( game.match.getState() );
+				}
+				game.match.restoreSnapshot(snapshot);
+			}
+
+			game.play(step);
+			checkSameState( game.match.getState(), states[step % distance] );
+			points = game.totalScore();
+		}
+
+		// make sure the rules actually had something to do
+		BOOST_CHECK_GT( points, 3 );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( MatchSnapshotTest )
+
+BOOST_AUTO_TEST_CASE( restore_fallback_rules )
+{
+	checkRestore(FALLBACK_RULES_NAME, PhysicBackend::FLOAT, 20000, 250);
+}
+
+BOOST_AUTO_TEST_CASE( restore_fixed_point_physics )
+{
+	checkRestore(FALLBACK_RULES_NAME, PhysicBackend::FIXED_POINT, 20000, 250);
+}
+
+// tennis.lua counts the ground hits in global variables, which are not part of the DuelMatchState
+BOOST_FIXTURE_TEST_CASE( restore_script_variables, DataFixture )
+{
+	checkRestore("tennis.lua", PhysicBackend::FLOAT, 20000, 250);
+}
+
+BOOST_FIXTURE_TEST_CASE( restore_into_other_match, DataFixture )
+{
+	RandomMatch original("classic.lua", PhysicBackend::FLOAT);
+	RandomMatch copy("classic.lua", PhysicBackend::FLOAT);
+
+	for(int step = 0; step < 5000; ++step)
+		original.play(step);
+
+	MatchSnapshot snapshot;
+	original.match.saveSnapshot(snapshot);
+	copy.match.restoreSnapshot(snapshot);
+
+	for(int step = 5000; step < 15000; ++step)
+	{
+		original.play(step);
+		copy.play(step);
+		checkSameState( original.match.getState(), copy.match.getState() );
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE( reset_restarts_match, DataFixture )
+{
+	RandomMatch fresh("tennis.lua", PhysicBackend::FLOAT);
+	RandomMatch reset("tennis.lua", PhysicBackend::FLOAT);
+
+	for(int step = 0; step < 5000; ++step)
+		reset.play(step + 12345);
+	reset.match.reset();
+
+	for(int step = 0; step < 10000; ++step)
+	{
+		fresh.play(step);
+		reset.play(step);
+		checkSameState( fresh.match.getState(), reset.match.getState() );
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
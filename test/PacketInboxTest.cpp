@@ -0,0 +1,73 @@
+#include <boost/test/unit_test.hpp>
+
+#include "server/PacketInbox.h"
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+	packet_ptr makePacket(int index)
+	{
+		auto packet = std::make_shared<Packet>();
+		packet->playerIndex = index;
+		return packet;
+	}
+
+	std::vector<int> drainIndices(PacketInbox& inbox)
+	{
+		std::vector<int> indices;
+		inbox.drain([&](const packet_ptr& packet) { indices.push_back(packet->playerIndex); });
+		return indices;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( PacketInboxTest )
+
+BOOST_AUTO_TEST_CASE( keeps_reliable_packets_when_full )
+{
+	PacketInbox inbox(16);
+	for(int i = 0; i < 100; ++i)
+		BOOST_CHECK( inbox.push(makePacket(i), true) );
+
+	std::vector<int> indices = drainIndices(inbox);
+	BOOST_REQUIRE_EQUAL( indices.size(), 100u );
+	for(int i = 0; i < 100; ++i)
+		BOOST_CHECK_EQUAL( indices[i], i );
+
+	// the overflow list is empty again, so the queue is used as before
+	BOOST_CHECK( inbox.push(makePacket(100), false) );
+	BOOST_CHECK_EQUAL( drainIndices(inbox).size(), 1u );
+}
+
+BOOST_AUTO_TEST_CASE( drops_unreliable_packets_when_full )
+{
+	PacketInbox inbox(16);
+	for(int i = 0; i < 16; ++i)
+		BOOST_CHECK( inbox.push(makePacket(i), false) );
+	BOOST_CHECK( !inbox.push(makePacket(16), false) );
+	// reliable packets are still accepted, and unreliable ones must not overtake them
+	BOOST_CHECK( inbox.push(makePacket(17), true) );
+	BOOST_CHECK( !inbox.push(makePacket(18), false) );
+
+	std::vector<int> indices = drainIndices(inbox);
+	BOOST_REQUIRE_EQUAL( indices.size(), 17u );
+	BOOST_CHECK_EQUAL( indices.back(), 17 );
+}
+
+BOOST_AUTO_TEST_CASE( try_pop_includes_overflow )
+{
+	PacketInbox inbox(4);
+	for(int i = 0; i < 10; ++i)
+		inbox.push(makePacket(i), true);
+
+	packet_ptr packet;
+	for(int i = 0; i < 10; ++i)
+	{
+		BOOST_REQUIRE( inbox.tryPop(packet) );
+		BOOST_CHECK_EQUAL( packet->playerIndex, i );
+	}
+	BOOST_CHECK( !inbox.tryPop(packet) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
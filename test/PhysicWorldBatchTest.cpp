@@ -0,0 +1,298 @@
+#include <boost/test/unit_test.hpp>
+
+#include "DuelMatch.h"
+#include "PhysicWorld.h"
+#include "PhysicWorldBatch.h"
+#include "GameConstants.h"
+#include "TestHelpers.h"
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// compares bit by bit, so that e.g. 0.f and -0.f are different
+	bool sameState(const PhysicState& a, const PhysicState& b)
+	{
+		return std::memcmp(&a, &b, sizeof(PhysicState)) == 0;
+	}
+
+	bool sameEvent(const MatchEvent& a, const MatchEvent& b)
+	{
+		return a.event == b.event && a.side == b.side &&
+				std::memcmp(&a.intensity, &b.intensity, sizeof(float)) == 0;
+	}
+
+	struct WorldFixture
+	{
+		std::vector<std::unique_ptr<PhysicWorld>> worlds;
+		std::vector<MatchEventBuffer> events;
+		std::vector<PlayerInput> inputs[MAX_PLAYERS];
+		std::vector<bool> valid;
+		std::vector<bool> running;
+		PhysicWorldBatch batch;
+		std::mt19937 random;
+
+		explicit WorldFixture(int size) : events(size), valid(size, true), running(size, true), batch(size)
+		{
+			for(int i = 0; i < size; ++i)
+			{
+				worlds.emplace_back(new PhysicWorld());
+				worlds.back()->setEventSink( &events[i] );
+			}
+			inputs[LEFT_PLAYER].resize(size);
+			inputs[RIGHT_PLAYER].resize(size);
+		}
+
+		float uniform(float low, float high)
+		{
+			return std::uniform_real_distribution<float>(low, high)(random);
+		}
+
+		void randomizeInputs(float changeProbability)
+		{
+			for(int i = 0; i < batch.size(); ++i)
+			{
+				for(auto& input : inputs)
+				{
+					if(uniform(0, 1) < changeProbability)
+						input[i] = PlayerInput(random() & 4, random() & 2, random() & 1);
+				}
+			}
+		}
+
+		// steps the batch and all single worlds and checks that the results are the same
+		void stepAndCompare(int step)
+		{
+			for(int i = 0; i < batch.size(); ++i)
+			{
+				events[i].clear();
+				worlds[i]->step(inputs[LEFT_PLAYER][i], inputs[RIGHT_PLAYER][i], valid[i], running[i]);
+				batch.setInput(i, inputs[LEFT_PLAYER][i], inputs[RIGHT_PLAYER][i], valid[i], running[i]);
+			}
+			batch.step();
+
+			std::vector<std::vector<MatchEvent>> batch_events(batch.size());
+			for(const auto& event : batch.getEvents())
+				batch_events.at(event.world).push_back(event.event);
+
+			for(int i = 0; i < batch.size(); ++i)
+			{
+				BOOST_REQUIRE_MESSAGE( sameState(worlds[i]->getState(), batch.getState(i)),
+										"world " << i << " differs after step " << step );
+				BOOST_REQUIRE_EQUAL( events[i].size(), (int)batch_events[i].size() );
+				for(int e = 0; e < events[i].size(); ++e)
+				{
+					BOOST_REQUIRE_MESSAGE( sameEvent(events[i][e], batch_events[i][e]),
+											"event " << e << " of world " << i << " differs after step " << step );
+				}
+			}
+		}
+	};
+}
+
+BOOST_AUTO_TEST_SUITE( PhysicWorldBatchTest )
+
+BOOST_AUTO_TEST_CASE( initial_state )
+{
+	PhysicWorld world;
+	PhysicWorldBatch batch(3);
+	for(int i = 0; i < batch.size(); ++i)
+		BOOST_CHECK( sameState(world.getState(), batch.getState(i)) );
+}
+
+BOOST_AUTO_TEST_CASE( load_store )
+{
+	PhysicWorld world;
+	world.step(PlayerInput(false, true, true), PlayerInput(true, false, false), true, true);
+
+	PhysicWorldBatch batch(2);
+	batch.load(1, world);
+	BOOST_CHECK( sameState(world.getState(), batch.getState(1)) );
+
+	PhysicWorld copy;
+	batch.store(1, copy);
+	BOOST_CHECK( sameState(world.getState(), copy.getState()) );
+
+	// the animation speed is copied as well, so the blob animation continues identically
+	world.step(PlayerInput(), PlayerInput(), true, true);
+	copy.step(PlayerInput(), PlayerInput(), true, true);
+	BOOST_CHECK( sameState(world.getState(), copy.getState()) );
+}
+
+// only the first worlds are stepped
+BOOST_AUTO_TEST_CASE( partial_step )
+{
+	WorldFixture fixture(3);
+	PhysicState idle = fixture.batch.getState(2);
+	// the ball falls onto the ground of the world that is not stepped
+	idle.ballPosition = Vector2(200, GROUND_PLANE_HEIGHT_MAX - BALL_RADIUS);
+	idle.ballVelocity = Vector2(0, 10);
+	fixture.batch.setState(2, idle);
+	fixture.batch.setInput(2, PlayerInput(false, true, true), PlayerInput(), true, true);
+
+	for(int step = 0; step < 100; ++step)
+	{
+		fixture.batch.step(2);
+		BOOST_REQUIRE( sameState(fixture.batch.getState(2), idle) );
+		for(const auto& event : fixture.batch.getEvents())
+			BOOST_REQUIRE_LT( event.world, 2 );
+	}
+}
+
+// plays many matches with random inputs, starting from the serve
+BOOST_AUTO_TEST_CASE( random_matches )
+{
+	const int WORLDS = 37;	// not a multiple of the vector width
+	WorldFixture fixture(WORLDS);
+
+	for(int step = 0; step < 20000; ++step)
+	{
+		fixture.randomizeInputs(0.1f);
+		for(int i = 0; i < WORLDS; ++i)
+		{
+			// restart the ball from time to time, so it is not just lying on the ground
+			if(step % 1000 == 500 + i)
+			{
+				PhysicState state = fixture.worlds[i]->getState();
+				state.ballPosition = Vector2(i % 2 ? 200 : 600, STANDARD_BALL_HEIGHT);
+				state.ballVelocity = Vector2(0, 0);
+				fixture.worlds[i]->setState(state);
+				fixture.batch.setState(i, state);
+			}
+		}
+		fixture.stepAndCompare(step);
+	}
+}
+
+// starts from random states, which results in collisions that rarely happen in real matches
+BOOST_AUTO_TEST_CASE( random_states )
+{
+	const int WORLDS = 64;
+	WorldFixture fixture(WORLDS);
+
+	for(int round = 0; round < 200; ++round)
+	{
+		for(int i = 0; i < WORLDS; ++i)
+		{
+			PhysicState state;
+			state.blobPosition[LEFT_PLAYER] = Vector2(fixture.uniform(-50, 450), fixture.uniform(200, GROUND_PLANE_HEIGHT + 10));
+			state.blobPosition[RIGHT_PLAYER] = Vector2(fixture.uniform(350, 850), fixture.uniform(200, GROUND_PLANE_HEIGHT + 10));
+			state.blobVelocity[LEFT_PLAYER] = Vector2(0, fixture.uniform(-15, 15));
+			state.blobVelocity[RIGHT_PLAYER] = Vector2(0, fixture.uniform(-15, 15));
+			state.blobState[LEFT_PLAYER] = fixture.uniform(-1, 5);
+			state.blobState[RIGHT_PLAYER] = fixture.uniform(-1, 5);
+			state.ballPosition = Vector2(fixture.uniform(-20, 820), fixture.uniform(0, 520));
+			state.ballVelocity = Vector2(fixture.uniform(-20, 20), fixture.uniform(-20, 20));
+			state.ballRotation = fixture.uniform(0, 6.25f);
+			state.ballAngularVelocity = fixture.uniform(-0.2f, 0.2f);
+
+			fixture.worlds[i]->setState(state);
+			fixture.batch.setState(i, state);
+			fixture.valid[i] = fixture.uniform(0, 1) < 0.8f;
+			fixture.running[i] = fixture.uniform(0, 1) < 0.8f;
+		}
+
+		for(int step = 0; step < 100; ++step)
+		{
+			fixture.randomizeInputs(0.2f);
+			fixture.stepAndCompare(step);
+		}
+	}
+}
+
+// DuelMatch::stepBatch gives the same matches as stepping each match on its own
+BOOST_FIXTURE_TEST_CASE( duel_matches, DataFixture )
+{
+	const int MATCHES = 7;
+	const int PAUSED = 5;
+	const int FIXED = 6;
+
+	std::vector<std::unique_ptr<RandomMatch>> single;
+	std::vector<std::unique_ptr<RandomMatch>> batched;
+	std::vector<DuelMatch*> matches;
+	for(int i = 0; i < MATCHES; ++i)
+	{
+		PhysicBackend backend = i == FIXED ? PhysicBackend::FIXED_POINT : PhysicBackend::FLOAT;
+		single.emplace_back(new RandomMatch(FALLBACK_RULES_NAME, backend));
+		batched.emplace_back(new RandomMatch(FALLBACK_RULES_NAME, backend));
+		matches.push_back(&batched.back()->match);
+	}
+
+	// the fixed point match does not need a world of the batch
+	PhysicWorldBatch batch(MATCHES - 1);
+	for(int step = 0; step < 10000; ++step)
+	{
+		if(step == 3000)
+		{
+			single[PAUSED]->match.pause();
+			batched[PAUSED]->match.pause();
+		}
+		if(step == 3500)
+		{
+			single[PAUSED]->match.unpause();
+			batched[PAUSED]->match.unpause();
+		}
+
+		// each match uses another part of the input sequence
+		for(int i = 0; i < MATCHES; ++i)
+		{
+			single[i]->play(step + i * 500);
+			batched[i]->setInput(step + i * 500);
+		}
+		DuelMatch::stepBatch(matches, batch);
+
+		for(int i = 0; i < MATCHES; ++i)
+		{
+			const DuelMatch& expected = single[i]->match;
+			const DuelMatch& actual = batched[i]->match;
+			BOOST_REQUIRE_MESSAGE( sameState(actual.getWorld().getState(), expected.getWorld().getState()),
+									"match " << i << " differs after step " << step );
+			checkSameState( actual.getState(), expected.getState() );
+			BOOST_REQUIRE_EQUAL( actual.getEvents().size(), expected.getEvents().size() );
+			for(int e = 0; e < expected.getEvents().size(); ++e)
+			{
+				BOOST_REQUIRE_MESSAGE( sameEvent(actual.getEvents()[e], expected.getEvents()[e]),
+										"event " << e << " of match " << i << " differs after step " << step );
+			}
+		}
+	}
+
+	// the matches have been played, not just served
+	for(int i = 0; i < MATCHES; ++i)
+		BOOST_CHECK_GT( batched[i]->totalScore(), 0 );
+}
+
+// fixed point and paused matches are stepped without the batch
+BOOST_FIXTURE_TEST_CASE( scalar_matches, DataFixture )
+{
+	RandomMatch fixed(FALLBACK_RULES_NAME, PhysicBackend::FIXED_POINT);
+	RandomMatch fixed_single(FALLBACK_RULES_NAME, PhysicBackend::FIXED_POINT);
+	RandomMatch paused;
+	paused.match.pause();
+	const DuelMatchState paused_state = paused.match.getState();
+
+	// a world the matches would overwrite if they were loaded into the batch
+	PhysicWorldBatch batch(1);
+	PhysicState marker = batch.getState(0);
+	marker.ballPosition = Vector2(123, 45);
+	batch.setState(0, marker);
+
+	for(int step = 0; step < 1000; ++step)
+	{
+		fixed.setInput(step);
+		paused.setInput(step);
+		DuelMatch::stepBatch({&fixed.match, &paused.match}, batch);
+		fixed_single.play(step);
+
+		checkSameState( fixed.match.getState(), fixed_single.match.getState() );
+		BOOST_REQUIRE_EQUAL( fixed.match.getEvents().size(), fixed_single.match.getEvents().size() );
+	}
+
+	BOOST_CHECK( sameState(batch.getState(0), marker) );
+	checkSameState( paused.match.getState(), paused_state );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+#include <boost/test/unit_test.hpp>
+
+#include "PhysicWorld.h"
+#include "TestHelpers.h"
+
+#include <cstdint>
+#include <vector>
+
+// The physics has to produce the same results on every architecture and compiler. These tests simulate
+// some fixed scenarios and compare hashes of the world state with the values recorded on x86-64.
+// If one of these tests fails, replays and network games will not work between this build and others.
+
+namespace
+{
+	const int CHECKPOINT_DISTANCE = 1000;
+	const int CHECKPOINT_COUNT = 20;
+
+	// state hashes at the checkpoints, recorded on x86-64
+	const std::uint64_t GOLDEN_RANDOM_MATCH_1[CHECKPOINT_COUNT] = {
+		0x7c8a51c8080df434ull, 0x1029de15c86a9a1eull, 0x5a1c2f94a9a4f927ull, 0x3a4fbd14e64abd9bull,
+		0xbee153b12bfb2d77ull, 0x3d83043985b48909ull, 0xc21fb6b5d012b055ull, 0x1159706e719f1fa3ull,
+		0x9d068e6cfa80a85eull, 0xa264c0e3ca2c7dacull, 0x35241b2132bf80f8ull, 0x3905e18658bcb7c7ull,
+		0x8fce81e0ae6f3c0bull, 0x730088497dcd77d4ull, 0xa3fc47205b133a1aull, 0xd6deebfb141c9825ull,
+		0x42b185fc7f42b671ull, 0xb9fdd1407da435e8ull, 0x70d3faf898e6b05full, 0x0e95099a725b578dull
+	};
+
+	const std::uint64_t GOLDEN_RANDOM_MATCH_2[CHECKPOINT_COUNT] = {
+		0xc2c50ffba64f3ffeull, 0x0fdfb024aeb58eddull, 0x408e91bb407e6815ull, 0x3906c73aea3ab00bull,
+		0x4fe95012d9ecbf18ull, 0x96db7619a90cff96ull, 0x5b8c58eb7647de97ull, 0x5d7742c88daa9090ull,
+		0x2bdde97e32f0c871ull, 0xbc52cd4f50c354c9ull, 0xa659e12c05d11d6bull, 0x24560076f7fb4640ull,
+		0x6cb358766d933dcbull, 0x1fb87d1f12bb7da3ull, 0x5f9b915d7a900666ull, 0x11b35b62b33eb774ull,
+		0x4c2d3d3e1b220ec5ull, 0x01815fc14cb2bab0ull, 0xd8daf82d66f702a6ull, 0x821ba3b882f26710ull
+	};
+
+	const std::uint64_t GOLDEN_NET_BOUNCES[CHECKPOINT_COUNT] = {
+		0x31bab81d9f222a20ull, 0xa7e03bab1cedc2efull, 0x8000532d22fc1f75ull, 0xeaf5aea27d4bffe2ull,
+		0x29d49db3797b3000ull, 0xc105b3fa13ff6a53ull, 0xfae54777a2691b37ull, 0x92c1a1f6bdc5e817ull,
+		0x0f8fec13401fd1aaull, 0xc451bcde58ff04d2ull, 0xe05e79b41fe01f7cull, 0xe7ae1c3ed241bab2ull,
+		0xc8bb4352be855d82ull, 0x2c0a24a1d918d337ull, 0xf107ae613ebc8782ull, 0xe7ccd816a44b3464ull,
+		0x914c74f97780729aull, 0xe39d1d2da98940daull, 0xf5d62f18e018c226ull, 0x4bfe015f4f0cdf94ull
+	};
+
+	/// a match between random players. The ball is thrown in from random positions from time to time,
+	/// so that it does not come to rest and hits the blobs, the net and the walls.
+	std::vector<std::uint64_t> randomMatch(std::uint32_t seed)
+	{
+		PhysicWorld world;
+		StateHash hash;
+		MatchEventBuffer events;
+		world.setEventSink( &events );
+
+		XorShift random(seed);
+		PlayerInput input[MAX_PLAYERS];
+		std::vector<std::uint64_t> checkpoints;
+		for(int step = 1; step <= CHECKPOINT_DISTANCE * CHECKPOINT_COUNT; ++step)
+		{
+			for(auto& in : input)
+			{
+				if(random.next() % 8 == 0)
+				{
+					std::uint32_t keys = random.next();
+					in = PlayerInput(keys & 4, keys & 2, keys & 1);
+				}
+			}
+
+			if(step % 400 == 0)
+			{
+				// separate statements, the evaluation order of function arguments is unspecified
+				float x = random.integer(50, 750);
+				float y = random.integer(100, 400);
+				float vx = random.integer(-24, 24) / 4.f;
+				float vy = random.integer(-40, 8) / 4.f;
+				world.setBallPosition( Vector2(x, y) );
+				world.setBallVelocity( Vector2(vx, vy) );
+			}
+
+			bool valid = step % 1500 < 1400;
+			bool running = step % 3000 > 50;
+			world.step(input[LEFT_PLAYER], input[RIGHT_PLAYER], valid, running);
+			hash.add(events);
+			hash.add(world.getState());
+
+			if(step % CHECKPOINT_DISTANCE == 0)
+				checkpoints.push_back(hash.value);
+		}
+		return checkpoints;
+	}
+
+	/// the ball alone, thrown from random positions near the net, so it often hits the net top
+	std::vector<std::uint64_t> netBounces(std::uint32_t seed)
+	{
+		PhysicWorld world;
+		StateHash hash;
+		MatchEventBuffer events;
+		world.setEventSink( &events );
+
+		XorShift random(seed);
+		std::vector<std::uint64_t> checkpoints;
+		for(int step = 1; step <= CHECKPOINT_DISTANCE * CHECKPOINT_COUNT; ++step)
+		{
+			if(step % 100 == 1)
+			{
+				float x = random.integer(300, 500);
+				float y = random.integer(50, 200);
+				float vx = random.integer(-60, 60) / 16.f;
+				float vy = random.integer(-32, 32) / 16.f;
+				world.setBallPosition( Vector2(x, y) );
+				world.setBallVelocity( Vector2(vx, vy) );
+			}
+
+			world.step(PlayerInput(), PlayerInput(), false, true);
+			hash.add(events);
+			hash.add(world.getState());
+
+			if(step % CHECKPOINT_DISTANCE == 0)
+				checkpoints.push_back(hash.value);
+		}
+		return checkpoints;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( PhysicWorldGoldenTest )
+
+BOOST_AUTO_TEST_CASE( random_match )
+{
+	checkCheckpoints( randomMatch(1), GOLDEN_RANDOM_MATCH_1, CHECKPOINT_DISTANCE );
+	checkCheckpoints( randomMatch(2), GOLDEN_RANDOM_MATCH_2, CHECKPOINT_DISTANCE );
+}
+
+BOOST_AUTO_TEST_CASE( net_bounces )
+{
+	checkCheckpoints( netBounces(3), GOLDEN_NET_BOUNCES, CHECKPOINT_DISTANCE );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
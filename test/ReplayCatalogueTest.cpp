@@ -0,0 +1,146 @@
+#include <boost/test/unit_test.hpp>
+
+#include "FileSystem.h"
+#include "FileWrite.h"
+#include "replays/ReplayCatalogue.h"
+#include "TestHelpers.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const char* CATALOGUE_FILE = "replays/catalogue.dat";
+	const char* CATALOGUE_TEMP_FILE = "replays/catalogue.dat.tmp";
+
+	/// an empty replay directory in the write dir
+	struct ReplayDirFixture : public DataFixture
+	{
+		ReplayDirFixture()
+		{
+			testFileSystem().mkdir("replays");
+			clear();
+		}
+
+		~ReplayDirFixture()
+		{
+			clear();
+		}
+
+		void clear()
+		{
+			for(const auto& file : testFileSystem().enumerateFiles("replays", "", true))
+				testFileSystem().deleteFile("replays/" + file);
+		}
+	};
+
+	std::vector<ReplayInfo> update(ReplayCatalogue& catalogue)
+	{
+		catalogue.update();
+		while(catalogue.isUpdating())
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return catalogue.getEntries();
+	}
+
+	/// updates a new catalogue, which starts from the stored one
+	std::vector<ReplayInfo> update()
+	{
+		ReplayCatalogue catalogue;
+		return update(catalogue);
+	}
+
+	void checkEntry(const ReplayInfo& info, const std::string& name, const std::vector<DuelMatchState>& states)
+	{
+		BOOST_CHECK_EQUAL( info.name, name );
+		BOOST_REQUIRE( info.valid );
+		BOOST_CHECK_EQUAL( info.playerNames[LEFT_PLAYER], "left player" );
+		BOOST_CHECK_EQUAL( info.playerNames[RIGHT_PLAYER], "right player" );
+		BOOST_CHECK_EQUAL( info.finalScore[LEFT_PLAYER], states.back().logicState.leftScore );
+		BOOST_CHECK_EQUAL( info.finalScore[RIGHT_PLAYER], states.back().logicState.rightScore );
+		BOOST_CHECK_EQUAL( info.speed, 75u );
+		BOOST_CHECK_EQUAL( info.duration, (states.size() + 75) / 75 );
+	}
+
+	void checkSameEntries(const std::vector<ReplayInfo>& a, const std::vector<ReplayInfo>& b)
+	{
+		BOOST_REQUIRE_EQUAL( a.size(), b.size() );
+		for(std::size_t i = 0; i < a.size(); ++i)
+		{
+			BOOST_CHECK_EQUAL( a[i].name, b[i].name );
+			BOOST_CHECK_EQUAL( a[i].size, b[i].size );
+			BOOST_CHECK_EQUAL( a[i].modified, b[i].modified );
+			BOOST_CHECK_EQUAL( a[i].valid, b[i].valid );
+			BOOST_CHECK_EQUAL( a[i].playerNames[LEFT_PLAYER], b[i].playerNames[LEFT_PLAYER] );
+			BOOST_CHECK_EQUAL( a[i].finalScore[RIGHT_PLAYER], b[i].finalScore[RIGHT_PLAYER] );
+			BOOST_CHECK_EQUAL( a[i].duration, b[i].duration );
+			BOOST_CHECK_EQUAL( a[i].date, b[i].date );
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( ReplayCatalogueTest )
+
+BOOST_FIXTURE_TEST_CASE( save_and_load, ReplayDirFixture )
+{
+	auto first = recordReplay("replays/first.bvr", 3000);
+	auto second = recordReplay("replays/second.bvr", 6000);
+
+	auto entries = update();
+	BOOST_REQUIRE_EQUAL( entries.size(), 2u );
+	checkEntry(entries[0], "first", first);
+	checkEntry(entries[1], "second", second);
+
+	// the catalogue has been replaced as a whole
+	BOOST_CHECK( testFileSystem().exists(CATALOGUE_FILE) );
+	BOOST_CHECK( !testFileSystem().exists(CATALOGUE_TEMP_FILE) );
+
+	// a new catalogue reads the same entries from the file
+	checkSameEntries( update(), entries );
+}
+
+BOOST_FIXTURE_TEST_CASE( invalidation, ReplayDirFixture )
+{
+	recordReplay("replays/changed.bvr", 3000);
+	recordReplay("replays/deleted.bvr", 3000);
+	auto unchanged = recordReplay("replays/unchanged.bvr", 3000);
+	BOOST_REQUIRE_EQUAL( update().size(), 3u );
+
+	auto changed = recordReplay("replays/changed.bvr", 5000);
+	testFileSystem().deleteFile("replays/deleted.bvr");
+	auto added = recordReplay("replays/added.bvr", 1000);
+	{
+		FileWrite broken("replays/broken.bvr");
+		broken.write("not a replay");
+	}
+
+	auto entries = update();
+	BOOST_REQUIRE_EQUAL( entries.size(), 4u );
+	checkEntry(entries[0], "added", added);
+	BOOST_CHECK_EQUAL( entries[1].name, "broken" );
+	BOOST_CHECK( !entries[1].valid );
+	checkEntry(entries[2], "changed", changed);
+	checkEntry(entries[3], "unchanged", unchanged);
+
+	// the changes have been saved
+	checkSameEntries( update(), entries );
+}
+
+BOOST_FIXTURE_TEST_CASE( broken_catalogue, ReplayDirFixture )
+{
+	auto replay = recordReplay("replays/replay.bvr", 3000);
+	{
+		FileWrite file(CATALOGUE_FILE);
+		file.writeUInt32(1);
+		file.writeUInt32(1000);
+	}
+
+	// the catalogue is rebuilt
+	auto entries = update();
+	BOOST_REQUIRE_EQUAL( entries.size(), 1u );
+	checkEntry(entries[0], "replay", replay);
+	checkSameEntries( update(), entries );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
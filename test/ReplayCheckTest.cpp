@@ -0,0 +1,94 @@
+#include <boost/test/unit_test.hpp>
+
+#include "DuelMatch.h"
+#include "FileWrite.h"
+#include "InputSource.h"
+#include "XorShift.h"
+#include "replays/IReplayLoader.h"
+#include "replays/ReplayCheck.h"
+#include "replays/ReplayDefs.h"
+#include "replays/ReplayRecorder.h"
+#include "TestHelpers.h"
+
+#include <memory>
+
+namespace
+{
+	const char* REPLAY_FILE = "replaychecktest.bvr";
+
+	/// records a match the same way LocalGameState does, i.e. the state is recorded before each step.
+	/// The left blob jumps already in the first step.
+	void recordMatch(int steps)
+	{
+		DuelMatch match(false, FALLBACK_RULES_NAME);
+		auto left = std::make_shared<InputSource>();
+		auto right = std::make_shared<InputSource>();
+		match.setInputSources(left, right);
+
+		ReplayRecorder recorder;
+		recorder.setPlayerNames("left", "right");
+		recorder.setGameSpeed(75);
+
+		XorShift random;
+		PlayerInput left_input(false, true, true);
+		PlayerInput right_input(true, false, false);
+		for(int step = 0; step < steps; ++step)
+		{
+			left->setInput(left_input);
+			right->setInput(right_input);
+			recorder.record(match.getState());
+			match.step();
+
+			left_input = random.holdInput(left_input);
+			right_input = random.holdInput(right_input);
+		}
+		recorder.record(match.getState());
+		recorder.finalize(match.getScore(LEFT_PLAYER), match.getScore(RIGHT_PLAYER));
+
+		FileWrite file(REPLAY_FILE);
+		recorder.save(file);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( ReplayCheckTest )
+
+BOOST_FIXTURE_TEST_CASE( reproduces_recorded_match, DataFixture )
+{
+	recordMatch(5000);
+
+	std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader(REPLAY_FILE));
+	DuelMatch match(false, FALLBACK_RULES_NAME);
+	ReplayCheckResult result = checkReplay(*loader, match);
+
+	BOOST_CHECK_MESSAGE( result.divergence == -1, "diverged at step " << result.divergence << ": " << result.difference );
+	// input 0 is not simulated, and the recorder adds a second of idle input at the end
+	BOOST_CHECK_EQUAL( result.steps, loader->getLength() - 1 );
+	BOOST_CHECK_GT( result.steps, 5000 );
+
+	// all savepoints have to be compared, including the one before the first step
+	int last_step;
+	int last_savepoint = loader->getSavePoint(loader->getLength() - 1, last_step);
+	BOOST_CHECK_EQUAL( result.savepoints, last_savepoint + 1 );
+	BOOST_CHECK_GT( result.savepoints, 5000 / REPLAY_SAVEPOINT_PERIOD );
+	BOOST_CHECK_EQUAL( result.lastMatch, last_step );
+
+	testFileSystem().deleteFile(REPLAY_FILE);
+}
+
+BOOST_FIXTURE_TEST_CASE( detects_divergence, DataFixture )
+{
+	recordMatch(2000);
+
+	// the fixed point physics do not produce the same trajectories as the float physics of the recording
+	std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader(REPLAY_FILE));
+	DuelMatch match(false, FALLBACK_RULES_NAME, 0, PhysicBackend::FIXED_POINT);
+	ReplayCheckResult result = checkReplay(*loader, match);
+
+	BOOST_CHECK_GE( result.divergence, 0 );
+	BOOST_CHECK( !result.difference.empty() );
+	BOOST_CHECK_LT( result.steps, 2000 );
+
+	testFileSystem().deleteFile(REPLAY_FILE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+#include <boost/test/unit_test.hpp>
+
+#include "FileRead.h"
+#include "replays/ReplayDefs.h"
+#include "replays/ReplayExport.h"
+#include "TestHelpers.h"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const char* REPLAY_FILE = "replayexporttest.bvr";
+	const char* EXPORT_NAME = "replayexporttest";
+	const char* RULES_NAME = "replayexporttest.lua";
+
+	/// the columns of a .frames file, with each value widened to 32 bits
+	typedef std::map<std::string, std::vector<std::uint32_t>> Columns;
+
+	Columns readFrames(const std::string& file)
+	{
+		FileRead source(file);
+		std::vector<char> data = source.readRawBytes(source.length());
+		std::size_t offset = 0;
+		auto read = [&](int bytes)
+		{
+			BOOST_REQUIRE_LE( offset + bytes, data.size() );
+			std::uint32_t value = 0;
+			for(int i = 0; i < bytes; ++i)
+				value |= (std::uint32_t)(unsigned char)data[offset + i] << (8 * i);
+			offset += bytes;
+			return value;
+		};
+
+		BOOST_REQUIRE_EQUAL( std::string(data.data(), 4), "BVXF" );
+		offset = 4;
+		BOOST_REQUIRE_EQUAL( read(2), 1u );
+		int column_count = read(2);
+
+		std::vector<std::pair<std::string, int>> header;
+		for(int i = 0; i < column_count; ++i)
+		{
+			char type = read(1);
+			int length = read(1);
+			header.emplace_back(std::string(data.data() + offset, length), type == 'b' ? 1 : 4);
+			offset += length;
+		}
+
+		Columns columns;
+		while(offset < data.size())
+		{
+			std::uint32_t frames = read(4);
+			std::uint32_t events = read(4);
+			for(const auto& column : header)
+			{
+				for(std::uint32_t frame = 0; frame < frames; ++frame)
+					columns[column.first].push_back(read(column.second));
+			}
+			offset += events * 10;
+		}
+		BOOST_REQUIRE_EQUAL( offset, data.size() );
+		return columns;
+	}
+
+	std::uint32_t bits(float value)
+	{
+		std::uint32_t result;
+		std::memcpy(&result, &value, sizeof(result));
+		return result;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( ReplayExportTest )
+
+// the replay is simulated with the physics it has been recorded with
+BOOST_FIXTURE_TEST_CASE( fixed_point_replay, DataFixture )
+{
+	auto states = recordReplay(REPLAY_FILE, 3000, PhysicBackend::FIXED_POINT);
+	testFileSystem().mkdir("rules");
+
+	ReplayExportResult result = exportReplay(REPLAY_FILE, EXPORT_NAME, false, RULES_NAME, 0);
+	BOOST_REQUIRE_MESSAGE( result.error.empty(), result.error );
+	// the recorder adds a second of idle input after the match
+	BOOST_CHECK_EQUAL( result.frames, states.size() + 75 );
+
+	Columns columns = readFrames(std::string(EXPORT_NAME) + ".frames");
+	BOOST_REQUIRE_EQUAL( columns["frame"].size(), result.frames );
+	for(std::size_t frame = 0; frame < states.size(); ++frame)
+	{
+		const PhysicState& world = states[frame].worldState;
+		BOOST_REQUIRE_EQUAL( columns["frame"][frame], frame );
+		BOOST_REQUIRE_MESSAGE( columns["ball_x"][frame] == bits(world.ballPosition.x) &&
+								columns["ball_y"][frame] == bits(world.ballPosition.y) &&
+								columns["ball_vx"][frame] == bits(world.ballVelocity.x) &&
+								columns["ball_vy"][frame] == bits(world.ballVelocity.y) &&
+								columns["left_blob_x"][frame] == bits(world.blobPosition[LEFT_PLAYER].x) &&
+								columns["left_blob_y"][frame] == bits(world.blobPosition[LEFT_PLAYER].y) &&
+								columns["right_blob_x"][frame] == bits(world.blobPosition[RIGHT_PLAYER].x) &&
+								columns["right_blob_y"][frame] == bits(world.blobPosition[RIGHT_PLAYER].y),
+								"exported frame " << frame << " differs from the recorded state" );
+		BOOST_REQUIRE_EQUAL( columns["left_score"][frame], (std::uint32_t)states[frame].logicState.leftScore );
+		BOOST_REQUIRE_EQUAL( columns["right_score"][frame], (std::uint32_t)states[frame].logicState.rightScore );
+	}
+
+	testFileSystem().deleteFile(std::string(EXPORT_NAME) + ".frames");
+	testFileSystem().deleteFile(std::string("rules/") + RULES_NAME);
+	testFileSystem().deleteFile(REPLAY_FILE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,192 @@
+#include <boost/test/unit_test.hpp>
+
+#include "XorShift.h"
+#include "replays/ReplayInputCodec.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	/// the decoder returns the input bits with the run start marker
+	std::uint8_t decoded(std::uint8_t packet)
+	{
+		return 0x80 | (packet & 0x3F);
+	}
+
+	std::vector<std::uint8_t> encode(const std::vector<std::uint8_t>& packets)
+	{
+		std::vector<std::uint8_t> data;
+		ReplayInputEncoder encoder;
+		for(auto packet : packets)
+			encoder.add(packet, data);
+		encoder.finishRun(data);
+		return data;
+	}
+
+	void checkDecode(const std::vector<std::uint8_t>& data, const std::vector<std::uint8_t>& packets)
+	{
+		ReplayInputDecoder decoder(data.data(), data.size());
+		for(unsigned int step = 0; step < packets.size(); ++step)
+		{
+			std::uint8_t packet = decoder.get(step);
+			BOOST_REQUIRE_MESSAGE( packet == decoded(packets[step]), "input differs at step " << step );
+		}
+
+		// there is nothing after the last run
+		BOOST_CHECK_THROW( decoder.get(packets.size()), std::runtime_error );
+	}
+
+	/// appends the run length bytes for a run of \p length steps
+	void appendLength(std::vector<std::uint8_t>& data, std::uint32_t length)
+	{
+		for(std::uint32_t rest = length - 1; rest != 0; rest >>= 7)
+			data.push_back(rest & 0x7F);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( ReplayInputCodecTest )
+
+BOOST_AUTO_TEST_CASE( empty_stream )
+{
+	std::vector<std::uint8_t> data = encode({});
+	BOOST_CHECK( data.empty() );
+
+	ReplayInputDecoder decoder(data.data(), data.size());
+	BOOST_CHECK_THROW( decoder.get(0), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( long_runs )
+{
+	// run lengths around the boundaries of the 7 bit length groups
+	const unsigned int lengths[] = {1, 2, 128, 129, 16384, 16385, 2097152, 2097153, 3};
+	std::vector<std::uint8_t> packets;
+	std::size_t expected_size = 0;
+	std::uint8_t packet = 0x80;
+	for(unsigned int length : lengths)
+	{
+		++packet;
+		packets.insert(packets.end(), length, packet);
+
+		std::vector<std::uint8_t> length_bytes;
+		appendLength(length_bytes, length);
+		expected_size += 1 + length_bytes.size();
+	}
+
+	std::vector<std::uint8_t> data = encode(packets);
+	BOOST_CHECK_EQUAL( data.size(), expected_size );
+	checkDecode(data, packets);
+}
+
+BOOST_AUTO_TEST_CASE( alternating_inputs )
+{
+	std::vector<std::uint8_t> packets;
+	for(int step = 0; step < 10000; ++step)
+		packets.push_back(step % 2 ? 0x80 | 0x09 : 0x80 | 0x22);
+
+	// every step is a run of its own, which needs no length bytes
+	std::vector<std::uint8_t> data = encode(packets);
+	BOOST_CHECK_EQUAL( data.size(), packets.size() );
+	checkDecode(data, packets);
+}
+
+BOOST_AUTO_TEST_CASE( random_inputs )
+{
+	XorShift random;
+	std::vector<std::uint8_t> packets;
+	std::uint8_t packet = 0x80;
+	for(int step = 0; step < 100000; ++step)
+	{
+		// the padding after the match uses 0 instead of the marker bit
+		if(random.integer(0, 7) == 0)
+			packet = random.integer(0, 63) == 0 ? 0 : 0x80 | random.integer(0, 63);
+		packets.push_back(packet);
+	}
+
+	checkDecode(encode(packets), packets);
+}
+
+BOOST_AUTO_TEST_CASE( seek_to_savepoints )
+{
+	// a savepoint every 100 steps ends the current run, even inside a run of identical input
+	std::vector<std::uint8_t> packets;
+	std::vector<std::uint8_t> data;
+	std::vector<std::size_t> offsets;
+	ReplayInputEncoder encoder;
+	for(int step = 0; step < 1000; ++step)
+	{
+		if(step % 100 == 0)
+		{
+			encoder.finishRun(data);
+			offsets.push_back(data.size());
+		}
+		std::uint8_t packet = 0x80 | (step / 250);
+		encoder.add(packet, data);
+		packets.push_back(packet);
+	}
+	encoder.finishRun(data);
+
+	ReplayInputDecoder decoder(data.data(), data.size());
+	for(int savepoint = 9; savepoint >= 0; --savepoint)
+	{
+		decoder.seek(offsets[savepoint], savepoint * 100);
+		for(int step = savepoint * 100; step < 1000; ++step)
+			BOOST_REQUIRE_EQUAL( (int)decoder.get(step), (int)decoded(packets[step]) );
+	}
+}
+
+BOOST_AUTO_TEST_CASE( pending_run )
+{
+	std::vector<std::uint8_t> data;
+	ReplayInputEncoder encoder;
+	for(int step = 0; step < 300; ++step)
+		encoder.add(0x81, data);
+	BOOST_CHECK( data.empty() );
+
+	// writing the pending run does not end it
+	std::vector<std::uint8_t> pending = data;
+	encoder.writePending(pending);
+	encoder.add(0x81, data);
+	encoder.finishRun(data);
+	BOOST_CHECK_EQUAL( pending.size(), data.size() );
+	checkDecode(pending, std::vector<std::uint8_t>(300, 0x81));
+	checkDecode(data, std::vector<std::uint8_t>(301, 0x81));
+}
+
+BOOST_AUTO_TEST_CASE( maximum_run_length )
+{
+	// a run of the maximum length is too long to be encoded step by step in a test, so its bytes are built here
+	const std::uint32_t max_length = ReplayInputEncoder::MAX_RUN_LENGTH;
+	std::vector<std::uint8_t> data = {0x85};
+	appendLength(data, max_length);
+	BOOST_CHECK_EQUAL( data.size(), 6u );
+	data.push_back(0x81);
+
+	ReplayInputDecoder decoder(data.data(), data.size());
+	BOOST_CHECK_EQUAL( (int)decoder.get(0), 0x85 );
+	BOOST_CHECK_EQUAL( (int)decoder.get(max_length - 1), 0x85 );
+	BOOST_CHECK_EQUAL( (int)decoder.get(max_length), 0x81 );
+	BOOST_CHECK_EQUAL( decoder.getRunStep(), max_length );
+	BOOST_CHECK_EQUAL( decoder.getRunOffset(), 6u );
+}
+
+BOOST_AUTO_TEST_CASE( corrupt_run_length )
+{
+	// one step more than the maximum length does not fit into the step counter
+	std::vector<std::uint8_t> too_long = {0x85, 0x7F, 0x7F, 0x7F, 0x7F, 0x0F, 0x81};
+	ReplayInputDecoder decoder(too_long.data(), too_long.size());
+	BOOST_CHECK_THROW( decoder.get(0), std::runtime_error );
+
+	// more than 32 bits
+	std::vector<std::uint8_t> overflow = {0x85, 0x7F, 0x7F, 0x7F, 0x7F, 0x10};
+	ReplayInputDecoder overflow_decoder(overflow.data(), overflow.size());
+	BOOST_CHECK_THROW( overflow_decoder.get(0), std::runtime_error );
+
+	// length bytes without a run start
+	std::vector<std::uint8_t> no_start = {0x05, 0x81};
+	ReplayInputDecoder no_start_decoder(no_start.data(), no_start.size());
+	BOOST_CHECK_THROW( no_start_decoder.get(0), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
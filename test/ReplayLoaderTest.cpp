@@ -0,0 +1,131 @@
+#include <boost/test/unit_test.hpp>
+
+#include "FileRead.h"
+#include "FileWrite.h"
+#include "InputSource.h"
+#include "XorShift.h"
+#include "replays/IReplayLoader.h"
+#include "replays/ReplayDefs.h"
+#include "TestHelpers.h"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	const char* REPLAY_FILE = "replayloadertest.bvr";
+	const char* TRUNCATED_FILE = "replayloadertest_truncated.bvr";
+
+	PlayerInput loadedInput(const InputSource& source)
+	{
+		return source.getRealInput().toPlayerInput(nullptr);
+	}
+
+	/// loads REPLAY_FILE and compares it with the recorded states
+	void checkReplay(const std::vector<DuelMatchState>& states, PhysicBackend backend)
+	{
+		std::unique_ptr<IReplayLoader> loader(IReplayLoader::createReplayLoader(REPLAY_FILE));
+		BOOST_CHECK_EQUAL( loader->getVersionMajor(), REPLAY_FILE_VERSION_MAJOR );
+		BOOST_CHECK_EQUAL( loader->getVersionMinor(), REPLAY_FILE_VERSION_MINOR );
+		BOOST_CHECK_EQUAL( loader->getPlayerName(LEFT_PLAYER), "left player" );
+		BOOST_CHECK_EQUAL( loader->getPlayerName(RIGHT_PLAYER), "right player" );
+		BOOST_CHECK_EQUAL( loader->getBlobColor(LEFT_PLAYER).toInt(), Color(255, 0, 0).toInt() );
+		BOOST_CHECK_EQUAL( loader->getBlobColor(RIGHT_PLAYER).toInt(), Color(0, 0, 255).toInt() );
+		BOOST_CHECK_EQUAL( loader->getSpeed(), 75 );
+		BOOST_CHECK( loader->getPhysicBackend() == backend );
+		BOOST_CHECK_EQUAL( loader->getFinalScore(LEFT_PLAYER), states.back().logicState.leftScore );
+		BOOST_CHECK_EQUAL( loader->getFinalScore(RIGHT_PLAYER), states.back().logicState.rightScore );
+		BOOST_CHECK_THROW( loader->getPlayerName(NO_PLAYER), std::invalid_argument );
+		BOOST_CHECK_THROW( loader->getBlobColor(NO_PLAYER), std::invalid_argument );
+		BOOST_CHECK_THROW( loader->getFinalScore(NO_PLAYER), std::invalid_argument );
+
+		// the recorder adds a second of idle input after the match
+		int length = loader->getLength();
+		BOOST_REQUIRE_EQUAL( length, (int)states.size() + 75 );
+
+		// sequential playback
+		InputSource left;
+		InputSource right;
+		for(int step = 0; step < length; ++step)
+		{
+			loader->getInputAt(step, &left, &right);
+			PlayerInput expected_left = step < (int)states.size() ? states[step].playerInput[LEFT_PLAYER] : PlayerInput();
+			PlayerInput expected_right = step < (int)states.size() ? states[step].playerInput[RIGHT_PLAYER] : PlayerInput();
+			BOOST_REQUIRE_MESSAGE( loadedInput(left) == expected_left, "left input differs at step " << step );
+			BOOST_REQUIRE_MESSAGE( loadedInput(right) == expected_right, "right input differs at step " << step );
+		}
+
+		// jumps, which restart decoding at a savepoint
+		XorShift random(7);
+		for(int i = 0; i < 2000; ++i)
+		{
+			int step = random.integer(0, (int)states.size() - 1);
+			loader->getInputAt(step, &left, &right);
+			BOOST_REQUIRE_MESSAGE( loadedInput(left) == states[step].playerInput[LEFT_PLAYER], "left input differs at step " << step );
+			BOOST_REQUIRE_MESSAGE( loadedInput(right) == states[step].playerInput[RIGHT_PLAYER], "right input differs at step " << step );
+		}
+
+		// savepoints
+		int last_step;
+		int savepoints = loader->getSavePoint(length - 1, last_step) + 1;
+		BOOST_CHECK_GE( savepoints, (int)states.size() / REPLAY_SAVEPOINT_PERIOD );
+		for(int index = 0; index < savepoints; ++index)
+		{
+			ReplaySavePoint savepoint;
+			loader->readSavePoint(index, savepoint);
+			BOOST_REQUIRE_LT( savepoint.step, states.size() );
+
+			int found;
+			BOOST_CHECK( loader->isSavePoint(savepoint.step, found) );
+			BOOST_CHECK_EQUAL( found, index );
+
+			checkSameState( savepoint.state, states[savepoint.step] );
+			BOOST_CHECK( savepoint.state.playerInput[LEFT_PLAYER] == states[savepoint.step].playerInput[LEFT_PLAYER] );
+			BOOST_CHECK( savepoint.state.playerInput[RIGHT_PLAYER] == states[savepoint.step].playerInput[RIGHT_PLAYER] );
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( ReplayLoaderTest )
+
+BOOST_FIXTURE_TEST_CASE( round_trip, DataFixture )
+{
+	auto states = recordReplay(REPLAY_FILE, 5000);
+	checkReplay(states, PhysicBackend::FLOAT);
+	testFileSystem().deleteFile(REPLAY_FILE);
+}
+
+BOOST_FIXTURE_TEST_CASE( round_trip_spooled, DataFixture )
+{
+	auto states = recordReplay(REPLAY_FILE, 5000, PhysicBackend::FIXED_POINT, true);
+	checkReplay(states, PhysicBackend::FIXED_POINT);
+	testFileSystem().deleteFile(REPLAY_FILE);
+}
+
+BOOST_FIXTURE_TEST_CASE( truncated_file, DataFixture )
+{
+	recordReplay(REPLAY_FILE, 2000);
+
+	std::vector<char> data;
+	{
+		FileRead file(REPLAY_FILE);
+		data = file.readRawBytes(file.length());
+	}
+
+	// cut inside the header, the metadata, the savepoint index and the input, and right before the end
+	for(std::size_t length : {std::size_t(0), std::size_t(4), std::size_t(REPLAY_V3_HEADER_SIZE - 1),
+							  std::size_t(REPLAY_V3_HEADER_SIZE + 10), data.size() / 2, data.size() - 1})
+	{
+		{
+			FileWrite file(TRUNCATED_FILE);
+			file.write(data.data(), length);
+		}
+		BOOST_CHECK_THROW( delete IReplayLoader::createReplayLoader(TRUNCATED_FILE), std::exception );
+	}
+
+	testFileSystem().deleteFile(TRUNCATED_FILE);
+	testFileSystem().deleteFile(REPLAY_FILE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,98 @@
+#include <boost/test/unit_test.hpp>
+
+#include "DuelMatch.h"
+#include "XorShift.h"
+#include "replays/ReplayDefs.h"
+#include "replays/ReplayPlayer.h"
+#include "TestHelpers.h"
+
+#include <vector>
+
+namespace
+{
+	const char* REPLAY_FILE = "replayplayertest.bvr";
+
+	/// plays the whole replay step by step and returns the state at each position
+	std::vector<DuelMatchState> playLinear()
+	{
+		ReplayPlayer player;
+		player.load(REPLAY_FILE);
+		DuelMatch match(false, FALLBACK_RULES_NAME);
+
+		std::vector<DuelMatchState> states;
+		states.push_back(match.getState());
+		while(player.play(&match))
+		{
+			BOOST_REQUIRE_EQUAL( player.getReplayPosition(), (int)states.size() );
+			states.push_back(match.getState());
+		}
+		return states;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( ReplayPlayerTest )
+
+BOOST_FIXTURE_TEST_CASE( linear_playback, DataFixture )
+{
+	auto recorded = recordReplay(REPLAY_FILE, 5000);
+	auto played = playLinear();
+
+	BOOST_REQUIRE_GT( played.size(), recorded.size() );
+	for(std::size_t position = 0; position < recorded.size(); ++position)
+		checkSameState( played[position], recorded[position] );
+
+	testFileSystem().deleteFile(REPLAY_FILE);
+}
+
+BOOST_FIXTURE_TEST_CASE( seek, DataFixture )
+{
+	// with a short distance, the cache is full long before the end of the replay
+	const int distance = 7;
+	recordReplay(REPLAY_FILE, distance * REPLAY_SEEK_CACHE_SIZE * 3);
+	auto linear = playLinear();
+	const int last = linear.size() - 1;
+
+	ReplayPlayer player;
+	player.load(REPLAY_FILE);
+	player.setSavePointDistance(distance);
+	DuelMatch match(false, FALLBACK_RULES_NAME);
+
+	auto seek = [&](int position)
+	{
+		BOOST_REQUIRE( player.gotoPlayingPosition(position, &match) );
+		BOOST_REQUIRE_EQUAL( player.getReplayPosition(), position );
+		BOOST_REQUIRE_LE( player.getCachedStateCount(), REPLAY_SEEK_CACHE_SIZE );
+	};
+
+	// playing to the end keeps the states closest to the end
+	while(player.play(&match))
+		BOOST_REQUIRE_LE( player.getCachedStateCount(), REPLAY_SEEK_CACHE_SIZE );
+	BOOST_CHECK_EQUAL( player.getCachedStateCount(), REPLAY_SEEK_CACHE_SIZE );
+	const int first_cached = (last / distance - REPLAY_SEEK_CACHE_SIZE + 1) * distance;
+
+	// reverse playback refills the rewind buffer from the cached states
+	for(int i = 0; i < 2 * REPLAY_REWIND_BUFFER_SIZE; ++i)
+	{
+		BOOST_REQUIRE( player.playBackwards(&match) );
+		checkSameState( match.getState(), linear[player.getReplayPosition()] );
+	}
+
+	// seeking within the cached part restores a cached state and simulates at most distance - 1 steps
+	XorShift random(3);
+	for(int i = 0; i < 300; ++i)
+	{
+		int position = random.integer(first_cached, last);
+		seek(position);
+		checkSameState( match.getState(), linear[position] );
+	}
+
+	// the savepoints of the file lack the blob animation, so the states simulated from them are only checked
+	// for the position. Seeking there replaces the cached states farthest away.
+	for(int i = 0; i < 300; ++i)
+		seek( random.integer(0, first_cached) );
+	BOOST_CHECK_EQUAL( player.getCachedStateCount(), REPLAY_SEEK_CACHE_SIZE );
+
+	testFileSystem().deleteFile(REPLAY_FILE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,220 @@
+#include <boost/test/unit_test.hpp>
+
+#include "SnapshotCodec.h"
+#include "DuelMatchState.h"
+#include "TestHelpers.h"
+#include "raknet/BitStream.h"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	// half a quantization step, see QuantizedMatchState
+	const float POSITION_ERROR = 1.f / 512;
+	const float ROTATION_ERROR = 1.f / 8192;
+
+	void checkClose(float decoded, float original, float error)
+	{
+		BOOST_CHECK_LE( std::abs(decoded - original), error );
+	}
+
+	void checkClose(const Vector2& decoded, const Vector2& original)
+	{
+		checkClose(decoded.x, original.x, POSITION_ERROR);
+		checkClose(decoded.y, original.y, POSITION_ERROR);
+	}
+
+	void checkDecoded(const DuelMatchState& decoded, const DuelMatchState& original)
+	{
+		const PhysicState& a = decoded.worldState;
+		const PhysicState& b = original.worldState;
+		for(int player = LEFT_PLAYER; player <= RIGHT_PLAYER; ++player)
+		{
+			checkClose(a.blobPosition[player], b.blobPosition[player]);
+			checkClose(a.blobVelocity[player], b.blobVelocity[player]);
+			checkClose(a.blobState[player], b.blobState[player], POSITION_ERROR);
+			BOOST_CHECK( decoded.playerInput[player] == original.playerInput[player] );
+			BOOST_CHECK_EQUAL( decoded.logicState.hitCount[player], original.logicState.hitCount[player] );
+			BOOST_CHECK_EQUAL( decoded.logicState.squish[player], original.logicState.squish[player] );
+		}
+		checkClose(a.ballPosition, b.ballPosition);
+		checkClose(a.ballVelocity, b.ballVelocity);
+		checkClose(a.ballRotation, b.ballRotation, ROTATION_ERROR);
+		checkClose(a.ballAngularVelocity, b.ballAngularVelocity, ROTATION_ERROR);
+
+		BOOST_CHECK_EQUAL( decoded.logicState.leftScore, original.logicState.leftScore );
+		BOOST_CHECK_EQUAL( decoded.logicState.rightScore, original.logicState.rightScore );
+		BOOST_CHECK_EQUAL( decoded.logicState.squishWall, original.logicState.squishWall );
+		BOOST_CHECK_EQUAL( decoded.logicState.squishGround, original.logicState.squishGround );
+		BOOST_CHECK_EQUAL( decoded.logicState.servingPlayer, original.logicState.servingPlayer );
+		BOOST_CHECK_EQUAL( decoded.logicState.winningPlayer, original.logicState.winningPlayer );
+		BOOST_CHECK_EQUAL( decoded.logicState.isBallValid, original.logicState.isBallValid );
+		BOOST_CHECK_EQUAL( decoded.logicState.isGameRunning, original.logicState.isGameRunning );
+	}
+
+	/// the states of a match with random input
+	std::vector<DuelMatchState> matchStates(int steps)
+	{
+		RandomMatch game;
+		std::vector<DuelMatchState> states;
+		for(int step = 0; step < steps; ++step)
+		{
+			game.play(step);
+			states.push_back( game.match.getState() );
+		}
+		return states;
+	}
+
+	/// a state in which every field has a value, so all of them are encoded
+	DuelMatchState filledState(float position, unsigned int count)
+	{
+		DuelMatchState state;
+		PhysicState& world = state.worldState;
+		for(int player = LEFT_PLAYER; player <= RIGHT_PLAYER; ++player)
+		{
+			world.blobPosition[player] = Vector2(position, -position);
+			world.blobVelocity[player] = Vector2(-position, position);
+			world.blobState[player] = position;
+			state.logicState.hitCount[player] = count;
+			state.logicState.squish[player] = count;
+			state.playerInput[player] = PlayerInput(true, false, player == LEFT_PLAYER);
+		}
+		world.ballPosition = Vector2(position, position);
+		world.ballVelocity = Vector2(-position, -position);
+		world.ballRotation = position;
+		world.ballAngularVelocity = -position;
+		state.logicState.leftScore = count;
+		state.logicState.rightScore = count;
+		state.logicState.squishWall = count;
+		state.logicState.squishGround = count;
+		state.logicState.servingPlayer = RIGHT_PLAYER;
+		state.logicState.winningPlayer = NO_PLAYER;
+		state.logicState.isBallValid = true;
+		state.logicState.isGameRunning = false;
+		return state;
+	}
+
+	/// sends a snapshot of \p state from the encoder to the decoder
+	/// \return the size of the snapshot in bytes
+	int transfer(SnapshotEncoder& encoder, SnapshotDecoder& decoder, const DuelMatchState& state, DuelMatchState& decoded)
+	{
+		RakNet::BitStream stream;
+		encoder.encode(state, stream);
+		BOOST_REQUIRE( decoder.decode(stream, decoded) );
+		return stream.GetNumberOfBytesUsed();
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( SnapshotCodecTest )
+
+BOOST_AUTO_TEST_CASE( keyframes )
+{
+	SnapshotEncoder encoder;
+	SnapshotDecoder decoder;
+	auto states = matchStates(2000);
+	DuelMatchState decoded;
+	for(const auto& state : states)
+	{
+		// without acknowledgements, every snapshot has to be a keyframe
+		transfer(encoder, decoder, state, decoded);
+		checkDecoded(decoded, state);
+	}
+	BOOST_CHECK_EQUAL( encoder.getKeyframeCount(), states.size() );
+}
+
+BOOST_AUTO_TEST_CASE( deltas )
+{
+	SnapshotEncoder encoder;
+	SnapshotDecoder decoder;
+	auto states = matchStates(5000);
+	std::vector<std::uint32_t> received;
+	DuelMatchState decoded;
+	int keyframe_size = 0;
+	int delta_size = 0;
+	for(std::size_t i = 0; i < states.size(); ++i)
+	{
+		int size = transfer(encoder, decoder, states[i], decoded);
+		checkDecoded(decoded, states[i]);
+		if(i == 0)
+			keyframe_size = size;
+		else
+			delta_size += size;
+
+		// the acknowledgements arrive with a few steps of latency
+		received.push_back(decoder.getLastSequence());
+		if(received.size() > 4)
+			encoder.acknowledge(received[received.size() - 5]);
+	}
+
+	BOOST_CHECK_EQUAL( encoder.getKeyframeCount(), 5u );
+	BOOST_CHECK_LT( delta_size / (int)(states.size() - 1), keyframe_size );
+}
+
+// moving backwards and lowering the counters produces negative differences
+BOOST_AUTO_TEST_CASE( negative_deltas )
+{
+	SnapshotEncoder encoder;
+	SnapshotDecoder decoder;
+	DuelMatchState decoded;
+	for(int i = 0; i < 100; ++i)
+	{
+		DuelMatchState state = filledState(300.f - i * 7.3f, 100 - i);
+		transfer(encoder, decoder, state, decoded);
+		checkDecoded(decoded, state);
+		encoder.acknowledge(decoder.getLastSequence());
+	}
+	BOOST_CHECK_EQUAL( encoder.getKeyframeCount(), 1u );
+}
+
+// differences that do not fit into 31 bits wrap around, and still have to be decoded exactly
+BOOST_AUTO_TEST_CASE( large_jumps )
+{
+	SnapshotEncoder encoder;
+	SnapshotDecoder decoder;
+	DuelMatchState decoded;
+	const float positions[] = {0.f, 8000000.f, -8000000.f, 8000000.f, 0.5f, -8000000.f};
+	const unsigned int counts[] = {0, 0xFFFFFFFFu, 0, 0x80000000u, 1, 0xFFFFFFFFu};
+	for(int i = 0; i < 6; ++i)
+	{
+		DuelMatchState state = filledState(positions[i], counts[i]);
+		transfer(encoder, decoder, state, decoded);
+		encoder.acknowledge(decoder.getLastSequence());
+
+		// these values are multiples of the quantization step, so they are transferred exactly
+		BOOST_CHECK_EQUAL( decoded.worldState.ballPosition.x, positions[i] );
+		BOOST_CHECK_EQUAL( decoded.worldState.blobVelocity[RIGHT_PLAYER].x, -positions[i] );
+		BOOST_CHECK_EQUAL( decoded.worldState.blobState[LEFT_PLAYER], positions[i] );
+		BOOST_CHECK_EQUAL( decoded.logicState.leftScore, counts[i] );
+		BOOST_CHECK_EQUAL( decoded.logicState.squishGround, counts[i] );
+	}
+	BOOST_CHECK_EQUAL( encoder.getKeyframeCount(), 1u );
+}
+
+BOOST_AUTO_TEST_CASE( lost_and_reordered_snapshots )
+{
+	SnapshotEncoder encoder;
+	SnapshotDecoder decoder;
+	DuelMatchState decoded;
+	auto states = matchStates(10);
+
+	transfer(encoder, decoder, states[0], decoded);
+	encoder.acknowledge(decoder.getLastSequence());
+
+	// two snapshots arrive in the wrong order: the older one is ignored
+	RakNet::BitStream first;
+	RakNet::BitStream second;
+	encoder.encode(states[1], first);
+	encoder.encode(states[2], second);
+	BOOST_CHECK( decoder.decode(second, decoded) );
+	BOOST_CHECK( !decoder.decode(first, decoded) );
+	checkDecoded(decoded, states[2]);
+
+	// a delta against a snapshot the decoder never received can not be decoded
+	SnapshotDecoder late;
+	RakNet::BitStream delta;
+	encoder.encode(states[3], delta);
+	BOOST_CHECK( !late.decode(delta, decoded) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
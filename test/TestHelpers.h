@@ -0,0 +1,247 @@
+#pragma once
+
+#include <boost/test/unit_test.hpp>
+
+#include "DuelMatch.h"
+#include "DuelMatchState.h"
+#include "FileSystem.h"
+#include "FileWrite.h"
+#include "InputSource.h"
+#include "MatchEvents.h"
+#include "PhysicState.h"
+#include "XorShift.h"
+#include "replays/ReplayRecorder.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+
+// the rules scripts and their api are loaded from the data directory of the source tree
+#ifndef BLOBBY_TEST_DATA_DIR
+#define BLOBBY_TEST_DATA_DIR "./data"
+#endif
+
+// the argument physfs is initialised with, in place of the path of the program
+#define TEST_EXECUTION_PATH "./test/"
+
+/// \brief the file system shared by all tests.
+/// \details physfs can only be initialised once per program, so it is created on first use and lives
+///			until the end. Files are written to and read from the working directory, the rules scripts
+///			are read from the data directory.
+inline FileSystem& testFileSystem()
+{
+	static FileSystem fs(TEST_EXECUTION_PATH);
+	static bool initialised = false;
+	if(!initialised)
+	{
+		fs.setWriteDir(".");
+		fs.addToSearchPath(".", true);
+		fs.addToSearchPath(BLOBBY_TEST_DATA_DIR);
+		initialised = true;
+	}
+	return fs;
+}
+
+/// for tests that load rules scripts or other files
+struct DataFixture
+{
+	DataFixture()
+	{
+		testFileSystem();
+	}
+};
+
+/// FNV-1a hash over the bits of world states and events
+struct StateHash
+{
+	std::uint64_t value = 14695981039346656037ull;
+
+	void add(const void* data, std::size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for(std::size_t i = 0; i < size; ++i)
+		{
+			value ^= bytes[i];
+			value *= 1099511628211ull;
+		}
+	}
+
+	void add(float f)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &f, sizeof(bits));
+		add(&bits, sizeof(bits));
+	}
+
+	void add(const Vector2& v)
+	{
+		add(v.x);
+		add(v.y);
+	}
+
+	void add(const PhysicState& state)
+	{
+		for(int player = LEFT_PLAYER; player <= RIGHT_PLAYER; ++player)
+		{
+			add(state.blobPosition[player]);
+			add(state.blobVelocity[player]);
+			add(state.blobState[player]);
+		}
+		add(state.ballPosition);
+		add(state.ballVelocity);
+		add(state.ballRotation);
+		add(state.ballAngularVelocity);
+	}
+
+	void add(const MatchEvent& event)
+	{
+		std::int32_t type = event.event;
+		std::int32_t side = event.side;
+		add(&type, sizeof(type));
+		add(&side, sizeof(side));
+		add(event.intensity);
+	}
+
+	/// adds and removes all events of \p events
+	void add(MatchEventBuffer& events)
+	{
+		for(const auto& event : events)
+			add(event);
+		events.clear();
+	}
+};
+
+/// compares the state hashes of a simulation, taken every \p distance steps, with recorded values
+template<std::size_t N>
+void checkCheckpoints(const std::vector<std::uint64_t>& checkpoints, const std::uint64_t (&golden)[N], int distance)
+{
+	BOOST_REQUIRE_EQUAL( checkpoints.size(), N );
+	for(std::size_t i = 0; i < N; ++i)
+	{
+		// report only the first difference, all later ones follow from it
+		BOOST_REQUIRE_MESSAGE( checkpoints[i] == golden[i], "trajectory differs before step " << (i + 1) * distance
+								<< ": 0x" << std::hex << std::setw(16) << std::setfill('0') << checkpoints[i] );
+	}
+}
+
+/// compares the physics bit by bit and the values of the rules
+inline void checkSameState(const DuelMatchState& a, const DuelMatchState& b)
+{
+	BOOST_REQUIRE( std::memcmp(&a.worldState, &b.worldState, sizeof(PhysicState)) == 0 );
+	BOOST_REQUIRE_EQUAL( a.logicState.leftScore, b.logicState.leftScore );
+	BOOST_REQUIRE_EQUAL( a.logicState.rightScore, b.logicState.rightScore );
+	BOOST_REQUIRE_EQUAL( a.logicState.hitCount[LEFT_PLAYER], b.logicState.hitCount[LEFT_PLAYER] );
+	BOOST_REQUIRE_EQUAL( a.logicState.hitCount[RIGHT_PLAYER], b.logicState.hitCount[RIGHT_PLAYER] );
+	BOOST_REQUIRE_EQUAL( a.logicState.servingPlayer, b.logicState.servingPlayer );
+	BOOST_REQUIRE_EQUAL( a.logicState.winningPlayer, b.logicState.winningPlayer );
+	BOOST_REQUIRE_EQUAL( a.logicState.isBallValid, b.logicState.isBallValid );
+	BOOST_REQUIRE_EQUAL( a.logicState.isGameRunning, b.logicState.isGameRunning );
+}
+
+/*! \class RandomMatch
+	\brief a DuelMatch played with random input.
+	\details The input only depends on the step number, so a match can be played again from any step,
+			e.g. after restoring a snapshot. The inputs repeat every INPUT_COUNT steps and are generated
+			in the constructor, so playing does not allocate.
+*/
+class RandomMatch
+{
+	public:
+		static const std::size_t INPUT_COUNT = 4096;	// power of two, so the index wraps with a mask
+
+		explicit RandomMatch(const std::string& rules = FALLBACK_RULES_NAME,
+							 PhysicBackend backend = PhysicBackend::FLOAT, int scoreToWin = 15) :
+			match(false, rules, scoreToWin, backend),
+			mLeft(std::make_shared<InputSource>()),
+			mRight(std::make_shared<InputSource>())
+		{
+			match.setInputSources(mLeft, mRight);
+
+			XorShift random;
+			PlayerInput current;
+			for(std::size_t i = 0; i < INPUT_COUNT; ++i)
+			{
+				current = random.holdInput(current);
+				mInputs.push_back(current);
+			}
+		}
+
+		/// the input of \p side in step \p step
+		PlayerInput input(std::size_t step, PlayerSide side) const
+		{
+			// the right player uses the same sequence, shifted by half its length
+			std::size_t offset = side == LEFT_PLAYER ? 0 : INPUT_COUNT / 2;
+			return mInputs[(step + offset) & (INPUT_COUNT - 1)];
+		}
+
+		/// sets the input of step \p step, without stepping the match
+		void setInput(std::size_t step)
+		{
+			mLeft->setInput( input(step, LEFT_PLAYER) );
+			mRight->setInput( input(step, RIGHT_PLAYER) );
+		}
+
+		/// plays step \p step of the match
+		void play(std::size_t step)
+		{
+			setInput(step);
+			match.step();
+		}
+
+		int totalScore() const
+		{
+			return match.getScore(LEFT_PLAYER) + match.getScore(RIGHT_PLAYER);
+		}
+
+		DuelMatch match;
+
+	private:
+		std::shared_ptr<InputSource> mLeft;
+		std::shared_ptr<InputSource> mRight;
+		std::vector<PlayerInput> mInputs;
+};
+
+/// plays a match with random input, records it the way LocalGameState does and saves the replay to \p file.
+/// \return the recorded states. State n is the state after n steps.
+inline std::vector<DuelMatchState> recordReplay(const std::string& file, int steps,
+											PhysicBackend backend = PhysicBackend::FLOAT, bool spooling = false)
+{
+	DuelMatch match(false, FALLBACK_RULES_NAME, 0, backend);
+	auto left = std::make_shared<InputSource>();
+	auto right = std::make_shared<InputSource>();
+	match.setInputSources(left, right);
+
+	ReplayRecorder recorder;
+	if(spooling)
+		BOOST_REQUIRE( recorder.enableSpooling() );
+	recorder.setPlayerNames("left player", "right player");
+	recorder.setPlayerColors(Color(255, 0, 0), Color(0, 0, 255));
+	recorder.setGameSpeed(75);
+	recorder.setPhysicBackend(backend);
+
+	std::vector<DuelMatchState> states;
+	XorShift random;
+	PlayerInput left_input;
+	PlayerInput right_input;
+	for(int step = 0; step < steps; ++step)
+	{
+		left_input = random.holdInput(left_input);
+		right_input = random.holdInput(right_input);
+		left->setInput(left_input);
+		right->setInput(right_input);
+
+		states.push_back(match.getState());
+		recorder.record(states.back());
+		match.step();
+	}
+	states.push_back(match.getState());
+	recorder.record(states.back());
+	recorder.finalize(match.getScore(LEFT_PLAYER), match.getScore(RIGHT_PLAYER));
+
+	FileWrite replay_file(file);
+	recorder.save(replay_file);
+	return states;
+}
@@ -0,0 +1,150 @@
+#include <boost/test/unit_test.hpp>
+
+#include "DuelMatch.h"
+#include "TrajectoryCache.h"
+#include "TestHelpers.h"
+
+#include <vector>
+
+namespace
+{
+	typedef TrajectoryCache::Key Key;
+	typedef TrajectoryCache::Result Result;
+
+	Key simulateKey(float x)
+	{
+		return Key(TrajectoryCache::Query::SIMULATE, 20, Vector2(x, 300), Vector2(3, -2));
+	}
+
+	Result result(int steps)
+	{
+		return Result{steps, Vector2(steps, 100), Vector2(-1, steps)};
+	}
+
+	void checkResult(const Result* found, const Result& expected)
+	{
+		BOOST_REQUIRE( found );
+		BOOST_CHECK_EQUAL( found->steps, expected.steps );
+		BOOST_CHECK_EQUAL( found->position.x, expected.position.x );
+		BOOST_CHECK_EQUAL( found->velocity.y, expected.velocity.y );
+	}
+
+	/// \p count keys that all start probing at the same slot \p slot
+	std::vector<Key> collidingKeys(int slot, int count)
+	{
+		std::vector<Key> keys;
+		for(int i = 0; (int)keys.size() < count; ++i)
+		{
+			Key key = simulateKey(i);
+			if(key.hash() % TrajectoryCache::SIZE == (std::uint32_t)slot)
+				keys.push_back(key);
+		}
+		return keys;
+	}
+}
+
+BOOST_AUTO_TEST_SUITE( TrajectoryCacheTest )
+
+BOOST_AUTO_TEST_CASE( hit_and_miss )
+{
+	TrajectoryCache cache;
+	const Key key = simulateKey(200);
+	BOOST_CHECK( !cache.find(key) );
+
+	cache.insert(key, result(20));
+	checkResult( cache.find(key), result(20) );
+	checkResult( cache.find(simulateKey(200)), result(20) );
+
+	// every parameter is part of the key, and floats are compared bit by bit
+	BOOST_CHECK( !cache.find(simulateKey(201)) );
+	BOOST_CHECK( !cache.find(Key(TrajectoryCache::Query::SIMULATE, 21, Vector2(200, 300), Vector2(3, -2))) );
+	BOOST_CHECK( !cache.find(Key(TrajectoryCache::Query::UNTIL_X, 20.f, Vector2(200, 300), Vector2(3, -2))) );
+	BOOST_CHECK( !cache.find(Key(TrajectoryCache::Query::SIMULATE, 20, Vector2(200, 300), Vector2(3, -2.0001f))) );
+	cache.insert(Key(TrajectoryCache::Query::UNTIL_Y, 0.f, Vector2(), Vector2()), result(1));
+	BOOST_CHECK( !cache.find(Key(TrajectoryCache::Query::UNTIL_Y, -0.f, Vector2(), Vector2())) );
+
+	BOOST_CHECK_EQUAL( cache.getHits(), 2u );
+	BOOST_CHECK_EQUAL( cache.getMisses(), 6u );
+	BOOST_CHECK_CLOSE( cache.getHitRate(), 0.25, 1e-9 );
+}
+
+BOOST_AUTO_TEST_CASE( invalidate )
+{
+	TrajectoryCache cache;
+	std::vector<Key> keys;
+	for(int i = 0; i < 100; ++i)
+	{
+		keys.push_back(simulateKey(i));
+		cache.insert(keys.back(), result(i));
+	}
+	for(int i = 0; i < 100; ++i)
+		checkResult( cache.find(keys[i]), result(i) );
+
+	cache.invalidate();
+	for(const auto& key : keys)
+		BOOST_CHECK( !cache.find(key) );
+
+	// the slots of the old generation are reused
+	cache.insert(keys[7], result(70));
+	checkResult( cache.find(keys[7]), result(70) );
+	BOOST_CHECK( !cache.find(keys[8]) );
+}
+
+BOOST_AUTO_TEST_CASE( eviction )
+{
+	// the keys start probing at the last slot, so the probes wrap around to the start of the table
+	std::vector<Key> keys = collidingKeys(TrajectoryCache::SIZE - 1, TrajectoryCache::PROBES + 2);
+
+	TrajectoryCache cache;
+	for(int i = 0; i < TrajectoryCache::PROBES; ++i)
+		cache.insert(keys[i], result(i));
+	for(int i = 0; i < TrajectoryCache::PROBES; ++i)
+		checkResult( cache.find(keys[i]), result(i) );
+
+	// all probed slots are used, so a further key replaces the entry in its first slot
+	const int last = TrajectoryCache::PROBES;
+	BOOST_CHECK( !cache.find(keys[last]) );
+	cache.insert(keys[last], result(last));
+	checkResult( cache.find(keys[last]), result(last) );
+	BOOST_CHECK( !cache.find(keys[0]) );
+	for(int i = 1; i < TrajectoryCache::PROBES; ++i)
+		checkResult( cache.find(keys[i]), result(i) );
+
+	// and again
+	cache.insert(keys[last + 1], result(last + 1));
+	checkResult( cache.find(keys[last + 1]), result(last + 1) );
+	BOOST_CHECK( !cache.find(keys[last]) );
+	for(int i = 1; i < TrajectoryCache::PROBES; ++i)
+		checkResult( cache.find(keys[i]), result(i) );
+}
+
+// the results are only valid for the ball of one frame, so the match empties the cache before the
+// input sources are asked for the input of the next step
+BOOST_FIXTURE_TEST_CASE( invalidated_by_match, DataFixture )
+{
+	RandomMatch match;
+	auto cache = match.match.getTrajectoryCache();
+	BOOST_REQUIRE( cache );
+
+	for(int step = 0; step < 10; ++step)
+	{
+		const Key key = simulateKey(step);
+		cache->insert(key, result(step));
+		checkResult( cache->find(key), result(step) );
+
+		match.play(step);
+		BOOST_CHECK( !cache->find(key) );
+	}
+
+	// a paused match does not ask for input, so the results stay valid
+	const Key key = simulateKey(100);
+	cache->insert(key, result(100));
+	match.match.pause();
+	match.play(10);
+	checkResult( cache->find(key), result(100) );
+	match.match.unpause();
+	match.play(10);
+	BOOST_CHECK( !cache->find(key) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()